@@ -0,0 +1,397 @@
+//
+// AABB tree benchmark
+//		Times AABBTree against testing every pair, for balls moving a little each frame, and
+//		checks everything it finds against brute force.
+//
+//	Each frame every ball moves, and 1% of them are taken out and put back somewhere else.
+//	The tree is validated after the inserts, the moves and the churn, and the fat boxes have
+//	to hold their balls. On the checked frames, QueryPairs, Query and RayCast have to find
+//	the same fat boxes that testing every one does, and the collisions from the pairs have
+//	to be the same as brute force's. Boxes that only just touch can go either way with
+//	rounding, so they aren't counted.
+//
+//	Builds without the Windows SDK, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../Win32GraphicsProject AABBTreeBenchmark.cpp
+//			../Win32GraphicsProject/Collision2D.cpp ../Win32GraphicsProject/AABBTree.cpp -o AABBTreeBenchmark
+//
+
+#include "Collision2D.h"
+#include "AABBTree.h"
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+
+using Clock = std::chrono::steady_clock;
+
+// how far apart boxes have to be before a test has to agree with brute force
+static const float slack = 0.01f;
+
+// -----------------------------------------------------
+// Balls bouncing around a box, about the same density whatever the count
+//
+struct World
+{
+	std::vector<Circle>		balls;
+	std::vector<Vector2>	velocities;
+	float					size;
+
+	World(int count, std::mt19937& rng)
+	{
+		size = sqrtf((float)count) * 40.0f;
+
+		std::uniform_real_distribution<float> radius(4.0f, 12.0f);
+		std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+		for (int i = 0; i < count; i++)
+		{
+			balls.push_back(Circle(RandomPosition(rng), radius(rng)));
+			velocities.push_back(Vector2(speed(rng), speed(rng)));
+		}
+	}
+
+	Vector2 RandomPosition(std::mt19937& rng) const
+	{
+		std::uniform_real_distribution<float> pos(0.0f, size);
+		return Vector2(pos(rng), pos(rng));
+	}
+
+	void Step()
+	{
+		for (size_t i = 0; i < balls.size(); i++)
+		{
+			Vector2& p = balls[i].center;
+			p += velocities[i];
+
+			if (p.x < 0.0f || p.x > size)
+				velocities[i].x = -velocities[i].x;
+			if (p.y < 0.0f || p.y > size)
+				velocities[i].y = -velocities[i].y;
+		}
+	}
+};
+
+// -----------------------------------------------------
+// Every pair, the way CollisionCheck loops
+//
+static int BruteForce(const World& world)
+{
+	int hits = 0;
+	int count = (int)world.balls.size();
+
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = i + 1; j < count; j++)
+		{
+			if (Collision2D::CircleCircleCheck(world.balls[i], world.balls[j]))
+				hits++;
+		}
+	}
+
+	return hits;
+}
+
+// -----------------------------------------------------
+// Move everything, then the narrowphase test on the pairs the tree found
+//
+static int TreeFrame(const World& world, AABBTree& tree, const std::vector<int>& proxies,
+	std::vector<ProxyPair>& pairs, int& rebuilt)
+{
+	rebuilt = 0;
+	for (int i = 0; i < (int)world.balls.size(); i++)
+	{
+		if (tree.Move(proxies[i], world.balls[i], world.velocities[i]))
+			rebuilt++;
+	}
+
+	pairs.clear();
+	tree.QueryPairs(pairs);
+
+	int hits = 0;
+	for (size_t p = 0; p < pairs.size(); p++)
+	{
+		int a = tree.GetUserData(pairs[p].proxyA);
+		int b = tree.GetUserData(pairs[p].proxyB);
+		if (Collision2D::CircleCircleCheck(world.balls[a], world.balls[b]))
+			hits++;
+	}
+
+	return hits;
+}
+
+// -----------------------------------------------------
+// How far two boxes overlap, negative if they're apart
+//
+static float OverlapDistance(const Box2D& a, const Box2D& b)
+{
+	Vector2 d = a.extents + b.extents;
+	float x = d.x - fabsf(a.center.x - b.center.x);
+	float y = d.y - fabsf(a.center.y - b.center.y);
+	return std::min(x, y);
+}
+
+// slab test of a segment against a box grown by grow, which can be negative
+static bool SegmentHitsBox(const Line2D& segment, const Box2D& box, float grow)
+{
+	Vector2 lower = box.center - box.extents - Vector2(grow, grow);
+	Vector2 upper = box.center + box.extents + Vector2(grow, grow);
+	Vector2 direction = segment.end - segment.start;
+
+	float tEnter = 0.0f;
+	float tExit = 1.0f;
+	for (int axis = 0; axis < 2; axis++)
+	{
+		float p = axis == 0 ? segment.start.x : segment.start.y;
+		float d = axis == 0 ? direction.x : direction.y;
+		float lo = axis == 0 ? lower.x : lower.y;
+		float hi = axis == 0 ? upper.x : upper.y;
+
+		if (d == 0.0f)
+		{
+			if (p < lo || p > hi)
+				return false;
+			continue;
+		}
+
+		float t1 = (lo - p) / d;
+		float t2 = (hi - p) / d;
+		if (t1 > t2)
+			std::swap(t1, t2);
+
+		tEnter = std::max(tEnter, t1);
+		tExit = std::min(tExit, t2);
+		if (tEnter > tExit)
+			return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------
+// The tree has to hold every ball and be consistent
+//
+static bool CheckTree(const World& world, const AABBTree& tree, const std::vector<int>& proxies, const char* after)
+{
+	if (!tree.Validate())
+	{
+		printf("tree isn't valid after %s\n", after);
+		return false;
+	}
+	if (tree.GetProxyCount() != (int)world.balls.size())
+	{
+		printf("tree has %d proxies after %s, should be %d\n", tree.GetProxyCount(), after, (int)world.balls.size());
+		return false;
+	}
+
+	for (int i = 0; i < (int)world.balls.size(); i++)
+	{
+		const Circle& ball = world.balls[i];
+		Box2D fat = tree.GetFatBox(proxies[i]);
+		Vector2 room = fat.extents - Vector2(fabsf(ball.center.x - fat.center.x), fabsf(ball.center.y - fat.center.y));
+		if (tree.GetUserData(proxies[i]) != i || room.x < ball.radius - slack || room.y < ball.radius - slack)
+		{
+			printf("ball %d isn't in its proxy's fat box after %s\n", i, after);
+			return false;
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------
+// QueryPairs, Query and RayCast against testing every fat box
+//
+static bool CheckQueries(const World& world, const AABBTree& tree, const std::vector<int>& proxies,
+	const std::vector<ProxyPair>& pairs, std::mt19937& rng)
+{
+	int count = (int)world.balls.size();
+
+	std::vector<Box2D> fat(count);
+	for (int i = 0; i < count; i++)
+		fat[i] = tree.GetFatBox(proxies[i]);
+
+	// pairs, as ball indices with the lower one first
+	std::vector<std::pair<int, int> > found;
+	for (const ProxyPair& pair : pairs)
+	{
+		int a = tree.GetUserData(pair.proxyA);
+		int b = tree.GetUserData(pair.proxyB);
+		found.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+	}
+	std::sort(found.begin(), found.end());
+	if (std::adjacent_find(found.begin(), found.end()) != found.end())
+	{
+		printf("QueryPairs gave a pair twice\n");
+		return false;
+	}
+
+	for (const std::pair<int, int>& pair : found)
+	{
+		if (OverlapDistance(fat[pair.first], fat[pair.second]) < -slack)
+		{
+			printf("QueryPairs gave balls %d and %d, their fat boxes don't overlap\n", pair.first, pair.second);
+			return false;
+		}
+	}
+
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = i + 1; j < count; j++)
+		{
+			if (OverlapDistance(fat[i], fat[j]) > slack && !std::binary_search(found.begin(), found.end(), std::make_pair(i, j)))
+			{
+				printf("QueryPairs missed balls %d and %d\n", i, j);
+				return false;
+			}
+		}
+	}
+
+	// a few boxes and segments of different sizes
+	std::uniform_real_distribution<float> extent(1.0f, world.size * 0.1f);
+	std::vector<int> results;
+	std::vector<ProxyRayHit> rayHits;
+
+	for (int q = 0; q < 20; q++)
+	{
+		Box2D box(world.RandomPosition(rng), Vector2(extent(rng), extent(rng)));
+
+		results.clear();
+		tree.Query(box, results);
+
+		std::vector<int> balls;
+		for (int proxy : results)
+			balls.push_back(tree.GetUserData(proxy));
+		std::sort(balls.begin(), balls.end());
+
+		for (int i = 0; i < count; i++)
+		{
+			float overlap = OverlapDistance(box, fat[i]);
+			bool inResults = std::binary_search(balls.begin(), balls.end(), i);
+			if ((overlap > slack && !inResults) || (overlap < -slack && inResults))
+			{
+				printf("Query %s ball %d\n", inResults ? "gave" : "missed", i);
+				return false;
+			}
+		}
+
+		Line2D segment(world.RandomPosition(rng), world.RandomPosition(rng));
+
+		rayHits.clear();
+		tree.RayCast(segment, rayHits);
+
+		balls.clear();
+		for (size_t h = 0; h < rayHits.size(); h++)
+		{
+			if (h > 0 && rayHits[h].fraction < rayHits[h - 1].fraction)
+			{
+				printf("RayCast hits aren't closest first\n");
+				return false;
+			}
+			balls.push_back(tree.GetUserData(rayHits[h].proxy));
+		}
+		std::sort(balls.begin(), balls.end());
+
+		for (int i = 0; i < count; i++)
+		{
+			bool inResults = std::binary_search(balls.begin(), balls.end(), i);
+			if ((SegmentHitsBox(segment, fat[i], -slack) && !inResults) || (!SegmentHitsBox(segment, fat[i], slack) && inResults))
+			{
+				printf("RayCast %s ball %d\n", inResults ? "gave" : "missed", i);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+int main()
+{
+	const int sizes[] = { 1000, 5000, 10000, 50000 };
+	const int frames = 30;
+
+	std::mt19937 rng(4127);
+
+	printf("%8s %8s %16s %16s %16s %12s %12s %10s\n", "bodies", "height", "brute ms/frame", "tree insert ms", "tree ms/frame", "pairs/frame", "moved/frame", "speedup");
+
+	for (int size : sizes)
+	{
+		World world(size, rng);
+
+		AABBTree tree;
+		std::vector<int> proxies(size);
+
+		Clock::time_point start = Clock::now();
+		for (int i = 0; i < size; i++)
+			proxies[i] = tree.Insert(world.balls[i], i);
+		double insertMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		if (!CheckTree(world, tree, proxies, "inserting"))
+			return 1;
+
+		// brute force gets slow, only check a few frames of it at the larger sizes
+		int checkFrames = size > 10000 ? 2 : frames;
+		int churn = size / 100;
+
+		double bruteSeconds = 0.0;
+		double treeSeconds = 0.0;
+		long long rebuilt = 0;
+		long long pairCount = 0;
+		std::vector<ProxyPair> pairs;
+		std::uniform_int_distribution<int> pick(0, size - 1);
+
+		for (int f = 0; f < frames; f++)
+		{
+			// take some out and put them back somewhere else, like bricks breaking and new ones coming in
+			for (int c = 0; c < churn; c++)
+			{
+				int i = pick(rng);
+				tree.Remove(proxies[i]);
+				world.balls[i].center = world.RandomPosition(rng);
+				proxies[i] = tree.Insert(world.balls[i], i);
+			}
+			if (!CheckTree(world, tree, proxies, "removing and inserting"))
+				return 1;
+
+			world.Step();
+
+			int moved = 0;
+			start = Clock::now();
+			int treeHits = TreeFrame(world, tree, proxies, pairs, moved);
+			treeSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			rebuilt += moved;
+			pairCount += (long long)pairs.size();
+
+			if (!CheckTree(world, tree, proxies, "moving"))
+				return 1;
+
+			if (f < checkFrames)
+			{
+				start = Clock::now();
+				int bruteHits = BruteForce(world);
+				bruteSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+				// both have to find the same collisions
+				if (bruteHits != treeHits)
+				{
+					printf("mismatch at %d bodies: brute %d, tree %d\n", size, bruteHits, treeHits);
+					return 1;
+				}
+
+				if (!CheckQueries(world, tree, proxies, pairs, rng))
+				{
+					printf("at %d bodies, frame %d\n", size, f);
+					return 1;
+				}
+			}
+		}
+
+		double bruteMs = bruteSeconds * 1000.0 / checkFrames;
+		double treeMs = treeSeconds * 1000.0 / frames;
+
+		printf("%8d %8d %16.3f %16.3f %16.3f %12lld %12lld %9.1fx\n", size, tree.GetHeight(), bruteMs, insertMs, treeMs,
+			pairCount / frames, rebuilt / frames, bruteMs / treeMs);
+	}
+
+	printf("the tree, its pairs, queries and ray casts matched brute force\n");
+	return 0;
+}
@@ -0,0 +1,164 @@
+//
+// Broadphase benchmark
+//		Times sweep and prune against testing every pair, for balls moving a little each frame.
+//		The first frame, which sorts every ball just inserted, is timed on its own.
+//
+//	Builds without the Windows SDK, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../Win32GraphicsProject BroadphaseBenchmark.cpp
+//			../Win32GraphicsProject/Collision2D.cpp ../Win32GraphicsProject/SweepAndPrune.cpp -o BroadphaseBenchmark
+//
+
+#include "Collision2D.h"
+#include "SweepAndPrune.h"
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+
+using Clock = std::chrono::steady_clock;
+
+// -----------------------------------------------------
+// Balls bouncing around a box, about the same density whatever the count
+//
+struct World
+{
+	std::vector<Circle>		balls;
+	std::vector<Vector2>	velocities;
+	float					size;
+
+	World(int count, std::mt19937& rng)
+	{
+		size = sqrtf((float)count) * 40.0f;
+
+		std::uniform_real_distribution<float> pos(0.0f, size);
+		std::uniform_real_distribution<float> radius(4.0f, 12.0f);
+		std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+
+		for (int i = 0; i < count; i++)
+		{
+			balls.push_back(Circle(Vector2(pos(rng), pos(rng)), radius(rng)));
+			velocities.push_back(Vector2(speed(rng), speed(rng)));
+		}
+	}
+
+	void Step()
+	{
+		for (size_t i = 0; i < balls.size(); i++)
+		{
+			Vector2& p = balls[i].center;
+			p += velocities[i];
+
+			if (p.x < 0.0f || p.x > size)
+				velocities[i].x = -velocities[i].x;
+			if (p.y < 0.0f || p.y > size)
+				velocities[i].y = -velocities[i].y;
+		}
+	}
+};
+
+// -----------------------------------------------------
+// Every pair, the way CollisionCheck loops
+//
+static int BruteForce(const World& world)
+{
+	int hits = 0;
+	int count = (int)world.balls.size();
+
+	for (int i = 0; i < count; i++)
+	{
+		for (int j = i + 1; j < count; j++)
+		{
+			if (Collision2D::CircleCircleCheck(world.balls[i], world.balls[j]))
+				hits++;
+		}
+	}
+
+	return hits;
+}
+
+// -----------------------------------------------------
+// Sweep and prune, then the narrowphase test on the pairs it found
+//
+static int Sweep(const World& world, SweepAndPrune& sap, std::vector<ProxyPair>& pairs)
+{
+	for (int i = 0; i < (int)world.balls.size(); i++)
+		sap.Move(i, world.balls[i]);
+
+	pairs.clear();
+	sap.FindPairs(pairs);
+
+	int hits = 0;
+	for (size_t p = 0; p < pairs.size(); p++)
+	{
+		if (Collision2D::CircleCircleCheck(world.balls[pairs[p].proxyA], world.balls[pairs[p].proxyB]))
+			hits++;
+	}
+
+	return hits;
+}
+
+int main()
+{
+	const int sizes[] = { 1000, 5000, 10000, 50000 };
+	const int frames = 30;
+
+	std::mt19937 rng(9201);
+
+	printf("%8s %16s %16s %16s %12s %12s %10s\n", "bodies", "brute ms/frame", "sap first ms", "sap ms/frame", "pairs/frame", "swaps/frame", "speedup");
+
+	for (int size : sizes)
+	{
+		World world(size, rng);
+
+		SweepAndPrune sap;
+		for (int i = 0; i < size; i++)
+			sap.Insert(world.balls[i], i);
+
+		// every endpoint is new, so this one sorts from scratch
+		std::vector<ProxyPair> pairs;
+		Clock::time_point firstStart = Clock::now();
+		Sweep(world, sap, pairs);
+		double firstMs = std::chrono::duration<double, std::milli>(Clock::now() - firstStart).count();
+
+		// brute force gets slow, only run a few frames of it at the larger sizes
+		int bruteFrames = size > 10000 ? 2 : frames;
+
+		double bruteSeconds = 0.0;
+		double sapSeconds = 0.0;
+		long long swaps = 0;
+		long long pairCount = 0;
+
+		for (int f = 0; f < frames; f++)
+		{
+			world.Step();
+
+			Clock::time_point start = Clock::now();
+			int sapHits = Sweep(world, sap, pairs);
+			sapSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			swaps += sap.GetLastSwapCount();
+			pairCount += (long long)pairs.size();
+
+			if (f < bruteFrames)
+			{
+				start = Clock::now();
+				int bruteHits = BruteForce(world);
+				bruteSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+				// both have to find the same collisions
+				if (bruteHits != sapHits)
+				{
+					printf("mismatch at %d bodies: brute %d, sap %d\n", size, bruteHits, sapHits);
+					return 1;
+				}
+			}
+		}
+
+		double bruteMs = bruteSeconds * 1000.0 / bruteFrames;
+		double sapMs = sapSeconds * 1000.0 / frames;
+
+		printf("%8d %16.3f %16.3f %16.3f %12lld %12lld %9.1fx\n", size, bruteMs, firstMs, sapMs,
+			pairCount / frames, swaps / frames, bruteMs / sapMs);
+	}
+
+	return 0;
+}
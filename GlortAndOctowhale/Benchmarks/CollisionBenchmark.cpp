@@ -0,0 +1,134 @@
+//
+// Collision benchmark
+//		Times the batched box / circle test against calling BoxCircleCheck once per box.
+//
+//	Builds without the Windows SDK, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../Win32GraphicsProject CollisionBenchmark.cpp
+//			../Win32GraphicsProject/Collision2D.cpp ../Win32GraphicsProject/Collision2DBatch.cpp -o CollisionBenchmark
+//
+
+#include "Collision2D.h"
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+
+using Clock = std::chrono::steady_clock;
+
+// stops the compiler throwing away results we never look at
+static volatile int sink;
+
+// -----------------------------------------------------
+// A random level of boxes stored both ways
+//
+struct BoxSet
+{
+	std::vector<Box2D> boxes;
+	std::vector<float> centerX, centerY, extentX, extentY;
+
+	BoxArray2D GetArrays() const
+	{
+		return BoxArray2D(centerX.data(), centerY.data(), extentX.data(), extentY.data(), (int)boxes.size());
+	}
+};
+
+static BoxSet MakeBoxes(int count, std::mt19937& rng)
+{
+	std::uniform_real_distribution<float> pos(0.0f, 1024.0f);
+	std::uniform_real_distribution<float> size(8.0f, 48.0f);
+
+	BoxSet set;
+	for (int i = 0; i < count; i++)
+	{
+		Box2D box(Vector2(pos(rng), pos(rng) * 0.75f), Vector2(size(rng), size(rng)));
+		set.boxes.push_back(box);
+		set.centerX.push_back(box.center.x);
+		set.centerY.push_back(box.center.y);
+		set.extentX.push_back(box.extents.x);
+		set.extentY.push_back(box.extents.y);
+	}
+	return set;
+}
+
+// -----------------------------------------------------
+// Runs test for at least minSeconds and returns ns per box
+//
+template <typename Test>
+static double TimeNsPerBox(int boxCount, Test test, double minSeconds = 0.2)
+{
+	long long boxesTested = 0;
+	Clock::time_point start = Clock::now();
+	double elapsed = 0.0;
+
+	do
+	{
+		for (int rep = 0; rep < 16; rep++)
+		{
+			test();
+			boxesTested += boxCount;
+		}
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	} while (elapsed < minSeconds);
+
+	return elapsed * 1e9 / (double)boxesTested;
+}
+
+int main()
+{
+	const int sizes[] = { 48, 1000, 100000 };
+	const char* levelNames[] = { "scalar", "sse2", "avx2" };
+
+	std::mt19937 rng(9201);
+
+	printf("best simd level: %s\n\n", levelNames[Collision2D::GetSimdLevel()]);
+	printf("%8s %14s %14s %14s %14s\n", "boxes", "single ns/box", "scalar ns/box", "sse2 ns/box", "avx2 ns/box");
+
+	for (int size : sizes)
+	{
+		BoxSet set = MakeBoxes(size, rng);
+		BoxArray2D arrays = set.GetArrays();
+		std::vector<unsigned int> mask((size + 31) / 32);
+		Circle ball(Vector2(512.0f, 384.0f), 23.0f);
+
+		// one BoxCircleCheck per box, the way CollisionCheck used to
+		double single = TimeNsPerBox(size, [&]()
+		{
+			int hits = 0;
+			for (int i = 0; i < size; i++)
+				hits += Collision2D::BoxCircleCheck(set.boxes[i], ball) ? 1 : 0;
+			sink = hits;
+		});
+
+		double batched[3];
+		for (int level = Collision2D::SimdScalar; level <= Collision2D::SimdAVX2; level++)
+		{
+			if (level > Collision2D::GetSimdLevel())
+			{
+				batched[level] = 0.0;
+				continue;
+			}
+
+			// make sure the batch agrees with the single test
+			Collision2D::BoxCircleCheckBatch(arrays, ball, mask.data(), (Collision2D::SimdLevel)level);
+			for (int i = 0; i < size; i++)
+			{
+				bool expected = Collision2D::BoxCircleCheck(set.boxes[i], ball);
+				bool got = (mask[i >> 5] >> (i & 31)) & 1;
+				if (expected != got)
+				{
+					printf("mismatch: %s box %d\n", levelNames[level], i);
+					return 1;
+				}
+			}
+
+			batched[level] = TimeNsPerBox(size, [&]()
+			{
+				sink = Collision2D::BoxCircleCheckBatch(arrays, ball, mask.data(), (Collision2D::SimdLevel)level);
+			});
+		}
+
+		printf("%8d %14.3f %14.3f %14.3f %14.3f\n", size, single, batched[0], batched[1], batched[2]);
+	}
+
+	return 0;
+}
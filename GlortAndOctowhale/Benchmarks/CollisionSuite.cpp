@@ -0,0 +1,614 @@
+//
+// Collision suite
+//		Times every Collision2D entry point over seeded random and adversarial inputs,
+//		and writes the results as JSON so collision changes can be compared on numbers.
+//
+//	Builds without the Windows SDK, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../Win32GraphicsProject CollisionSuite.cpp
+//			../Win32GraphicsProject/Collision2D.cpp ../Win32GraphicsProject/Collision2DBatch.cpp -o CollisionSuite
+//
+//	Options:
+//		--seed=N		seed for the inputs (default 9201), the same seed always makes the same inputs
+//		--min-time=S	seconds to run each test for (default 0.1)
+//		--filter=TEXT	only run tests whose "function/workload" name contains TEXT
+//		--out=FILE		write the JSON to FILE instead of stdout
+//
+
+#include "Collision2D.h"
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+using Clock = std::chrono::steady_clock;
+
+static const float pi = 3.14159265f;
+
+// stops the compiler throwing away results we never look at
+static volatile int sink;
+
+// -----------------------------------------------------
+// Seeded random numbers
+//	built straight from the mt19937 output, which is the same everywhere (the std
+//	distributions aren't), so a seed gives the same inputs on every compiler, give or
+//	take the last bit of cosf / sinf for the angles
+//
+struct Random
+{
+	std::mt19937 rng;
+
+	Random(unsigned int seed) : rng(seed) {}
+
+	float Float(float lo, float hi) { return lo + (hi - lo) * (float)(rng() >> 8) * (1.0f / 16777216.0f); }
+	float Angle() { return Float(-pi, pi); }
+	bool Chance(float p) { return Float(0.0f, 1.0f) < p; }
+	Vector2 Direction() { float a = Angle(); return Vector2(cosf(a), sinf(a)); }
+	Vector2 Position() { return Vector2(Float(0.0f, 1024.0f), Float(0.0f, 768.0f)); }
+	Vector2 Extents() { return Vector2(Float(4.0f, 48.0f), Float(4.0f, 48.0f)); }
+	Box2D Box() { return Box2D(Position(), Extents()); }
+	Circle Ball() { return Circle(Position(), Float(4.0f, 32.0f)); }
+	OBB2D OrientedBox()
+	{
+		float a = Angle();
+		return OBB2D(Position(), Extents(), cosf(a), sinf(a));
+	}
+};
+
+// -----------------------------------------------------
+// Inputs, one struct per kind of test
+//
+struct BoxPair		{ Box2D a; Box2D b; };
+struct BoxBall		{ Box2D box; Circle circle; Vector2 velocity; };
+struct BallPair		{ Circle a; Circle b; Vector2 displacement; };
+struct LinePair		{ Line2D a; Line2D b; };
+struct OBBPair		{ OBB2D a; OBB2D b; };
+struct OBBBall		{ OBB2D box; Circle circle; };
+
+// -----------------------------------------------------
+// Collects the results and writes them out
+//
+struct Result
+{
+	std::string	function;
+	std::string	workload;
+	int			inputs;
+	int			itemsPerOp;
+	long long	ops;
+	double		seconds;
+	double		hitRate;
+};
+
+struct Suite
+{
+	unsigned int		seed;
+	double				minTime;
+	std::string			filter;
+	std::vector<Result>	results;
+
+	bool Wanted(const char* function, const char* workload) const
+	{
+		std::string name = std::string(function) + "/" + workload;
+		return filter.empty() || name.find(filter) != std::string::npos;
+	}
+
+	// op returns non zero for a hit, which is used for the hit rate
+	//	so we can check a workload really does what it says (e.g. corner cases that all hit)
+	template <typename Input, typename Op>
+	void Run(const char* function, const char* workload, const std::vector<Input>& inputs, Op op, int itemsPerOp = 1)
+	{
+		if (!Wanted(function, workload) || inputs.empty())
+			return;
+
+		// warm up and count the hits
+		int hits = 0;
+		for (size_t i = 0; i < inputs.size(); i++)
+			hits += op(inputs[i]) ? 1 : 0;
+
+		long long ops = 0;
+		int total = 0;
+		Clock::time_point start = Clock::now();
+		double elapsed = 0.0;
+
+		do
+		{
+			for (size_t i = 0; i < inputs.size(); i++)
+				total += op(inputs[i]);
+			ops += (long long)inputs.size();
+			elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		} while (elapsed < minTime);
+
+		sink = total;
+
+		Result result;
+		result.function = function;
+		result.workload = workload;
+		result.inputs = (int)inputs.size();
+		result.itemsPerOp = itemsPerOp;
+		result.ops = ops;
+		result.seconds = elapsed;
+		result.hitRate = (double)hits / (double)inputs.size();
+		results.push_back(result);
+
+		fprintf(stderr, "%-22s %-18s %10.2f ns/op\n", function, workload, elapsed * 1e9 / (double)ops);
+	}
+
+	void WriteJson(FILE* file) const
+	{
+		static const char* levelNames[] = { "scalar", "sse2", "avx2" };
+
+		fprintf(file, "{\n");
+		fprintf(file, "  \"seed\": %u,\n", seed);
+		fprintf(file, "  \"min_time\": %g,\n", minTime);
+		fprintf(file, "  \"simd\": \"%s\",\n", levelNames[Collision2D::GetSimdLevel()]);
+		fprintf(file, "  \"results\": [\n");
+
+		for (size_t r = 0; r < results.size(); r++)
+		{
+			const Result& result = results[r];
+			double nsPerOp = result.seconds * 1e9 / (double)result.ops;
+
+			fprintf(file, "    {\"function\": \"%s\", \"workload\": \"%s\", \"inputs\": %d, \"items_per_op\": %d, "
+				"\"ops\": %lld, \"ns_per_op\": %.4f, \"ops_per_sec\": %.1f, \"items_per_sec\": %.1f, \"hit_rate\": %.4f}%s\n",
+				result.function.c_str(), result.workload.c_str(), result.inputs, result.itemsPerOp,
+				result.ops, nsPerOp, 1e9 / nsPerOp, 1e9 * result.itemsPerOp / nsPerOp, result.hitRate,
+				r + 1 < results.size() ? "," : "");
+		}
+
+		fprintf(file, "  ]\n}\n");
+	}
+};
+
+// number of inputs per workload, small enough to stay in the cache
+static const int inputCount = 4096;
+
+// -----------------------------------------------------
+// Box / Box
+//
+static void BoxBoxTests(Suite& suite, Random& random)
+{
+	std::vector<BoxPair> randomPairs, overlapping, separated, touching;
+
+	for (int i = 0; i < inputCount; i++)
+	{
+		BoxPair pair = { random.Box(), random.Box() };
+		randomPairs.push_back(pair);
+
+		// inside each other
+		Vector2 reach = pair.a.extents + pair.b.extents;
+		pair.b.center = pair.a.center + Vector2(random.Float(-0.9f, 0.9f) * reach.x, random.Float(-0.9f, 0.9f) * reach.y);
+		overlapping.push_back(pair);
+
+		// lined up on y but apart on x, the first test fails
+		pair.b.center = pair.a.center + Vector2(reach.x * random.Float(1.01f, 2.0f), random.Float(-0.5f, 0.5f) * reach.y);
+		separated.push_back(pair);
+
+		// sides exactly touching, right on the boundary of the < test
+		pair.b.center = pair.a.center + Vector2(reach.x, random.Float(-0.5f, 0.5f) * reach.y);
+		touching.push_back(pair);
+	}
+
+	auto op = [](const BoxPair& p) { return Collision2D::BoxBoxCheck(p.a, p.b) ? 1 : 0; };
+	suite.Run("BoxBoxCheck", "random", randomPairs, op);
+	suite.Run("BoxBoxCheck", "overlapping", overlapping, op);
+	suite.Run("BoxBoxCheck", "separated_x", separated, op);
+	suite.Run("BoxBoxCheck", "touching_edge", touching, op);
+}
+
+// -----------------------------------------------------
+// Box / Circle
+//
+static void BoxCircleTests(Suite& suite, Random& random)
+{
+	std::vector<BoxBall> randomInputs, corner, inside;
+
+	for (int i = 0; i < inputCount; i++)
+	{
+		BoxBall input = { random.Box(), random.Ball(), Vector2::Zero };
+		randomInputs.push_back(input);
+
+		// off a corner, diagonally. both axis tests pass so the distance test decides
+		Vector2 signs(random.Chance(0.5f) ? 1.0f : -1.0f, random.Chance(0.5f) ? 1.0f : -1.0f);
+		Vector2 cornerPos = input.box.center + input.box.extents * signs;
+		input.circle.center = cornerPos + signs * (input.circle.radius * random.Float(0.5f, 0.8f));
+		corner.push_back(input);
+
+		// center inside the box
+		input.circle.center = input.box.center + input.box.extents * Vector2(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f));
+		inside.push_back(input);
+	}
+
+	auto op = [](const BoxBall& p) { return Collision2D::BoxCircleCheck(p.box, p.circle) ? 1 : 0; };
+	suite.Run("BoxCircleCheck", "random", randomInputs, op);
+	suite.Run("BoxCircleCheck", "corner", corner, op);
+	suite.Run("BoxCircleCheck", "inside", inside, op);
+}
+
+// -----------------------------------------------------
+// Circle / Circle
+//
+static void CircleCircleTests(Suite& suite, Random& random)
+{
+	std::vector<BallPair> randomPairs, touching;
+
+	for (int i = 0; i < inputCount; i++)
+	{
+		BallPair pair = { random.Ball(), random.Ball(), Vector2::Zero };
+		randomPairs.push_back(pair);
+
+		// just touching, on one side or the other of the <= by a hair
+		float distance = (pair.a.radius + pair.b.radius) * (1.0f + random.Float(-1e-6f, 1e-6f));
+		pair.b.center = pair.a.center + random.Direction() * distance;
+		touching.push_back(pair);
+	}
+
+	auto op = [](const BallPair& p) { return Collision2D::CircleCircleCheck(p.a, p.b) ? 1 : 0; };
+	suite.Run("CircleCircleCheck", "random", randomPairs, op);
+	suite.Run("CircleCircleCheck", "touching", touching, op);
+}
+
+// -----------------------------------------------------
+// Line / Line
+//
+static void LineLineTests(Suite& suite, Random& random)
+{
+	std::vector<LinePair> randomPairs, nearParallel, parallel, collinear, perpendicular;
+
+	for (int i = 0; i < inputCount; i++)
+	{
+		Line2D a(random.Position(), random.Position());
+		LinePair pair = { a, Line2D(random.Position(), random.Position()) };
+		randomPairs.push_back(pair);
+
+		Vector2 direction = a.end - a.start;
+		float length = direction.Length();
+		direction /= length;
+		Vector2 across(-direction.y, direction.x);
+
+		// turned by a tiny angle, so the denominator (about length^2 * angle) lands either side of the parallel epsilon
+		float angle = powf(10.0f, random.Float(-6.0f, -2.0f)) / (length * length);
+		Vector2 turned(direction.x * cosf(angle) - direction.y * sinf(angle), direction.x * sinf(angle) + direction.y * cosf(angle));
+		Vector2 start = a.start + across * random.Float(1.0f, 50.0f);
+		pair.b = Line2D(start, start + turned * length);
+		nearParallel.push_back(pair);
+
+		// exactly parallel, offset sideways
+		pair.b = Line2D(a.start + across * 10.0f, a.end + across * 10.0f);
+		parallel.push_back(pair);
+
+		// on the same line, overlapping
+		pair.b = Line2D(a.start + direction * (length * 0.5f), a.end + direction * (length * 0.5f));
+		collinear.push_back(pair);
+
+		// crossing at the middle at right angles
+		Vector2 middle = (a.start + a.end) * 0.5f;
+		pair.b = Line2D(middle - across * 50.0f, middle + across * 50.0f);
+		perpendicular.push_back(pair);
+	}
+
+	auto op = [](const LinePair& p)
+	{
+		float ta, tb;
+		Vector2 intersection;
+		return Collision2D::LineLineCheck(p.a, p.b, ta, tb, intersection) ? 1 : 0;
+	};
+	suite.Run("LineLineCheck", "random", randomPairs, op);
+	suite.Run("LineLineCheck", "near_parallel", nearParallel, op);
+	suite.Run("LineLineCheck", "parallel", parallel, op);
+	suite.Run("LineLineCheck", "collinear", collinear, op);
+	suite.Run("LineLineCheck", "perpendicular", perpendicular, op);
+}
+
+// -----------------------------------------------------
+// Moving circle against a box, for ReflectCircleBox and the contact / sweep functions
+//	the circle is placed so it reaches the box during one 60th of a second
+//
+static const float frameTime = 1.0f / 60.0f;
+
+static void MovingBallInputs(Random& random, std::vector<BoxBall>& face, std::vector<BoxBall>& corner,
+	std::vector<BoxBall>& grazing, std::vector<BoxBall>& inside, std::vector<BoxBall>& miss)
+{
+	for (int i = 0; i < inputCount; i++)
+	{
+		Box2D box = random.Box();
+		float radius = random.Float(4.0f, 16.0f);
+		float speed = random.Float(300.0f, 900.0f);
+		float travel = speed * frameTime;
+
+		// straight at the top face, hitting part way through the frame
+		BoxBall input;
+		input.box = box;
+		input.circle = Circle(box.center + Vector2(random.Float(-0.9f, 0.9f) * box.extents.x,
+			-(box.extents.y + radius + travel * random.Float(0.1f, 0.9f))), radius);
+		input.velocity = Vector2(0.0f, speed);
+		face.push_back(input);
+
+		// diagonally at a corner
+		Vector2 signs(random.Chance(0.5f) ? 1.0f : -1.0f, random.Chance(0.5f) ? 1.0f : -1.0f);
+		Vector2 diagonal = signs * 0.70710678f;
+		input.circle.center = box.center + box.extents * signs + diagonal * (radius + travel * random.Float(0.1f, 0.9f));
+		input.velocity = -diagonal * speed;
+		corner.push_back(input);
+
+		// sliding along the top face exactly one radius above it
+		input.circle.center = box.center + Vector2(-box.extents.x - travel * 0.5f, -(box.extents.y + radius));
+		input.velocity = Vector2(speed, 0.0f);
+		grazing.push_back(input);
+
+		// starting overlapping the box
+		input.circle.center = box.center + box.extents * Vector2(random.Float(-1.0f, 1.0f), random.Float(-1.0f, 1.0f));
+		input.velocity = random.Direction() * speed;
+		inside.push_back(input);
+
+		// moving away from the box
+		input.circle.center = box.center + Vector2(0.0f, -(box.extents.y + radius + 1.0f));
+		input.velocity = Vector2(random.Float(-0.5f, 0.5f), -1.0f) * speed;
+		miss.push_back(input);
+	}
+}
+
+static void MovingBallTests(Suite& suite, Random& random)
+{
+	std::vector<BoxBall> face, corner, grazing, inside, miss;
+	MovingBallInputs(random, face, corner, grazing, inside, miss);
+
+	// ReflectCircleBox, a hit is a change of velocity
+	auto reflect = [](const BoxBall& p)
+	{
+		Vector2 velocity = p.velocity;
+		Collision2D::ReflectCircleBox(p.circle, velocity, frameTime, p.box);
+		return velocity != p.velocity ? 1 : 0;
+	};
+	suite.Run("ReflectCircleBox", "face", face, reflect);
+	suite.Run("ReflectCircleBox", "corner", corner, reflect);
+	suite.Run("ReflectCircleBox", "grazing", grazing, reflect);
+	suite.Run("ReflectCircleBox", "inside", inside, reflect);
+	suite.Run("ReflectCircleBox", "moving_away", miss, reflect);
+
+	auto contact = [](const BoxBall& p) { return Collision2D::CircleBoxContact(p.circle, p.box, p.velocity * frameTime).hit ? 1 : 0; };
+	suite.Run("CircleBoxContact", "face", face, contact);
+	suite.Run("CircleBoxContact", "corner", corner, contact);
+	suite.Run("CircleBoxContact", "grazing", grazing, contact);
+	suite.Run("CircleBoxContact", "inside", inside, contact);
+	suite.Run("CircleBoxContact", "moving_away", miss, contact);
+
+	auto sweep = [](const BoxBall& p)
+	{
+		float toi;
+		Vector2 normal;
+		return Collision2D::SweepCircleBox(p.circle, p.velocity * frameTime, p.box, toi, normal) ? 1 : 0;
+	};
+	suite.Run("SweepCircleBox", "face", face, sweep);
+	suite.Run("SweepCircleBox", "corner", corner, sweep);
+	suite.Run("SweepCircleBox", "inside", inside, sweep);
+	suite.Run("SweepCircleBox", "moving_away", miss, sweep);
+}
+
+// -----------------------------------------------------
+// Moving circle against a circle
+//
+static void CircleContactTests(Suite& suite, Random& random)
+{
+	std::vector<BallPair> swept, overlapping;
+
+	for (int i = 0; i < inputCount; i++)
+	{
+		BallPair pair = { random.Ball(), random.Ball(), Vector2::Zero };
+		float reach = pair.a.radius + pair.b.radius;
+
+		// heading for the other circle, off center
+		Vector2 direction = random.Direction();
+		Vector2 across(-direction.y, direction.x);
+		float travel = random.Float(5.0f, 15.0f);
+		pair.a.center = pair.b.center - direction * (reach + travel * random.Float(0.1f, 0.9f)) + across * (reach * random.Float(-0.5f, 0.5f));
+		pair.displacement = direction * travel;
+		swept.push_back(pair);
+
+		pair.a.center = pair.b.center + random.Direction() * (reach * random.Float(0.0f, 0.99f));
+		overlapping.push_back(pair);
+	}
+
+	auto op = [](const BallPair& p) { return Collision2D::CircleCircleContact(p.a, p.b, p.displacement).hit ? 1 : 0; };
+	suite.Run("CircleCircleContact", "swept", swept, op);
+	suite.Run("CircleCircleContact", "overlapping", overlapping, op);
+}
+
+// -----------------------------------------------------
+// Oriented boxes
+//
+static void OBBTests(Suite& suite, Random& random)
+{
+	std::vector<OBBPair> randomPairs, nearTouching;
+	std::vector<OBBBall> randomBalls, corner;
+
+	for (int i = 0; i < inputCount; i++)
+	{
+		OBBPair pair = { random.OrientedBox(), random.OrientedBox() };
+		randomPairs.push_back(pair);
+
+		// b slid out along a's x axis until they are about to separate
+		//	the distance needed is both boxes projected onto that axis
+		Vector2 axis = pair.a.axisX;
+		float reachB = fabsf(pair.b.axisX.Dot(axis)) * pair.b.extents.x + fabsf(pair.b.axisY.Dot(axis)) * pair.b.extents.y;
+		pair.b.center = pair.a.center + axis * ((pair.a.extents.x + reachB) * random.Float(0.98f, 1.02f));
+		nearTouching.push_back(pair);
+
+		OBBBall ball = { pair.a, random.Ball() };
+		randomBalls.push_back(ball);
+
+		// just off a rotated corner
+		Vector2 cornerPos = pair.a.center + pair.a.axisX * pair.a.extents.x + pair.a.axisY * pair.a.extents.y;
+		Vector2 out = pair.a.axisX + pair.a.axisY;
+		out.Normalize();
+		ball.circle.center = cornerPos + out * (ball.circle.radius * random.Float(0.9f, 1.1f));
+		corner.push_back(ball);
+	}
+
+	auto pairOp = [](const OBBPair& p) { return Collision2D::OBBOBBCheck(p.a, p.b) ? 1 : 0; };
+	suite.Run("OBBOBBCheck", "random", randomPairs, pairOp);
+	suite.Run("OBBOBBCheck", "near_touching", nearTouching, pairOp);
+
+	auto ballOp = [](const OBBBall& p) { return Collision2D::OBBCircleCheck(p.box, p.circle) ? 1 : 0; };
+	suite.Run("OBBCircleCheck", "random", randomBalls, ballOp);
+	suite.Run("OBBCircleCheck", "corner", corner, ballOp);
+
+	// the helpers that turn rotated boxes into axis aligned ones
+	auto boundsOp = [](const OBBPair& p)
+	{
+		Box2D box = Collision2D::BoundingBox(p.a);
+		return box.extents.x > box.extents.y ? 1 : 0;
+	};
+	suite.Run("BoundingBox", "random", randomPairs, boundsOp);
+
+	auto extentsOp = [](const OBBPair& p)
+	{
+		Vector2 extents = Collision2D::RotatedExtents(p.a.extents, p.a.axisX.x, p.a.axisX.y);
+		return extents.x > extents.y ? 1 : 0;
+	};
+	suite.Run("RotatedExtents", "random", randomPairs, extentsOp);
+}
+
+// -----------------------------------------------------
+// MoveCircle through the game's brick layout, and bouncing down a narrow corridor
+//
+static void MoveCircleTests(Suite& suite, Random& random)
+{
+	// 8 x 6 bricks and the paddle, like the game
+	std::vector<Box2D> bricks;
+	for (int y = 0; y < 6; y++)
+	{
+		for (int x = 0; x < 8; x++)
+			bricks.push_back(Box2D(Vector2(160.0f + x * 100.0f, 100.0f + y * 40.0f), Vector2(48.0f, 18.0f)));
+	}
+	bricks.push_back(Box2D(Vector2(512.0f, 700.0f), Vector2(80.0f, 12.0f)));
+
+	// two walls 30 pixels apart, a fast ball bounces between them several times a frame
+	std::vector<Box2D> corridor;
+	corridor.push_back(Box2D(Vector2(-10.0f, 0.0f), Vector2(10.0f, 1000.0f)));
+	corridor.push_back(Box2D(Vector2(40.0f, 0.0f), Vector2(10.0f, 1000.0f)));
+
+	std::vector<BoxBall> field, bouncing;
+	for (int i = 0; i < inputCount; i++)
+	{
+		BoxBall input;
+		input.circle = Circle(random.Position(), 11.5f);
+		input.velocity = random.Direction() * random.Float(300.0f, 900.0f);
+		field.push_back(input);
+
+		input.circle = Circle(Vector2(random.Float(8.0f, 22.0f), random.Float(-100.0f, 100.0f)), 8.0f);
+		input.velocity = Vector2(random.Chance(0.5f) ? 1500.0f : -1500.0f, random.Float(-200.0f, 200.0f));
+		bouncing.push_back(input);
+	}
+
+	auto move = [](const BoxBall& p, const std::vector<Box2D>& boxes)
+	{
+		SweepHit2D hits[8];
+		int numHits;
+		Vector2 velocity = p.velocity;
+		Collision2D::MoveCircle(p.circle, velocity, frameTime, boxes.data(), (int)boxes.size(), hits, 8, numHits);
+		return numHits;
+	};
+	suite.Run("MoveCircle", "brick_field", field, [&](const BoxBall& p) { return move(p, bricks); }, (int)bricks.size());
+	suite.Run("MoveCircle", "corridor", bouncing, [&](const BoxBall& p) { return move(p, corridor); }, (int)corridor.size());
+}
+
+// -----------------------------------------------------
+// The batched box / circle test at each instruction set, per call
+//
+static void BatchTests(Suite& suite, Random& random)
+{
+	static const char* workloads[3][2] = {
+		{ "scalar_48", "scalar_4096" },
+		{ "sse2_48", "sse2_4096" },
+		{ "avx2_48", "avx2_4096" } };
+	const int sizes[] = { 48, 4096 };
+
+	for (int s = 0; s < 2; s++)
+	{
+		int size = sizes[s];
+		std::vector<float> centerX, centerY, extentX, extentY;
+		for (int i = 0; i < size; i++)
+		{
+			Box2D box = random.Box();
+			centerX.push_back(box.center.x);
+			centerY.push_back(box.center.y);
+			extentX.push_back(box.extents.x);
+			extentY.push_back(box.extents.y);
+		}
+		BoxArray2D boxes(centerX.data(), centerY.data(), extentX.data(), extentY.data(), size);
+		std::vector<unsigned int> mask((size + 31) / 32);
+
+		// a handful of balls, each op tests one ball against every box
+		std::vector<Circle> balls;
+		for (int i = 0; i < 64; i++)
+			balls.push_back(random.Ball());
+
+		for (int level = Collision2D::SimdScalar; level <= Collision2D::GetSimdLevel(); level++)
+		{
+			suite.Run("BoxCircleCheckBatch", workloads[level][s], balls, [&](const Circle& ball)
+			{
+				return Collision2D::BoxCircleCheckBatch(boxes, ball, mask.data(), (Collision2D::SimdLevel)level) > 0 ? 1 : 0;
+			}, size);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	Suite suite;
+	suite.seed = 9201;
+	suite.minTime = 0.1;
+	const char* outPath = nullptr;
+
+	for (int a = 1; a < argc; a++)
+	{
+		if (strncmp(argv[a], "--seed=", 7) == 0)
+			suite.seed = (unsigned int)strtoul(argv[a] + 7, nullptr, 10);
+		else if (strncmp(argv[a], "--min-time=", 11) == 0)
+			suite.minTime = atof(argv[a] + 11);
+		else if (strncmp(argv[a], "--filter=", 9) == 0)
+			suite.filter = argv[a] + 9;
+		else if (strncmp(argv[a], "--out=", 6) == 0)
+			outPath = argv[a] + 6;
+		else
+		{
+			fprintf(stderr, "usage: %s [--seed=N] [--min-time=S] [--filter=TEXT] [--out=FILE]\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// each group gets its own generator, so filtering one out doesn't change the others' inputs
+	Random boxBox(suite.seed), boxCircle(suite.seed + 1), circleCircle(suite.seed + 2), lineLine(suite.seed + 3);
+	Random moving(suite.seed + 4), circleContact(suite.seed + 5), obb(suite.seed + 6), moveCircle(suite.seed + 7), batch(suite.seed + 8);
+
+	BoxBoxTests(suite, boxBox);
+	BoxCircleTests(suite, boxCircle);
+	CircleCircleTests(suite, circleCircle);
+	LineLineTests(suite, lineLine);
+	MovingBallTests(suite, moving);
+	CircleContactTests(suite, circleContact);
+	OBBTests(suite, obb);
+	MoveCircleTests(suite, moveCircle);
+	BatchTests(suite, batch);
+
+	FILE* file = stdout;
+	if (outPath)
+	{
+		file = fopen(outPath, "w");
+		if (!file)
+		{
+			fprintf(stderr, "can't write %s\n", outPath);
+			return 1;
+		}
+	}
+
+	suite.WriteJson(file);
+
+	if (file != stdout)
+		fclose(file);
+
+	return 0;
+}
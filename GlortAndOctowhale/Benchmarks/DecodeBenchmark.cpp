@@ -0,0 +1,249 @@
+//
+// Decode benchmark
+//		Times PngCodec::Decode over the shipped textures at each SIMD level, with and
+//		without premultiplying, and checks every level gives the same pixels. Then times
+//		the same images coming back out of a DecodeCache, against a memcpy of the pixels.
+//
+//	usage: DecodeBenchmark [textures directory, ../Textures by default]
+//
+//	Builds without the Windows SDK, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../Win32GraphicsProject DecodeBenchmark.cpp ../Win32GraphicsProject/PngCodec.cpp
+//			../Win32GraphicsProject/Zlib.cpp ../Win32GraphicsProject/DecodeCache.cpp -o DecodeBenchmark
+//
+
+#include "PngCodec.h"
+#include "DecodeCache.h"
+#include "Zlib.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+using Clock = std::chrono::steady_clock;
+
+// stops the compiler throwing away results we never look at
+static volatile uint32_t sink;
+
+struct TestFile
+{
+	std::string				name;
+	std::vector<uint8_t>	data;
+	std::vector<uint8_t>	compressed;		// the IDAT chunks, to time inflate on its own
+	size_t					rawSize;
+};
+
+static bool ReadFile(const std::string& path, std::vector<uint8_t>& data)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	uint8_t buffer[65536];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + n);
+	}
+	fclose(file);
+	return true;
+}
+
+// pull the image data out of a PNG, so the inflate part can be timed by itself
+static void CollectIdat(TestFile& file)
+{
+	const uint8_t* p = file.data.data();
+	size_t pos = 8;
+	while (pos + 12 <= file.data.size())
+	{
+		uint32_t length = ((uint32_t)p[pos] << 24) | ((uint32_t)p[pos + 1] << 16) | ((uint32_t)p[pos + 2] << 8) | p[pos + 3];
+		if (memcmp(p + pos + 4, "IDAT", 4) == 0)
+			file.compressed.insert(file.compressed.end(), p + pos + 8, p + pos + 8 + length);
+		pos += length + 12;
+	}
+
+	std::vector<uint8_t> raw;
+	Zlib::Inflate(file.compressed.data(), file.compressed.size(), raw);
+	file.rawSize = raw.size();
+}
+
+// -----------------------------------------------------
+// Runs test for at least minSeconds and returns ms per call
+//
+template <typename Test>
+static double TimeMs(Test test, double minSeconds = 0.2)
+{
+	long long calls = 0;
+	Clock::time_point start = Clock::now();
+	double elapsed = 0.0;
+
+	do
+	{
+		test();
+		calls++;
+		elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+	} while (elapsed < minSeconds);
+
+	return elapsed * 1000.0 / (double)calls;
+}
+
+int main(int argc, char* argv[])
+{
+	std::string directory = argc > 1 ? argv[1] : "../Textures";
+	const char* levelNames[] = { "scalar", "sse2", "avx2" };
+
+	std::vector<TestFile> files;
+	std::error_code ec;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
+	{
+		if (entry.path().extension() != ".png")
+			continue;
+
+		TestFile file;
+		file.name = entry.path().filename().string();
+		if (!ReadFile(entry.path().string(), file.data))
+			continue;
+		CollectIdat(file);
+		files.push_back(file);
+	}
+	if (files.empty())
+	{
+		printf("no PNGs in %s\n", directory.c_str());
+		return 1;
+	}
+	std::sort(files.begin(), files.end(), [](const TestFile& a, const TestFile& b) { return a.name < b.name; });
+
+	// starts empty, so the first decode of each file is a miss that stores it
+	std::string cacheDirectory = (std::filesystem::temp_directory_path() / "DecodeBenchmarkCache").string();
+	std::filesystem::remove_all(cacheDirectory, ec);
+	if (!DecodeCache::SetDirectory(std::wstring(cacheDirectory.begin(), cacheDirectory.end()).c_str()))
+	{
+		printf("can't make %s\n", cacheDirectory.c_str());
+		return 1;
+	}
+
+	printf("best simd level: %s\n\n", levelNames[PngCodec::GetSimdLevel()]);
+	printf("%-30s %10s %10s %10s %10s %10s %12s %10s %10s %10s\n", "file", "pixels", "inflate ms", "scalar ms", "sse2 ms", "avx2 ms", "premult ms",
+		"store ms", "cached ms", "memcpy ms");
+
+	double total[8] = { 0.0 };
+	size_t totalPixels = 0;
+
+	for (const TestFile& file : files)
+	{
+		// every level, premultiplied or not, has to match the scalar decode
+		ImageRGBA reference;
+		std::string error;
+		if (!PngCodec::Decode(file.data.data(), file.data.size(), reference, &error, false, PngCodec::SimdScalar))
+		{
+			printf("%s: %s\n", file.name.c_str(), error.c_str());
+			return 1;
+		}
+		ImageRGBA premultiplied = reference;
+		PngCodec::Premultiply(premultiplied);
+
+		for (int level = PngCodec::SimdScalar; level <= PngCodec::GetSimdLevel(); level++)
+		{
+			for (int premultiply = 0; premultiply < 2; premultiply++)
+			{
+				ImageRGBA image;
+				PngCodec::Decode(file.data.data(), file.data.size(), image, nullptr, premultiply != 0, (PngCodec::SimdLevel)level);
+				if (image.pixels != (premultiply ? premultiplied.pixels : reference.pixels))
+				{
+					printf("mismatch: %s %s%s\n", file.name.c_str(), levelNames[level], premultiply ? " premultiplied" : "");
+					return 1;
+				}
+			}
+		}
+
+		double times[8] = { 0.0 };
+
+		times[0] = TimeMs([&]()
+		{
+			std::vector<uint8_t> raw;
+			raw.reserve(file.rawSize);
+			Zlib::Inflate(file.compressed.data(), file.compressed.size(), raw, file.rawSize);
+			sink = raw.back();
+		});
+
+		for (int level = PngCodec::SimdScalar; level <= PngCodec::GetSimdLevel(); level++)
+		{
+			times[1 + level] = TimeMs([&]()
+			{
+				ImageRGBA image;
+				PngCodec::Decode(file.data.data(), file.data.size(), image, nullptr, false, (PngCodec::SimdLevel)level);
+				sink = image.pixels.back();
+			});
+		}
+
+		times[4] = TimeMs([&]()
+		{
+			ImageRGBA image;
+			PngCodec::Decode(file.data.data(), file.data.size(), image, nullptr, true);
+			sink = image.pixels.back();
+		});
+
+		// premultiplied, like the game loads them. the first one decodes and writes the cache file
+		Clock::time_point storeStart = Clock::now();
+		ImageRGBA stored;
+		bool hit = true;
+		DecodeCache::Decode(file.data.data(), file.data.size(), stored, nullptr, true, &hit);
+		times[5] = std::chrono::duration<double, std::milli>(Clock::now() - storeStart).count();
+
+		ImageRGBA cached;
+		DecodeCache::Decode(file.data.data(), file.data.size(), cached, nullptr, true, &hit);
+		if (!hit || cached.pixels != premultiplied.pixels)
+		{
+			printf("decode cache gave different pixels for %s\n", file.name.c_str());
+			return 1;
+		}
+
+		times[6] = TimeMs([&]()
+		{
+			ImageRGBA image;
+			DecodeCache::Decode(file.data.data(), file.data.size(), image, nullptr, true);
+			sink = image.pixels.back();
+		});
+
+		// the least a second launch could do: copy the pixels once
+		times[7] = TimeMs([&]()
+		{
+			std::vector<uint32_t> copy(premultiplied.pixels.size());
+			memcpy(copy.data(), premultiplied.pixels.data(), copy.size() * 4);
+			sink = copy.back();
+		});
+
+		printf("%-30s %10d %10.3f %10.3f %10.3f %10.3f %12.3f %10.3f %10.3f %10.3f\n", file.name.c_str(), reference.width * reference.height,
+			times[0], times[1], times[2], times[3], times[4], times[5], times[6], times[7]);
+
+		for (int i = 0; i < 8; i++)
+			total[i] += times[i];
+		totalPixels += reference.pixels.size();
+	}
+
+	printf("%-30s %10zu %10.3f %10.3f %10.3f %10.3f %12.3f %10.3f %10.3f %10.3f\n", "total", totalPixels, total[0], total[1], total[2], total[3], total[4],
+		total[5], total[6], total[7]);
+
+	// what's left after inflate is unfiltering and converting, the part SIMD is for
+	int best = PngCodec::GetSimdLevel();
+	printf("\nunfilter + convert: scalar %.2f ms, %s %.2f ms (%.2fx), %.1f Mpixels/s decoded at %s\n",
+		total[1] - total[0], levelNames[best], total[1 + best] - total[0],
+		(total[1] - total[0]) / std::max(total[1 + best] - total[0], 1e-6), totalPixels / (total[1 + best] * 1000.0), levelNames[best]);
+	printf("premultiplying adds %.2f ms over the whole set\n", total[4] - total[1 + best]);
+	printf("from the decode cache: %.2f ms against %.2f ms decoding (%.1fx), %.1fx a memcpy of the pixels. the first run pays %.2f ms to store them\n",
+		total[6], total[4], total[4] / std::max(total[6], 1e-6), total[6] / std::max(total[7], 1e-6), total[5] - total[4]);
+
+	// nothing's too old, so a limit of one byte has to take every file the run stored
+	int pruned = DecodeCache::Prune(1, DecodeCache::MaxAgeDays);
+	if (pruned != (int)files.size() || !std::filesystem::is_empty(cacheDirectory, ec))
+	{
+		printf("pruning the decode cache removed %d files, it should have been all %d\n", pruned, (int)files.size());
+		return 1;
+	}
+
+	std::filesystem::remove_all(cacheDirectory, ec);
+
+	return 0;
+}
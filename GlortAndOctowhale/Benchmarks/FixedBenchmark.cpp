@@ -0,0 +1,200 @@
+//
+// Fixed point benchmark
+//		Times the fixed point collision path against the float one, and prints a checksum of
+//		the fixed point results. Build it with different flags (-O0, -O3 -mfma -ffp-contract=fast,
+//		MSVC /fp:fast ...) and the checksum should never change.
+//
+//	Builds without the Windows SDK, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../Win32GraphicsProject FixedBenchmark.cpp
+//			../Win32GraphicsProject/Collision2D.cpp ../Win32GraphicsProject/FixedCollision2D.cpp -o FixedBenchmark
+//
+
+#include "Collision2D.h"
+#include "FixedCollision2D.h"
+#include <chrono>
+#include <random>
+#include <vector>
+#include <stdio.h>
+
+using Clock = std::chrono::steady_clock;
+
+// stops the compiler throwing away results we never look at
+static volatile float floatSink;
+static volatile int32_t fixedSink;
+
+// -----------------------------------------------------
+// FNV-1a over the raw fixed point values
+//
+static uint64_t HashRaw(uint64_t hash, int32_t raw)
+{
+	for (int b = 0; b < 4; b++)
+	{
+		hash ^= (uint64_t)((raw >> (b * 8)) & 0xff);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+// -----------------------------------------------------
+// A level of bricks and a paddle, plus balls flying about in it
+//
+struct Scene
+{
+	std::vector<Box2D>		boxes;
+	std::vector<FixedBox2D>	fixedBoxes;
+
+	std::vector<Circle>		balls;
+	std::vector<Vector2>	velocities;
+
+	// a random number from 0 up to range, in 1/16ths
+	static float Sixteenths(std::mt19937& rng, int range)
+	{
+		return (float)(rng() % (uint32_t)(range * 16)) * (1.0f / 16.0f);
+	}
+
+	Scene(int numBalls, std::mt19937& rng)
+	{
+		// the brick layout the game uses, 8 x 6
+		for (int y = 0; y < 6; y++)
+		{
+			for (int x = 0; x < 8; x++)
+				boxes.push_back(Box2D(Vector2(160.0f + x * 100.0f, 100.0f + y * 40.0f), Vector2(48.0f, 18.0f)));
+		}
+		boxes.push_back(Box2D(Vector2(512.0f, 700.0f), Vector2(80.0f, 12.0f)));
+
+		for (size_t i = 0; i < boxes.size(); i++)
+			fixedBoxes.push_back(FixedBox2D(boxes[i]));
+
+		// built from the raw generator output in 1/16ths, so every compiler and library makes the same floats
+		for (int i = 0; i < numBalls; i++)
+		{
+			Vector2 position(Sixteenths(rng, 1024), Sixteenths(rng, 768));
+			Vector2 velocity(Sixteenths(rng, 1800) - 900.0f, Sixteenths(rng, 1800) - 900.0f);
+			balls.push_back(Circle(position, 11.5f));
+			velocities.push_back(velocity);
+		}
+	}
+};
+
+int main()
+{
+	const int numBalls = 4096;
+	const int frames = 60;
+	const float deltaTime = 1.0f / 60.0f;
+	const Fixed fixedDeltaTime = Fixed::FromFloat(deltaTime);
+
+	std::mt19937 rng(9201);
+	Scene scene(numBalls, rng);
+
+	// ---- single contacts, every ball against every box ----
+	long long contacts = 0;
+	Clock::time_point start = Clock::now();
+	float floatToi = 0.0f;
+	for (int b = 0; b < numBalls; b++)
+	{
+		Vector2 displacement = scene.velocities[b] * deltaTime;
+		for (size_t i = 0; i < scene.boxes.size(); i++)
+		{
+			Contact2D contact = Collision2D::CircleBoxContact(scene.balls[b], scene.boxes[i], displacement);
+			floatToi += contact.toi;
+			contacts++;
+		}
+	}
+	floatSink = floatToi;
+	double floatContactNs = std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / contacts;
+
+	uint64_t contactHash = 14695981039346656037ull;
+	int disagree = 0;
+	start = Clock::now();
+	for (int b = 0; b < numBalls; b++)
+	{
+		FixedCircle ball(scene.balls[b]);
+		FixedVector2 displacement = ToFixed(scene.velocities[b]) * fixedDeltaTime;
+		for (size_t i = 0; i < scene.fixedBoxes.size(); i++)
+		{
+			FixedContact2D contact = FixedCollision2D::CircleBoxContact(ball, scene.fixedBoxes[i], displacement);
+			contactHash = HashRaw(contactHash, contact.hit ? contact.toi.raw : -1);
+		}
+	}
+	double fixedContactNs = std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / contacts;
+
+	// how often the two agree on hit / miss (they can differ right on the edge)
+	for (int b = 0; b < numBalls; b++)
+	{
+		FixedCircle ball(scene.balls[b]);
+		FixedVector2 displacement = ToFixed(scene.velocities[b]) * fixedDeltaTime;
+		for (size_t i = 0; i < scene.boxes.size(); i++)
+		{
+			bool floatHit = Collision2D::CircleBoxContact(scene.balls[b], scene.boxes[i], scene.velocities[b] * deltaTime).hit;
+			bool fixedHit = FixedCollision2D::CircleBoxContact(ball, scene.fixedBoxes[i], displacement).hit;
+			if (floatHit != fixedHit)
+				disagree++;
+		}
+	}
+
+	// ---- MoveCircle, every ball for a second of game time ----
+	const int maxHits = 8;
+	std::vector<Circle> floatBalls = scene.balls;
+	std::vector<Vector2> floatVelocities = scene.velocities;
+
+	start = Clock::now();
+	for (int f = 0; f < frames; f++)
+	{
+		for (int b = 0; b < numBalls; b++)
+		{
+			SweepHit2D hits[maxHits];
+			int numHits;
+			floatBalls[b].center = Collision2D::MoveCircle(floatBalls[b], floatVelocities[b], deltaTime,
+				scene.boxes.data(), (int)scene.boxes.size(), hits, maxHits, numHits);
+		}
+	}
+	double floatMoveNs = std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / ((double)frames * numBalls);
+
+	std::vector<FixedCircle> fixedBalls;
+	std::vector<FixedVector2> fixedVelocities;
+	for (int b = 0; b < numBalls; b++)
+	{
+		fixedBalls.push_back(FixedCircle(scene.balls[b]));
+		fixedVelocities.push_back(ToFixed(scene.velocities[b]));
+	}
+
+	start = Clock::now();
+	for (int f = 0; f < frames; f++)
+	{
+		for (int b = 0; b < numBalls; b++)
+		{
+			FixedSweepHit2D hits[maxHits];
+			int numHits;
+			fixedBalls[b].center = FixedCollision2D::MoveCircle(fixedBalls[b], fixedVelocities[b], fixedDeltaTime,
+				scene.fixedBoxes.data(), (int)scene.fixedBoxes.size(), hits, maxHits, numHits);
+		}
+	}
+	double fixedMoveNs = std::chrono::duration<double>(Clock::now() - start).count() * 1e9 / ((double)frames * numBalls);
+
+	uint64_t moveHash = 14695981039346656037ull;
+	float maxDrift = 0.0f;
+	for (int b = 0; b < numBalls; b++)
+	{
+		moveHash = HashRaw(moveHash, fixedBalls[b].center.x.raw);
+		moveHash = HashRaw(moveHash, fixedBalls[b].center.y.raw);
+		moveHash = HashRaw(moveHash, fixedVelocities[b].x.raw);
+		moveHash = HashRaw(moveHash, fixedVelocities[b].y.raw);
+
+		float drift = Vector2::Distance(ToVector2(fixedBalls[b].center), floatBalls[b].center);
+		if (drift > maxDrift)
+			maxDrift = drift;
+	}
+	fixedSink = fixedBalls[0].center.x.raw;
+	floatSink = floatBalls[0].center.x;
+
+	printf("%-18s %12s %12s %8s\n", "", "float ns", "fixed ns", "cost");
+	printf("%-18s %12.2f %12.2f %7.2fx\n", "CircleBoxContact", floatContactNs, fixedContactNs, fixedContactNs / floatContactNs);
+	printf("%-18s %12.2f %12.2f %7.2fx\n", "MoveCircle", floatMoveNs, fixedMoveNs, fixedMoveNs / floatMoveNs);
+	printf("\n");
+	printf("contact hit/miss disagreements: %d of %lld\n", disagree, contacts);
+	printf("largest float/fixed position difference after %d frames: %.3f px\n", frames, maxDrift);
+	printf("fixed contact checksum: %016llx\n", (unsigned long long)contactHash);
+	printf("fixed move checksum:    %016llx\n", (unsigned long long)moveHash);
+
+	return 0;
+}
@@ -0,0 +1,316 @@
+//
+// Pack benchmark
+//		Times getting every asset's bytes from loose files against from an AssetPack,
+//		both cold (nothing in the page cache) and warm (everything in it).
+//
+//	usage: PackBenchmark [game directory, .. by default]
+//
+//	The assets are everything in Textures and Font the game could load. Loose loading
+//	is what the game did before packs: for each file a look for a cooked .dds next to
+//	PNGs, then open, read and close. Pack loading opens and maps the pack once, then
+//	looks each name up in its index and reads the bytes where they're mapped, or
+//	inflates them. Packs are written to the temp directory, stored and deflated, so the
+//	two can be compared. Decoding isn't timed, it's the same whichever way the bytes came.
+//
+//	Cold runs drop the files from the page cache first with posix_fadvise, which only
+//	works on file systems that honour it; how much was still cached is printed, and if
+//	it isn't near 0% the cold numbers are really warm ones.
+//
+//	Linux only, for posix_fadvise and mincore:
+//		g++ -O2 -std=c++17 -I../Win32GraphicsProject PackBenchmark.cpp
+//			../Win32GraphicsProject/AssetPack.cpp ../Win32GraphicsProject/Zlib.cpp -o PackBenchmark
+//
+
+#include "AssetPack.h"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+namespace fs = std::filesystem;
+
+// stops the compiler throwing away results we never look at
+static volatile uint32_t sink;
+
+struct Asset
+{
+	std::string	path;		// on disk
+	std::string	name;		// what the game asks for, ..\Textures\start.png
+};
+
+struct LoadResult
+{
+	double	ms;
+	int		fileCalls;		// opens and stats
+	size_t	bytes;
+};
+
+static double Milliseconds(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+static bool ReadFile(const std::string& path, std::vector<uint8_t>& data)
+{
+	FILE* file = fopen(path.c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	uint8_t buffer[65536];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + n);
+	}
+	fclose(file);
+	return true;
+}
+
+// one byte in every 64, so every page is touched without the sum costing much
+static uint32_t Touch(const uint8_t* data, size_t size)
+{
+	uint32_t sum = 0;
+	for (size_t i = 0; i < size; i += 64)
+	{
+		sum += data[i];
+	}
+	return sum;
+}
+
+// -----------------------------------------------------
+// Page cache
+//
+static void Evict(const std::string& path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
+	// pages that haven't been written out yet can't be dropped, and the packs were just written
+	fdatasync(file);
+	posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED);
+	close(file);
+}
+
+// bytes of the file in the page cache
+static size_t Resident(const std::string& path)
+{
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return 0;
+
+	struct stat info;
+	size_t resident = 0;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+	{
+		void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, file, 0);
+		if (view != MAP_FAILED)
+		{
+			long page = sysconf(_SC_PAGESIZE);
+			std::vector<unsigned char> pages((info.st_size + page - 1) / page);
+			if (mincore(view, (size_t)info.st_size, pages.data()) == 0)
+			{
+				for (size_t i = 0; i < pages.size(); i++)
+					resident += (pages[i] & 1) ? (size_t)page : 0;
+			}
+			munmap(view, (size_t)info.st_size);
+		}
+	}
+	close(file);
+	return std::min(resident, (size_t)info.st_size);
+}
+
+// -----------------------------------------------------
+// The two ways of loading
+//
+static LoadResult LoadLoose(const std::vector<Asset>& assets)
+{
+	LoadResult result = { 0.0, 0, 0 };
+	Clock::time_point start = Clock::now();
+
+	uint32_t sum = 0;
+	for (const Asset& asset : assets)
+	{
+		// ResourceCache looks for a cooked version of each PNG
+		if (asset.path.size() > 4 && asset.path.compare(asset.path.size() - 4, 4, ".png") == 0)
+		{
+			struct stat info;
+			sum += stat((asset.path.substr(0, asset.path.size() - 4) + ".dds").c_str(), &info) == 0;
+			result.fileCalls++;
+		}
+
+		std::vector<uint8_t> data;
+		ReadFile(asset.path, data);
+		result.fileCalls++;
+		result.bytes += data.size();
+		sum += Touch(data.data(), data.size());
+	}
+
+	sink = sum;
+	result.ms = Milliseconds(start);
+	return result;
+}
+
+static LoadResult LoadPack(const std::string& packPath, const std::vector<Asset>& assets)
+{
+	LoadResult result = { 0.0, 1, 0 };
+	Clock::time_point start = Clock::now();
+
+	AssetPack pack;
+	if (!pack.Open(packPath.c_str()))
+		return result;
+
+	uint32_t sum = 0;
+	for (const Asset& asset : assets)
+	{
+		if (asset.name.size() > 4 && asset.name.compare(asset.name.size() - 4, 4, ".png") == 0)
+			sum += pack.Find((asset.name.substr(0, asset.name.size() - 4) + ".dds").c_str()) != nullptr;
+
+		const PackEntry* entry = pack.Find(asset.name.c_str());
+		AssetData data;
+		if (entry == nullptr || !pack.Read(*entry, data))
+			continue;
+		result.bytes += data.size;
+		sum += Touch(data.data, data.size);
+	}
+
+	sink = sum;
+	result.ms = Milliseconds(start);
+	return result;
+}
+
+// -----------------------------------------------------
+// Best of a few runs, cold or warm
+//
+template <typename Load>
+static LoadResult Run(Load load, const std::vector<std::string>& files, bool cold, int runs, double* residentPercent)
+{
+	LoadResult best = { 1e30, 0, 0 };
+	size_t resident = 0;
+	size_t total = 0;
+
+	for (int run = 0; run < runs; run++)
+	{
+		if (cold)
+		{
+			for (const std::string& file : files)
+				Evict(file);
+		}
+		for (const std::string& file : files)
+		{
+			resident += Resident(file);
+			total += (size_t)fs::file_size(file);
+		}
+
+		LoadResult r = load();
+		if (r.ms < best.ms)
+			best = r;
+	}
+
+	*residentPercent = total ? 100.0 * resident / total : 0.0;
+	return best;
+}
+
+int main(int argc, char* argv[])
+{
+	fs::path root = argc > 1 ? argv[1] : "..";
+	const char* skip[] = { ".hxl", ".sheet", ".exe" };
+
+	std::vector<Asset> assets;
+	std::vector<PackInput> inputs;
+	std::error_code ec;
+	for (const char* directory : { "Textures", "Font" })
+	{
+		for (const fs::directory_entry& entry : fs::directory_iterator(root / directory, ec))
+		{
+			std::string extension = entry.path().extension().string();
+			if (!entry.is_regular_file() || std::find(skip, skip + 3, extension) != skip + 3)
+				continue;
+
+			Asset asset;
+			asset.path = entry.path().string();
+			asset.name = std::string("..\\") + directory + "\\" + entry.path().filename().string();
+			assets.push_back(asset);
+
+			PackInput input;
+			input.name = asset.name;
+			ReadFile(asset.path, input.data);
+			inputs.push_back(input);
+		}
+	}
+	if (assets.empty())
+	{
+		printf("no assets under %s\n", root.string().c_str());
+		return 1;
+	}
+	std::sort(assets.begin(), assets.end(), [](const Asset& a, const Asset& b) { return a.name < b.name; });
+
+	std::string storedPack = (fs::temp_directory_path() / "PackBenchmark.pack").string();
+	std::string deflatedPack = (fs::temp_directory_path() / "PackBenchmarkDeflated.pack").string();
+	std::string error;
+	if (!AssetPack::Write(storedPack.c_str(), inputs, false, 64, &error) || !AssetPack::Write(deflatedPack.c_str(), inputs, true, 64, &error))
+	{
+		printf("%s\n", error.c_str());
+		return 1;
+	}
+
+	std::vector<std::string> looseFiles;
+	for (const Asset& asset : assets)
+		looseFiles.push_back(asset.path);
+
+	size_t looseBytes = 0;
+	for (const PackInput& input : inputs)
+		looseBytes += input.data.size();
+
+	printf("%d assets, %.1f KB loose, %.1f KB packed, %.1f KB packed and deflated\n\n", (int)assets.size(),
+		looseBytes / 1024.0, fs::file_size(storedPack) / 1024.0, fs::file_size(deflatedPack) / 1024.0);
+
+	printf("%-20s %-6s %10s %12s %10s %12s\n", "load", "cache", "ms", "file calls", "KB", "was cached");
+
+	const int coldRuns = 5;
+	const int warmRuns = 20;
+	for (int cold = 1; cold >= 0; cold--)
+	{
+		double resident[3];
+		LoadResult loose = Run([&]() { return LoadLoose(assets); }, looseFiles, cold != 0, cold ? coldRuns : warmRuns, &resident[0]);
+		LoadResult stored = Run([&]() { return LoadPack(storedPack, assets); }, { storedPack }, cold != 0, cold ? coldRuns : warmRuns, &resident[1]);
+		LoadResult deflated = Run([&]() { return LoadPack(deflatedPack, assets); }, { deflatedPack }, cold != 0, cold ? coldRuns : warmRuns, &resident[2]);
+
+		const char* cache = cold ? "cold" : "warm";
+		printf("%-20s %-6s %10.3f %12d %10.1f %11.0f%%\n", "loose files", cache, loose.ms, loose.fileCalls, loose.bytes / 1024.0, resident[0]);
+		printf("%-20s %-6s %10.3f %12d %10.1f %11.0f%%\n", "pack", cache, stored.ms, stored.fileCalls, stored.bytes / 1024.0, resident[1]);
+		printf("%-20s %-6s %10.3f %12d %10.1f %11.0f%%\n", "pack, deflated", cache, deflated.ms, deflated.fileCalls, deflated.bytes / 1024.0, resident[2]);
+
+		if (loose.bytes != stored.bytes || loose.bytes != deflated.bytes)
+		{
+			printf("the packs didn't give back every byte\n");
+			return 1;
+		}
+	}
+
+	// the index on its own, with everything mapped and cached
+	AssetPack pack;
+	pack.Open(storedPack.c_str());
+	int lookups = 0;
+	Clock::time_point start = Clock::now();
+	uint32_t found = 0;
+	while (Milliseconds(start) < 200.0)
+	{
+		for (const Asset& asset : assets)
+			found += pack.Find(asset.name.c_str()) != nullptr;
+		lookups += (int)assets.size();
+	}
+	sink = found;
+	printf("\nFind: %.0f ns a lookup, name cleaning and hashing included\n", Milliseconds(start) * 1e6 / lookups);
+
+	fs::remove(storedPack, ec);
+	fs::remove(deflatedPack, ec);
+	return 0;
+}
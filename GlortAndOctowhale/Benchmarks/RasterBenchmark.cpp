@@ -0,0 +1,267 @@
+//
+// Raster benchmark
+//		Times SoftwareFramebuffer drawing frames like the game's at each SIMD level, on
+//		one thread and on every core, and checks they all give exactly the same pixels.
+//
+//	usage: RasterBenchmark [-threads n] [-capture directory] [textures directory, ../Textures by default]
+//
+//	The scenes are built from the shipped atlas page, premultiplied as the game loads it:
+//		game		the background, 48 bricks, the paddle, a spinning ball and a few bursts
+//		particles	the background and 100k particles, like ParticleBenchmark
+//		sprites		the background and 2000 bricks scaled, spun and tinted, blended straight
+//					and additive
+//	Each frame is a Blit of the background then Execute, timed on one thread and on
+//	-threads, every core by default. With -capture, the last frame of each scene is
+//	written to the directory as raster_<scene>.png.
+//
+//	Builds without the Windows SDK, e.g. on Linux:
+//		g++ -O2 -std=c++17 -pthread -I../Win32GraphicsProject RasterBenchmark.cpp
+//			../Win32GraphicsProject/SoftwareFramebuffer.cpp ../Win32GraphicsProject/RenderQueue.cpp
+//			../Win32GraphicsProject/ParticleSystem.cpp ../Win32GraphicsProject/TextureAtlas.cpp
+//			../Win32GraphicsProject/PngCodec.cpp ../Win32GraphicsProject/Zlib.cpp -o RasterBenchmark
+//
+
+#include "SoftwareFramebuffer.h"
+#include "ParticleSystem.h"
+#include "TextureAtlas.h"
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using Clock = std::chrono::steady_clock;
+
+static double Milliseconds(Clock::time_point start)
+{
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// the game's window
+static const int screenWidth = 1024;
+static const int screenHeight = 768;
+
+// stand ins for the views, only ever compared
+static ID3D11ShaderResourceView* const pageView = (ID3D11ShaderResourceView*)1;
+
+struct Scene
+{
+	const char*	name;
+	RenderQueue	queue;
+	int			frames;
+};
+
+// xorshift, so every run lays the scenes out the same
+static uint32_t randomState = 0x9e3779b9;
+static float Random()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return (randomState >> 8) * (1.0f / 16777216.0f);
+}
+
+// a sprite from the atlas page, centred on its origin like Sprite draws
+static void AddSprite(RenderQueue& queue, const AtlasRegion& region, int frameX, int frameY, int width, int height,
+	float x, float y, float rotation, float scale, uint32_t color, BlendMode blend)
+{
+	DrawCommand c;
+	c.texture = pageView;
+	c.srcLeft = region.x + frameX;
+	c.srcTop = region.y + frameY;
+	c.srcRight = c.srcLeft + width;
+	c.srcBottom = c.srcTop + height;
+	c.x = x;
+	c.y = y;
+	c.originX = width * 0.5f;
+	c.originY = height * 0.5f;
+	c.rotation = rotation;
+	c.scale = scale;
+	c.color = color;
+	c.layer = 0.5f;
+	queue.Submit(c, blend);
+}
+
+int main(int argc, char* argv[])
+{
+	std::string captureDirectory;
+	std::string textures = "../Textures";
+	int threads = (int)std::thread::hardware_concurrency();
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "-capture") == 0 && i + 1 < argc)
+			captureDirectory = argv[++i];
+		else if (strcmp(argv[i], "-threads") == 0 && i + 1 < argc)
+			threads = atoi(argv[++i]);
+		else
+			textures = argv[i];
+	}
+
+	ImageRGBA background;
+	ImageRGBA page;
+	TextureAtlas atlas;
+	std::string error;
+	if (!PngCodec::Load((textures + "/background.png").c_str(), background, &error) ||
+		!PngCodec::Load((textures + "/gameplay0.png").c_str(), page, &error, true))
+	{
+		printf("can't load the textures from %s: %s\n", textures.c_str(), error.c_str());
+		return 1;
+	}
+	if (!atlas.Load((textures + "/gameplay.atlas").c_str()))
+	{
+		printf("%s\n", atlas.GetError().c_str());
+		return 1;
+	}
+
+	const AtlasRegion* brick = atlas.Find("morloxSpritesheet.png");
+	const AtlasRegion* paddle = atlas.Find("octowhaleSpritesheet.png");
+	const AtlasRegion* ball = atlas.Find("glortSpritesheet.png");
+	const AtlasRegion* particle = atlas.Find("particle.png");
+	if (!brick || !paddle || !ball || !particle)
+	{
+		printf("gameplay.atlas is missing a sprite\n");
+		return 1;
+	}
+
+	Scene scenes[3];
+
+	// the game mid level, laid out like MyProject does it
+	scenes[0].name = "game";
+	scenes[0].frames = 300;
+	{
+		RenderQueue& queue = scenes[0].queue;
+		for (int n = 0; n < 48; n++)
+		{
+			int frame = n % 4;
+			AddSprite(queue, *brick, (frame % 2) * 85, (frame / 2) * 74, 85, 74,
+				180.0f + (n % 8) * 95.0f, 50.0f + (n / 8) * 74.0f, 0.0f, 1.0f, 0xffffffff, BlendAlpha);
+		}
+		AddSprite(queue, *paddle, 0, 0, 379, 63, screenWidth * 0.5f, screenHeight * 0.85f, 0.0f, 1.0f, 0xffffffff, BlendAlpha);
+		AddSprite(queue, *ball, 0, 0, 72, 70, screenWidth * 0.5f, screenHeight * 0.65f, 0.7f, 1.3f, 0xffffffff, BlendAlpha);
+
+		ParticleEmitter burst = { 80, 40.0f, 220.0f, 0.0f, 3.141592f, 0.4f, 0.9f, 1.0f, 3.0f, 0xff9ed2f0 };
+		ParticleSystem particles;
+		particles.Initialize(1000);
+		particles.SetTexture(pageView, particle->width, particle->height, particle->x, particle->y);
+		for (int f = 0; f < 20; f++)
+		{
+			if (f % 4 == 0)
+				particles.Emit(burst, Vector2(275.0f + f * 30.0f, 200.0f));
+			particles.Update(1.0f / 60.0f);
+		}
+		particles.Draw(&queue, 0.0f, BlendAlpha);
+		queue.Sort();
+	}
+
+	// a screen full of particles
+	scenes[1].name = "particles";
+	scenes[1].frames = 30;
+	{
+		ParticleEmitter burst = { 2000, 20.0f, 200.0f, 0.0f, 3.141592f, 0.5f, 1.17f, 1.0f, 3.0f, 0xffffffff };
+		ParticleSystem particles;
+		particles.Initialize(100000);
+		particles.SetGravity(Vector2(0, 300));
+		particles.SetDrag(1.0f);
+		particles.SetTexture(pageView, particle->width, particle->height, particle->x, particle->y);
+		for (int f = 0; f < 120; f++)
+		{
+			particles.Emit(burst, Vector2(screenWidth * 0.5f + (f % 7) * 30.0f, screenHeight * 0.5f));
+			particles.Update(1.0f / 60.0f);
+		}
+		while (particles.GetCount() < 100000 && particles.Emit(burst, Vector2(screenWidth * 0.5f, screenHeight * 0.5f)) > 0)
+		{
+		}
+		particles.Draw(&scenes[1].queue, 0.0f, BlendAlpha);
+		scenes[1].queue.Sort();
+	}
+
+	// big, overlapping and none of them axis aligned
+	scenes[2].name = "sprites";
+	scenes[2].frames = 30;
+	{
+		RenderQueue& queue = scenes[2].queue;
+		for (int n = 0; n < 2000; n++)
+		{
+			uint32_t tint = DrawCommand::PackColor(0.5f + Random() * 0.5f, 0.5f + Random() * 0.5f, 0.5f + Random() * 0.5f, 0.4f + Random() * 0.6f);
+			AddSprite(queue, *brick, 0, 0, 85, 74, Random() * screenWidth, Random() * screenHeight,
+				Random() * 6.283185f, 0.5f + Random() * 1.5f, tint, n % 5 == 0 ? BlendAdditive : BlendNonPremultiplied);
+		}
+		queue.Sort();
+	}
+
+	const SoftwareFramebuffer::SimdLevel levels[3] = { SoftwareFramebuffer::SimdScalar, SoftwareFramebuffer::SimdSSE2, SoftwareFramebuffer::SimdAVX2 };
+	const char* levelNames[3] = { "scalar", "SSE2", "AVX2" };
+	int levelCount = SoftwareFramebuffer::GetSimdLevel() + 1;
+
+	if (threads < 1)
+		threads = 1;
+	int threadCounts[2] = { 1, threads };
+	int threadCountCount = threads > 1 ? 2 : 1;
+
+	printf("%dx%d, %d cores\n\n", screenWidth, screenHeight, (int)std::thread::hardware_concurrency());
+	printf("%-10s %8s %8s %8s %10s %10s %12s %10s  %s\n", "scene", "draws", "level", "threads", "ms/frame", "Mpixel/s",
+		"vs scalar x1", "fps", "checksum");
+
+	bool same = true;
+	for (Scene& scene : scenes)
+	{
+		uint64_t reference = 0;
+		double referenceMs = 0.0;
+
+		for (int t = 0; t < threadCountCount; t++)
+		{
+			SoftwareFramebuffer framebuffer(threadCounts[t]);
+			framebuffer.Resize(screenWidth, screenHeight);
+			framebuffer.SetTexture(pageView, &page);
+
+			for (int l = 0; l < levelCount; l++)
+			{
+				framebuffer.SetSimdLevel(levels[l]);
+
+				// one to warm up, then the best of the rest so a context switch doesn't count
+				double best = 1e30;
+				for (int f = 0; f <= scene.frames; f++)
+				{
+					Clock::time_point start = Clock::now();
+					framebuffer.Blit(background, 0, 0);
+					framebuffer.Execute(scene.queue);
+					double ms = Milliseconds(start);
+					if (f > 0 && ms < best)
+						best = ms;
+				}
+
+				uint64_t checksum = framebuffer.GetChecksum();
+				if (t == 0 && l == 0)
+				{
+					reference = checksum;
+					referenceMs = best;
+
+					if (!captureDirectory.empty())
+					{
+						std::string file = captureDirectory + "/raster_" + scene.name + ".png";
+						if (!framebuffer.SaveCapture(file.c_str()))
+							printf("can't write %s\n", file.c_str());
+					}
+				}
+
+				double pixels = (double)framebuffer.GetLastPixelCount() + (double)screenWidth * screenHeight;
+				printf("%-10s %8d %8s %8d %10.3f %10.0f %11.1fx %10.0f  %016llx%s\n", scene.name, framebuffer.GetLastDrawCount(),
+					levelNames[l], framebuffer.GetThreadCount(), best, pixels / best / 1000.0, referenceMs / best, 1000.0 / best,
+					(unsigned long long)checksum, checksum == reference ? "" : "  DIFFERENT");
+
+				same = same && checksum == reference;
+			}
+		}
+		printf("\n");
+	}
+
+	if (!same)
+	{
+		printf("some levels or thread counts gave different pixels\n");
+		return 1;
+	}
+	printf("every level and thread count gave the same pixels\n");
+	return 0;
+}
@@ -0,0 +1,176 @@
+//
+// AssetPacker
+//		Writes files into one AssetPack the game maps at startup
+//
+//	usage: AssetPacker [-compress] [-align bytes] [-skip .ext ...] out.pack root path [path ...]
+//
+//	Each path is a file or a directory under root, and directories are packed with
+//	everything under them. Files are named by their path from root, so for the game,
+//	from the GlortAndOctowhale directory:
+//		AssetPacker -skip .hxl -skip .sheet -skip .exe assets.pack . Textures Font
+//	packs Textures\start.png as "textures\start.png", which is what the game's
+//	"..\Textures\start.png" looks up. -skip leaves out files with that extension, for
+//	working files the game never loads.
+//
+//	With -compress, files that deflate to at least an eighth smaller are stored
+//	compressed; the rest stay as they are so they can be read with no copy. That about
+//	halves the game's pack, mostly the cooked DDS and the fonts, but inflating costs more
+//	than reading the extra bytes from anything but a slow disk (see PackBenchmark), so
+//	it's for when the size matters more. Blobs start on multiples of -align bytes, 64 by
+//	default. The pack is read back and checked against the files before it's reported.
+//
+//	Builds anywhere, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../../Win32GraphicsProject AssetPacker.cpp
+//			../../Win32GraphicsProject/AssetPack.cpp ../../Win32GraphicsProject/Zlib.cpp -o AssetPacker
+//
+
+#include "AssetPack.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace fs = std::filesystem;
+
+static bool ReadFile(const fs::path& path, std::vector<uint8_t>& data)
+{
+	FILE* file = fopen(path.string().c_str(), "rb");
+	if (file == nullptr)
+		return false;
+
+	uint8_t buffer[65536];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + n);
+	}
+	fclose(file);
+	return true;
+}
+
+static std::string Lower(std::string text)
+{
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		text[i] = (char)tolower((unsigned char)text[i]);
+	}
+	return text;
+}
+
+int main(int argc, char* argv[])
+{
+	bool compress = false;
+	int alignment = 64;
+	std::vector<std::string> skip;
+
+	int arg = 1;
+	bool usage = false;
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		if (strcmp(argv[arg], "-compress") == 0)
+			compress = true;
+		else if (strcmp(argv[arg], "-align") == 0 && arg + 1 < argc)
+			alignment = atoi(argv[++arg]);
+		else if (strcmp(argv[arg], "-skip") == 0 && arg + 1 < argc)
+			skip.push_back(Lower(argv[++arg]));
+		else
+			usage = true;
+		arg++;
+	}
+
+	if (usage || arg + 2 >= argc)
+	{
+		fprintf(stderr, "usage: %s [-compress] [-align bytes] [-skip .ext ...] out.pack root path [path ...]\n", argv[0]);
+		return 1;
+	}
+
+	const char* outFile = argv[arg++];
+	fs::path root = argv[arg++];
+
+	// every file under the paths, by name so the pack is the same each time
+	std::vector<fs::path> files;
+	for (; arg < argc; arg++)
+	{
+		fs::path path = root / argv[arg];
+		std::error_code ec;
+		if (fs::is_directory(path, ec))
+		{
+			for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path, ec))
+			{
+				if (entry.is_regular_file())
+					files.push_back(entry.path());
+			}
+		}
+		else if (fs::is_regular_file(path, ec))
+		{
+			files.push_back(path);
+		}
+		else
+		{
+			fprintf(stderr, "%s: not found\n", path.string().c_str());
+			return 1;
+		}
+	}
+
+	std::vector<PackInput> inputs;
+	for (const fs::path& file : files)
+	{
+		if (std::find(skip.begin(), skip.end(), Lower(file.extension().string())) != skip.end())
+			continue;
+
+		PackInput input;
+		input.name = AssetPack::MakeName(file.lexically_relative(root).string().c_str());
+		if (!ReadFile(file, input.data))
+		{
+			fprintf(stderr, "%s: can't read it\n", file.string().c_str());
+			return 1;
+		}
+		inputs.push_back(input);
+	}
+	std::sort(inputs.begin(), inputs.end(), [](const PackInput& a, const PackInput& b) { return a.name < b.name; });
+
+	std::string error;
+	if (!AssetPack::Write(outFile, inputs, compress, alignment, &error))
+	{
+		fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	// read it back the way the game does, and check every file came through
+	AssetPack pack;
+	if (!pack.Open(outFile) || !pack.Verify(&error))
+	{
+		fprintf(stderr, "%s: %s\n", outFile, error.empty() ? "can't read it back" : error.c_str());
+		return 1;
+	}
+
+	printf("%-48s %10s %10s\n", "name", "bytes", "stored");
+	size_t totalBytes = 0;
+	size_t totalStored = 0;
+	int compressedCount = 0;
+	for (const PackInput& input : inputs)
+	{
+		const PackEntry* entry = pack.Find(input.name.c_str());
+		AssetData data;
+		if (entry == nullptr || !pack.Read(*entry, data) || data.size != input.data.size() ||
+			memcmp(data.data, input.data.data(), data.size) != 0)
+		{
+			fprintf(stderr, "%s doesn't match what was packed\n", input.name.c_str());
+			return 1;
+		}
+
+		bool compressed = (entry->flags & AssetPack::FlagCompressed) != 0;
+		printf("%-48s %10zu %10llu%s\n", input.name.c_str(), input.data.size(), (unsigned long long)entry->storedSize,
+			compressed ? "  deflated" : "");
+
+		totalBytes += input.data.size();
+		totalStored += (size_t)entry->storedSize;
+		compressedCount += compressed ? 1 : 0;
+	}
+
+	printf("\n%d files, %d deflated, %.1f KB in %.1f KB of blobs, %.1f KB pack\n", (int)inputs.size(), compressedCount,
+		totalBytes / 1024.0, totalStored / 1024.0, pack.GetFileSize() / 1024.0);
+
+	return 0;
+}
@@ -0,0 +1,234 @@
+//
+// AtlasPacker
+//		Packs PNGs into as few atlas pages as it can and writes a region manifest
+//
+//	usage: AtlasPacker [-max size] [-padding pixels] out.atlas in.png [in.png ...]
+//
+//	Pages are written next to the manifest as out0.png, out1.png, ... Each page is the
+//	smallest power of two size that takes everything left (up to -max, 2048 by default);
+//	whatever doesn't fit goes on the next page. Regions are named after the file they
+//	came from, so the game can ask for the file and get the region.
+//
+//	Builds anywhere, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../../Win32GraphicsProject AtlasPacker.cpp MaxRectsPacker.cpp
+//			../../Win32GraphicsProject/TextureAtlas.cpp ../../Win32GraphicsProject/PngCodec.cpp
+//			../../Win32GraphicsProject/Zlib.cpp -o AtlasPacker
+//
+
+#include "MaxRectsPacker.h"
+#include "TextureAtlas.h"
+#include "PngCodec.h"
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct InputImage
+{
+	std::string	name;		// file name without the directory
+	ImageRGBA	image;
+	bool		packed;
+};
+
+static std::string FileName(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// -----------------------------------------------------
+// Try to pack every image in order into a width * height page. with all set it only
+//	succeeds if everything fits, otherwise it takes what it can
+//
+static bool PackPage(std::vector<InputImage>& inputs, const std::vector<int>& order, int width, int height, int padding,
+	bool all, std::vector<MaxRectsPacker::Rect>& placed, std::vector<int>& which)
+{
+	// the padding goes after each image, so the bin is a padding bigger to not waste the far edges
+	MaxRectsPacker packer;
+	packer.Reset(width + padding, height + padding);
+
+	placed.clear();
+	which.clear();
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		InputImage& input = inputs[order[i]];
+		if (input.packed)
+			continue;
+
+		MaxRectsPacker::Rect r;
+		if (packer.Insert(input.image.width + padding, input.image.height + padding, r))
+		{
+			r.width = input.image.width;
+			r.height = input.image.height;
+			placed.push_back(r);
+			which.push_back(order[i]);
+		}
+		else if (all)
+		{
+			return false;
+		}
+	}
+	return !placed.empty();
+}
+
+int main(int argc, char* argv[])
+{
+	int maxSize = 2048;
+	int padding = 2;
+
+	int arg = 1;
+	while (arg + 1 < argc && argv[arg][0] == '-')
+	{
+		if (strcmp(argv[arg], "-max") == 0)
+			maxSize = atoi(argv[arg + 1]);
+		else if (strcmp(argv[arg], "-padding") == 0)
+			padding = atoi(argv[arg + 1]);
+		else
+			break;
+		arg += 2;
+	}
+
+	if (argc - arg < 2 || maxSize <= 0 || padding < 0)
+	{
+		fprintf(stderr, "usage: %s [-max size] [-padding pixels] out.atlas in.png [in.png ...]\n", argv[0]);
+		return 1;
+	}
+
+	std::string manifestPath = argv[arg++];
+
+	// read everything first, so a bad file stops it before anything is written
+	std::vector<InputImage> inputs;
+	for (; arg < argc; arg++)
+	{
+		InputImage input;
+		std::string error;
+		if (!PngCodec::Load(argv[arg], input.image, &error))
+		{
+			fprintf(stderr, "%s: %s\n", argv[arg], error.c_str());
+			return 1;
+		}
+		if (input.image.width > maxSize || input.image.height > maxSize)
+		{
+			fprintf(stderr, "%s: %dx%d won't fit on a %d page\n", argv[arg], input.image.width, input.image.height, maxSize);
+			return 1;
+		}
+		input.name = FileName(argv[arg]);
+		input.packed = false;
+		inputs.push_back(input);
+	}
+
+	// biggest side first packs tightest
+	std::vector<int> order(inputs.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = (int)i;
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b)
+	{
+		const ImageRGBA& ia = inputs[a].image;
+		const ImageRGBA& ib = inputs[b].image;
+		return std::max(ia.width, ia.height) > std::max(ib.width, ib.height);
+	});
+
+	// every power of two page up to the max, smallest first, wide before tall
+	std::vector<std::pair<int, int>> sizes;
+	for (int w = 1; w <= maxSize; w *= 2)
+	{
+		for (int h = std::max(1, w / 2); h <= w * 2 && h <= maxSize; h *= 2)
+			sizes.push_back(std::make_pair(w, h));
+	}
+	std::stable_sort(sizes.begin(), sizes.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b)
+	{
+		return (size_t)a.first * a.second < (size_t)b.first * b.second;
+	});
+
+	std::string directory = manifestPath.substr(0, manifestPath.size() - FileName(manifestPath).size());
+	std::string baseName = FileName(manifestPath);
+	size_t dot = baseName.rfind('.');
+	if (dot != std::string::npos)
+		baseName.erase(dot);
+
+	TextureAtlas atlas;
+	size_t imageArea = 0;
+	size_t pageArea = 0;
+	size_t left = inputs.size();
+
+	while (left > 0)
+	{
+		std::vector<MaxRectsPacker::Rect> placed;
+		std::vector<int> which;
+		int width = maxSize, height = maxSize;
+
+		bool fitted = false;
+		for (size_t s = 0; s < sizes.size() && !fitted; s++)
+		{
+			if (PackPage(inputs, order, sizes[s].first, sizes[s].second, padding, true, placed, which))
+			{
+				width = sizes[s].first;
+				height = sizes[s].second;
+				fitted = true;
+			}
+		}
+		if (!fitted)
+			PackPage(inputs, order, maxSize, maxSize, padding, false, placed, which);
+
+		int pageIndex = (int)atlas.GetPageCount();
+		std::string pageName = baseName + std::to_string(pageIndex) + ".png";
+
+		ImageRGBA page;
+		page.Resize(width, height);
+
+		size_t used = 0;
+		for (size_t i = 0; i < placed.size(); i++)
+		{
+			InputImage& input = inputs[which[i]];
+			const MaxRectsPacker::Rect& r = placed[i];
+			for (int y = 0; y < r.height; y++)
+			{
+				memcpy(page.Row(r.y + y) + r.x, input.image.Row(y), r.width * 4);
+			}
+
+			AtlasRegion region;
+			region.name = input.name;
+			region.page = pageIndex;
+			region.x = r.x;
+			region.y = r.y;
+			region.width = r.width;
+			region.height = r.height;
+			atlas.AddRegion(region);
+
+			input.packed = true;
+			used += (size_t)r.width * r.height;
+			left--;
+		}
+
+		atlas.AddPage(pageName, width, height);
+		if (!PngCodec::Save((directory + pageName).c_str(), page))
+		{
+			fprintf(stderr, "%s: can't write it\n", (directory + pageName).c_str());
+			return 1;
+		}
+
+		printf("%s: %dx%d, %d images, %.1f%% used\n", pageName.c_str(), width, height, (int)placed.size(),
+			100.0 * used / ((double)width * height));
+
+		imageArea += used;
+		pageArea += (size_t)width * height;
+	}
+
+	if (!atlas.Save(manifestPath.c_str()))
+	{
+		fprintf(stderr, "%s: can't write it\n", manifestPath.c_str());
+		return 1;
+	}
+
+	// read it back, so a broken writer can't get past here
+	TextureAtlas check;
+	if (!check.Load(manifestPath.c_str()) || check.GetRegionCount() != (int)inputs.size())
+	{
+		fprintf(stderr, "%s: doesn't read back the same\n", manifestPath.c_str());
+		return 1;
+	}
+
+	printf("%s: %d images on %d pages, packing ratio %.1f%%\n", manifestPath.c_str(), (int)inputs.size(), atlas.GetPageCount(),
+		100.0 * imageArea / (double)pageArea);
+	return 0;
+}
@@ -0,0 +1,145 @@
+//
+// MaxRectsPacker
+//		Packs rectangles into a fixed size bin, MaxRects with best short side fit
+//
+
+#include "MaxRectsPacker.h"
+#include <limits.h>
+
+static bool Contains(const MaxRectsPacker::Rect& outer, const MaxRectsPacker::Rect& inner)
+{
+	return inner.x >= outer.x && inner.y >= outer.y &&
+		inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+}
+
+void MaxRectsPacker::Reset(int width, int height)
+{
+	binWidth = width;
+	binHeight = height;
+	usedArea = 0;
+
+	Rect all = { 0, 0, width, height };
+	freeRects.clear();
+	freeRects.push_back(all);
+}
+
+// -----------------------------------------------------
+// Place one rect
+//
+bool MaxRectsPacker::Insert(int width, int height, Rect& placed)
+{
+	int bestShort = INT_MAX;
+	int bestLong = INT_MAX;
+	int best = -1;
+
+	for (size_t i = 0; i < freeRects.size(); i++)
+	{
+		const Rect& f = freeRects[i];
+		if (f.width < width || f.height < height)
+			continue;
+
+		int leftoverX = f.width - width;
+		int leftoverY = f.height - height;
+		int shortSide = leftoverX < leftoverY ? leftoverX : leftoverY;
+		int longSide = leftoverX < leftoverY ? leftoverY : leftoverX;
+
+		if (shortSide < bestShort || (shortSide == bestShort && longSide < bestLong))
+		{
+			bestShort = shortSide;
+			bestLong = longSide;
+			best = (int)i;
+		}
+	}
+
+	if (best < 0)
+		return false;
+
+	placed.x = freeRects[best].x;
+	placed.y = freeRects[best].y;
+	placed.width = width;
+	placed.height = height;
+
+	// split everything the new rect overlaps. the new pieces go on the end and don't
+	//	overlap it, so only the rects that were there to start with need checking
+	size_t count = freeRects.size();
+	for (size_t i = 0; i < count; i++)
+	{
+		if (SplitFree(freeRects[i], placed))
+			freeRects[i].width = 0;		// split up, drop it below
+	}
+
+	size_t kept = 0;
+	for (size_t i = 0; i < freeRects.size(); i++)
+	{
+		if (freeRects[i].width > 0)
+			freeRects[kept++] = freeRects[i];
+	}
+	freeRects.resize(kept);
+	Prune();
+
+	usedArea += (size_t)width * height;
+	return true;
+}
+
+// -----------------------------------------------------
+// Up to four free rects are left around the used one
+//
+bool MaxRectsPacker::SplitFree(const Rect& free, const Rect& used)
+{
+	if (used.x >= free.x + free.width || used.x + used.width <= free.x ||
+		used.y >= free.y + free.height || used.y + used.height <= free.y)
+		return false;
+
+	Rect f = free;	// free may be about to move as the list grows
+
+	if (used.y > f.y)
+	{
+		Rect above = { f.x, f.y, f.width, used.y - f.y };
+		freeRects.push_back(above);
+	}
+	if (used.y + used.height < f.y + f.height)
+	{
+		Rect below = { f.x, used.y + used.height, f.width, f.y + f.height - (used.y + used.height) };
+		freeRects.push_back(below);
+	}
+	if (used.x > f.x)
+	{
+		Rect left = { f.x, f.y, used.x - f.x, f.height };
+		freeRects.push_back(left);
+	}
+	if (used.x + used.width < f.x + f.width)
+	{
+		Rect right = { used.x + used.width, f.y, f.x + f.width - (used.x + used.width), f.height };
+		freeRects.push_back(right);
+	}
+	return true;
+}
+
+void MaxRectsPacker::Prune()
+{
+	for (size_t i = 0; i < freeRects.size(); i++)
+	{
+		for (size_t j = i + 1; j < freeRects.size(); )
+		{
+			if (Contains(freeRects[j], freeRects[i]))
+			{
+				freeRects.erase(freeRects.begin() + i);
+				i--;
+				break;
+			}
+			if (Contains(freeRects[i], freeRects[j]))
+			{
+				freeRects.erase(freeRects.begin() + j);
+				continue;
+			}
+			j++;
+		}
+	}
+}
+
+float MaxRectsPacker::GetOccupancy() const
+{
+	if (binWidth == 0 || binHeight == 0)
+		return 0.0f;
+	return (float)usedArea / ((float)binWidth * binHeight);
+}
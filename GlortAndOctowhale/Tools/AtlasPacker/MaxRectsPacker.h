@@ -0,0 +1,49 @@
+//
+// MaxRectsPacker
+//		Packs rectangles into a fixed size bin, MaxRects with best short side fit
+//
+//	Keeps a list of every maximal free rectangle. Each new rect goes in the free
+//	rectangle it fits most snugly (smallest leftover on its shorter side), then every
+//	free rectangle it overlaps is split around it and any free rectangle inside another
+//	is thrown away. Rects are never rotated, sprites can't draw rotated regions.
+//
+
+#ifndef _MAX_RECTS_PACKER_H
+#define _MAX_RECTS_PACKER_H
+
+#include <stddef.h>
+#include <vector>
+
+class MaxRectsPacker
+{
+public:
+	struct Rect
+	{
+		int	x, y, width, height;
+	};
+
+	MaxRectsPacker() : binWidth(0), binHeight(0), usedArea(0) {}
+
+	// start again with an empty bin
+	void Reset(int width, int height);
+
+	// find a place for a width * height rect. false if it won't fit
+	bool Insert(int width, int height, Rect& placed);
+
+	// fraction of the bin that's been used
+	float GetOccupancy() const;
+
+private:
+	// split free around used, adding the pieces to the free list. false if they don't touch
+	bool SplitFree(const Rect& free, const Rect& used);
+
+	// remove free rectangles that are inside another
+	void Prune();
+
+	int					binWidth;
+	int					binHeight;
+	size_t				usedArea;
+	std::vector<Rect>	freeRects;
+};
+
+#endif // _MAX_RECTS_PACKER_H
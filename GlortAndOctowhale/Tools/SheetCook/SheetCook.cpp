@@ -0,0 +1,55 @@
+//
+// SheetCook
+//		Turns text sprite sheet descriptors into the binary ones the game loads
+//
+//	usage: SheetCook in.sheet out.sheetb [in.sheet out.sheetb ...]
+//
+//	Builds anywhere, e.g. on Linux:
+//		g++ -O2 -std=c++17 -I../../Win32GraphicsProject SheetCook.cpp
+//			../../Win32GraphicsProject/SpriteSheet.cpp -o SheetCook
+//
+
+#include "SpriteSheet.h"
+#include <stdio.h>
+
+int main(int argc, char* argv[])
+{
+	if (argc < 3 || (argc - 1) % 2 != 0)
+	{
+		fprintf(stderr, "usage: %s in.sheet out.sheetb [in.sheet out.sheetb ...]\n", argv[0]);
+		return 1;
+	}
+
+	int failed = 0;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		SpriteSheet sheet;
+		if (!sheet.Load(argv[i]))
+		{
+			fprintf(stderr, "%s: %s\n", argv[i], sheet.GetError().c_str());
+			failed++;
+			continue;
+		}
+
+		if (!sheet.SaveBinary(argv[i + 1]))
+		{
+			fprintf(stderr, "%s: can't write it\n", argv[i + 1]);
+			failed++;
+			continue;
+		}
+
+		// read it back, so a broken writer can't get past here
+		SpriteSheet cooked;
+		if (!cooked.Load(argv[i + 1]) || cooked.GetFrameCount() != sheet.GetFrameCount() ||
+			cooked.GetClipCount() != sheet.GetClipCount())
+		{
+			fprintf(stderr, "%s: doesn't read back the same\n", argv[i + 1]);
+			failed++;
+			continue;
+		}
+
+		printf("%s -> %s: %d frames, %d clips\n", argv[i], argv[i + 1], sheet.GetFrameCount(), sheet.GetClipCount());
+	}
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,780 @@
+//
+// BlockCompressor
+//		Encodes 4x4 RGBA blocks as BC3 or BC7, and decodes them again to measure quality
+//
+
+#include "BlockCompressor.h"
+#include <math.h>
+#include <string.h>
+
+// BC7's 4 bit index weights, out of 64
+static const int bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static inline int Channel(uint32_t pixel, int c)
+{
+	return (pixel >> (c * 8)) & 0xff;
+}
+
+// -----------------------------------------------------
+// The block's principal axis over the first channels channels, and how far along it
+//	the pixels go either side of the mean
+//
+static void FitAxis(const uint32_t pixels[16], int channels, float low[4], float high[4])
+{
+	float mean[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < channels; c++)
+			mean[c] += Channel(pixels[i], c);
+	}
+	for (int c = 0; c < channels; c++)
+		mean[c] /= 16.0f;
+
+	float covariance[4][4];
+	memset(covariance, 0, sizeof(covariance));
+	for (int i = 0; i < 16; i++)
+	{
+		float d[4];
+		for (int c = 0; c < channels; c++)
+			d[c] = Channel(pixels[i], c) - mean[c];
+		for (int a = 0; a < channels; a++)
+		{
+			for (int b = 0; b < channels; b++)
+				covariance[a][b] += d[a] * d[b];
+		}
+	}
+
+	// power iteration from the diagonal, which is never at right angles to the answer
+	float axis[4] = { 0, 0, 0, 0 };
+	for (int c = 0; c < channels; c++)
+		axis[c] = covariance[c][c] + 1.0f;
+	for (int iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = { 0, 0, 0, 0 };
+		float length = 0.0f;
+		for (int a = 0; a < channels; a++)
+		{
+			for (int b = 0; b < channels; b++)
+				next[a] += covariance[a][b] * axis[b];
+			length += next[a] * next[a];
+		}
+		if (length < 1e-12f)
+			break;
+		length = 1.0f / sqrtf(length);
+		for (int c = 0; c < channels; c++)
+			axis[c] = next[c] * length;
+	}
+
+	float length = 0.0f;
+	for (int c = 0; c < channels; c++)
+		length += axis[c] * axis[c];
+	length = length > 0.0f ? 1.0f / sqrtf(length) : 0.0f;
+
+	float minT = 0.0f, maxT = 0.0f;
+	for (int i = 0; i < 16; i++)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < channels; c++)
+			t += (Channel(pixels[i], c) - mean[c]) * axis[c] * length;
+		minT = t < minT ? t : minT;
+		maxT = t > maxT ? t : maxT;
+	}
+
+	for (int c = 0; c < channels; c++)
+	{
+		low[c] = mean[c] + minT * axis[c] * length;
+		high[c] = mean[c] + maxT * axis[c] * length;
+	}
+}
+
+// -----------------------------------------------------
+// Least squares endpoints for fixed indices. weight[i] is how much of the second endpoint
+//	pixel i gets. false if every pixel has the same weight, when there's nothing to solve
+//
+static bool SolveEndpoints(const uint32_t pixels[16], int channels, const float weight[16], float e0[4], float e1[4])
+{
+	float aa = 0, ab = 0, bb = 0;
+	float ax[4] = { 0, 0, 0, 0 };
+	float bx[4] = { 0, 0, 0, 0 };
+	for (int i = 0; i < 16; i++)
+	{
+		float b = weight[i];
+		float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < channels; c++)
+		{
+			ax[c] += a * Channel(pixels[i], c);
+			bx[c] += b * Channel(pixels[i], c);
+		}
+	}
+
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+		return false;
+
+	for (int c = 0; c < channels; c++)
+	{
+		e0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+		e1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+	}
+	return true;
+}
+
+// -----------------------------------------------------
+// BC1 colour, 4 colour mode
+//
+static inline uint16_t Pack565(const float c[3])
+{
+	int r = (int)(c[0] * 31.0f / 255.0f + 0.5f);
+	int g = (int)(c[1] * 63.0f / 255.0f + 0.5f);
+	int b = (int)(c[2] * 31.0f / 255.0f + 0.5f);
+	r = r < 0 ? 0 : (r > 31 ? 31 : r);
+	g = g < 0 ? 0 : (g > 63 ? 63 : g);
+	b = b < 0 ? 0 : (b > 31 ? 31 : b);
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static inline void Unpack565(uint16_t v, int c[3])
+{
+	int r = (v >> 11) & 31;
+	int g = (v >> 5) & 63;
+	int b = v & 31;
+	c[0] = (r << 3) | (r >> 2);
+	c[1] = (g << 2) | (g >> 4);
+	c[2] = (b << 3) | (b >> 2);
+}
+
+// the four colours two endpoints give, in index order
+static void ColorPalette(uint16_t c0, uint16_t c1, int palette[4][3])
+{
+	Unpack565(c0, palette[0]);
+	Unpack565(c1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		if (c0 > c1)
+		{
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		}
+		else
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+}
+
+// nearest palette colour for each pixel, returns the total squared error
+static int ColorIndices(const uint32_t pixels[16], uint16_t c0, uint16_t c1, uint8_t indices[16])
+{
+	int palette[4][3];
+	ColorPalette(c0, c1, palette);
+
+	int total = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int best = 0, bestError = 1 << 30;
+		for (int p = 0; p < 4; p++)
+		{
+			int error = 0;
+			for (int c = 0; c < 3; c++)
+			{
+				int d = Channel(pixels[i], c) - palette[p][c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best = p;
+			}
+		}
+		indices[i] = (uint8_t)best;
+		total += bestError;
+	}
+	return total;
+}
+
+static void EncodeColorBlock(const uint32_t pixels[16], uint8_t block[8])
+{
+	float low[4], high[4];
+	FitAxis(pixels, 3, low, high);
+
+	// the brighter end goes first, c0 > c1 picks 4 colour mode
+	uint16_t bestC0 = Pack565(high), bestC1 = Pack565(low);
+	if (bestC0 < bestC1)
+	{
+		uint16_t swap = bestC0;
+		bestC0 = bestC1;
+		bestC1 = swap;
+	}
+	uint8_t bestIndices[16];
+	int bestError = ColorIndices(pixels, bestC0, bestC1, bestIndices);
+
+	// refine with least squares against the indices we got
+	static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	for (int iteration = 0; iteration < 2 && bestError > 0 && bestC0 != bestC1; iteration++)
+	{
+		float weight[16];
+		for (int i = 0; i < 16; i++)
+			weight[i] = weights[bestIndices[i]];
+
+		float e0[4], e1[4];
+		if (!SolveEndpoints(pixels, 3, weight, e0, e1))
+			break;
+
+		uint16_t c0 = Pack565(e0), c1 = Pack565(e1);
+		if (c0 < c1)
+		{
+			uint16_t swap = c0;
+			c0 = c1;
+			c1 = swap;
+		}
+		if (c0 == c1)
+			break;
+
+		uint8_t indices[16];
+		int error = ColorIndices(pixels, c0, c1, indices);
+		if (error >= bestError)
+			break;
+
+		bestError = error;
+		bestC0 = c0;
+		bestC1 = c1;
+		memcpy(bestIndices, indices, sizeof(indices));
+	}
+
+	// a flat block comes out with both endpoints the same, which is 3 colour mode. index 0 is
+	//	still the first endpoint there, so point everything at it
+	if (bestC0 == bestC1)
+		memset(bestIndices, 0, sizeof(bestIndices));
+
+	uint32_t bits = 0;
+	for (int i = 0; i < 16; i++)
+		bits |= (uint32_t)bestIndices[i] << (i * 2);
+
+	block[0] = (uint8_t)bestC0;
+	block[1] = (uint8_t)(bestC0 >> 8);
+	block[2] = (uint8_t)bestC1;
+	block[3] = (uint8_t)(bestC1 >> 8);
+	block[4] = (uint8_t)bits;
+	block[5] = (uint8_t)(bits >> 8);
+	block[6] = (uint8_t)(bits >> 16);
+	block[7] = (uint8_t)(bits >> 24);
+}
+
+// -----------------------------------------------------
+// BC4 alpha
+//
+static void AlphaPalette(int a0, int a1, int palette[8])
+{
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1)
+	{
+		for (int i = 1; i < 7; i++)
+			palette[i + 1] = ((7 - i) * a0 + i * a1) / 7;
+	}
+	else
+	{
+		for (int i = 1; i < 5; i++)
+			palette[i + 1] = ((5 - i) * a0 + i * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static int AlphaIndices(const uint32_t pixels[16], int a0, int a1, uint8_t indices[16])
+{
+	int palette[8];
+	AlphaPalette(a0, a1, palette);
+
+	int total = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int alpha = Channel(pixels[i], 3);
+		int best = 0, bestError = 1 << 30;
+		for (int p = 0; p < 8; p++)
+		{
+			int d = alpha - palette[p];
+			if (d * d < bestError)
+			{
+				bestError = d * d;
+				best = p;
+			}
+		}
+		indices[i] = (uint8_t)best;
+		total += bestError;
+	}
+	return total;
+}
+
+static void EncodeAlphaBlock(const uint32_t pixels[16], uint8_t block[8])
+{
+	// the full range with 8 steps, or the range between 0 and 255 with 6 steps and
+	//	exact 0 and 255, whichever fits better. sprite edges usually want the second
+	int low = 255, high = 0;
+	int innerLow = 255, innerHigh = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int alpha = Channel(pixels[i], 3);
+		low = alpha < low ? alpha : low;
+		high = alpha > high ? alpha : high;
+		if (alpha != 0 && alpha != 255)
+		{
+			innerLow = alpha < innerLow ? alpha : innerLow;
+			innerHigh = alpha > innerHigh ? alpha : innerHigh;
+		}
+	}
+	if (innerLow > innerHigh)
+		innerLow = innerHigh = 0;
+
+	uint8_t indices[16], innerIndices[16];
+	int a0 = high, a1 = low;
+	int error = AlphaIndices(pixels, a0, a1, indices);
+	if (error > 0 && AlphaIndices(pixels, innerLow, innerHigh, innerIndices) < error)
+	{
+		a0 = innerLow;
+		a1 = innerHigh;
+		memcpy(indices, innerIndices, sizeof(indices));
+	}
+
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; i++)
+		bits |= (uint64_t)indices[i] << (i * 3);
+
+	block[0] = (uint8_t)a0;
+	block[1] = (uint8_t)a1;
+	for (int i = 0; i < 6; i++)
+		block[2 + i] = (uint8_t)(bits >> (i * 8));
+}
+
+// -----------------------------------------------------
+// BC3, alpha block then colour block
+//
+void BlockCompressor::EncodeBC3(const uint32_t pixels[16], uint8_t block[16])
+{
+	EncodeAlphaBlock(pixels, block);
+	EncodeColorBlock(pixels, block + 8);
+}
+
+void BlockCompressor::DecodeBC3(const uint8_t block[16], uint32_t pixels[16])
+{
+	int alphas[8];
+	AlphaPalette(block[0], block[1], alphas);
+	uint64_t alphaBits = 0;
+	for (int i = 0; i < 6; i++)
+		alphaBits |= (uint64_t)block[2 + i] << (i * 8);
+
+	uint16_t c0 = (uint16_t)(block[8] | (block[9] << 8));
+	uint16_t c1 = (uint16_t)(block[10] | (block[11] << 8));
+	int colors[4][3];
+	ColorPalette(c0, c1, colors);
+	uint32_t colorBits = block[12] | (block[13] << 8) | (block[14] << 16) | ((uint32_t)block[15] << 24);
+
+	for (int i = 0; i < 16; i++)
+	{
+		const int* color = colors[(colorBits >> (i * 2)) & 3];
+		int alpha = alphas[(alphaBits >> (i * 3)) & 7];
+		pixels[i] = color[0] | (color[1] << 8) | (color[2] << 16) | ((uint32_t)alpha << 24);
+	}
+}
+
+// -----------------------------------------------------
+// BC7
+//
+struct Bc7Endpoints
+{
+	int	e0[4], e1[4];	// 8 bit, low bit is the p-bit
+};
+
+static Bc7Endpoints QuantizeBC7(const float e0[4], const float e1[4], int p0, int p1)
+{
+	Bc7Endpoints q;
+	for (int c = 0; c < 4; c++)
+	{
+		int v0 = (int)floorf((e0[c] - p0) * 0.5f + 0.5f);
+		int v1 = (int)floorf((e1[c] - p1) * 0.5f + 0.5f);
+		v0 = v0 < 0 ? 0 : (v0 > 127 ? 127 : v0);
+		v1 = v1 < 0 ? 0 : (v1 > 127 ? 127 : v1);
+		q.e0[c] = (v0 << 1) | p0;
+		q.e1[c] = (v1 << 1) | p1;
+	}
+	return q;
+}
+
+static int BC7Indices(const uint32_t pixels[16], const Bc7Endpoints& q, uint8_t indices[16])
+{
+	int palette[16][4];
+	for (int p = 0; p < 16; p++)
+	{
+		for (int c = 0; c < 4; c++)
+			palette[p][c] = ((64 - bc7Weights[p]) * q.e0[c] + bc7Weights[p] * q.e1[c] + 32) >> 6;
+	}
+
+	int total = 0;
+	for (int i = 0; i < 16; i++)
+	{
+		int best = 0, bestError = 1 << 30;
+		for (int p = 0; p < 16; p++)
+		{
+			int error = 0;
+			for (int c = 0; c < 4; c++)
+			{
+				int d = Channel(pixels[i], c) - palette[p][c];
+				error += d * d;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				best = p;
+			}
+		}
+		indices[i] = (uint8_t)best;
+		total += bestError;
+	}
+	return total;
+}
+
+// the best p-bits for endpoints e0 and e1
+static int FitBC7(const uint32_t pixels[16], const float e0[4], const float e1[4], Bc7Endpoints& best, uint8_t bestIndices[16])
+{
+	int bestError = 1 << 30;
+	for (int p = 0; p < 4; p++)
+	{
+		Bc7Endpoints q = QuantizeBC7(e0, e1, p & 1, p >> 1);
+		uint8_t indices[16];
+		int error = BC7Indices(pixels, q, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			best = q;
+			memcpy(bestIndices, indices, 16);
+		}
+	}
+	return bestError;
+}
+
+// writes bits from the low end of the block up
+struct BitWriter
+{
+	uint8_t*	block;
+	int			position;
+
+	void Write(uint32_t value, int count)
+	{
+		for (int i = 0; i < count; i++, position++)
+		{
+			if (value & (1u << i))
+				block[position >> 3] |= (uint8_t)(1 << (position & 7));
+		}
+	}
+};
+
+struct BitReader
+{
+	const uint8_t*	block;
+	int				position;
+
+	uint32_t Read(int count)
+	{
+		uint32_t value = 0;
+		for (int i = 0; i < count; i++, position++)
+		{
+			if (block[position >> 3] & (1 << (position & 7)))
+				value |= 1u << i;
+		}
+		return value;
+	}
+};
+
+// -----------------------------------------------------
+// Mode 6, RGBA together with 4 bit indices. returns the squared error
+//
+static int EncodeMode6(const uint32_t pixels[16], uint8_t block[16])
+{
+	float low[4], high[4];
+	FitAxis(pixels, 4, low, high);
+
+	Bc7Endpoints best;
+	uint8_t bestIndices[16];
+	int bestError = FitBC7(pixels, low, high, best, bestIndices);
+
+	for (int iteration = 0; iteration < 2 && bestError > 0; iteration++)
+	{
+		float weight[16];
+		for (int i = 0; i < 16; i++)
+			weight[i] = bc7Weights[bestIndices[i]] / 64.0f;
+
+		float e0[4], e1[4];
+		if (!SolveEndpoints(pixels, 4, weight, e0, e1))
+			break;
+
+		Bc7Endpoints q;
+		uint8_t indices[16];
+		int error = FitBC7(pixels, e0, e1, q, indices);
+		if (error >= bestError)
+			break;
+
+		bestError = error;
+		best = q;
+		memcpy(bestIndices, indices, sizeof(indices));
+	}
+
+	// the first index has its top bit left out, so it has to be under 8. the weights are
+	//	symmetric, so swapping the ends and flipping the indices gives the same colours
+	if (bestIndices[0] >= 8)
+	{
+		for (int c = 0; c < 4; c++)
+		{
+			int swap = best.e0[c];
+			best.e0[c] = best.e1[c];
+			best.e1[c] = swap;
+		}
+		for (int i = 0; i < 16; i++)
+			bestIndices[i] = (uint8_t)(15 - bestIndices[i]);
+	}
+
+	memset(block, 0, 16);
+	BitWriter writer = { block, 0 };
+	writer.Write(1 << 6, 7);
+	for (int c = 0; c < 4; c++)
+	{
+		writer.Write(best.e0[c] >> 1, 7);
+		writer.Write(best.e1[c] >> 1, 7);
+	}
+	writer.Write(best.e0[0] & 1, 1);
+	writer.Write(best.e1[0] & 1, 1);
+	writer.Write(bestIndices[0], 3);
+	for (int i = 1; i < 16; i++)
+		writer.Write(bestIndices[i], 4);
+
+	return bestError;
+}
+
+// -----------------------------------------------------
+// Mode 5, colour and alpha with their own 2 bit indices, like BC3 does. which is best
+//	at sprite edges, where the alpha changes and the colour doesn't. rotation swaps
+//	a colour channel with alpha first, for blocks where that channel is the odd one out
+//
+static const int mode5Weights[4] = { 0, 21, 43, 64 };
+
+// an endpoint to bits, and back to 8
+static inline int Quantize(float v, int bits)
+{
+	int top = (1 << bits) - 1;
+	int q = (int)(v * top / 255.0f + 0.5f);
+	q = q < 0 ? 0 : (q > top ? top : q);
+	return q;
+}
+
+static inline int Unquantize(int q, int bits)
+{
+	return (q << (8 - bits)) | (q >> (2 * bits - 8));
+}
+
+// fit the first channels of pixels with 2 bit indices. e0 and e1 come back quantized
+static int FitMode5Part(const uint32_t pixels[16], int channels, int bits, int e0[4], int e1[4], uint8_t indices[16])
+{
+	float low[4], high[4];
+	FitAxis(pixels, channels, low, high);
+
+	int bestError = 1 << 30;
+	for (int iteration = 0; iteration < 3; iteration++)
+	{
+		int q0[4], q1[4];
+		int palette[4][4];
+		for (int c = 0; c < channels; c++)
+		{
+			q0[c] = Quantize(low[c], bits);
+			q1[c] = Quantize(high[c], bits);
+			for (int p = 0; p < 4; p++)
+				palette[p][c] = ((64 - mode5Weights[p]) * Unquantize(q0[c], bits) + mode5Weights[p] * Unquantize(q1[c], bits) + 32) >> 6;
+		}
+
+		uint8_t chosen[16];
+		int error = 0;
+		for (int i = 0; i < 16; i++)
+		{
+			int best = 0, bestPixel = 1 << 30;
+			for (int p = 0; p < 4; p++)
+			{
+				int e = 0;
+				for (int c = 0; c < channels; c++)
+				{
+					int d = Channel(pixels[i], c) - palette[p][c];
+					e += d * d;
+				}
+				if (e < bestPixel)
+				{
+					bestPixel = e;
+					best = p;
+				}
+			}
+			chosen[i] = (uint8_t)best;
+			error += bestPixel;
+		}
+
+		if (error >= bestError)
+			break;
+		bestError = error;
+		memcpy(e0, q0, sizeof(q0));
+		memcpy(e1, q1, sizeof(q1));
+		memcpy(indices, chosen, 16);
+		if (error == 0)
+			break;
+
+		// least squares against these indices for the next go
+		float weight[16];
+		for (int i = 0; i < 16; i++)
+			weight[i] = mode5Weights[chosen[i]] / 64.0f;
+		if (!SolveEndpoints(pixels, channels, weight, low, high))
+			break;
+	}
+
+	// the first index's top bit is left out
+	if (indices[0] >= 2)
+	{
+		for (int c = 0; c < channels; c++)
+		{
+			int swap = e0[c];
+			e0[c] = e1[c];
+			e1[c] = swap;
+		}
+		for (int i = 0; i < 16; i++)
+			indices[i] = (uint8_t)(3 - indices[i]);
+	}
+	return bestError;
+}
+
+// swap alpha with channel rotation - 1, which undoes itself
+static inline uint32_t Rotate(uint32_t pixel, int rotation)
+{
+	if (rotation == 0)
+		return pixel;
+	int shift = (rotation - 1) * 8;
+	uint32_t alpha = pixel >> 24;
+	uint32_t other = (pixel >> shift) & 0xff;
+	pixel &= ~((0xffu << 24) | (0xffu << shift));
+	return pixel | (other << 24) | (alpha << shift);
+}
+
+static int EncodeMode5(const uint32_t pixels[16], int rotation, uint8_t block[16])
+{
+	uint32_t color[16], alpha[16];
+	for (int i = 0; i < 16; i++)
+	{
+		uint32_t pixel = Rotate(pixels[i], rotation);
+		color[i] = pixel & 0xffffff;
+		alpha[i] = pixel >> 24;
+	}
+
+	int c0[4], c1[4], a0[4], a1[4];
+	uint8_t colorIndices[16], alphaIndices[16];
+	int error = FitMode5Part(color, 3, 7, c0, c1, colorIndices);
+	error += FitMode5Part(alpha, 1, 8, a0, a1, alphaIndices);
+
+	memset(block, 0, 16);
+	BitWriter writer = { block, 0 };
+	writer.Write(1 << 5, 6);
+	writer.Write(rotation, 2);
+	for (int c = 0; c < 3; c++)
+	{
+		writer.Write(c0[c], 7);
+		writer.Write(c1[c], 7);
+	}
+	writer.Write(a0[0], 8);
+	writer.Write(a1[0], 8);
+	writer.Write(colorIndices[0], 1);
+	for (int i = 1; i < 16; i++)
+		writer.Write(colorIndices[i], 2);
+	writer.Write(alphaIndices[0], 1);
+	for (int i = 1; i < 16; i++)
+		writer.Write(alphaIndices[i], 2);
+
+	return error;
+}
+
+void BlockCompressor::EncodeBC7(const uint32_t pixels[16], uint8_t block[16])
+{
+	int bestError = EncodeMode6(pixels, block);
+
+	// separate alpha only helps if there's some
+	bool opaque = true;
+	for (int i = 0; i < 16 && opaque; i++)
+		opaque = (pixels[i] >> 24) == 255;
+
+	for (int rotation = 0; rotation < 4 && bestError > 0 && !opaque; rotation++)
+	{
+		uint8_t candidate[16];
+		int error = EncodeMode5(pixels, rotation, candidate);
+		if (error < bestError)
+		{
+			bestError = error;
+			memcpy(block, candidate, 16);
+		}
+	}
+}
+
+void BlockCompressor::DecodeBC7(const uint8_t block[16], uint32_t pixels[16])
+{
+	if ((block[0] & 0x7f) == 0x40)
+	{
+		BitReader reader = { block, 7 };
+		int e0[4], e1[4];
+		for (int c = 0; c < 4; c++)
+		{
+			e0[c] = reader.Read(7) << 1;
+			e1[c] = reader.Read(7) << 1;
+		}
+		int p0 = reader.Read(1);
+		int p1 = reader.Read(1);
+		for (int c = 0; c < 4; c++)
+		{
+			e0[c] |= p0;
+			e1[c] |= p1;
+		}
+
+		for (int i = 0; i < 16; i++)
+		{
+			int w = bc7Weights[reader.Read(i == 0 ? 3 : 4)];
+			uint32_t pixel = 0;
+			for (int c = 0; c < 4; c++)
+				pixel |= (uint32_t)(((64 - w) * e0[c] + w * e1[c] + 32) >> 6) << (c * 8);
+			pixels[i] = pixel;
+		}
+	}
+	else if ((block[0] & 0x3f) == 0x20)
+	{
+		BitReader reader = { block, 6 };
+		int rotation = reader.Read(2);
+		int e0[4], e1[4];
+		for (int c = 0; c < 3; c++)
+		{
+			e0[c] = Unquantize(reader.Read(7), 7);
+			e1[c] = Unquantize(reader.Read(7), 7);
+		}
+		e0[3] = reader.Read(8);
+		e1[3] = reader.Read(8);
+
+		int colorIndices[16];
+		for (int i = 0; i < 16; i++)
+			colorIndices[i] = reader.Read(i == 0 ? 1 : 2);
+
+		for (int i = 0; i < 16; i++)
+		{
+			int w = mode5Weights[colorIndices[i]];
+			int wa = mode5Weights[reader.Read(i == 0 ? 1 : 2)];
+			uint32_t pixel = 0;
+			for (int c = 0; c < 3; c++)
+				pixel |= (uint32_t)(((64 - w) * e0[c] + w * e1[c] + 32) >> 6) << (c * 8);
+			pixel |= (uint32_t)(((64 - wa) * e0[3] + wa * e1[3] + 32) >> 6) << 24;
+			pixels[i] = Rotate(pixel, rotation);
+		}
+	}
+	else
+	{
+		memset(pixels, 0, 16 * sizeof(uint32_t));
+	}
+}
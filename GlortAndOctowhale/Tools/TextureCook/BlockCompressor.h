@@ -0,0 +1,35 @@
+//
+// BlockCompressor
+//		Encodes 4x4 RGBA blocks as BC3 or BC7, and decodes them again to measure quality
+//
+//	BC3 is a BC1 colour block (two 565 endpoints, 2 bit indices) with a BC4 alpha block
+//	(two 8 bit endpoints, 3 bit indices). BC7 tries two of its eight modes and keeps the
+//	better: mode 6 (RGBA endpoints with a p-bit, 4 bit indices), which is best on smooth
+//	colour, and mode 5 (RGB and alpha indexed separately, with each channel rotation),
+//	which is best at sprite edges. The partitioned modes would do better on blocks with
+//	three or more distinct colours but cost many times more to search.
+//
+//	Both fit endpoints along the block's principal axis and then refine them with least
+//	squares against the chosen indices, keeping whichever came out with less error.
+//	Blocks are 16 bytes either way, a quarter of RGBA8.
+//
+
+#ifndef _BLOCK_COMPRESSOR_H
+#define _BLOCK_COMPRESSOR_H
+
+#include <stdint.h>
+
+class BlockCompressor
+{
+public:
+	// pixels are 16 RGBA values in rows, red in the low byte, like ImageRGBA
+	static void EncodeBC3(const uint32_t pixels[16], uint8_t block[16]);
+	static void EncodeBC7(const uint32_t pixels[16], uint8_t block[16]);
+
+	static void DecodeBC3(const uint8_t block[16], uint32_t pixels[16]);
+
+	// only modes 5 and 6, what EncodeBC7 writes. other modes decode as transparent black
+	static void DecodeBC7(const uint8_t block[16], uint32_t pixels[16]);
+};
+
+#endif // _BLOCK_COMPRESSOR_H
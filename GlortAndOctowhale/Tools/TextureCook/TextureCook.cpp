@@ -0,0 +1,441 @@
+//
+// TextureCook
+//		Cooks PNGs into block compressed DDS textures, with mips, for TextureType::Load
+//
+//	usage: TextureCook [-format bc7|bc3] [-nomips] [-straight] [-threads n] [-out directory]
+//			in.png [in.png ...]
+//
+//	Each in.png becomes in.dds, next to it or in -out. BC7 (the default) and BC3 are both a
+//	byte a pixel, a quarter of the RGBA8 the PNGs are uploaded as, and the game doesn't
+//	have to inflate anything to load them. Mips are made with a box filter down to 1x1
+//	unless -nomips is given.
+//
+//	Colours are premultiplied by alpha like the async loader does (AssetLoader::SetPremultiply),
+//	and the DDS says so, so the sprites keep drawing with premultiplied blending. -straight
+//	leaves them alone. Every block of every mip across every input is shared out between
+//	the threads, one per core by default.
+//
+//	For each file it prints the quality of the top mip (PSNR over RGBA, decoded back from
+//	the blocks), the time the PNG took to decode, and the sizes against RGBA8. The block
+//	decoders were checked against Pillow's BC3 / BC7 decoding; to check them again, get it
+//	with pip install pillow and compare Image.open("in.dds") with the PNG.
+//
+//	Builds anywhere, e.g. on Linux:
+//		g++ -O2 -std=c++17 -pthread -I../../Win32GraphicsProject TextureCook.cpp BlockCompressor.cpp
+//			../../Win32GraphicsProject/PngCodec.cpp ../../Win32GraphicsProject/Zlib.cpp -o TextureCook
+//
+
+#include "BlockCompressor.h"
+#include "PngCodec.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+// what goes in the DDS headers
+static const uint32_t DXGI_FORMAT_BC3_UNORM = 77;
+static const uint32_t DXGI_FORMAT_BC7_UNORM = 98;
+
+enum AlphaMode
+{
+	AlphaStraight = 1,
+	AlphaPremultiplied = 2,
+	AlphaOpaque = 3
+};
+
+struct CookedTexture
+{
+	std::string				inputPath;
+	std::string				outputPath;
+	std::vector<ImageRGBA>	mips;			// what each level should look like
+	std::vector<size_t>		mipOffsets;		// where each level's blocks start in blocks
+	std::vector<uint8_t>	blocks;
+	AlphaMode				alphaMode;
+	size_t					pngBytes;
+	double					decodeTime;		// ms to decode the PNG
+};
+
+// one row of blocks in one mip, what a thread takes at a time
+struct Job
+{
+	int	texture;
+	int	mip;
+	int	blockRow;
+};
+
+static std::string FileName(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+// -----------------------------------------------------
+// Half the size, averaging each 2x2. odd sizes drop the last row or column, which
+//	is gone by the next level anyway. colours have to be premultiplied to average right
+//
+static void Downsample(const ImageRGBA& source, ImageRGBA& mip)
+{
+	int width = source.width > 1 ? source.width / 2 : 1;
+	int height = source.height > 1 ? source.height / 2 : 1;
+	mip.Resize(width, height);
+
+	for (int y = 0; y < height; y++)
+	{
+		const uint32_t* row0 = source.Row(std::min(y * 2, source.height - 1));
+		const uint32_t* row1 = source.Row(std::min(y * 2 + 1, source.height - 1));
+		uint32_t* out = mip.Row(y);
+
+		for (int x = 0; x < width; x++)
+		{
+			int x0 = std::min(x * 2, source.width - 1);
+			int x1 = std::min(x * 2 + 1, source.width - 1);
+
+			uint32_t pixel = 0;
+			for (int c = 0; c < 32; c += 8)
+			{
+				uint32_t sum = ((row0[x0] >> c) & 0xff) + ((row0[x1] >> c) & 0xff) + ((row1[x0] >> c) & 0xff) + ((row1[x1] >> c) & 0xff);
+				pixel |= ((sum + 2) / 4) << c;
+			}
+			out[x] = pixel;
+		}
+	}
+}
+
+static void Unpremultiply(ImageRGBA& image)
+{
+	for (size_t i = 0; i < image.pixels.size(); i++)
+	{
+		uint32_t pixel = image.pixels[i];
+		uint32_t alpha = pixel >> 24;
+		if (alpha == 0 || alpha == 255)
+			continue;
+
+		uint32_t out = alpha << 24;
+		for (int c = 0; c < 24; c += 8)
+		{
+			uint32_t v = (((pixel >> c) & 0xff) * 255 + alpha / 2) / alpha;
+			out |= (v > 255 ? 255 : v) << c;
+		}
+		image.pixels[i] = out;
+	}
+}
+
+// the 4x4 block at bx, by. past the edge repeats the last row or column
+static void GetBlock(const ImageRGBA& image, int bx, int by, uint32_t pixels[16])
+{
+	for (int y = 0; y < 4; y++)
+	{
+		const uint32_t* row = image.Row(std::min(by * 4 + y, image.height - 1));
+		for (int x = 0; x < 4; x++)
+			pixels[y * 4 + x] = row[std::min(bx * 4 + x, image.width - 1)];
+	}
+}
+
+static int BlocksAcross(int size)
+{
+	return (size + 3) / 4;
+}
+
+// -----------------------------------------------------
+// PSNR of a mip against what it was meant to be, over all four channels
+//
+static double MeasurePsnr(const CookedTexture& texture, int mip, bool bc7)
+{
+	const ImageRGBA& image = texture.mips[mip];
+	const uint8_t* blocks = texture.blocks.data() + texture.mipOffsets[mip];
+	int across = BlocksAcross(image.width);
+
+	double squared = 0.0;
+	for (int by = 0; by < BlocksAcross(image.height); by++)
+	{
+		for (int bx = 0; bx < across; bx++)
+		{
+			uint32_t decoded[16];
+			const uint8_t* block = blocks + ((size_t)by * across + bx) * 16;
+			if (bc7)
+				BlockCompressor::DecodeBC7(block, decoded);
+			else
+				BlockCompressor::DecodeBC3(block, decoded);
+
+			for (int y = 0; y < 4 && by * 4 + y < image.height; y++)
+			{
+				for (int x = 0; x < 4 && bx * 4 + x < image.width; x++)
+				{
+					uint32_t expected = image.Row(by * 4 + y)[bx * 4 + x];
+					for (int c = 0; c < 32; c += 8)
+					{
+						int d = (int)((decoded[y * 4 + x] >> c) & 0xff) - (int)((expected >> c) & 0xff);
+						squared += d * d;
+					}
+				}
+			}
+		}
+	}
+
+	double mse = squared / ((double)image.width * image.height * 4.0);
+	return mse > 0.0 ? 10.0 * log10(255.0 * 255.0 / mse) : 99.0;
+}
+
+// -----------------------------------------------------
+// DDS with the DX10 header, which BC7 needs and which has somewhere for the alpha mode
+//
+static void PutU32(std::vector<uint8_t>& out, uint32_t v)
+{
+	out.push_back((uint8_t)v);
+	out.push_back((uint8_t)(v >> 8));
+	out.push_back((uint8_t)(v >> 16));
+	out.push_back((uint8_t)(v >> 24));
+}
+
+static bool WriteDds(const CookedTexture& texture, uint32_t format)
+{
+	const ImageRGBA& top = texture.mips[0];
+	int mipCount = (int)texture.mips.size();
+
+	std::vector<uint8_t> file;
+	PutU32(file, 0x20534444);						// "DDS "
+
+	// DDS_HEADER
+	PutU32(file, 124);								// size
+	PutU32(file, 0x1 | 0x2 | 0x4 | 0x1000 | 0x80000 | (mipCount > 1 ? 0x20000 : 0));	// caps, height, width, pixel format, linear size, mip count
+	PutU32(file, top.height);
+	PutU32(file, top.width);
+	PutU32(file, (uint32_t)BlocksAcross(top.width) * BlocksAcross(top.height) * 16);
+	PutU32(file, 0);								// depth
+	PutU32(file, mipCount);
+	for (int i = 0; i < 11; i++)
+		PutU32(file, 0);							// reserved
+
+	// DDS_PIXELFORMAT, just says look at the DX10 header
+	PutU32(file, 32);
+	PutU32(file, 0x4);								// four cc
+	PutU32(file, 0x30315844);						// "DX10"
+	for (int i = 0; i < 5; i++)
+		PutU32(file, 0);
+
+	PutU32(file, 0x1000 | (mipCount > 1 ? 0x8 | 0x400000 : 0));	// texture, complex and mipmap
+	for (int i = 0; i < 4; i++)
+		PutU32(file, 0);							// caps2, 3, 4, reserved
+
+	// DDS_HEADER_DXT10
+	PutU32(file, format);
+	PutU32(file, 3);								// 2D
+	PutU32(file, 0);								// misc flags
+	PutU32(file, 1);								// array size
+	PutU32(file, texture.alphaMode);
+
+	file.insert(file.end(), texture.blocks.begin(), texture.blocks.end());
+
+	FILE* out = fopen(texture.outputPath.c_str(), "wb");
+	if (out == nullptr)
+		return false;
+	bool written = fwrite(file.data(), 1, file.size(), out) == file.size();
+	return fclose(out) == 0 && written;
+}
+
+int main(int argc, char* argv[])
+{
+	bool bc7 = true;
+	bool mips = true;
+	bool premultiply = true;
+	int threadCount = (int)std::thread::hardware_concurrency();
+	std::string outDirectory;
+
+	int arg = 1;
+	bool usage = false;
+	while (arg < argc && argv[arg][0] == '-')
+	{
+		if (strcmp(argv[arg], "-nomips") == 0)
+			mips = false;
+		else if (strcmp(argv[arg], "-straight") == 0)
+			premultiply = false;
+		else if (strcmp(argv[arg], "-format") == 0 && arg + 1 < argc)
+		{
+			arg++;
+			if (strcmp(argv[arg], "bc7") == 0)
+				bc7 = true;
+			else if (strcmp(argv[arg], "bc3") == 0)
+				bc7 = false;
+			else
+				usage = true;
+		}
+		else if (strcmp(argv[arg], "-threads") == 0 && arg + 1 < argc)
+			threadCount = atoi(argv[++arg]);
+		else if (strcmp(argv[arg], "-out") == 0 && arg + 1 < argc)
+			outDirectory = argv[++arg];
+		else
+			usage = true;
+		arg++;
+	}
+
+	if (usage || arg >= argc)
+	{
+		fprintf(stderr, "usage: %s [-format bc7|bc3] [-nomips] [-straight] [-threads n] [-out directory] in.png [in.png ...]\n", argv[0]);
+		return 1;
+	}
+	if (threadCount < 1)
+		threadCount = 1;
+	if (!outDirectory.empty() && outDirectory.back() != '/' && outDirectory.back() != '\\')
+		outDirectory += '/';
+
+	// read everything first, so a bad file stops it before anything is written
+	std::vector<CookedTexture> textures;
+	for (; arg < argc; arg++)
+	{
+		CookedTexture texture;
+		texture.inputPath = argv[arg];
+
+		std::string name = FileName(texture.inputPath);
+		std::string base = outDirectory.empty() ? texture.inputPath.substr(0, texture.inputPath.size() - name.size()) : outDirectory;
+		size_t dot = name.rfind('.');
+		texture.outputPath = base + (dot == std::string::npos ? name : name.substr(0, dot)) + ".dds";
+
+		Clock::time_point start = Clock::now();
+		ImageRGBA weighted;
+		std::string error;
+		if (!PngCodec::Load(texture.inputPath.c_str(), weighted, &error, true))
+		{
+			fprintf(stderr, "%s: %s\n", texture.inputPath.c_str(), error.c_str());
+			return 1;
+		}
+		texture.decodeTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		FILE* file = fopen(texture.inputPath.c_str(), "rb");
+		fseek(file, 0, SEEK_END);
+		texture.pngBytes = (size_t)ftell(file);
+		fclose(file);
+
+		texture.alphaMode = premultiply ? AlphaPremultiplied : AlphaStraight;
+		bool opaque = true;
+		for (size_t i = 0; i < weighted.pixels.size() && opaque; i++)
+			opaque = (weighted.pixels[i] >> 24) == 255;
+		if (opaque)
+			texture.alphaMode = AlphaOpaque;
+
+		// mips are averaged premultiplied, then put back to straight if that's what's wanted
+		for (;;)
+		{
+			texture.mips.push_back(weighted);
+			if (!premultiply)
+				Unpremultiply(texture.mips.back());
+
+			if (!mips || (weighted.width == 1 && weighted.height == 1))
+				break;
+
+			ImageRGBA next;
+			Downsample(weighted, next);
+			weighted.pixels.swap(next.pixels);
+			weighted.width = next.width;
+			weighted.height = next.height;
+		}
+
+		size_t bytes = 0;
+		for (size_t m = 0; m < texture.mips.size(); m++)
+		{
+			texture.mipOffsets.push_back(bytes);
+			bytes += (size_t)BlocksAcross(texture.mips[m].width) * BlocksAcross(texture.mips[m].height) * 16;
+		}
+		texture.blocks.resize(bytes);
+
+		textures.push_back(texture);
+	}
+
+	// every row of blocks, biggest mips first so the stragglers at the end are small
+	std::vector<Job> jobs;
+	for (size_t m = 0; ; m++)
+	{
+		bool any = false;
+		for (size_t t = 0; t < textures.size(); t++)
+		{
+			if (m >= textures[t].mips.size())
+				continue;
+			any = true;
+			for (int row = 0; row < BlocksAcross(textures[t].mips[m].height); row++)
+			{
+				Job job = { (int)t, (int)m, row };
+				jobs.push_back(job);
+			}
+		}
+		if (!any)
+			break;
+	}
+
+	Clock::time_point encodeStart = Clock::now();
+
+	std::atomic<size_t> nextJob(0);
+	auto work = [&]()
+	{
+		for (size_t j = nextJob++; j < jobs.size(); j = nextJob++)
+		{
+			CookedTexture& texture = textures[jobs[j].texture];
+			const ImageRGBA& image = texture.mips[jobs[j].mip];
+			int across = BlocksAcross(image.width);
+			uint8_t* out = texture.blocks.data() + texture.mipOffsets[jobs[j].mip] + (size_t)jobs[j].blockRow * across * 16;
+
+			for (int bx = 0; bx < across; bx++)
+			{
+				uint32_t pixels[16];
+				GetBlock(image, bx, jobs[j].blockRow, pixels);
+				if (bc7)
+					BlockCompressor::EncodeBC7(pixels, out + bx * 16);
+				else
+					BlockCompressor::EncodeBC3(pixels, out + bx * 16);
+			}
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < threadCount; i++)
+		threads.push_back(std::thread(work));
+	work();
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+
+	double encodeTime = std::chrono::duration<double, std::milli>(Clock::now() - encodeStart).count();
+
+	printf("%-32s %10s %5s %8s %11s %10s %10s %10s %6s\n", "file", "size", "mips", "psnr dB", "png decode", "png KB", "rgba8 KB", "dds KB", "ratio");
+
+	size_t totalPng = 0, totalRgba = 0, totalDds = 0, totalBlocks = 0;
+	double totalDecode = 0.0;
+	const char* alphaNames[] = { "", "straight", "premultiplied", "opaque" };
+
+	for (size_t t = 0; t < textures.size(); t++)
+	{
+		CookedTexture& texture = textures[t];
+		if (!WriteDds(texture, bc7 ? DXGI_FORMAT_BC7_UNORM : DXGI_FORMAT_BC3_UNORM))
+		{
+			fprintf(stderr, "%s: can't write it\n", texture.outputPath.c_str());
+			return 1;
+		}
+
+		size_t rgbaBytes = 0;
+		for (size_t m = 0; m < texture.mips.size(); m++)
+			rgbaBytes += texture.mips[m].pixels.size() * 4;
+
+		char size[32];
+		snprintf(size, sizeof(size), "%dx%d", texture.mips[0].width, texture.mips[0].height);
+
+		printf("%-32s %10s %5d %8.2f %8.2f ms %10.1f %10.1f %10.1f %5.2fx  %s\n", FileName(texture.outputPath).c_str(), size,
+			(int)texture.mips.size(), MeasurePsnr(texture, 0, bc7), texture.decodeTime, texture.pngBytes / 1024.0,
+			rgbaBytes / 1024.0, texture.blocks.size() / 1024.0, (double)rgbaBytes / texture.blocks.size(), alphaNames[texture.alphaMode]);
+
+		totalPng += texture.pngBytes;
+		totalRgba += rgbaBytes;
+		totalDds += texture.blocks.size();
+		totalBlocks += texture.blocks.size() / 16;
+		totalDecode += texture.decodeTime;
+	}
+
+	printf("%s, %d textures: %.1f KB of RGBA8 down to %.1f KB (%.2fx), %.1f ms of PNG decoding not needed at startup\n",
+		bc7 ? "BC7" : "BC3", (int)textures.size(), totalRgba / 1024.0, totalDds / 1024.0, (double)totalRgba / totalDds, totalDecode);
+	printf("encoded %zu blocks in %.1f ms on %d threads, %.0f blocks/s\n", totalBlocks, encodeTime, threadCount,
+		totalBlocks / (encodeTime / 1000.0));
+
+	return 0;
+}
@@ -0,0 +1,608 @@
+//
+// AABBTree
+//		Dynamic bounding volume tree for lots of moving shapes
+//
+
+#include "AABBTree.h"
+#include <algorithm>
+#include <math.h>
+
+// how much further a fat box is stretched in the direction something is moving
+static const float displacementMultiplier = 2.0f;
+
+// box helpers, boxes here are lower/upper corners
+static inline float Perimeter(const Vector2& lower, const Vector2& upper)
+{
+	return 2.0f * ((upper.x - lower.x) + (upper.y - lower.y));
+}
+
+static inline bool Overlaps(const Vector2& lowerA, const Vector2& upperA, const Vector2& lowerB, const Vector2& upperB)
+{
+	return lowerA.x <= upperB.x && lowerA.y <= upperB.y && lowerB.x <= upperA.x && lowerB.y <= upperA.y;
+}
+
+static inline bool Contains(const Vector2& lowerA, const Vector2& upperA, const Vector2& lowerB, const Vector2& upperB)
+{
+	return lowerA.x <= lowerB.x && lowerA.y <= lowerB.y && upperB.x <= upperA.x && upperB.y <= upperA.y;
+}
+
+// -----------------------------------------------------
+// Constructor
+//
+AABBTree::AABBTree(float _margin)
+{
+	margin = _margin;
+	root = -1;
+	freeList = -1;
+	proxyCount = 0;
+}
+
+// -----------------------------------------------------
+// Removes everything
+//
+void AABBTree::Clear()
+{
+	nodes.clear();
+	root = -1;
+	freeList = -1;
+	proxyCount = 0;
+}
+
+// -----------------------------------------------------
+// Get a node from the free list, or make a new one
+//
+int AABBTree::AllocateNode()
+{
+	int node;
+
+	if (freeList >= 0)
+	{
+		node = freeList;
+		freeList = nodes[node].parent;
+	}
+	else
+	{
+		node = (int)nodes.size();
+		nodes.push_back(Node());
+	}
+
+	nodes[node].parent = -1;
+	nodes[node].child1 = -1;
+	nodes[node].child2 = -1;
+	nodes[node].height = 0;
+	nodes[node].userData = -1;
+
+	return node;
+}
+
+// -----------------------------------------------------
+// Put a node back on the free list
+//
+void AABBTree::FreeNode(int node)
+{
+	nodes[node].parent = freeList;
+	nodes[node].height = -1;
+	freeList = node;
+}
+
+// -----------------------------------------------------
+// Add a shape to the tree
+//
+int AABBTree::Insert(const Box2D& box, int userData)
+{
+	int proxy = AllocateNode();
+
+	Vector2 fat = box.extents + Vector2(margin, margin);
+	nodes[proxy].lower = box.center - fat;
+	nodes[proxy].upper = box.center + fat;
+	nodes[proxy].userData = userData;
+	nodes[proxy].height = 0;
+
+	InsertLeaf(proxy);
+	proxyCount++;
+
+	return proxy;
+}
+
+int AABBTree::Insert(const Circle& circle, int userData)
+{
+	return Insert(Box2D(circle.center, Vector2(circle.radius, circle.radius)), userData);
+}
+
+// -----------------------------------------------------
+// Take a shape out of the tree
+//
+void AABBTree::Remove(int proxy)
+{
+	if (proxy < 0 || proxy >= (int)nodes.size() || nodes[proxy].height != 0)
+		return;
+
+	RemoveLeaf(proxy);
+	FreeNode(proxy);
+	proxyCount--;
+}
+
+// -----------------------------------------------------
+// A shape moved, only change the tree if it left its fat box
+//
+bool AABBTree::Move(int proxy, const Box2D& box, Vector2 displacement)
+{
+	Vector2 lower = box.center - box.extents;
+	Vector2 upper = box.center + box.extents;
+
+	// the new fat box, stretched in the direction we are moving
+	Vector2 fatLower = lower - Vector2(margin, margin);
+	Vector2 fatUpper = upper + Vector2(margin, margin);
+
+	Vector2 stretch = displacement * displacementMultiplier;
+	if (stretch.x < 0) fatLower.x += stretch.x; else fatUpper.x += stretch.x;
+	if (stretch.y < 0) fatLower.y += stretch.y; else fatUpper.y += stretch.y;
+
+	const Node& node = nodes[proxy];
+	if (Contains(node.lower, node.upper, lower, upper))
+	{
+		// still inside, unless the fat box is now much bigger than it needs to be (it slowed down)
+		Vector2 hugeLower = fatLower - (fatUpper - fatLower);
+		Vector2 hugeUpper = fatUpper + (fatUpper - fatLower);
+		if (Contains(hugeLower, hugeUpper, node.lower, node.upper))
+			return false;
+	}
+
+	RemoveLeaf(proxy);
+
+	nodes[proxy].lower = fatLower;
+	nodes[proxy].upper = fatUpper;
+
+	InsertLeaf(proxy);
+	return true;
+}
+
+bool AABBTree::Move(int proxy, const Circle& circle, Vector2 displacement)
+{
+	return Move(proxy, Box2D(circle.center, Vector2(circle.radius, circle.radius)), displacement);
+}
+
+// -----------------------------------------------------
+// Get the fat box of a proxy
+//
+Box2D AABBTree::GetFatBox(int proxy) const
+{
+	const Node& node = nodes[proxy];
+	return Box2D((node.lower + node.upper) * 0.5f, (node.upper - node.lower) * 0.5f);
+}
+
+// -----------------------------------------------------
+// Insert a leaf next to the sibling that grows the tree the least
+//
+void AABBTree::InsertLeaf(int leaf)
+{
+	if (root < 0)
+	{
+		root = leaf;
+		nodes[root].parent = -1;
+		return;
+	}
+
+	Vector2 leafLower = nodes[leaf].lower;
+	Vector2 leafUpper = nodes[leaf].upper;
+
+	// walk down, picking the cheapest child each time (cost is the perimeter of the boxes)
+	int index = root;
+	while (!nodes[index].IsLeaf())
+	{
+		const Node& node = nodes[index];
+
+		float area = Perimeter(node.lower, node.upper);
+		float combinedArea = Perimeter(Vector2::Min(node.lower, leafLower), Vector2::Max(node.upper, leafUpper));
+
+		// cost of making a new parent for this node and the leaf
+		float cost = 2.0f * combinedArea;
+
+		// minimum cost of pushing the leaf further down
+		float inheritanceCost = 2.0f * (combinedArea - area);
+
+		float childCost[2];
+		int children[2] = { node.child1, node.child2 };
+		for (int c = 0; c < 2; c++)
+		{
+			const Node& child = nodes[children[c]];
+			float childArea = Perimeter(Vector2::Min(child.lower, leafLower), Vector2::Max(child.upper, leafUpper));
+
+			if (child.IsLeaf())
+				childCost[c] = childArea + inheritanceCost;
+			else
+				childCost[c] = (childArea - Perimeter(child.lower, child.upper)) + inheritanceCost;
+		}
+
+		// stop here if that's the cheapest
+		if (cost < childCost[0] && cost < childCost[1])
+			break;
+
+		index = childCost[0] < childCost[1] ? children[0] : children[1];
+	}
+
+	int sibling = index;
+
+	// make a new parent for the sibling and the leaf
+	int oldParent = nodes[sibling].parent;
+	int newParent = AllocateNode();
+
+	nodes[newParent].parent = oldParent;
+	nodes[newParent].lower = Vector2::Min(leafLower, nodes[sibling].lower);
+	nodes[newParent].upper = Vector2::Max(leafUpper, nodes[sibling].upper);
+	nodes[newParent].height = nodes[sibling].height + 1;
+	nodes[newParent].child1 = sibling;
+	nodes[newParent].child2 = leaf;
+	nodes[sibling].parent = newParent;
+	nodes[leaf].parent = newParent;
+
+	if (oldParent >= 0)
+	{
+		// the sibling wasn't the root
+		if (nodes[oldParent].child1 == sibling)
+			nodes[oldParent].child1 = newParent;
+		else
+			nodes[oldParent].child2 = newParent;
+	}
+	else
+	{
+		root = newParent;
+	}
+
+	Refit(nodes[leaf].parent);
+}
+
+// -----------------------------------------------------
+// Take a leaf out, its sibling takes the place of their parent
+//
+void AABBTree::RemoveLeaf(int leaf)
+{
+	if (leaf == root)
+	{
+		root = -1;
+		return;
+	}
+
+	int parent = nodes[leaf].parent;
+	int grandParent = nodes[parent].parent;
+	int sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+	if (grandParent >= 0)
+	{
+		if (nodes[grandParent].child1 == parent)
+			nodes[grandParent].child1 = sibling;
+		else
+			nodes[grandParent].child2 = sibling;
+
+		nodes[sibling].parent = grandParent;
+		FreeNode(parent);
+
+		Refit(grandParent);
+	}
+	else
+	{
+		root = sibling;
+		nodes[sibling].parent = -1;
+		FreeNode(parent);
+	}
+}
+
+// -----------------------------------------------------
+// Walk up to the root, balancing and fixing the boxes and heights
+//
+void AABBTree::Refit(int index)
+{
+	while (index >= 0)
+	{
+		index = Balance(index);
+
+		int child1 = nodes[index].child1;
+		int child2 = nodes[index].child2;
+
+		nodes[index].height = 1 + std::max(nodes[child1].height, nodes[child2].height);
+		nodes[index].lower = Vector2::Min(nodes[child1].lower, nodes[child2].lower);
+		nodes[index].upper = Vector2::Max(nodes[child1].upper, nodes[child2].upper);
+
+		index = nodes[index].parent;
+	}
+}
+
+// -----------------------------------------------------
+// If one side of A is more than one level taller than the other,
+//	rotate the taller child up into A's place. A becomes its child, keeping
+//	the other side plus the shorter of the grandchildren
+//
+int AABBTree::Balance(int iA)
+{
+	if (nodes[iA].IsLeaf() || nodes[iA].height < 2)
+		return iA;
+
+	int iB = nodes[iA].child1;
+	int iC = nodes[iA].child2;
+
+	int balance = nodes[iC].height - nodes[iB].height;
+
+	// work out which child moves up, and its children
+	int iUp;		// the child moving up
+	int iStay;		// the child staying under A
+	if (balance > 1)
+	{
+		iUp = iC;
+		iStay = iB;
+	}
+	else if (balance < -1)
+	{
+		iUp = iB;
+		iStay = iC;
+	}
+	else
+	{
+		return iA;
+	}
+
+	int iF = nodes[iUp].child1;
+	int iG = nodes[iUp].child2;
+
+	// the child moving up takes A's place
+	nodes[iUp].child1 = iA;
+	nodes[iUp].parent = nodes[iA].parent;
+	nodes[iA].parent = iUp;
+
+	if (nodes[iUp].parent >= 0)
+	{
+		int parent = nodes[iUp].parent;
+		if (nodes[parent].child1 == iA)
+			nodes[parent].child1 = iUp;
+		else
+			nodes[parent].child2 = iUp;
+	}
+	else
+	{
+		root = iUp;
+	}
+
+	// the taller grandchild stays with the child that moved up, the shorter one moves under A
+	int iKeep = iF;
+	int iGive = iG;
+	if (nodes[iG].height > nodes[iF].height)
+	{
+		iKeep = iG;
+		iGive = iF;
+	}
+
+	nodes[iUp].child2 = iKeep;
+	if (iUp == iC)
+		nodes[iA].child2 = iGive;
+	else
+		nodes[iA].child1 = iGive;
+	nodes[iGive].parent = iA;
+
+	// fix A first, it's now below the child that moved up
+	nodes[iA].lower = Vector2::Min(nodes[iStay].lower, nodes[iGive].lower);
+	nodes[iA].upper = Vector2::Max(nodes[iStay].upper, nodes[iGive].upper);
+	nodes[iA].height = 1 + std::max(nodes[iStay].height, nodes[iGive].height);
+
+	nodes[iUp].lower = Vector2::Min(nodes[iA].lower, nodes[iKeep].lower);
+	nodes[iUp].upper = Vector2::Max(nodes[iA].upper, nodes[iKeep].upper);
+	nodes[iUp].height = 1 + std::max(nodes[iA].height, nodes[iKeep].height);
+
+	return iUp;
+}
+
+// -----------------------------------------------------
+// Gather the proxies whose fat boxes overlap box
+//
+int AABBTree::Query(const Box2D& box, std::vector<int>& results) const
+{
+	if (root < 0)
+		return 0;
+
+	Vector2 lower = box.center - box.extents;
+	Vector2 upper = box.center + box.extents;
+	int found = 0;
+
+	stack.clear();
+	stack.push_back(root);
+
+	while (!stack.empty())
+	{
+		int index = stack.back();
+		stack.pop_back();
+
+		const Node& node = nodes[index];
+		if (!Overlaps(node.lower, node.upper, lower, upper))
+			continue;
+
+		if (node.IsLeaf())
+		{
+			results.push_back(index);
+			found++;
+		}
+		else
+		{
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	return found;
+}
+
+// -----------------------------------------------------
+// Gather every pair of overlapping proxies
+//	each leaf queries the tree, and only keeps pairs where it is the lower id
+//
+int AABBTree::QueryPairs(std::vector<ProxyPair>& pairs) const
+{
+	int found = 0;
+
+	for (int leaf = 0; leaf < (int)nodes.size(); leaf++)
+	{
+		if (nodes[leaf].height != 0)
+			continue;
+
+		Vector2 lower = nodes[leaf].lower;
+		Vector2 upper = nodes[leaf].upper;
+
+		stack.clear();
+		stack.push_back(root);
+
+		while (!stack.empty())
+		{
+			int index = stack.back();
+			stack.pop_back();
+
+			const Node& node = nodes[index];
+			if (!Overlaps(node.lower, node.upper, lower, upper))
+				continue;
+
+			if (node.IsLeaf())
+			{
+				if (index > leaf)
+				{
+					ProxyPair pair;
+					pair.proxyA = leaf;
+					pair.proxyB = index;
+					pairs.push_back(pair);
+					found++;
+				}
+			}
+			else
+			{
+				stack.push_back(node.child1);
+				stack.push_back(node.child2);
+			}
+		}
+	}
+
+	return found;
+}
+
+// -----------------------------------------------------
+// Gather the proxies a segment crosses, closest first
+//
+int AABBTree::RayCast(const Line2D& segment, std::vector<ProxyRayHit>& results) const
+{
+	if (root < 0)
+		return 0;
+
+	Vector2 start = segment.start;
+	Vector2 direction = segment.end - segment.start;
+	size_t first = results.size();
+
+	stack.clear();
+	stack.push_back(root);
+
+	while (!stack.empty())
+	{
+		int index = stack.back();
+		stack.pop_back();
+
+		const Node& node = nodes[index];
+
+		// slab test against the node's box
+		float tEnter = 0.0f;
+		float tExit = 1.0f;
+		bool hit = true;
+
+		for (int axis = 0; axis < 2 && hit; axis++)
+		{
+			float p = axis == 0 ? start.x : start.y;
+			float d = axis == 0 ? direction.x : direction.y;
+			float lo = axis == 0 ? node.lower.x : node.lower.y;
+			float hi = axis == 0 ? node.upper.x : node.upper.y;
+
+			if (d == 0.0f)
+			{
+				hit = p >= lo && p <= hi;
+				continue;
+			}
+
+			float t1 = (lo - p) / d;
+			float t2 = (hi - p) / d;
+			if (t1 > t2)
+				std::swap(t1, t2);
+
+			tEnter = std::max(tEnter, t1);
+			tExit = std::min(tExit, t2);
+			hit = tEnter <= tExit;
+		}
+
+		if (!hit)
+			continue;
+
+		if (node.IsLeaf())
+		{
+			ProxyRayHit rayHit;
+			rayHit.proxy = index;
+			rayHit.fraction = tEnter;
+			results.push_back(rayHit);
+		}
+		else
+		{
+			stack.push_back(node.child1);
+			stack.push_back(node.child2);
+		}
+	}
+
+	// closest first
+	std::sort(results.begin() + first, results.end(),
+		[](const ProxyRayHit& a, const ProxyRayHit& b) { return a.fraction < b.fraction; });
+
+	return (int)(results.size() - first);
+}
+
+// -----------------------------------------------------
+// Check the tree is consistent
+//
+bool AABBTree::Validate() const
+{
+	if (root < 0)
+		return proxyCount == 0;
+
+	if (nodes[root].parent != -1)
+		return false;
+
+	// count the leaves
+	int leaves = 0;
+	for (int i = 0; i < (int)nodes.size(); i++)
+	{
+		if (nodes[i].height == 0)
+			leaves++;
+	}
+
+	// every node not in the tree has to be on the free list, a tree of n leaves has n - 1 parents
+	int freeNodes = 0;
+	for (int i = freeList; i >= 0; i = nodes[i].parent)
+	{
+		if (nodes[i].height != -1 || ++freeNodes > (int)nodes.size())
+			return false;
+	}
+
+	return leaves == proxyCount && freeNodes + 2 * proxyCount - 1 == (int)nodes.size() && ValidateNode(root, -1);
+}
+
+bool AABBTree::ValidateNode(int index, int parent) const
+{
+	const Node& node = nodes[index];
+
+	if (node.parent != parent)
+		return false;
+
+	if (node.IsLeaf())
+		return node.height == 0;
+
+	const Node& child1 = nodes[node.child1];
+	const Node& child2 = nodes[node.child2];
+
+	// heights and boxes have to fit the children. the rotations only move the taller child up
+	//	one level, so the two sides aren't always within one of each other, like they would be
+	//	in an AVL tree
+	if (node.height != 1 + std::max(child1.height, child2.height))
+		return false;
+	if (!Contains(node.lower, node.upper, child1.lower, child1.upper) ||
+		!Contains(node.lower, node.upper, child2.lower, child2.upper))
+		return false;
+
+	return ValidateNode(node.child1, index) && ValidateNode(node.child2, index);
+}
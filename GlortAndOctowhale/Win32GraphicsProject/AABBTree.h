@@ -0,0 +1,108 @@
+//
+// AABBTree
+//		Dynamic bounding volume tree for lots of moving shapes
+//
+//	Each shape (proxy) is stored in a leaf with a "fat" box, its box grown by a margin.
+//	Moving a shape only touches the tree when it leaves its fat box, and the tree is kept
+//	close to balanced with rotations as shapes come and go, so queries stay O(log n). It
+//	isn't strictly balanced: with 50k moving shapes it's about 19 deep, against 16 for a
+//	perfect tree (see Benchmarks/AABBTreeBenchmark.cpp).
+//
+
+#ifndef _AABB_TREE_H
+#define _AABB_TREE_H
+
+#include <vector>
+#include "Collision2D.h"
+
+// a proxy whose fat box a segment crosses, fraction (0-1) is where along the segment it enters
+struct ProxyRayHit
+{
+	int		proxy;
+	float	fraction;
+};
+
+class AABBTree
+{
+public:
+	// margin is how far boxes are grown, so small movements don't change the tree
+	AABBTree(float margin = 4.0f);
+
+	// add a shape, returns the proxy id used to refer to it. userData is kept for the caller
+	int Insert(const Box2D& box, int userData);
+	int Insert(const Circle& circle, int userData);
+
+	// take a shape out of the tree
+	void Remove(int proxy);
+
+	// a shape moved to box. displacement is how far it moved this frame, used to grow the fat box
+	//	in the direction of travel. returns true if the tree had to be changed
+	bool Move(int proxy, const Box2D& box, Vector2 displacement);
+	bool Move(int proxy, const Circle& circle, Vector2 displacement);
+
+	// removes everything
+	void Clear();
+
+	// the fat box and user data of a proxy
+	Box2D GetFatBox(int proxy) const;
+	int GetUserData(int proxy) const { return nodes[proxy].userData; }
+
+	// gathers the proxies whose fat boxes overlap box, returns how many were added
+	int Query(const Box2D& box, std::vector<int>& results) const;
+
+	// gathers every pair of proxies whose fat boxes overlap, returns how many were added
+	int QueryPairs(std::vector<ProxyPair>& pairs) const;
+
+	// gathers the proxies whose fat boxes the segment crosses, closest first
+	//	returns how many were added
+	int RayCast(const Line2D& segment, std::vector<ProxyRayHit>& results) const;
+
+	// information about the tree
+	int GetProxyCount() const { return proxyCount; }
+	int GetHeight() const { return root < 0 ? 0 : nodes[root].height; }
+
+	// checks the tree is consistent, for debugging: parent links, heights, every box holds
+	//	its children, and every node is either in the tree or on the free list
+	bool Validate() const;
+
+private:
+	// boxes are stored as min/max inside the tree, it makes the unions cheap
+	struct Node
+	{
+		Vector2	lower;
+		Vector2	upper;
+
+		int		parent;		// also the next free node when the node isn't used
+		int		child1;
+		int		child2;
+		int		height;		// leaves are 0, free nodes are -1
+		int		userData;
+
+		bool IsLeaf() const { return child1 < 0; }
+	};
+
+	int AllocateNode();
+	void FreeNode(int node);
+
+	void InsertLeaf(int leaf);
+	void RemoveLeaf(int leaf);
+
+	// rotate the tree at node if it is out of balance, returns the new root of the subtree
+	int Balance(int node);
+
+	// fix the heights and boxes from node up to the root
+	void Refit(int node);
+
+	bool ValidateNode(int node, int parent) const;
+
+	std::vector<Node>	nodes;
+	int					root;
+	int					freeList;
+	int					proxyCount;
+	float				margin;
+
+	// scratch stack for queries, so they don't allocate
+	mutable std::vector<int> stack;
+};
+
+#endif // _AABB_TREE_H
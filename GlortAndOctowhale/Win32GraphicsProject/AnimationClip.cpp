@@ -0,0 +1,111 @@
+//
+// AnimationClip
+//		Named runs of frames in a sheet, and the library that keeps them
+//
+
+#include "AnimationClip.h"
+#include "FrameTable.h"
+#include "SpriteSheet.h"
+#include "AssetPack.h"
+
+// -----------------------------------------------------
+// Constructor
+//
+ClipLibrary::ClipLibrary()
+{
+}
+
+ClipLibrary::~ClipLibrary()
+{
+	Clear();
+}
+
+// -----------------------------------------------------
+// Add a clip, or replace the one with the same name
+//
+const AnimationClip* ClipLibrary::Add(const std::string& name, TextureType* pTexture, int frameWidth, int frameHeight,
+	float framesPerSecond, AnimationClip::Mode mode, int firstFrame, int frameCount)
+{
+	return Put(name, pTexture, FrameTable::Get(pTexture, frameWidth, frameHeight), framesPerSecond, mode, firstFrame, frameCount);
+}
+
+// -----------------------------------------------------
+// Add every clip a sheet descriptor names
+//
+bool ClipLibrary::AddSheet(const char* sheetFileName, TextureType* pTexture)
+{
+	const FrameTable* pFrames = FrameTable::Load(sheetFileName, pTexture);
+	if (pFrames == nullptr)
+		return false;
+
+	// the table keeps the frames, the clips are only wanted here
+	SpriteSheet sheet;
+	AssetData file;
+	if (!AssetPack::ReadFile(sheetFileName, file) || !sheet.Parse(file.data, file.size))
+		return false;
+
+	for (int i = 0; i < sheet.GetClipCount(); i++)
+	{
+		const SheetClip& c = sheet.GetClip(i);
+		Put(c.name, pTexture, pFrames, c.framesPerSecond, (AnimationClip::Mode)c.mode, c.firstFrame, c.frameCount);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------
+// Add or replace a clip
+//
+const AnimationClip* ClipLibrary::Put(const std::string& name, TextureType* pTexture, const FrameTable* pFrames,
+	float framesPerSecond, AnimationClip::Mode mode, int firstFrame, int frameCount)
+{
+	if (pFrames == nullptr || firstFrame < 0 || firstFrame >= pFrames->GetFrameCount())
+		return nullptr;
+
+	// keep it within the sheet
+	int available = pFrames->GetFrameCount() - firstFrame;
+	if (frameCount <= 0 || frameCount > available)
+		frameCount = available;
+
+	AnimationClip* pClip = const_cast<AnimationClip*>(Find(name));
+	if (pClip == nullptr)
+	{
+		pClip = new AnimationClip;
+		clips.push_back(pClip);
+	}
+
+	pClip->name = name;
+	pClip->pTexture = pTexture;
+	pClip->pFrames = pFrames;
+	pClip->firstFrame = firstFrame;
+	pClip->frameCount = frameCount;
+	pClip->framesPerSecond = framesPerSecond;
+	pClip->mode = mode;
+
+	return pClip;
+}
+
+// -----------------------------------------------------
+// Find a clip by name
+//
+const AnimationClip* ClipLibrary::Find(const std::string& name) const
+{
+	for (size_t i = 0; i < clips.size(); i++)
+	{
+		if (clips[i]->name == name)
+			return clips[i];
+	}
+	return nullptr;
+}
+
+// -----------------------------------------------------
+// Delete every clip
+//
+void ClipLibrary::Clear()
+{
+	for (size_t i = 0; i < clips.size(); i++)
+	{
+		delete clips[i];
+	}
+	clips.clear();
+}
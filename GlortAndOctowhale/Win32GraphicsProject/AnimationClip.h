@@ -0,0 +1,97 @@
+//
+// AnimationClip
+//		Named runs of frames in a sheet, and the library that keeps them
+//
+//	A clip is a range of frames from a FrameTable, played at its own rate in one of a
+//	few modes. Clips live in a ClipLibrary and sprites only point at them, so lots of
+//	sprites can share one clip, and a sprite changes what it looks like (damaged, powered
+//	up...) by playing another clip rather than needing another sprite.
+//
+
+#ifndef _ANIMATION_CLIP_H
+#define _ANIMATION_CLIP_H
+
+#include <string>
+#include <vector>
+
+// forward declares
+class TextureType;
+class FrameTable;
+class Sprite;
+
+struct AnimationClip
+{
+	enum Mode
+	{
+		Loop,		// 0 1 2 0 1 2 ...
+		Once,		// 0 1 2, then stays on 2
+		PingPong	// 0 1 2 1 0 1 2 ...
+	};
+
+	std::string			name;
+	TextureType*		pTexture;
+	const FrameTable*	pFrames;
+	int					firstFrame;			// into pFrames
+	int					frameCount;
+	float				framesPerSecond;
+	Mode				mode;
+
+	// frames in one time through the clip, ping-pong goes there and back
+	int CycleLength() const
+	{
+		if (mode == PingPong && frameCount > 1)
+			return frameCount * 2 - 2;
+		return frameCount;
+	}
+};
+
+// gets told when a sprite's clip ends
+class ClipListener
+{
+public:
+	virtual ~ClipListener() {}
+
+	// a Once clip reached its last frame, or a Loop / PingPong clip came back round to the start
+	//	it's fine to play another clip on the sprite from here
+	virtual void OnClipFinished(Sprite* pSprite, const AnimationClip* pClip) = 0;
+};
+
+class ClipLibrary
+{
+public:
+	ClipLibrary();
+	~ClipLibrary();
+
+	// add a clip of frameCount frames from firstFrame, in a sheet cut into frameWidth x frameHeight
+	//	frameCount <= 0 means the rest of the sheet. adding a name that is already there
+	//	replaces that clip in place, sprites playing it should PlayClip it again.
+	//	returns null if the sheet has no such frames
+	const AnimationClip* Add(const std::string& name, TextureType* pTexture, int frameWidth, int frameHeight,
+		float framesPerSecond, AnimationClip::Mode mode = AnimationClip::Loop, int firstFrame = 0, int frameCount = 0);
+
+	// add every clip in a sheet descriptor (see SpriteSheet), each under the name it has there
+	//	returns false if the sheet can't be loaded for this texture
+	bool AddSheet(const char* sheetFileName, TextureType* pTexture);
+
+	// find a clip by name, null if there isn't one
+	const AnimationClip* Find(const std::string& name) const;
+
+	// delete every clip. nothing may be playing them
+	void Clear();
+
+	int GetCount() const { return (int)clips.size(); }
+
+private:
+	// add or replace a clip from frames that are already worked out
+	const AnimationClip* Put(const std::string& name, TextureType* pTexture, const FrameTable* pFrames,
+		float framesPerSecond, AnimationClip::Mode mode, int firstFrame, int frameCount);
+
+	// clips are never moved once added, sprites hold pointers to them
+	std::vector<AnimationClip*> clips;
+
+	// no copying
+	ClipLibrary(const ClipLibrary&);
+	ClipLibrary& operator=(const ClipLibrary&);
+};
+
+#endif // _ANIMATION_CLIP_H
@@ -0,0 +1,302 @@
+//
+// AssetLoader
+//		Reads and decodes images on a pool of worker threads
+//
+
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "DecodeCache.h"
+#include <stdio.h>
+#ifdef _WIN32
+#include <Windows.h>	// OutputDebugStringA
+#endif
+
+// -----------------------------------------------------
+// Constructor / destructor
+//
+AssetLoader::AssetLoader(int threads)
+{
+	busy = 0;
+	quitting = false;
+	premultiply = false;
+	start = std::chrono::steady_clock::now();
+
+	if (threads <= 0)
+	{
+		threads = (int)std::thread::hardware_concurrency() - 1;
+		if (threads < 1)
+			threads = 1;
+		if (threads > 8)
+			threads = 8;	// there are under 20 images, more won't help
+	}
+
+	for (int i = 0; i < threads; i++)
+	{
+		workers.push_back(std::thread(&AssetLoader::WorkerLoop, this));
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quitting = true;
+
+		// nobody gets these now
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			queue[i]->started = true;
+			queue[i]->done = true;
+			queue[i]->error = "loader stopped";
+		}
+		queue.clear();
+	}
+	wake.notify_all();
+	finished.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+double AssetLoader::GetMilliseconds() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// -----------------------------------------------------
+// Queue an image
+//
+std::shared_ptr<PendingImage> AssetLoader::Queue(const wchar_t* fileName)
+{
+	return Add(fileName, nullptr, nullptr);
+}
+
+std::shared_ptr<PendingImage> AssetLoader::Queue(const AssetPack& pack, const PackEntry& entry, const wchar_t* fileName)
+{
+	return Add(fileName, &pack, &entry);
+}
+
+std::shared_ptr<PendingImage> AssetLoader::Add(const wchar_t* fileName, const AssetPack* pack, const PackEntry* packEntry)
+{
+	std::shared_ptr<PendingImage> pending = std::make_shared<PendingImage>();
+	pending->fileName = fileName;
+	pending->pack = pack;
+	pending->packEntry = packEntry;
+	pending->premultiplied = premultiply;
+	pending->cached = false;
+	pending->started = false;
+	pending->done = false;
+	pending->fileBytes = 0;
+	pending->queuedAt = GetMilliseconds();
+	pending->readTime = 0.0;
+	pending->decodeTime = 0.0;
+	pending->doneAt = 0.0;
+	pending->waitTime = 0.0;
+	pending->uploadTime = -1.0;
+
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		queue.push_back(pending);
+		loads.push_back(pending);
+	}
+	wake.notify_one();
+
+	return pending;
+}
+
+// -----------------------------------------------------
+// Wait for one, doing it here if nobody has started it
+//
+bool AssetLoader::Wait(PendingImage& pending)
+{
+	double waitStart = GetMilliseconds();
+
+	std::unique_lock<std::mutex> guard(lock);
+	if (!pending.started)
+	{
+		for (size_t i = 0; i < queue.size(); i++)
+		{
+			if (queue[i].get() == &pending)
+			{
+				queue.erase(queue.begin() + i);
+				break;
+			}
+		}
+		pending.started = true;
+
+		guard.unlock();
+		Run(pending);
+		guard.lock();
+
+		pending.done = true;
+		finished.notify_all();
+	}
+	else
+	{
+		finished.wait(guard, [&] { return pending.done; });
+	}
+
+	pending.waitTime = GetMilliseconds() - waitStart;
+	return pending.error.empty();
+}
+
+bool AssetLoader::IsIdle() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return queue.empty() && busy == 0;
+}
+
+// -----------------------------------------------------
+// Workers take the oldest image until told to stop
+//
+void AssetLoader::WorkerLoop()
+{
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;)
+	{
+		wake.wait(guard, [&] { return quitting || !queue.empty(); });
+		if (quitting)
+			return;
+
+		std::shared_ptr<PendingImage> pending = queue.front();
+		queue.pop_front();
+		pending->started = true;
+		busy++;
+
+		guard.unlock();
+		Run(*pending);
+		guard.lock();
+
+		pending->done = true;
+		busy--;
+		finished.notify_all();
+	}
+}
+
+// -----------------------------------------------------
+// Read the file and decode it
+//
+void AssetLoader::Run(PendingImage& pending)
+{
+	double readStart = GetMilliseconds();
+
+	// a stored file in a pack is decoded where it's mapped, the read is only for compressed ones
+	AssetData data;
+	if (pending.pack != nullptr)
+	{
+		if (!pending.pack->Read(*pending.packEntry, data))
+		{
+			pending.error = "can't inflate it";
+			pending.doneAt = GetMilliseconds();
+			return;
+		}
+	}
+	else
+	{
+#ifdef _WIN32
+		FILE* file = _wfopen(pending.fileName.c_str(), L"rb");
+#else
+		std::string narrow(pending.fileName.begin(), pending.fileName.end());
+		FILE* file = fopen(narrow.c_str(), "rb");
+#endif
+		if (file == nullptr)
+		{
+			pending.error = "can't open it";
+			pending.doneAt = GetMilliseconds();
+			return;
+		}
+
+		fseek(file, 0, SEEK_END);
+		long size = ftell(file);
+		fseek(file, 0, SEEK_SET);
+		if (size > 0)
+		{
+			data.buffer.resize(size);
+			data.buffer.resize(fread(data.buffer.data(), 1, data.buffer.size(), file));
+		}
+		fclose(file);
+
+		data.data = data.buffer.data();
+		data.size = data.buffer.size();
+	}
+
+	double decodeStart = GetMilliseconds();
+	pending.fileBytes = data.size;
+	pending.readTime = decodeStart - readStart;
+
+	// straight out of the decode cache if this PNG has been decoded before
+	DecodeCache::Decode(data.data, data.size, pending.image, &pending.error, pending.premultiplied, &pending.cached);
+
+	pending.doneAt = GetMilliseconds();
+	pending.decodeTime = pending.doneAt - decodeStart;
+}
+
+// -----------------------------------------------------
+// Report
+//
+void AssetLoader::LogReport(double firstFrame) const
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	double working = 0.0;
+	double lastDone = 0.0;
+	int cached = 0;
+	for (size_t i = 0; i < loads.size(); i++)
+	{
+		// the workers are still writing the times of anything not done
+		if (!loads[i]->done)
+			continue;
+
+		working += loads[i]->readTime + loads[i]->decodeTime;
+		cached += loads[i]->cached ? 1 : 0;
+		if (loads[i]->doneAt > lastDone)
+			lastDone = loads[i]->doneAt;
+	}
+
+	char line[512];
+	snprintf(line, sizeof(line), "AssetLoader: %d images on %d threads (%d from the decode cache), all decoded at %.1f ms, %.1f ms of reading and decoding\n",
+		(int)loads.size(), (int)workers.size(), cached, lastDone, working);
+	std::string text = line;
+
+	if (firstFrame >= 0.0)
+	{
+		snprintf(line, sizeof(line), "AssetLoader: first frame drawn at %.1f ms\n", firstFrame);
+		text += line;
+	}
+
+	for (size_t i = 0; i < loads.size(); i++)
+	{
+		const PendingImage& p = *loads[i];
+
+		// just the file name
+		size_t slash = p.fileName.find_last_of(L"\\/");
+		std::wstring wide = slash == std::wstring::npos ? p.fileName : p.fileName.substr(slash + 1);
+		std::string name(wide.begin(), wide.end());
+
+		if (!p.done)
+		{
+			snprintf(line, sizeof(line), "  %-32s still loading\n", name.c_str());
+			text += line;
+			continue;
+		}
+
+		char upload[32];
+		if (p.uploadTime >= 0.0)
+			snprintf(upload, sizeof(upload), "%.2f ms", p.uploadTime);
+		else
+			snprintf(upload, sizeof(upload), "not yet");
+
+		snprintf(line, sizeof(line), "  %-32s %7.1f KB  read %6.2f ms  %s %7.2f ms  done at %7.1f ms  waited %6.2f ms  upload %s%s%s\n",
+			name.c_str(), p.fileBytes / 1024.0, p.readTime, p.cached ? "cached" : "decode", p.decodeTime, p.doneAt, p.waitTime, upload,
+			p.error.empty() ? "" : "  FAILED: ", p.error.c_str());
+		text += line;
+	}
+
+#ifdef _WIN32
+	OutputDebugStringA(text.c_str());
+#else
+	fputs(text.c_str(), stderr);
+#endif
+}
@@ -0,0 +1,118 @@
+//
+// AssetLoader
+//		Reads and decodes images on a pool of worker threads
+//
+//	Queue adds a file and returns straight away with a PendingImage. Workers read
+//	the file, or find it in an AssetPack, and decode it to RGBA (PngCodec), which is
+//	the slow part; making the D3D texture from the pixels is quick and happens on the
+//	main thread, when the texture is first used (see TextureType::LoadAsync). Waiting for an image that no worker has
+//	started yet decodes it on the waiting thread instead of sitting in the queue.
+//
+//	With a DecodeCache directory set, a PNG decoded on an earlier run is read back as
+//	pixels instead of being decoded again.
+//
+//	Every load is timed, and LogReport writes the times out per file.
+//
+
+#ifndef _ASSET_LOADER_H
+#define _ASSET_LOADER_H
+
+#include "PngCodec.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class AssetPack;
+struct PackEntry;
+
+// one image on its way. the loader fills it in, the main thread reads it once done is set
+struct PendingImage
+{
+	std::wstring	fileName;
+	const AssetPack*	pack;		// where it's read from, null for the disk
+	const PackEntry*	packEntry;
+	ImageRGBA		image;
+	std::string		error;			// why it failed, empty if it didn't
+	bool			premultiplied;	// colours were multiplied by alpha as it decoded
+	bool			cached;			// the pixels came from the DecodeCache, not a decode
+	bool			started;		// guarded by the loader's lock
+	bool			done;
+
+	// milliseconds, from when the loader was made
+	size_t			fileBytes;
+	double			queuedAt;
+	double			readTime;
+	double			decodeTime;
+	double			doneAt;
+	double			waitTime;		// main thread blocked on it
+	double			uploadTime;		// making the texture, < 0 until it's been made
+};
+
+class AssetLoader
+{
+public:
+	// threads 0 uses one less than the machine has, so the main thread keeps a core
+	explicit AssetLoader(int threads = 0);
+
+	// stops the workers. images still queued are failed, not loaded
+	~AssetLoader();
+
+	// multiply colours by alpha as images decode, for drawing with premultiplied blending.
+	//	only changes images queued after it
+	void SetPremultiply(bool premultiply) { this->premultiply = premultiply; }
+	bool GetPremultiply() const { return premultiply; }
+
+	// start loading an image file
+	std::shared_ptr<PendingImage> Queue(const wchar_t* fileName);
+
+	// start loading one from an asset pack, which has to stay open until it's done
+	std::shared_ptr<PendingImage> Queue(const AssetPack& pack, const PackEntry& entry, const wchar_t* fileName);
+
+	// block until the image is done. true if it decoded
+	bool Wait(PendingImage& pending);
+
+	// nothing queued or being worked on
+	bool IsIdle() const;
+
+	int GetThreadCount() const { return (int)workers.size(); }
+
+	// time since the loader was made
+	double GetMilliseconds() const;
+
+	// write every load's times to the debugger output. firstFrame is when the first frame
+	//	was drawn, to compare against, or < 0 to leave it out
+	void LogReport(double firstFrame = -1.0) const;
+
+private:
+	void WorkerLoop();
+
+	// make a PendingImage and queue it
+	std::shared_ptr<PendingImage> Add(const wchar_t* fileName, const AssetPack* pack, const PackEntry* packEntry);
+
+	// read and decode, on whichever thread gets it
+	void Run(PendingImage& pending);
+
+	std::vector<std::thread>					workers;
+	std::deque<std::shared_ptr<PendingImage>>	queue;
+	std::vector<std::shared_ptr<PendingImage>>	loads;		// everything, for the report
+	int											busy;		// workers in Run
+	bool										quitting;
+	bool										premultiply;
+
+	mutable std::mutex							lock;
+	std::condition_variable						wake;		// something queued, or quitting
+	std::condition_variable						finished;	// an image is done
+
+	std::chrono::steady_clock::time_point		start;
+
+	// no copying, the workers point at it
+	AssetLoader(const AssetLoader&);
+	AssetLoader& operator=(const AssetLoader&);
+};
+
+#endif // _ASSET_LOADER_H
@@ -0,0 +1,475 @@
+//
+// AssetPack
+//		Every asset in one file, mapped into memory and found by name
+//
+
+#include "AssetPack.h"
+#include "Zlib.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const AssetPack* AssetPack::pMounted = nullptr;
+
+// -----------------------------------------------------
+// Constructor
+//
+AssetPack::AssetPack()
+{
+	base = nullptr;
+	fileSize = 0;
+	header = nullptr;
+	entries = nullptr;
+	buckets = nullptr;
+	names = nullptr;
+}
+
+AssetPack::~AssetPack()
+{
+	Close();
+}
+
+// -----------------------------------------------------
+// Map the file
+//
+bool AssetPack::Open(const wchar_t* fileName)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	HANDLE mapping = NULL;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+		mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	// the view keeps the file open by itself
+	if (mapping != NULL)
+	{
+		base = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		fileSize = (size_t)size.QuadPart;
+		CloseHandle(mapping);
+	}
+	CloseHandle(file);
+#else
+	std::wstring wide = fileName;
+	std::string narrow(wide.begin(), wide.end());
+	int file = open(narrow.c_str(), O_RDONLY);
+	if (file < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(file, &info) == 0 && info.st_size > 0)
+	{
+		void* view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		if (view != MAP_FAILED)
+		{
+			base = (const uint8_t*)view;
+			fileSize = (size_t)info.st_size;
+		}
+	}
+	close(file);
+#endif
+
+	if (base == nullptr)
+	{
+		fileSize = 0;
+		return false;
+	}
+
+	header = (const PackHeader*)base;
+	if (!Validate())
+	{
+		Close();
+		return false;
+	}
+
+	entries = (const PackEntry*)(base + header->entriesOffset);
+	buckets = (const uint32_t*)(base + header->bucketsOffset);
+	names = (const char*)(base + header->namesOffset);
+	return true;
+}
+
+bool AssetPack::Open(const char* fileName)
+{
+	std::string narrow = fileName;
+	return Open(std::wstring(narrow.begin(), narrow.end()).c_str());
+}
+
+void AssetPack::Close()
+{
+	if (pMounted == this)
+		pMounted = nullptr;
+
+	if (base != nullptr)
+	{
+#ifdef _WIN32
+		UnmapViewOfFile(base);
+#else
+		munmap((void*)base, fileSize);
+#endif
+	}
+
+	base = nullptr;
+	fileSize = 0;
+	header = nullptr;
+	entries = nullptr;
+	buckets = nullptr;
+	names = nullptr;
+}
+
+bool AssetPack::Validate() const
+{
+	if (fileSize < sizeof(PackHeader))
+		return false;
+
+	const PackHeader& h = *header;
+	if (h.magic != Magic || h.version != Version || h.fileSize != fileSize)
+		return false;
+
+	// the tables are in order and inside the file. offsets are checked against what's left
+	//	so nothing can overflow
+	if (h.bucketCount == 0 || (h.bucketCount & (h.bucketCount - 1)) != 0 || h.entryCount >= h.bucketCount ||
+		h.entriesOffset < sizeof(PackHeader) || h.entriesOffset % 8 != 0 || h.entriesOffset > fileSize ||
+		h.entryCount > (fileSize - h.entriesOffset) / sizeof(PackEntry) ||
+		h.bucketsOffset < h.entriesOffset + h.entryCount * sizeof(PackEntry) || h.bucketsOffset % 4 != 0 || h.bucketsOffset > fileSize ||
+		h.bucketCount > (fileSize - h.bucketsOffset) / sizeof(uint32_t) ||
+		h.namesOffset < h.bucketsOffset + h.bucketCount * sizeof(uint32_t) || h.namesOffset > fileSize)
+	{
+		return false;
+	}
+
+	const PackEntry* e = (const PackEntry*)(base + h.entriesOffset);
+	uint64_t namesSize = fileSize - h.namesOffset;
+	for (uint32_t i = 0; i < h.entryCount; i++)
+	{
+		// deflate can't do better than about 1032:1, so a bigger size is a broken entry and
+		//	not something to allocate for
+		if (e[i].offset > fileSize || e[i].storedSize > fileSize - e[i].offset ||
+			e[i].nameOffset > namesSize || e[i].nameLength > namesSize - e[i].nameOffset ||
+			((e[i].flags & FlagCompressed) == 0 && e[i].storedSize != e[i].size) ||
+			e[i].size / 1032 > e[i].storedSize)
+		{
+			return false;
+		}
+	}
+
+	// one bucket for each entry, so there are empty ones to stop Find's probing
+	const uint32_t* b = (const uint32_t*)(base + h.bucketsOffset);
+	uint32_t used = 0;
+	for (uint32_t i = 0; i < h.bucketCount; i++)
+	{
+		if (b[i] > h.entryCount)
+			return false;
+		used += b[i] != 0;
+	}
+
+	return used == h.entryCount;
+}
+
+// -----------------------------------------------------
+// Names
+//
+std::string AssetPack::MakeName(const char* path)
+{
+	std::string name = path;
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		name[i] = name[i] == '/' ? '\\' : (char)tolower((unsigned char)name[i]);
+	}
+
+	// the game's paths are relative to the project directory, the pack's to the directory above
+	for (;;)
+	{
+		if (name.compare(0, 2, ".\\") == 0)
+			name.erase(0, 2);
+		else if (name.compare(0, 3, "..\\") == 0)
+			name.erase(0, 3);
+		else
+			break;
+	}
+
+	return name;
+}
+
+std::string AssetPack::MakeName(const wchar_t* path)
+{
+	// the paths are all plain ASCII
+	std::wstring wide = path;
+	return MakeName(std::string(wide.begin(), wide.end()).c_str());
+}
+
+uint64_t AssetPack::Hash(const std::string& name)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < name.size(); i++)
+	{
+		hash = (hash ^ (uint8_t)name[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+std::string AssetPack::GetName(const PackEntry& entry) const
+{
+	return std::string(names + entry.nameOffset, entry.nameLength);
+}
+
+// -----------------------------------------------------
+// Look up a name in the hash table
+//
+const PackEntry* AssetPack::FindName(const std::string& name) const
+{
+	if (base == nullptr)
+		return nullptr;
+
+	uint64_t hash = Hash(name);
+	uint32_t mask = header->bucketCount - 1;
+
+	// there's always an empty bucket, so this stops
+	for (uint32_t i = (uint32_t)hash & mask; buckets[i] != 0; i = (i + 1) & mask)
+	{
+		const PackEntry& e = entries[buckets[i] - 1];
+		if (e.hash == hash && e.nameLength == name.size() && memcmp(names + e.nameOffset, name.data(), name.size()) == 0)
+			return &e;
+	}
+
+	return nullptr;
+}
+
+const PackEntry* AssetPack::Find(const char* fileName) const
+{
+	return FindName(MakeName(fileName));
+}
+
+const PackEntry* AssetPack::Find(const wchar_t* fileName) const
+{
+	return FindName(MakeName(fileName));
+}
+
+// -----------------------------------------------------
+// Get the bytes, out of the mapping if they weren't compressed
+//
+bool AssetPack::Read(const PackEntry& entry, AssetData& out) const
+{
+	out.buffer.clear();
+	out.data = nullptr;
+	out.size = 0;
+
+	const uint8_t* blob = base + entry.offset;
+	if ((entry.flags & FlagCompressed) == 0)
+	{
+		out.data = blob;
+		out.size = (size_t)entry.size;
+		return true;
+	}
+
+	if (!Zlib::Inflate(blob, (size_t)entry.storedSize, out.buffer, (size_t)entry.size) || out.buffer.size() != entry.size)
+	{
+		out.buffer.clear();
+		return false;
+	}
+
+	out.data = out.buffer.data();
+	out.size = out.buffer.size();
+	return true;
+}
+
+bool AssetPack::Verify(std::string* error) const
+{
+	for (int i = 0; i < GetEntryCount(); i++)
+	{
+		AssetData data;
+		if (!Read(entries[i], data) || Zlib::Crc32(data.data, data.size) != entries[i].crc)
+		{
+			if (error)
+				*error = GetName(entries[i]) + " is corrupt";
+			return false;
+		}
+
+		if (FindName(GetName(entries[i])) != &entries[i])
+		{
+			if (error)
+				*error = GetName(entries[i]) + " can't be found by name";
+			return false;
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------
+// The mounted pack
+//
+void AssetPack::Mount(const AssetPack* pPack)
+{
+	pMounted = pPack != nullptr && pPack->IsOpen() ? pPack : nullptr;
+}
+
+bool AssetPack::ReadFile(const char* fileName, AssetData& out)
+{
+	const PackEntry* pEntry = pMounted ? pMounted->Find(fileName) : nullptr;
+	if (pEntry)
+		return pMounted->Read(*pEntry, out);
+
+	out.buffer.clear();
+	out.data = nullptr;
+	out.size = 0;
+
+	FILE* file = fopen(fileName, "rb");
+	if (file == nullptr)
+		return false;
+
+	uint8_t buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		out.buffer.insert(out.buffer.end(), buffer, buffer + n);
+	}
+	fclose(file);
+
+	out.data = out.buffer.data();
+	out.size = out.buffer.size();
+	return true;
+}
+
+// -----------------------------------------------------
+// Write a pack
+//
+static uint64_t AlignUp(uint64_t value, uint64_t alignment)
+{
+	return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool AssetPack::Write(const char* fileName, const std::vector<PackInput>& inputs, bool compress, int alignment, std::string* error)
+{
+	if (alignment < 1 || (alignment & (alignment - 1)) != 0)
+	{
+		if (error)
+			*error = "alignment has to be a power of two";
+		return false;
+	}
+
+	// at least twice as many buckets as entries keeps the probes short
+	uint32_t bucketCount = 16;
+	while (bucketCount < inputs.size() * 2)
+	{
+		bucketCount *= 2;
+	}
+
+	std::vector<PackEntry> table(inputs.size());
+	std::vector<uint32_t> bucketTable(bucketCount, 0);
+	std::vector<std::vector<uint8_t>> compressed(inputs.size());
+	std::string nameText;
+
+	for (size_t i = 0; i < inputs.size(); i++)
+	{
+		std::string name = MakeName(inputs[i].name.c_str());
+		const std::vector<uint8_t>& data = inputs[i].data;
+
+		PackEntry& e = table[i];
+		memset(&e, 0, sizeof(e));
+		e.hash = Hash(name);
+		e.size = data.size();
+		e.storedSize = data.size();
+		e.nameOffset = (uint32_t)nameText.size();
+		e.nameLength = (uint32_t)name.size();
+		e.crc = Zlib::Crc32(data.data(), data.size());
+		nameText += name;
+
+		uint32_t slot = (uint32_t)e.hash & (bucketCount - 1);
+		for (; bucketTable[slot] != 0; slot = (slot + 1) & (bucketCount - 1))
+		{
+			const PackEntry& other = table[bucketTable[slot] - 1];
+			if (other.hash == e.hash && nameText.compare(other.nameOffset, other.nameLength, name) == 0)
+			{
+				if (error)
+					*error = name + " is in the pack twice";
+				return false;
+			}
+		}
+		bucketTable[slot] = (uint32_t)i + 1;
+
+		// only worth losing the zero-copy read for if it saves a good amount
+		if (compress && !data.empty())
+		{
+			Zlib::Deflate(data.data(), data.size(), compressed[i]);
+			if (compressed[i].size() <= data.size() - data.size() / 8)
+			{
+				e.flags |= FlagCompressed;
+				e.storedSize = compressed[i].size();
+			}
+			else
+			{
+				std::vector<uint8_t>().swap(compressed[i]);
+			}
+		}
+	}
+
+	PackHeader h;
+	memset(&h, 0, sizeof(h));
+	h.magic = Magic;
+	h.version = Version;
+	h.entryCount = (uint32_t)inputs.size();
+	h.bucketCount = bucketCount;
+	h.entriesOffset = sizeof(PackHeader);
+	h.bucketsOffset = h.entriesOffset + table.size() * sizeof(PackEntry);
+	h.namesOffset = h.bucketsOffset + bucketCount * sizeof(uint32_t);
+
+	uint64_t offset = h.namesOffset + nameText.size();
+	for (size_t i = 0; i < table.size(); i++)
+	{
+		offset = AlignUp(offset, alignment);
+		table[i].offset = offset;
+		offset += table[i].storedSize;
+	}
+	h.fileSize = offset;
+
+	FILE* file = fopen(fileName, "wb");
+	if (file == nullptr)
+	{
+		if (error)
+			*error = std::string("can't write ") + fileName;
+		return false;
+	}
+
+	fwrite(&h, sizeof(h), 1, file);
+	fwrite(table.data(), sizeof(PackEntry), table.size(), file);
+	fwrite(bucketTable.data(), sizeof(uint32_t), bucketTable.size(), file);
+	fwrite(nameText.data(), 1, nameText.size(), file);
+
+	uint64_t written = h.namesOffset + nameText.size();
+	static const uint8_t zeros[4096] = { 0 };
+	for (size_t i = 0; i < table.size(); i++)
+	{
+		// zeros up to the blob's alignment
+		while (written < table[i].offset)
+		{
+			size_t pad = (size_t)(table[i].offset - written < sizeof(zeros) ? table[i].offset - written : sizeof(zeros));
+			fwrite(zeros, 1, pad, file);
+			written += pad;
+		}
+
+		const std::vector<uint8_t>& blob = (table[i].flags & FlagCompressed) ? compressed[i] : inputs[i].data;
+		fwrite(blob.data(), 1, blob.size(), file);
+		written += blob.size();
+	}
+
+	if (fclose(file) != 0)
+	{
+		if (error)
+			*error = std::string("can't write ") + fileName;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,157 @@
+//
+// AssetPack
+//		Every asset in one file, mapped into memory and found by name
+//
+//	The file is a header, a table of entries, a hash table of names and then the blobs:
+//		PackHeader
+//		PackEntry * entryCount
+//		uint32_t * bucketCount		entry index + 1, 0 for empty. linear probing
+//		names						no terminators, entries say where theirs is
+//		blobs						each starts on a multiple of the alignment
+//
+//	Everything the game needs to find a file is at the front, so opening the pack
+//	touches a page or two and each blob is only read in when something asks for it.
+//	Blobs are stored as they were, or deflated (Zlib) when that makes them noticeably
+//	smaller. A stored blob is read straight out of the mapping with no copy, which is
+//	what PNGs, cooked DDS files and fonts want since they're compressed already.
+//
+//	Names are paths relative to the game's directory, lower case with backslashes, so
+//	"..\\Textures\\start.png" and "Textures/Start.png" are both "textures\\start.png".
+//
+//	Packs are written by Tools\AssetPacker. With one mounted, ResourceCache and the
+//	sprite sheets look in it first and fall back to loose files for anything it hasn't
+//	got, so a pack doesn't have to have everything.
+//
+
+#ifndef _ASSET_PACK_H
+#define _ASSET_PACK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct PackHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	entryCount;
+	uint32_t	bucketCount;		// a power of two
+	uint64_t	entriesOffset;
+	uint64_t	bucketsOffset;
+	uint64_t	namesOffset;
+	uint64_t	fileSize;
+};
+
+struct PackEntry
+{
+	uint64_t	hash;				// of the name, see AssetPack::Hash
+	uint64_t	offset;				// of the blob, from the start of the file
+	uint64_t	storedSize;			// bytes in the pack
+	uint64_t	size;				// bytes once inflated
+	uint32_t	nameOffset;			// from namesOffset
+	uint32_t	nameLength;
+	uint32_t	flags;
+	uint32_t	crc;				// of the inflated bytes
+};
+
+// one file's bytes. data points into the pack when the file was stored as it was,
+//	otherwise at buffer. not copyable, data would still point at the old buffer
+struct AssetData
+{
+	AssetData() : data(nullptr), size(0) {}
+
+	const uint8_t*			data;
+	size_t					size;
+	std::vector<uint8_t>	buffer;
+
+private:
+	AssetData(const AssetData&);
+	AssetData& operator=(const AssetData&);
+};
+
+// a file to go in a pack
+struct PackInput
+{
+	std::string				name;
+	std::vector<uint8_t>	data;
+};
+
+class AssetPack
+{
+public:
+	static const uint32_t Magic = 0x314b4150;		// "PAK1"
+	static const uint32_t Version = 1;
+	static const uint32_t FlagCompressed = 1;
+
+	AssetPack();
+
+	// unmaps it, and unmounts it if it's mounted
+	~AssetPack();
+
+	// map a pack file. false if it can't be opened or isn't a valid pack
+	bool Open(const wchar_t* fileName);
+	bool Open(const char* fileName);
+	void Close();
+
+	bool IsOpen() const { return base != nullptr; }
+
+	// the entry for a file, null if it isn't in the pack
+	const PackEntry* Find(const char* fileName) const;
+	const PackEntry* Find(const wchar_t* fileName) const;
+
+	// an entry's bytes, inflated if they were compressed. false if they won't inflate
+	bool Read(const PackEntry& entry, AssetData& out) const;
+
+	int GetEntryCount() const { return base ? (int)header->entryCount : 0; }
+	const PackEntry& GetEntry(int i) const { return entries[i]; }
+	std::string GetName(const PackEntry& entry) const;
+
+	// bytes mapped, the whole file
+	size_t GetFileSize() const { return fileSize; }
+
+	// inflate everything and check it against the CRCs, for tools. error says which failed
+	bool Verify(std::string* error = nullptr) const;
+
+	// what a path is called in a pack: lower case, backslashes, and no leading .\ or ..\ parts
+	static std::string MakeName(const char* path);
+	static std::string MakeName(const wchar_t* path);
+
+	// FNV-1a, of a name that's already been through MakeName
+	static uint64_t Hash(const std::string& name);
+
+	// the pack the game loads from, null for loose files. the pack has to stay open while
+	//	it's mounted
+	static void Mount(const AssetPack* pPack);
+	static const AssetPack* GetMounted() { return pMounted; }
+
+	// a file from the mounted pack if it's there, otherwise from the disk
+	static bool ReadFile(const char* fileName, AssetData& out);
+
+	// write a pack of the inputs, in their order. alignment is a power of two. with compress,
+	//	blobs are deflated when it saves at least an eighth. false, with error set, if the
+	//	names clash or the file can't be written
+	static bool Write(const char* fileName, const std::vector<PackInput>& inputs, bool compress, int alignment = 64,
+		std::string* error = nullptr);
+
+private:
+	// check the header and every offset in it, so nothing read later can be out of the file
+	bool Validate() const;
+
+	const PackEntry* FindName(const std::string& name) const;
+
+	const uint8_t*		base;		// the mapping
+	size_t				fileSize;
+	const PackHeader*	header;
+	const PackEntry*	entries;
+	const uint32_t*		buckets;
+	const char*			names;
+
+	static const AssetPack*	pMounted;
+
+	// no copying, it owns the mapping
+	AssetPack(const AssetPack&);
+	AssetPack& operator=(const AssetPack&);
+};
+
+#endif // _ASSET_PACK_H
@@ -59,150 +59,369 @@ bool Collision2D::CircleCircleCheck(Circle circleA, Circle circleB)
 	return distance <= (circleA.radius + circleB.radius);
 }
 
-inline bool IsZeroToOne(float t) { return t >= 0 && t <= 1;  }
+// -----------------------------------------------------
+// Oriented box / Oriented box check
+//	two boxes overlap unless there is a gap between them along one
+//	of their 4 face normals (the separating axis test)
+bool Collision2D::OBBOBBCheck(const OBB2D& boxA, const OBB2D& boxB)
+{
+	Vector2 delta = boxB.center - boxA.center;
+	const Vector2* axes[4] = { &boxA.axisX, &boxA.axisY, &boxB.axisX, &boxB.axisY };
+
+	for (int i = 0; i < 4; i++)
+	{
+		const Vector2& axis = *axes[i];
+
+		// how far each box reaches along this axis
+		float reachA = boxA.extents.x * fabsf(boxA.axisX.Dot(axis)) + boxA.extents.y * fabsf(boxA.axisY.Dot(axis));
+		float reachB = boxB.extents.x * fabsf(boxB.axisX.Dot(axis)) + boxB.extents.y * fabsf(boxB.axisY.Dot(axis));
+
+		if (fabsf(delta.Dot(axis)) > reachA + reachB)
+			return false;
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------
+// Oriented box / Circle check
+//	move the circle into the box's space, then it's an axis aligned test
+bool Collision2D::OBBCircleCheck(const OBB2D& box, const Circle& circle)
+{
+	Vector2 delta = circle.center - box.center;
+	Vector2 local(delta.Dot(box.axisX), delta.Dot(box.axisY));
+
+	// distance from the closest point on the box
+	float dx = fabsf(local.x) - box.extents.x;
+	float dy = fabsf(local.y) - box.extents.y;
+	if (dx < 0) dx = 0;
+	if (dy < 0) dy = 0;
+
+	return dx * dx + dy * dy <= circle.radius * circle.radius;
+}
+
+// -----------------------------------------------------
+// Extents of the axis aligned box around a rotated box
+//	each corner reaches |cos| * x + |sin| * y along x, and the other way round along y
+Vector2 Collision2D::RotatedExtents(Vector2 extents, float cosTheta, float sinTheta)
+{
+	float c = fabsf(cosTheta);
+	float s = fabsf(sinTheta);
+
+	return Vector2(
+		extents.x * c + extents.y * s,
+		extents.x * s + extents.y * c);
+}
+
+// -----------------------------------------------------
+// Axis aligned box around an oriented box
+Box2D Collision2D::BoundingBox(const OBB2D& box)
+{
+	Vector2 extents(
+		box.extents.x * fabsf(box.axisX.x) + box.extents.y * fabsf(box.axisY.x),
+		box.extents.x * fabsf(box.axisX.y) + box.extents.y * fabsf(box.axisY.y));
+
+	return Box2D(box.center, extents);
+}
 
 // -----------------------------------------------------
 // reflect a circle off a box - returns
 // the new position of the circle and updates the velocity
 Vector2 Collision2D::ReflectCircleBox(Circle circle, Vector2& velocity, float deltaTime, Box2D box)
 {
-	float extra = circle.radius;
+	Vector2 movement = velocity * deltaTime;
+	Contact2D contact = CircleBoxContact(circle, box, movement);
 
-	// our first contact point is the edge of the circle, our last is based on our velocity
-	Line2D  circleMovement;
+	// no contact, or moving away from it, move the circle
+	if (!contact.hit || movement.Dot(contact.normal) >= 0)
+	{
+		return circle.center + movement;
+	}
 
-	// line segments of the box
-	Line2D top(box.center + Vector2(-box.extents.x - extra, -box.extents.y), box.center + Vector2(box.extents.x + extra, -box.extents.y));
-	Line2D left(box.center + Vector2(-box.extents.x, -box.extents.y - extra), box.center + Vector2(-box.extents.x, box.extents.y + extra));
-	Line2D right(box.center + Vector2(box.extents.x,-box.extents.y - extra), box.center + Vector2(box.extents.x, box.extents.y + extra));
-	Line2D bottom(box.center + Vector2(-box.extents.x -extra, box.extents.y), box.center + Vector2(box.extents.x + extra, box.extents.y));
+	// get the new velocity by reflecting it in the normal
+	Vector2 newVelocity;
+	Vector2::Reflect(velocity, contact.normal, newVelocity);
 
+	// move up to the contact (and out of the box if we started inside), then the rest of the way with the new velocity
+	Vector2 finalPosition = circle.center + contact.normal * contact.penetration +
+		velocity * contact.toi * deltaTime + newVelocity * (1 - contact.toi) * deltaTime;
 
-	// the normal of the edge we hit
-	Vector2 normal = Vector2::Zero;
+	velocity = newVelocity;
 
-	float t = -10000; // the final time (0-1)
+	return finalPosition;
+}
 
-	float ty = 10000;
-	float tx = 10000;
+// clamp a float between min and max
+inline float ClampFloat(float v, float min, float max)
+{
+	if (v < min) v = min;
+	if (v > max) v = max;
+	return v;
+}
 
-	// 
-	float tCircle, tBox;
-	Vector2 contact;
+// -----------------------------------------------------
+// Contact between a moving circle and a box
+//	A circle touches the box when its center is inside the box grown by the radius, with
+//	rounded corners. So if we aren't already touching, we trace the center as a ray against that rounded box.
+Contact2D Collision2D::CircleBoxContact(const Circle& circle, const Box2D& box, Vector2 displacement)
+{
+	Contact2D contact;
+
+	// work relative to the center of the box
+	Vector2 start = circle.center - box.center;
+	Vector2 extents = box.extents;
+	float radius = circle.radius;
+
+	// check if we are already touching the box
+	Vector2 closest(ClampFloat(start.x, -extents.x, extents.x), ClampFloat(start.y, -extents.y, extents.y));
+	Vector2 away = start - closest;
+	float distanceSq = away.LengthSquared();
 
-	// test for the box moving down
-	if (velocity.y > 0)
+	if (distanceSq <= radius * radius)
 	{
-		circleMovement.start = circle.center + Vector2(0, circle.radius);
-		circleMovement.end = circleMovement.start + velocity*deltaTime;
+		contact.hit = true;
+		contact.toi = 0.0f;
 
-		LineLineCheck(circleMovement, top, tCircle, tBox, contact);
-		if (IsZeroToOne(tCircle) && IsZeroToOne(tBox))
+		if (distanceSq > 0.0f)
 		{
-			t = tCircle;
-			normal = Vector2(0, -1); // reflect up
+			float distance = sqrtf(distanceSq);
+			contact.normal = away / distance;
+			contact.penetration = radius - distance;
+			contact.point = box.center + closest;
 		}
-		else if (IsZeroToOne(-tCircle) && IsZeroToOne(tBox)) // detect corner cases (t -1>circle>0)
+		else
 		{
-			ty = tCircle;
-			normal.y = -1;
+			// the center is inside the box, push out the shortest way
+			float insideX = extents.x - fabsf(start.x);
+			float insideY = extents.y - fabsf(start.y);
+
+			if (insideX < insideY)
+			{
+				contact.normal = Vector2(start.x < 0 ? -1.0f : 1.0f, 0);
+				contact.penetration = insideX + radius;
+				contact.point = box.center + Vector2(contact.normal.x * extents.x, start.y);
+			}
+			else
+			{
+				contact.normal = Vector2(0, start.y < 0 ? -1.0f : 1.0f);
+				contact.penetration = insideY + radius;
+				contact.point = box.center + Vector2(start.x, contact.normal.y * extents.y);
+			}
 		}
+
+		return contact;
 	}
-	// moving up
-	else if (velocity.y < 0)
+
+	// trace against the grown box, one axis (slab) at a time
+	Vector2 grown = extents + Vector2(radius, radius);
+	float tEnter = 0.0f;
+	float tExit = 1.0f;
+	int enterAxis = -1;
+
+	for (int axis = 0; axis < 2; axis++)
 	{
-		circleMovement.start = circle.center + Vector2(0, -circle.radius);
-		circleMovement.end = circleMovement.start + velocity*deltaTime;
+		float p = axis == 0 ? start.x : start.y;
+		float d = axis == 0 ? displacement.x : displacement.y;
+		float g = axis == 0 ? grown.x : grown.y;
 
-		LineLineCheck(circleMovement, bottom, tCircle, tBox, contact);
-		if (IsZeroToOne(tCircle) && IsZeroToOne(tBox))
+		if (d == 0.0f)
 		{
-			t = tCircle;
-			normal = Vector2(0, 1); // reflect down
+			// not moving on this axis, we have to already be in the slab
+			if (p < -g || p > g)
+				return contact;
+			continue;
 		}
-		else if (IsZeroToOne(-tCircle) && IsZeroToOne(tBox)) // detect corner cases (t -1>circle>0)
+
+		float t1 = (-g - p) / d;
+		float t2 = (g - p) / d;
+		if (t1 > t2)
 		{
-			ty = tCircle;
-			normal.y = 1;
+			float temp = t1;
+			t1 = t2;
+			t2 = temp;
 		}
 
+		if (t1 > tEnter)
+		{
+			tEnter = t1;
+			enterAxis = axis;
+		}
+		if (t2 < tExit)
+			tExit = t2;
+
+		if (tEnter > tExit)
+			return contact;
 	}
 
-	if (velocity.x > 0)
+	// where we entered the grown box
+	Vector2 enter = start + displacement * tEnter;
+	bool outsideX = enter.x < -extents.x || enter.x > extents.x;
+	bool outsideY = enter.y < -extents.y || enter.y > extents.y;
+
+	if (outsideX && outsideY)
 	{
-		circleMovement.start = circle.center + Vector2(circle.radius,0);
-		circleMovement.end = circleMovement.start + velocity*deltaTime;
+		// in a corner region, the rounded box is a circle around the corner here
+		Vector2 corner(enter.x < 0 ? -extents.x : extents.x, enter.y < 0 ? -extents.y : extents.y);
+		Vector2 m = start - corner;
+
+		float a = displacement.Dot(displacement);
+		float b = m.Dot(displacement);
+		float c = m.Dot(m) - radius * radius;
+
+		// moving away from the corner, or missing it
+		float discriminant = b * b - a * c;
+		if (b >= 0 || discriminant < 0)
+			return contact;
+
+		float t = (-b - sqrtf(discriminant)) / a;
+		if (t < 0 || t > 1)
+			return contact;
+
+		contact.hit = true;
+		contact.toi = t;
+		contact.normal = (m + displacement * t) / radius;
+		contact.point = box.center + corner;
+		return contact;
+	}
 
-		LineLineCheck(circleMovement, left, tCircle, tBox, contact);
-		if (IsZeroToOne(tCircle) && IsZeroToOne(tBox))
-		{
-			// make sure it's a closer collision
-			if (t < 0 || tCircle < t)
-			{
-				t = tCircle;
-				normal = Vector2(-1, 0); // reflect float left
-			}
-		}
-		else if (IsZeroToOne(-tCircle) && IsZeroToOne(tBox)) // detect corner cases (t -1>circle>0)
-		{
-			tx = tCircle;
-			normal.x = -1;
-		}
+	// starting inside the grown box always lands in a corner, so we entered through a face
+	if (enterAxis < 0)
+		return contact;
+
+	contact.hit = true;
+	contact.toi = tEnter;
+	if (enterAxis == 0)
+		contact.normal = Vector2(displacement.x > 0 ? -1.0f : 1.0f, 0);
+	else
+		contact.normal = Vector2(0, displacement.y > 0 ? -1.0f : 1.0f);
+
+	// the contact is one radius from the center, back along the normal
+	contact.point = circle.center + displacement * tEnter - contact.normal * radius;
+
+	return contact;
+}
+
+// -----------------------------------------------------
+// Contact between a moving circle and another circle
+//	same idea as the box, the other circle grows by our radius and we trace our center against it
+Contact2D Collision2D::CircleCircleContact(const Circle& circle, const Circle& other, Vector2 displacement)
+{
+	Contact2D contact;
+
+	Vector2 m = circle.center - other.center;
+	float radius = circle.radius + other.radius;
+	float distanceSq = m.LengthSquared();
 
+	if (distanceSq <= radius * radius)
+	{
+		float distance = sqrtf(distanceSq);
+
+		contact.hit = true;
+		contact.toi = 0.0f;
+		contact.penetration = radius - distance;
+		contact.normal = distance > 0.0f ? m / distance : Vector2(0, -1);
+		contact.point = other.center + contact.normal * other.radius;
+		return contact;
 	}
-	else if (velocity.x < 0)
+
+	float a = displacement.Dot(displacement);
+	float b = m.Dot(displacement);
+	float c = distanceSq - radius * radius;
+
+	// moving away, or missing it
+	float discriminant = b * b - a * c;
+	if (a == 0.0f || b >= 0 || discriminant < 0)
+		return contact;
+
+	float t = (-b - sqrtf(discriminant)) / a;
+	if (t > 1)
+		return contact;
+
+	contact.hit = true;
+	contact.toi = t;
+	contact.normal = (m + displacement * t) / radius;
+	contact.point = other.center + contact.normal * other.radius;
+	return contact;
+}
+
+// -----------------------------------------------------
+// Swept circle / box test
+//
+bool Collision2D::SweepCircleBox(const Circle& circle, Vector2 displacement, const Box2D& box, float& toi, Vector2& normal)
+{
+	Contact2D contact = CircleBoxContact(circle, box, displacement);
+
+	// already overlapping and moving away (or not at all) isn't a hit
+	if (!contact.hit || (contact.toi == 0.0f && displacement.Dot(contact.normal) >= 0))
+		return false;
+
+	toi = contact.toi;
+	normal = contact.normal;
+	return true;
+}
+
+// -----------------------------------------------------
+// Moves a circle through a set of boxes, bouncing off the first thing it hits
+//	and carrying on with the time left over until the time is used up
+Vector2 Collision2D::MoveCircle(Circle circle, Vector2& velocity, float deltaTime, const Box2D* boxes, int count,
+	SweepHit2D* hits, int maxHits, int& numHits)
+{
+	// stop bouncing back and forth forever in a tight spot
+	const int maxBounces = 8;
+
+	numHits = 0;
+	float timeLeft = 1.0f; // fraction of deltaTime we still have to move
+
+	for (int bounce = 0; bounce < maxBounces && timeLeft > 0.0f; bounce++)
 	{
-		circleMovement.start = circle.center + Vector2(-circle.radius, 0);
-		circleMovement.end = circleMovement.start + velocity*deltaTime;
+		Vector2 displacement = velocity * (deltaTime * timeLeft);
 
-		LineLineCheck(circleMovement, right, tCircle, tBox, contact);
-		if (IsZeroToOne(tCircle) && IsZeroToOne(tBox))
+		// find the first box we hit
+		int hitIndex = -1;
+		Contact2D hit;
+
+		for (int i = 0; i < count; i++)
 		{
-			// make sure it's a closer collision
-			if (t < 0 || tCircle < t)
+			Contact2D contact = CircleBoxContact(circle, boxes[i], displacement);
+
+			// already overlapping and moving away isn't a hit
+			if (!contact.hit || (contact.toi == 0.0f && displacement.Dot(contact.normal) >= 0))
+				continue;
+
+			// take the earliest, and the deepest if we are overlapping more than one
+			if (hitIndex < 0 || contact.toi < hit.toi || (contact.toi == hit.toi && contact.penetration > hit.penetration))
 			{
-				t = tCircle;
-				normal = Vector2(1, 0); // reflect right
+				hitIndex = i;
+				hit = contact;
 			}
 		}
-		else if (IsZeroToOne(-tCircle) && IsZeroToOne(tBox)) // detect corner cases (t -1>circle>0)
+
+		// nothing in the way, move the rest of the way
+		if (hitIndex < 0)
 		{
-			tx = tCircle;
-			normal.x = 1;
+			circle.center += displacement;
+			break;
 		}
-	}
-
 
-	Vector2 finalPosition;
+		// move up to the contact, out of the box if we started inside it, and bounce
+		circle.center += displacement * hit.toi + hit.normal * hit.penetration;
+		Vector2::Reflect(velocity, hit.normal, velocity);
 
-	// we were already penetrating on the axis because of the corner to reflect off accordingly 
-	if (t < 0 && (tx < 0 || ty < 0))
-	{
-		t = 0;
-		normal.Normalize();
-	}
+		// record the time as a fraction of the whole step
+		float timeUsed = (1.0f - timeLeft) + hit.toi * timeLeft;
+		timeLeft *= 1.0f - hit.toi;
 
-
-	// make sure we had a contact point
-	if (t >= 0)
-	{
-		// get the new velocity by reflecting it in the normal
-		Vector2 newVelocity;
-		Vector2::Reflect(velocity, normal, newVelocity);
-
-		// calculate the new center
-		finalPosition = circle.center + velocity * t * deltaTime + newVelocity * (1 - t) * deltaTime;
-	
-		velocity = newVelocity;
-	}
-	else
-	{
-		// no intersection, move the circle
-		finalPosition = circle.center + deltaTime * velocity;
+		if (numHits < maxHits)
+		{
+			hits[numHits].index = hitIndex;
+			hits[numHits].time = timeUsed;
+			hits[numHits].position = circle.center;
+			hits[numHits].contact = hit;
+			numHits++;
+		}
 	}
 
-	return finalPosition;
-
+	return circle.center;
 }
 
 // Line / Line test
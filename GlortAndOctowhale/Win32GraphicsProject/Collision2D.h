@@ -8,8 +8,12 @@
 
 #ifndef _COLLISION_H
 #define _COLLISION_H
+#ifdef _WIN32
 #include <d3d11.h>
 #include <SimpleMath.h>
+#else
+#include "PortableMath.h"	// lets the benchmarks build without the Windows SDK
+#endif
 using DirectX::SimpleMath::Vector2;
 
 // Basic Shapes we use for collision
@@ -37,6 +41,36 @@ struct Box2D
 };
 
 
+//
+// An oriented bounding box
+//	axisX and axisY are the box's own (unit length) axes, extents are the half sizes along them
+//
+struct OBB2D
+{
+	OBB2D()
+	{
+		center = Vector2::Zero;
+		extents = Vector2::Zero;
+		axisX = Vector2(1, 0);
+		axisY = Vector2(0, 1);
+	}
+
+	// a box rotated by an angle, given as its cos and sin so callers can reuse them
+	OBB2D(Vector2 _center, Vector2 _extents, float cosTheta, float sinTheta)
+	{
+		center = _center;
+		extents = _extents;
+		axisX = Vector2(cosTheta, sinTheta);
+		axisY = Vector2(-sinTheta, cosTheta);
+	}
+
+	Vector2 center;
+	Vector2 extents;
+	Vector2 axisX;
+	Vector2 axisY;
+};
+
+
 //
 // Circle, represented by a center and radius
 //
@@ -73,6 +107,81 @@ struct Line2D
 	}
 };
 
+//
+// Everything about a contact between two shapes, found in one pass
+//
+struct Contact2D
+{
+	bool	hit;			// true if the shapes touch (or will touch while moving)
+	float	toi;			// time of impact, fraction (0-1) of the movement. 0 if already touching
+	float	penetration;	// how far the shapes overlap along the normal. 0 if they only touch when moving
+	Vector2	normal;			// points out of the shape that was hit, towards the moving shape
+	Vector2	point;			// contact point on the surface of the shape that was hit
+
+	Contact2D()
+	{
+		hit = false;
+		toi = 0.0f;
+		penetration = 0.0f;
+		normal = Vector2::Zero;
+		point = Vector2::Zero;
+	}
+};
+
+//
+// One bounce found while moving a circle through a set of boxes
+//
+struct SweepHit2D
+{
+	int			index;		// which box was hit
+	float		time;		// fraction of deltaTime when it hit (0-1)
+	Vector2		position;	// center of the circle when it hit
+	Contact2D	contact;	// the contact that caused the bounce
+
+	SweepHit2D()
+	{
+		index = -1;
+		time = 0.0f;
+		position = Vector2::Zero;
+	}
+};
+
+//
+// Two proxies a broadphase found overlapping. proxyA < proxyB
+//
+struct ProxyPair
+{
+	int proxyA;
+	int proxyB;
+};
+
+//
+// A set of axis aligned boxes stored as structure of arrays, for the batched tests
+//	each array holds count floats
+//
+struct BoxArray2D
+{
+	const float* centerX;
+	const float* centerY;
+	const float* extentX;
+	const float* extentY;
+	int count;
+
+	BoxArray2D()
+	{
+		centerX = centerY = extentX = extentY = nullptr;
+		count = 0;
+	}
+	BoxArray2D(const float* _centerX, const float* _centerY, const float* _extentX, const float* _extentY, int _count)
+	{
+		centerX = _centerX;
+		centerY = _centerY;
+		extentX = _extentX;
+		extentY = _extentY;
+		count = _count;
+	}
+};
+
 //
 // A collection of 2D collision functions to test for collisions between different shapes
 //
@@ -84,6 +193,16 @@ public:
 	static bool BoxBoxCheck(Box2D boxA, Box2D boxB);
 	static bool CircleCircleCheck(Circle circleA, Circle circleB);
 
+	// Oriented box tests, using the separating axis test
+	static bool OBBOBBCheck(const OBB2D& boxA, const OBB2D& boxB);
+	static bool OBBCircleCheck(const OBB2D& box, const Circle& circle);
+
+	// extents of the axis aligned box that exactly fits a box rotated by an angle
+	static Vector2 RotatedExtents(Vector2 extents, float cosTheta, float sinTheta);
+
+	// the axis aligned box that exactly fits an oriented box
+	static Box2D BoundingBox(const OBB2D& box);
+
 	// Line / Line test
 	//	returns true of the lines intersect (i.e. not parallel)
 	//	t_a, t_b are the parameterized equation values
@@ -93,6 +212,44 @@ public:
 	// the new position of the circle and updates the velocity
 	static Vector2 ReflectCircleBox(Circle circle, Vector2& velocity, float deltaTime, Box2D box);
 
+	// Contact between a circle moving by displacement and a box, in one pass
+	//	if they already overlap the contact has toi 0 and the penetration depth,
+	//	otherwise the box is swept (grown by the radius, with rounded corners) to find the exact toi
+	static Contact2D CircleBoxContact(const Circle& circle, const Box2D& box, Vector2 displacement = Vector2::Zero);
+
+	// Contact between a circle moving by displacement and another circle
+	static Contact2D CircleCircleContact(const Circle& circle, const Circle& other, Vector2 displacement = Vector2::Zero);
+
+	// Swept circle / box test
+	//	returns true if the circle moving by displacement hits the box. toi is the fraction (0-1)
+	//	of displacement travelled before the hit and normal points out of the box
+	//	starting out overlapping only counts if we are moving further in
+	static bool SweepCircleBox(const Circle& circle, Vector2 displacement, const Box2D& box, float& toi, Vector2& normal);
+
+	// Moves a circle by velocity * deltaTime through a set of boxes, bouncing off
+	//	whatever it hits until the time is used up. velocity is updated by each bounce
+	//	and a circle that starts inside a box is pushed out first
+	//	returns the final position, hits receives up to maxHits bounces in the order they happened
+	static Vector2 MoveCircle(Circle circle, Vector2& velocity, float deltaTime, const Box2D* boxes, int count,
+		SweepHit2D* hits, int maxHits, int& numHits);
+
+	// instruction sets the batched tests can use
+	enum SimdLevel
+	{
+		SimdScalar,
+		SimdSSE2,
+		SimdAVX2
+	};
+
+	// the best instruction set this machine supports
+	static SimdLevel GetSimdLevel();
+
+	// Batched box / circle test, same result as BoxCircleCheck for every box
+	//	bit i of hitMask is set if box i hits. hitMask needs (count + 31) / 32 entries
+	//	returns the number of boxes hit
+	static int BoxCircleCheckBatch(const BoxArray2D& boxes, const Circle& circle, unsigned int* hitMask);
+	static int BoxCircleCheckBatch(const BoxArray2D& boxes, const Circle& circle, unsigned int* hitMask, SimdLevel level);
+
 };
 
 
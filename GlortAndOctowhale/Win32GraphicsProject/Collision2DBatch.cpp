@@ -0,0 +1,228 @@
+//
+// Collision2D batched tests
+//		Tests one shape against many boxes stored as structure of arrays.
+//		Each test has a scalar version plus SSE2 (4 boxes) and AVX2 (8 boxes) versions,
+//		picked at runtime based on what the cpu supports.
+//
+
+#include "Collision2D.h"
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define COLLISION_X86 1
+#include <emmintrin.h>	// SSE2
+#include <immintrin.h>	// AVX2
+#ifdef _MSC_VER
+#include <intrin.h>		// __cpuid
+#endif
+#endif
+
+// the AVX2 kernels are compiled for AVX2 even if the rest of the file isn't
+#if defined(COLLISION_X86) && (defined(__GNUC__) || defined(__clang__))
+#define COLLISION_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define COLLISION_TARGET_AVX2
+#endif
+
+// count the bits set in a mask
+static inline int CountBits(unsigned int v)
+{
+	int count = 0;
+	while (v)
+	{
+		v &= v - 1;
+		count++;
+	}
+	return count;
+}
+
+// -----------------------------------------------------
+// Work out the best instruction set we can use
+//
+static Collision2D::SimdLevel DetectSimdLevel()
+{
+#if defined(COLLISION_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osSavesAvx)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2)
+		return Collision2D::SimdAVX2;
+	if (sse2)
+		return Collision2D::SimdSSE2;
+	return Collision2D::SimdScalar;
+#elif defined(COLLISION_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return Collision2D::SimdAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return Collision2D::SimdSSE2;
+	return Collision2D::SimdScalar;
+#else
+	return Collision2D::SimdScalar;
+#endif
+}
+
+Collision2D::SimdLevel Collision2D::GetSimdLevel()
+{
+	static SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+// -----------------------------------------------------
+// Box / Circle, one box at a time
+//	same three tests as BoxCircleCheck
+//
+static int BoxCircleBatchScalar(const BoxArray2D& boxes, const Circle& circle, unsigned int* hitMask, int start)
+{
+	int hits = 0;
+
+	for (int i = start; i < boxes.count; i++)
+	{
+		float dx = circle.center.x - boxes.centerX[i];
+		float dy = circle.center.y - boxes.centerY[i];
+		float ex = boxes.extentX[i];
+		float ey = boxes.extentY[i];
+
+		bool hit = fabsf(dx) <= ex + circle.radius &&
+			fabsf(dy) <= ey + circle.radius &&
+			(sqrtf(dx * dx + dy * dy) <= sqrtf(ex * ex + ey * ey) + circle.radius);
+
+		if (hit)
+		{
+			hitMask[i >> 5] |= 1u << (i & 31);
+			hits++;
+		}
+	}
+
+	return hits;
+}
+
+#ifdef COLLISION_X86
+
+// -----------------------------------------------------
+// Box / Circle, 4 boxes at a time
+//
+static int BoxCircleBatchSSE2(const BoxArray2D& boxes, const Circle& circle, unsigned int* hitMask)
+{
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 cx = _mm_set1_ps(circle.center.x);
+	const __m128 cy = _mm_set1_ps(circle.center.y);
+	const __m128 r = _mm_set1_ps(circle.radius);
+
+	int hits = 0;
+	int i = 0;
+
+	for (; i + 4 <= boxes.count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(cx, _mm_loadu_ps(boxes.centerX + i));
+		__m128 dy = _mm_sub_ps(cy, _mm_loadu_ps(boxes.centerY + i));
+		__m128 ex = _mm_loadu_ps(boxes.extentX + i);
+		__m128 ey = _mm_loadu_ps(boxes.extentY + i);
+
+		// x and y axis distance
+		__m128 inX = _mm_cmple_ps(_mm_and_ps(dx, absMask), _mm_add_ps(ex, r));
+		__m128 inY = _mm_cmple_ps(_mm_and_ps(dy, absMask), _mm_add_ps(ey, r));
+
+		// straight line distance
+		__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		__m128 reach = _mm_add_ps(_mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey))), r);
+		__m128 inDist = _mm_cmple_ps(dist, reach);
+
+		unsigned int bits = (unsigned int)_mm_movemask_ps(_mm_and_ps(_mm_and_ps(inX, inY), inDist));
+		if (bits)
+		{
+			hitMask[i >> 5] |= bits << (i & 31);
+			hits += CountBits(bits);
+		}
+	}
+
+	// whatever is left over
+	return hits + BoxCircleBatchScalar(boxes, circle, hitMask, i);
+}
+
+// -----------------------------------------------------
+// Box / Circle, 8 boxes at a time
+//
+COLLISION_TARGET_AVX2
+static int BoxCircleBatchAVX2(const BoxArray2D& boxes, const Circle& circle, unsigned int* hitMask)
+{
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const __m256 cx = _mm256_set1_ps(circle.center.x);
+	const __m256 cy = _mm256_set1_ps(circle.center.y);
+	const __m256 r = _mm256_set1_ps(circle.radius);
+
+	int hits = 0;
+	int i = 0;
+
+	for (; i + 8 <= boxes.count; i += 8)
+	{
+		__m256 dx = _mm256_sub_ps(cx, _mm256_loadu_ps(boxes.centerX + i));
+		__m256 dy = _mm256_sub_ps(cy, _mm256_loadu_ps(boxes.centerY + i));
+		__m256 ex = _mm256_loadu_ps(boxes.extentX + i);
+		__m256 ey = _mm256_loadu_ps(boxes.extentY + i);
+
+		// x and y axis distance
+		__m256 inX = _mm256_cmp_ps(_mm256_and_ps(dx, absMask), _mm256_add_ps(ex, r), _CMP_LE_OQ);
+		__m256 inY = _mm256_cmp_ps(_mm256_and_ps(dy, absMask), _mm256_add_ps(ey, r), _CMP_LE_OQ);
+
+		// straight line distance
+		__m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+		__m256 reach = _mm256_add_ps(_mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(ex, ex), _mm256_mul_ps(ey, ey))), r);
+		__m256 inDist = _mm256_cmp_ps(dist, reach, _CMP_LE_OQ);
+
+		unsigned int bits = (unsigned int)_mm256_movemask_ps(_mm256_and_ps(_mm256_and_ps(inX, inY), inDist));
+		if (bits)
+		{
+			hitMask[i >> 5] |= bits << (i & 31);
+			hits += CountBits(bits);
+		}
+	}
+
+	// whatever is left over
+	return hits + BoxCircleBatchScalar(boxes, circle, hitMask, i);
+}
+
+#endif // COLLISION_X86
+
+// -----------------------------------------------------
+// Batched Box / Circle check
+//
+int Collision2D::BoxCircleCheckBatch(const BoxArray2D& boxes, const Circle& circle, unsigned int* hitMask)
+{
+	return BoxCircleCheckBatch(boxes, circle, hitMask, GetSimdLevel());
+}
+
+int Collision2D::BoxCircleCheckBatch(const BoxArray2D& boxes, const Circle& circle, unsigned int* hitMask, SimdLevel level)
+{
+	if (boxes.count <= 0)
+		return 0;
+
+	// clear the mask, the kernels only set bits
+	for (int w = 0; w < (boxes.count + 31) / 32; w++)
+		hitMask[w] = 0;
+
+	// never use more than the cpu has
+	if (level > GetSimdLevel())
+		level = GetSimdLevel();
+
+#ifdef COLLISION_X86
+	if (level == SimdAVX2)
+		return BoxCircleBatchAVX2(boxes, circle, hitMask);
+	if (level == SimdSSE2)
+		return BoxCircleBatchSSE2(boxes, circle, hitMask);
+#endif
+
+	return BoxCircleBatchScalar(boxes, circle, hitMask, 0);
+}
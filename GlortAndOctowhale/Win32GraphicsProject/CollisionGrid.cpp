@@ -0,0 +1,255 @@
+//
+// CollisionGrid
+//		Uniform grid broadphase for static boxes (bricks)
+//
+
+#include "CollisionGrid.h"
+#include <algorithm>
+#include <math.h>
+
+// -----------------------------------------------------
+// Constructor
+//
+CollisionGrid::CollisionGrid()
+{
+	origin = Vector2::Zero;
+	cellSize = 0.0f;
+	invCellSize = 0.0f;
+	columns = 0;
+	rows = 0;
+	queryId = 0;
+}
+
+// -----------------------------------------------------
+// Removes everything from the grid
+//
+void CollisionGrid::Clear()
+{
+	columns = 0;
+	rows = 0;
+	cellStart.clear();
+	cellCount.clear();
+	cellItems.clear();
+	boxes.clear();
+	active.clear();
+	queryMark.clear();
+	queryId = 0;
+}
+
+// -----------------------------------------------------
+// Index the boxes into cells
+//
+void CollisionGrid::Build(const Box2D* boxList, int count, float size)
+{
+	Clear();
+
+	if (boxList == nullptr || count <= 0)
+		return;
+
+	boxes.assign(boxList, boxList + count);
+	active.assign(count, 1);
+	queryMark.assign(count, 0);
+
+	// find the bounds of everything and the biggest box
+	Vector2 minPos = boxes[0].center - boxes[0].extents;
+	Vector2 maxPos = boxes[0].center + boxes[0].extents;
+	float largest = 0.0f;
+
+	for (int i = 0; i < count; i++)
+	{
+		Vector2 lo = boxes[i].center - boxes[i].extents;
+		Vector2 hi = boxes[i].center + boxes[i].extents;
+
+		minPos.x = std::min(minPos.x, lo.x);
+		minPos.y = std::min(minPos.y, lo.y);
+		maxPos.x = std::max(maxPos.x, hi.x);
+		maxPos.y = std::max(maxPos.y, hi.y);
+
+		largest = std::max(largest, std::max(boxes[i].extents.x, boxes[i].extents.y) * 2.0f);
+	}
+
+	// cells at least as big as the biggest box means a box touches at most 4 cells
+	if (size <= 0.0f)
+		size = largest;
+	if (size <= 0.0f)
+		size = 1.0f;
+
+	cellSize = size;
+	invCellSize = 1.0f / size;
+	origin = minPos;
+	columns = std::max(1, (int)ceilf((maxPos.x - minPos.x) * invCellSize));
+	rows = std::max(1, (int)ceilf((maxPos.y - minPos.y) * invCellSize));
+
+	int numCells = columns * rows;
+	cellStart.assign(numCells + 1, 0);
+	cellCount.assign(numCells, 0);
+
+	// first pass counts how many boxes land in each cell
+	int minX, minY, maxX, maxY;
+	for (int i = 0; i < count; i++)
+	{
+		CellRange(boxes[i], minX, minY, maxX, maxY);
+		for (int y = minY; y <= maxY; y++)
+			for (int x = minX; x <= maxX; x++)
+				cellCount[y * columns + x]++;
+	}
+
+	for (int c = 0; c < numCells; c++)
+		cellStart[c + 1] = cellStart[c] + cellCount[c];
+
+	// second pass fills the cells
+	cellItems.assign(cellStart[numCells], -1);
+	std::fill(cellCount.begin(), cellCount.end(), 0);
+
+	for (int i = 0; i < count; i++)
+	{
+		CellRange(boxes[i], minX, minY, maxX, maxY);
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int x = minX; x <= maxX; x++)
+			{
+				int c = y * columns + x;
+				cellItems[cellStart[c] + cellCount[c]] = i;
+				cellCount[c]++;
+			}
+		}
+	}
+}
+
+// -----------------------------------------------------
+// Take a box out of the cells it was in
+//
+void CollisionGrid::Remove(int index)
+{
+	if (!IsActive(index))
+		return;
+
+	active[index] = 0;
+
+	int minX, minY, maxX, maxY;
+	CellRange(boxes[index], minX, minY, maxX, maxY);
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			int c = y * columns + x;
+			int* items = &cellItems[cellStart[c]];
+
+			// swap it with the last active entry in the cell
+			for (int k = 0; k < cellCount[c]; k++)
+			{
+				if (items[k] == index)
+				{
+					cellCount[c]--;
+					items[k] = items[cellCount[c]];
+					items[cellCount[c]] = index;
+					break;
+				}
+			}
+		}
+	}
+}
+
+// -----------------------------------------------------
+// Gather the active boxes in the cells touched by bounds
+//
+int CollisionGrid::Query(const Box2D& bounds, int* results, int maxResults)
+{
+	int minX, minY, maxX, maxY;
+	if (!CellRange(bounds, minX, minY, maxX, maxY))
+		return 0;
+
+	// new query id, reset the marks if we wrap around
+	queryId++;
+	if (queryId == 0)
+	{
+		std::fill(queryMark.begin(), queryMark.end(), 0);
+		queryId = 1;
+	}
+
+	int found = 0;
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			int c = y * columns + x;
+			const int* items = &cellItems[cellStart[c]];
+
+			for (int k = 0; k < cellCount[c] && found < maxResults; k++)
+			{
+				int i = items[k];
+				if (queryMark[i] != queryId)
+				{
+					queryMark[i] = queryId;
+					results[found++] = i;
+				}
+			}
+		}
+	}
+
+	// keep the results in index order so callers behave the same as a linear scan
+	std::sort(results, results + found);
+
+	return found;
+}
+
+// -----------------------------------------------------
+// Bounds of a circle moving by displacement
+//
+Box2D CollisionGrid::SweptBounds(const Circle& circle, Vector2 displacement)
+{
+	Vector2 extents(
+		fabsf(displacement.x) * 0.5f + circle.radius,
+		fabsf(displacement.y) * 0.5f + circle.radius);
+
+	return Box2D(circle.center + displacement * 0.5f, extents);
+}
+
+// -----------------------------------------------------
+// Bounds of a circle moving by displacement, bouncing any way it likes
+//
+Box2D CollisionGrid::BouncedBounds(const Circle& circle, Vector2 displacement)
+{
+	float reach = displacement.Length() + circle.radius;
+	return Box2D(circle.center, Vector2(reach, reach));
+}
+
+// -----------------------------------------------------
+// Cell coordinates, clamped to the grid
+//
+int CollisionGrid::CellX(float x) const
+{
+	int c = (int)floorf((x - origin.x) * invCellSize);
+	return std::min(std::max(c, 0), columns - 1);
+}
+
+int CollisionGrid::CellY(float y) const
+{
+	int r = (int)floorf((y - origin.y) * invCellSize);
+	return std::min(std::max(r, 0), rows - 1);
+}
+
+// -----------------------------------------------------
+// Range of cells a box touches
+//
+bool CollisionGrid::CellRange(const Box2D& box, int& minX, int& minY, int& maxX, int& maxY) const
+{
+	if (columns == 0 || rows == 0)
+		return false;
+
+	Vector2 lo = box.center - box.extents;
+	Vector2 hi = box.center + box.extents;
+
+	// completely outside the grid
+	if (hi.x < origin.x || hi.y < origin.y ||
+		lo.x > origin.x + columns * cellSize || lo.y > origin.y + rows * cellSize)
+		return false;
+
+	minX = CellX(lo.x);
+	minY = CellY(lo.y);
+	maxX = CellX(hi.x);
+	maxY = CellY(hi.y);
+
+	return true;
+}
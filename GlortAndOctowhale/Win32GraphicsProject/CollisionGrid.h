@@ -0,0 +1,79 @@
+//
+// CollisionGrid
+//		Uniform grid broadphase for static boxes (bricks)
+//
+//	The grid is built once when the level is laid out. Boxes can only be
+//	removed afterwards, so a query only has to look at the handful of cells
+//	the query bounds touch instead of every box in the level.
+//
+
+#ifndef _COLLISION_GRID_H
+#define _COLLISION_GRID_H
+
+#include <vector>
+#include "Collision2D.h"
+
+class CollisionGrid
+{
+public:
+	CollisionGrid();
+
+	// index the given boxes. index i in the grid refers to boxes[i]
+	//  a cellSize <= 0 picks a size from the largest box, so a box touches at most 4 cells
+	void Build(const Box2D* boxes, int count, float cellSize = 0.0f);
+
+	// removes everything from the grid
+	void Clear();
+
+	// take a box out of the grid (i.e. the brick was destroyed)
+	void Remove(int index);
+
+	// check if a box is still in the grid
+	bool IsActive(int index) const { return index >= 0 && index < (int)boxes.size() && active[index] != 0; }
+
+	// get the box that was indexed
+	const Box2D& GetBox(int index) const { return boxes[index]; }
+
+	// number of boxes the grid was built with (active or not)
+	int GetCount() const { return (int)boxes.size(); }
+
+	// gathers the active boxes in the cells touched by bounds
+	//	results are sorted and unique, returns the number written
+	int Query(const Box2D& bounds, int* results, int maxResults);
+
+	// bounds of a circle moving by displacement, used to query for a moving ball
+	static Box2D SweptBounds(const Circle& circle, Vector2 displacement);
+
+	// bounds of everywhere a circle can get moving by displacement when it can bounce on
+	//	the way. bouncing doesn't make the path longer, so it stays within |displacement|
+	static Box2D BouncedBounds(const Circle& circle, Vector2 displacement);
+
+private:
+	// cell coordinates of a position, clamped to the grid
+	int CellX(float x) const;
+	int CellY(float y) const;
+
+	// gets the range of cells a box touches. returns false if it's outside the grid
+	bool CellRange(const Box2D& box, int& minX, int& minY, int& maxX, int& maxY) const;
+
+	Vector2					origin;		// upper left of the grid
+	float					cellSize;
+	float					invCellSize;
+	int						columns;
+	int						rows;
+
+	// cell contents are stored back to back. cellStart[c] is where cell c begins
+	//	and cellCount[c] is how many of those entries are still active
+	std::vector<int>		cellStart;
+	std::vector<int>		cellCount;
+	std::vector<int>		cellItems;
+
+	std::vector<Box2D>		boxes;
+	std::vector<char>		active;
+
+	// used to avoid reporting a box that spans several cells more than once
+	std::vector<unsigned int>	queryMark;
+	unsigned int				queryId;
+};
+
+#endif // _COLLISION_GRID_H
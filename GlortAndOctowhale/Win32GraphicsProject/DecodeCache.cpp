@@ -0,0 +1,403 @@
+//
+// DecodeCache
+//		Keeps decoded PNGs on disk so the next launch reads pixels instead of inflating
+//
+
+#include "DecodeCache.h"
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+static_assert(sizeof(DecodeCacheHeader) == 64, "the pixels are meant to start 64 bytes in");
+
+// empty when the cache is off
+static std::wstring cacheDirectory;
+
+static std::atomic<int> hitCount(0);
+static std::atomic<int> missCount(0);
+static std::atomic<int> storeCount(0);
+static std::atomic<size_t> bytesRead(0);
+static int prunedCount = 0;
+static size_t prunedBytes = 0;
+
+// -----------------------------------------------------
+// Files by wide name, which only Windows has
+//
+static FILE* OpenCacheFile(const std::wstring& path, const wchar_t* mode)
+{
+#ifdef _WIN32
+	return _wfopen(path.c_str(), mode);
+#else
+	std::wstring wideMode = mode;
+	return fopen(std::string(path.begin(), path.end()).c_str(), std::string(wideMode.begin(), wideMode.end()).c_str());
+#endif
+}
+
+// replaces to if it's there
+static bool RenameCacheFile(const std::wstring& from, const std::wstring& to)
+{
+#ifdef _WIN32
+	return MoveFileExW(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(std::string(from.begin(), from.end()).c_str(), std::string(to.begin(), to.end()).c_str()) == 0;
+#endif
+}
+
+static void RemoveCacheFile(const std::wstring& path)
+{
+#ifdef _WIN32
+	_wremove(path.c_str());
+#else
+	remove(std::string(path.begin(), path.end()).c_str());
+#endif
+}
+
+static bool MakeDirectory(const std::wstring& path)
+{
+#ifdef _WIN32
+	return CreateDirectoryW(path.c_str(), NULL) != 0 || GetLastError() == ERROR_ALREADY_EXISTS;
+#else
+	return mkdir(std::string(path.begin(), path.end()).c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
+// sets the modified time to now
+static void TouchCacheFile(const std::wstring& path)
+{
+#ifdef _WIN32
+	_wutime(path.c_str(), NULL);
+#else
+	utime(std::string(path.begin(), path.end()).c_str(), NULL);
+#endif
+}
+
+// a file in the cache directory
+struct CacheFile
+{
+	std::wstring	name;
+	uint64_t		size;
+	int64_t			modified;	// seconds since 1970
+	bool			temporary;	// a .tmp that Store didn't finish with
+};
+
+static bool HasSuffix(const std::wstring& name, const wchar_t* suffix)
+{
+	size_t length = wcslen(suffix);
+	return name.size() > length && name.compare(name.size() - length, length, suffix) == 0;
+}
+
+// the .rgba and .tmp files in a directory, nothing else in there is touched
+static void ListCacheFiles(const std::wstring& directory, std::vector<CacheFile>& files)
+{
+#ifdef _WIN32
+	WIN32_FIND_DATAW data;
+	HANDLE find = FindFirstFileW((directory + L"\\*").c_str(), &data);
+	if (find == INVALID_HANDLE_VALUE)
+		return;
+
+	do
+	{
+		CacheFile file;
+		file.name = data.cFileName;
+		file.temporary = HasSuffix(file.name, L".tmp");
+		if ((data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) || (!file.temporary && !HasSuffix(file.name, L".rgba")))
+			continue;
+
+		// FILETIME is 100ns ticks since 1601
+		uint64_t ticks = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+		file.modified = (int64_t)(ticks / 10000000) - 11644473600ll;
+		file.size = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+		files.push_back(file);
+	}
+	while (FindNextFileW(find, &data));
+
+	FindClose(find);
+#else
+	std::string narrow(directory.begin(), directory.end());
+	DIR* dir = opendir(narrow.c_str());
+	if (dir == nullptr)
+		return;
+
+	while (dirent* entry = readdir(dir))
+	{
+		std::string name = entry->d_name;
+		CacheFile file;
+		file.name = std::wstring(name.begin(), name.end());
+		file.temporary = HasSuffix(file.name, L".tmp");
+		if (!file.temporary && !HasSuffix(file.name, L".rgba"))
+			continue;
+
+		struct stat info;
+		if (stat((narrow + "/" + name).c_str(), &info) != 0 || !S_ISREG(info.st_mode))
+			continue;
+
+		file.modified = (int64_t)info.st_mtime;
+		file.size = (uint64_t)info.st_size;
+		files.push_back(file);
+	}
+
+	closedir(dir);
+#endif
+}
+
+static unsigned long ProcessId()
+{
+#ifdef _WIN32
+	return (unsigned long)GetCurrentProcessId();
+#else
+	return (unsigned long)getpid();
+#endif
+}
+
+// -----------------------------------------------------
+// Setup
+//
+bool DecodeCache::SetDirectory(const wchar_t* directory)
+{
+	cacheDirectory = directory;
+	if (cacheDirectory.empty())
+		return true;
+
+	// without a separator on the end, MakePath adds one
+	while (cacheDirectory.size() > 1 && (cacheDirectory.back() == L'\\' || cacheDirectory.back() == L'/'))
+	{
+		cacheDirectory.pop_back();
+	}
+
+	if (!MakeDirectory(cacheDirectory))
+	{
+		cacheDirectory.clear();
+		return false;
+	}
+
+	Prune(MaxBytes, MaxAgeDays);
+	return true;
+}
+
+// -----------------------------------------------------
+// Keep the directory from growing forever
+//
+int DecodeCache::Prune(uint64_t maxBytes, int maxAgeDays)
+{
+	if (!IsEnabled())
+		return 0;
+
+	std::vector<CacheFile> files;
+	ListCacheFiles(cacheDirectory, files);
+
+	int64_t now = (int64_t)time(nullptr);
+	int64_t oldest = now - (int64_t)maxAgeDays * 24 * 60 * 60;
+	int64_t oldestTemporary = now - 24 * 60 * 60;
+
+	// most recently used first, so everything past the size limit goes
+	std::sort(files.begin(), files.end(), [](const CacheFile& a, const CacheFile& b) { return a.modified > b.modified; });
+
+	int removed = 0;
+	uint64_t kept = 0;
+	for (const CacheFile& file : files)
+	{
+		// another thread or process could still be writing a new temporary file
+		bool prune = file.temporary ? file.modified < oldestTemporary : file.modified < oldest || kept + file.size > maxBytes;
+		if (!prune)
+		{
+			if (!file.temporary)
+				kept += file.size;
+			continue;
+		}
+
+#ifdef _WIN32
+		std::wstring path = cacheDirectory + L"\\" + file.name;
+#else
+		std::wstring path = cacheDirectory + L"/" + file.name;
+#endif
+		RemoveCacheFile(path);
+		prunedBytes += (size_t)file.size;
+		removed++;
+	}
+
+	prunedCount += removed;
+	return removed;
+}
+
+bool DecodeCache::IsEnabled()
+{
+	return !cacheDirectory.empty();
+}
+
+std::wstring DecodeCache::MakePath(uint64_t sourceHash, Format format)
+{
+	wchar_t name[64];
+	swprintf(name, 64, L"%016llx-%ls.rgba", (unsigned long long)sourceHash, format == FormatRGBA8Premultiplied ? L"rgba8p" : L"rgba8");
+#ifdef _WIN32
+	return cacheDirectory + L"\\" + name;
+#else
+	return cacheDirectory + L"/" + name;
+#endif
+}
+
+// -----------------------------------------------------
+// Eight bytes at a time, finished like splitmix64 so every bit of the input moves the name
+//
+uint64_t DecodeCache::Hash(const uint8_t* data, size_t size)
+{
+	const uint64_t k = 0x9e3779b97f4a7c15ull;
+	uint64_t hash = (uint64_t)size * k;
+
+	size_t i = 0;
+	for (; i + 8 <= size; i += 8)
+	{
+		uint64_t word;
+		memcpy(&word, data + i, 8);
+		hash ^= word * k;
+		hash = ((hash << 29) | (hash >> 35)) * 0xbf58476d1ce4e5b9ull;
+	}
+
+	uint64_t tail = 0;
+	memcpy(&tail, data + i, size - i);
+	hash ^= tail * k;
+
+	hash ^= hash >> 30;
+	hash *= 0xbf58476d1ce4e5b9ull;
+	hash ^= hash >> 27;
+	hash *= 0x94d049bb133111ebull;
+	hash ^= hash >> 31;
+	return hash;
+}
+
+// -----------------------------------------------------
+// Read a cache file, only if it's for exactly this source
+//
+bool DecodeCache::Load(uint64_t sourceHash, size_t sourceSize, Format format, ImageRGBA& image)
+{
+	if (!IsEnabled())
+		return false;
+
+	std::wstring path = MakePath(sourceHash, format);
+	FILE* file = OpenCacheFile(path, L"rb");
+	if (file == nullptr)
+		return false;
+
+	DecodeCacheHeader header;
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 && header.magic == Magic && header.version == Version &&
+		header.format == (uint32_t)format && header.sourceHash == sourceHash && header.sourceSize == sourceSize &&
+		header.width > 0 && header.height > 0 && header.width <= 16384 && header.height <= 16384 &&
+		header.pixelBytes == (uint64_t)header.width * header.height * 4;
+
+	// straight into the image, the only copy is out of the file cache
+	if (ok)
+	{
+		image.width = (int)header.width;
+		image.height = (int)header.height;
+		image.pixels.resize((size_t)header.width * header.height);
+		ok = fread(image.pixels.data(), 1, (size_t)header.pixelBytes, file) == header.pixelBytes;
+	}
+	fclose(file);
+
+	if (!ok)
+	{
+		image = ImageRGBA();
+		return false;
+	}
+
+	// it's been used, so pruning keeps it
+	TouchCacheFile(path);
+
+	bytesRead += (size_t)header.pixelBytes;
+	return true;
+}
+
+bool DecodeCache::Store(uint64_t sourceHash, size_t sourceSize, Format format, const ImageRGBA& image)
+{
+	if (!IsEnabled() || image.width <= 0 || image.height <= 0)
+		return false;
+
+	DecodeCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = Magic;
+	header.version = Version;
+	header.format = (uint32_t)format;
+	header.width = (uint32_t)image.width;
+	header.height = (uint32_t)image.height;
+	header.sourceHash = sourceHash;
+	header.sourceSize = sourceSize;
+	header.pixelBytes = (uint64_t)image.width * image.height * 4;
+
+	// written somewhere only this thread uses, then moved into place in one go
+	static std::atomic<unsigned> serial(0);
+	std::wstring path = MakePath(sourceHash, format);
+	wchar_t suffix[64];
+	swprintf(suffix, 64, L".%lu-%u.tmp", ProcessId(), serial++);
+	std::wstring temporary = path + suffix;
+
+	FILE* file = OpenCacheFile(temporary, L"wb");
+	if (file == nullptr)
+		return false;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		fwrite(image.pixels.data(), 1, (size_t)header.pixelBytes, file) == header.pixelBytes;
+	ok = fclose(file) == 0 && ok;
+
+	if (!ok || !RenameCacheFile(temporary, path))
+	{
+		RemoveCacheFile(temporary);
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------
+// Decode through the cache
+//
+bool DecodeCache::Decode(const uint8_t* data, size_t size, ImageRGBA& image, std::string* error, bool premultiply, bool* hit)
+{
+	if (hit)
+		*hit = false;
+
+	if (!IsEnabled())
+		return PngCodec::Decode(data, size, image, error, premultiply);
+
+	uint64_t hash = Hash(data, size);
+	Format format = premultiply ? FormatRGBA8Premultiplied : FormatRGBA8;
+
+	if (Load(hash, size, format, image))
+	{
+		hitCount++;
+		if (hit)
+			*hit = true;
+		return true;
+	}
+
+	missCount++;
+	if (!PngCodec::Decode(data, size, image, error, premultiply))
+		return false;
+
+	if (Store(hash, size, format, image))
+		storeCount++;
+	return true;
+}
+
+DecodeCache::Stats DecodeCache::GetStats()
+{
+	Stats stats;
+	stats.hits = hitCount;
+	stats.misses = missCount;
+	stats.stores = storeCount;
+	stats.bytesRead = bytesRead;
+	stats.pruned = prunedCount;
+	stats.bytesPruned = prunedBytes;
+	return stats;
+}
@@ -0,0 +1,113 @@
+//
+// DecodeCache
+//		Keeps decoded PNGs on disk so the next launch reads pixels instead of inflating
+//
+//	Each cache file is named after a hash of the PNG's bytes and the pixel format, so
+//	an edited PNG just misses and is decoded and stored again; nothing has to notice
+//	that it changed. The file is a 64 byte header (see DecodeCacheHeader) then the
+//	pixels, rows top to bottom with no padding, exactly what TextureType::Create
+//	uploads. That's a read the size of the texture, against an inflate and unfilter for
+//	the PNG, and the pixels start cache line aligned so the file could be mapped and
+//	uploaded from directly.
+//
+//	Files are written under another name and renamed into place, so a crash or two
+//	threads storing the same image never leave half a file to be read. The header is
+//	checked against the source's hash and size before anything is used.
+//
+//	Nothing notices an edited PNG, so its old file is never read again but stays where
+//	it is, and the directory grows with every edit. SetDirectory prunes it: files that
+//	haven't been used for MaxAgeDays go, then the least recently used until what's left
+//	is under MaxBytes. A hit sets its file's modified time, so that's the time it was
+//	last used (last access times are often turned off on NTFS). Between launches the
+//	cache can still grow by whatever one run stores.
+//
+//	Off until SetDirectory is called. Safe to use from the loader's threads once it has
+//	been.
+//
+
+#ifndef _DECODE_CACHE_H
+#define _DECODE_CACHE_H
+
+#include "PngCodec.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+struct DecodeCacheHeader
+{
+	uint32_t	magic;
+	uint32_t	version;		// DecodeCache::Version when it was written
+	uint32_t	format;			// DecodeCache::Format
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	reserved;
+	uint64_t	sourceHash;		// DecodeCache::Hash of the PNG
+	uint64_t	sourceSize;
+	uint64_t	pixelBytes;		// width * height * 4
+	uint8_t		padding[16];	// the pixels start 64 bytes in
+};
+
+class DecodeCache
+{
+public:
+	static const uint32_t Magic = 0x31544344;		// "DCT1"
+
+	// change this whenever PngCodec would decode the same file to different pixels
+	static const uint32_t Version = 1;
+
+	// what SetDirectory prunes the cache to
+	static const int MaxAgeDays = 30;
+	static const uint64_t MaxBytes = (uint64_t)256 << 20;
+
+	enum Format
+	{
+		FormatRGBA8 = 1,
+		FormatRGBA8Premultiplied = 2
+	};
+
+	// what the cache has done since startup
+	struct Stats
+	{
+		int		hits;
+		int		misses;
+		int		stores;			// misses written back
+		size_t	bytesRead;		// pixels read from cache files
+		int		pruned;			// files Prune removed
+		size_t	bytesPruned;
+	};
+
+	// where cache files go, made if it isn't there, then pruned to MaxBytes and MaxAgeDays.
+	//	an empty name turns the cache off. call before anything is loaded, it isn't guarded
+	//	against the loader's threads
+	static bool SetDirectory(const wchar_t* directory);
+	static bool IsEnabled();
+
+	// remove cache files that haven't been used for maxAgeDays, then the least recently
+	//	used until the rest add up to no more than maxBytes. temporary files left by a crash
+	//	go once they're a day old. returns how many files were removed. like SetDirectory,
+	//	not while the loader's threads are using the cache
+	static int Prune(uint64_t maxBytes, int maxAgeDays);
+
+	// decode a PNG in memory through the cache: the stored pixels if they're there,
+	//	otherwise PngCodec::Decode and store them. hit says which, if it isn't null. with
+	//	the cache off this is just PngCodec::Decode
+	static bool Decode(const uint8_t* data, size_t size, ImageRGBA& image, std::string* error = nullptr,
+		bool premultiply = false, bool* hit = nullptr);
+
+	// the cached pixels for a PNG's hash and size, false if there aren't any
+	static bool Load(uint64_t sourceHash, size_t sourceSize, Format format, ImageRGBA& image);
+
+	// write them. failing only means decoding again next launch, so it's silent
+	static bool Store(uint64_t sourceHash, size_t sourceSize, Format format, const ImageRGBA& image);
+
+	// 64 bit hash of the bytes, eight at a time. not for anything adversarial
+	static uint64_t Hash(const uint8_t* data, size_t size);
+
+	static Stats GetStats();
+
+private:
+	// the cache file for a key
+	static std::wstring MakePath(uint64_t sourceHash, Format format);
+};
+
+#endif // _DECODE_CACHE_H
@@ -0,0 +1,133 @@
+//
+// EntityPool
+//		Fixed number of objects, with a packed list of the live ones
+//
+//	Objects never move, so pointers to them and anything indexed by their slot (like the
+//	collision grid) stay good while they are alive. Destroying one swaps the last live
+//	slot into its place in the live list, so looping over the live ones never touches a
+//	dead one, and costs nothing for the ones that are gone.
+//
+//	Game code holds an EntityId, the slot plus a generation that goes up every time the
+//	slot is destroyed, so an id for something that's gone (and maybe been reused) is caught.
+//
+
+#ifndef _ENTITY_POOL_H
+#define _ENTITY_POOL_H
+
+// slot in the low 16 bits, generation in the high 16. 0 is never a live entity
+typedef unsigned int EntityId;
+const EntityId InvalidEntity = 0;
+
+template <typename T, int Capacity>
+class EntityPool
+{
+public:
+	static_assert(Capacity > 0 && Capacity <= 0xffff, "slots have to fit in 16 bits");
+
+	EntityPool()
+	{
+		for (int i = 0; i < Capacity; i++)
+		{
+			generation[i] = 1;
+		}
+		count = 0;
+		Clear();
+	}
+
+	// get a free slot and make it live. returns InvalidEntity if they're all in use
+	//	the object is left as it was, set it up after creating it.
+	//	straight after Clear, slots are handed out 0, 1, 2...
+	EntityId Create()
+	{
+		if (count == Capacity)
+			return InvalidEntity;
+
+		int slot = dense[count];
+		count++;
+		return MakeId(slot);
+	}
+
+	// take something out of the live list. does nothing if it's already gone
+	void Destroy(EntityId id)
+	{
+		if (!IsAlive(id))
+			return;
+
+		// swap the last live slot into the gap, the dead one goes to the front of the free ones
+		int slot = SlotOf(id);
+		int at = sparse[slot];
+		int last = count - 1;
+
+		int moved = dense[last];
+		dense[at] = moved;
+		sparse[moved] = at;
+		dense[last] = slot;
+		sparse[slot] = last;
+		count--;
+
+		NextGeneration(slot);
+	}
+
+	// everything is dead, and ids from before won't work
+	void Clear()
+	{
+		for (int i = 0; i < count; i++)
+		{
+			NextGeneration(dense[i]);
+		}
+		for (int i = 0; i < Capacity; i++)
+		{
+			dense[i] = i;
+			sparse[i] = i;
+		}
+		count = 0;
+	}
+
+	bool IsAlive(EntityId id) const
+	{
+		int slot = SlotOf(id);
+		return id != InvalidEntity && slot < Capacity && sparse[slot] < count && generation[slot] == (int)(id >> 16);
+	}
+
+	// get a live object, null if it's gone
+	T* Get(EntityId id)				{ return IsAlive(id) ? &items[SlotOf(id)] : nullptr; }
+	const T* Get(EntityId id) const	{ return IsAlive(id) ? &items[SlotOf(id)] : nullptr; }
+
+	// the id of whatever is in a slot now, InvalidEntity if the slot isn't live
+	EntityId GetIdAtSlot(int slot) const
+	{
+		if (slot < 0 || slot >= Capacity || sparse[slot] >= count)
+			return InvalidEntity;
+		return MakeId(slot);
+	}
+
+	// the slot part of an id, for indexing other arrays
+	static int SlotOf(EntityId id) { return (int)(id & 0xffff); }
+
+	// live objects, in no particular order. 0 <= i < GetCount()
+	int GetCount() const				{ return count; }
+	T& operator[](int i)				{ return items[dense[i]]; }
+	const T& operator[](int i) const	{ return items[dense[i]]; }
+	EntityId GetId(int i) const			{ return MakeId(dense[i]); }
+
+	static int GetCapacity() { return Capacity; }
+
+private:
+	EntityId MakeId(int slot) const { return ((EntityId)generation[slot] << 16) | (EntityId)slot; }
+
+	// old ids for this slot don't work any more
+	void NextGeneration(int slot)
+	{
+		generation[slot] = (generation[slot] + 1) & 0xffff;
+		if (generation[slot] == 0)
+			generation[slot] = 1;
+	}
+
+	T		items[Capacity];
+	int		dense[Capacity];		// live slots first, then the free ones
+	int		sparse[Capacity];		// where each slot is in dense
+	int		generation[Capacity];
+	int		count;
+};
+
+#endif // _ENTITY_POOL_H
@@ -0,0 +1,177 @@
+//
+// Fixed
+//		Q16.16 fixed point numbers, for simulation that has to give the same answer on every build
+//
+//	Floats can give slightly different answers depending on compiler flags (FMA contraction,
+//	library versions of sqrtf/fmodf, etc). Everything here is integer math, so it doesn't.
+//	Range is about +/-32767 with a precision of 1/65536. Shifts of negative numbers are
+//	arithmetic on every compiler we build with (MSVC, gcc, clang).
+//
+//	Adding and subtracting wrap around on overflow, like the hardware does. They're done
+//	on uint32_t, because signed overflow is undefined and the optimiser is free to give a
+//	different answer in different builds. Converting the result back to int32_t keeps the
+//	bits on all three compilers.
+//
+//	Squared lengths and dot products of positions don't fit in 16.16, so those come back "wide",
+//	as an int64_t that is still 16.16 fixed point.
+//
+
+#ifndef _FIXED_H
+#define _FIXED_H
+
+#include <stdint.h>
+#include <math.h>
+
+struct Fixed
+{
+	int32_t raw;
+
+	static const int FractionBits = 16;
+	static const int32_t OneRaw = 1 << FractionBits;
+
+	Fixed() : raw(0) {}
+
+	// conversions. FromFloat rounds to the nearest 1/65536 and saturates
+	static Fixed FromRaw(int32_t r) { Fixed f; f.raw = r; return f; }
+	static Fixed FromInt(int v) { return FromRaw((int32_t)((uint32_t)v << FractionBits)); }
+	static Fixed FromFloat(float v)
+	{
+		if (v >= 32767.0f) return FromRaw(INT32_MAX);
+		if (v <= -32768.0f) return FromRaw(INT32_MIN);
+		return FromRaw((int32_t)floorf(v * 65536.0f + 0.5f));
+	}
+	static Fixed FromWide(int64_t wide) { return FromRaw(Saturate(wide)); }
+
+	float ToFloat() const { return (float)raw * (1.0f / 65536.0f); }
+	int ToInt() const { return raw >> FractionBits; }	// rounds down
+
+	// arithmetic. add and subtract wrap, multiply rounds down, divide rounds towards zero
+	//	and saturates (even for / 0)
+	Fixed operator+(Fixed b) const { return FromRaw(WrapAdd(raw, b.raw)); }
+	Fixed operator-(Fixed b) const { return FromRaw(WrapSub(raw, b.raw)); }
+	Fixed operator-() const { return FromRaw(WrapSub(0, raw)); }
+	Fixed operator*(Fixed b) const { return FromWide(((int64_t)raw * b.raw) >> FractionBits); }
+	Fixed operator/(Fixed b) const { return FromWide(WideDiv(raw, b.raw)); }
+
+	Fixed& operator+=(Fixed b) { raw = WrapAdd(raw, b.raw); return *this; }
+	Fixed& operator-=(Fixed b) { raw = WrapSub(raw, b.raw); return *this; }
+	Fixed& operator*=(Fixed b) { *this = *this * b; return *this; }
+	Fixed& operator/=(Fixed b) { *this = *this / b; return *this; }
+
+	bool operator==(Fixed b) const { return raw == b.raw; }
+	bool operator!=(Fixed b) const { return raw != b.raw; }
+	bool operator<(Fixed b) const { return raw < b.raw; }
+	bool operator>(Fixed b) const { return raw > b.raw; }
+	bool operator<=(Fixed b) const { return raw <= b.raw; }
+	bool operator>=(Fixed b) const { return raw >= b.raw; }
+
+	static Fixed Abs(Fixed a) { return a.raw < 0 ? -a : a; }
+	static Fixed Min(Fixed a, Fixed b) { return a.raw < b.raw ? a : b; }
+	static Fixed Max(Fixed a, Fixed b) { return a.raw > b.raw ? a : b; }
+	static Fixed Clamp(Fixed v, Fixed lo, Fixed hi) { return v.raw < lo.raw ? lo : (v.raw > hi.raw ? hi : v); }
+
+	// square root of a wide value, rounds down. negative values give 0
+	static Fixed SqrtWide(int64_t wide)
+	{
+		if (wide <= 0)
+			return Fixed();
+
+		// sqrt(raw / 65536) * 65536 = sqrt(raw * 65536)
+		if (wide >= ((int64_t)1 << 47))
+			return FromRaw(INT32_MAX);
+
+		uint64_t n = (uint64_t)wide << FractionBits;
+		uint64_t result = 0;
+		uint64_t bit = (uint64_t)1 << 62;
+
+		while (bit > n)
+			bit >>= 2;
+
+		while (bit != 0)
+		{
+			if (n >= result + bit)
+			{
+				n -= result + bit;
+				result = (result >> 1) + bit;
+			}
+			else
+			{
+				result >>= 1;
+			}
+			bit >>= 2;
+		}
+
+		return FromWide((int64_t)result);
+	}
+	static Fixed Sqrt(Fixed a) { return SqrtWide(a.raw); }
+
+	// wide helpers, both sides are 16.16
+	static int64_t WideMul(int64_t a, int64_t b) { return (a * b) >> FractionBits; }
+	static int64_t WideDiv(int64_t a, int64_t b)
+	{
+		if (b == 0)
+			return a < 0 ? INT32_MIN : INT32_MAX;
+
+		// drop precision rather than overflow when shifting a up
+		while (a >= ((int64_t)1 << 46) || a <= -((int64_t)1 << 46))
+		{
+			a >>= 1;
+			b >>= 1;
+			if (b == 0)
+				return a < 0 ? INT32_MIN : INT32_MAX;
+		}
+
+		return (a * OneRaw) / b;
+	}
+
+	// raw add and subtract with defined wrap around, see the top of the file
+	static int32_t WrapAdd(int32_t a, int32_t b) { return (int32_t)((uint32_t)a + (uint32_t)b); }
+	static int32_t WrapSub(int32_t a, int32_t b) { return (int32_t)((uint32_t)a - (uint32_t)b); }
+
+	static int32_t Saturate(int64_t wide)
+	{
+		if (wide > INT32_MAX) return INT32_MAX;
+		if (wide < INT32_MIN) return INT32_MIN;
+		return (int32_t)wide;
+	}
+};
+
+//
+// 2D vector of fixed point numbers
+//
+struct FixedVector2
+{
+	Fixed x;
+	Fixed y;
+
+	FixedVector2() {}
+	FixedVector2(Fixed _x, Fixed _y) : x(_x), y(_y) {}
+
+	static FixedVector2 FromFloat(float fx, float fy) { return FixedVector2(Fixed::FromFloat(fx), Fixed::FromFloat(fy)); }
+
+	// these go through Fixed's operators, so they wrap the same way
+	FixedVector2 operator+(const FixedVector2& v) const { return FixedVector2(x + v.x, y + v.y); }
+	FixedVector2 operator-(const FixedVector2& v) const { return FixedVector2(x - v.x, y - v.y); }
+	FixedVector2 operator-() const { return FixedVector2(-x, -y); }
+	FixedVector2 operator*(Fixed s) const { return FixedVector2(x * s, y * s); }
+	FixedVector2 operator/(Fixed s) const { return FixedVector2(x / s, y / s); }
+
+	FixedVector2& operator+=(const FixedVector2& v) { x += v.x; y += v.y; return *this; }
+	FixedVector2& operator-=(const FixedVector2& v) { x -= v.x; y -= v.y; return *this; }
+
+	bool operator==(const FixedVector2& v) const { return x == v.x && y == v.y; }
+	bool operator!=(const FixedVector2& v) const { return x != v.x || y != v.y; }
+
+	// wide, so positions a screen apart don't overflow
+	int64_t DotWide(const FixedVector2& v) const { return ((int64_t)x.raw * v.x.raw + (int64_t)y.raw * v.y.raw) >> Fixed::FractionBits; }
+	int64_t LengthSquaredWide() const { return DotWide(*this); }
+
+	// for vectors that are small enough (e.g. one of them is a normal)
+	Fixed Dot(const FixedVector2& v) const { return Fixed::FromWide(DotWide(v)); }
+	Fixed Length() const { return Fixed::SqrtWide(LengthSquaredWide()); }
+
+	// reflect v about the normal n
+	static FixedVector2 Reflect(const FixedVector2& v, const FixedVector2& n) { return v - n * (Fixed::FromInt(2) * v.Dot(n)); }
+};
+
+#endif // _FIXED_H
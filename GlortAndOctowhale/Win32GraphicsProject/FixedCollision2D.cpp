@@ -0,0 +1,292 @@
+//
+// FixedCollision
+//		Fixed point versions of the Collision2D shapes and tests
+//
+
+#include "FixedCollision2D.h"
+
+static const Fixed fixedZero;
+static const Fixed fixedOne = Fixed::FromInt(1);
+
+// -----------------------------------------------------
+// Box Box Check
+//
+bool FixedCollision2D::BoxBoxCheck(const FixedBox2D& boxA, const FixedBox2D& boxB)
+{
+	FixedVector2 delta = boxA.center - boxB.center;
+
+	return Fixed::Abs(delta.x) < boxA.extents.x + boxB.extents.x &&
+		Fixed::Abs(delta.y) < boxA.extents.y + boxB.extents.y;
+}
+
+// -----------------------------------------------------
+// Box Circle Check
+//
+bool FixedCollision2D::BoxCircleCheck(const FixedBox2D& box, const FixedCircle& circle)
+{
+	FixedVector2 distance = circle.center - box.center;
+
+	// check the x axis distance
+	if (Fixed::Abs(distance.x) > box.extents.x + circle.radius)
+		return false;
+
+	// check the y axis distance
+	if (Fixed::Abs(distance.y) > box.extents.y + circle.radius)
+		return false;
+
+	// straight line distance
+	if (distance.Length() > box.extents.Length() + circle.radius)
+		return false;
+
+	return true;
+}
+
+// -----------------------------------------------------
+// Circle / Circle check
+//	compares squared distances, so there's no square root at all
+//
+bool FixedCollision2D::CircleCircleCheck(const FixedCircle& circleA, const FixedCircle& circleB)
+{
+	int64_t reach = (int64_t)circleA.radius.raw + circleB.radius.raw;
+	return (circleA.center - circleB.center).LengthSquaredWide() <= Fixed::WideMul(reach, reach);
+}
+
+// -----------------------------------------------------
+// Line / Line test
+//	a = a.start + (a.end - a.start) * t_a, b the same with t_b
+//
+bool FixedCollision2D::LineLineCheck(const FixedLine2D& a, const FixedLine2D& b, Fixed& t_a, Fixed& t_b, FixedVector2& intersection)
+{
+	FixedVector2 dirA = a.end - a.start;
+	FixedVector2 dirB = b.end - b.start;
+	FixedVector2 between = b.start - a.start;
+
+	// cross products, kept wide
+	int64_t denom = Fixed::WideMul(dirA.x.raw, dirB.y.raw) - Fixed::WideMul(dirA.y.raw, dirB.x.raw);
+
+	// parallel lines
+	if (denom == 0)
+		return false;
+
+	int64_t numA = Fixed::WideMul(between.x.raw, dirB.y.raw) - Fixed::WideMul(between.y.raw, dirB.x.raw);
+	int64_t numB = Fixed::WideMul(between.x.raw, dirA.y.raw) - Fixed::WideMul(between.y.raw, dirA.x.raw);
+
+	t_a = Fixed::FromWide(Fixed::WideDiv(numA, denom));
+	t_b = Fixed::FromWide(Fixed::WideDiv(numB, denom));
+	intersection = a.start + dirA * t_a;
+
+	return true;
+}
+
+// -----------------------------------------------------
+// Contact between a moving circle and a box
+//	same steps as Collision2D::CircleBoxContact
+//
+FixedContact2D FixedCollision2D::CircleBoxContact(const FixedCircle& circle, const FixedBox2D& box, FixedVector2 displacement)
+{
+	FixedContact2D contact;
+
+	// work relative to the center of the box
+	FixedVector2 start = circle.center - box.center;
+	FixedVector2 extents = box.extents;
+	Fixed radius = circle.radius;
+
+	// check if we are already touching the box
+	FixedVector2 closest(Fixed::Clamp(start.x, -extents.x, extents.x), Fixed::Clamp(start.y, -extents.y, extents.y));
+	FixedVector2 away = start - closest;
+	int64_t distanceSq = away.LengthSquaredWide();
+
+	if (distanceSq <= Fixed::WideMul(radius.raw, radius.raw))
+	{
+		contact.hit = true;
+		contact.toi = fixedZero;
+
+		Fixed distance = Fixed::SqrtWide(distanceSq);
+		if (distance > fixedZero)
+		{
+			contact.normal = away / distance;
+			contact.penetration = radius - distance;
+			contact.point = box.center + closest;
+		}
+		else
+		{
+			// the center is inside the box (or too close to tell), push out the shortest way
+			Fixed insideX = extents.x - Fixed::Abs(start.x);
+			Fixed insideY = extents.y - Fixed::Abs(start.y);
+
+			if (insideX < insideY)
+			{
+				contact.normal = FixedVector2(start.x < fixedZero ? -fixedOne : fixedOne, fixedZero);
+				contact.penetration = insideX + radius;
+				contact.point = box.center + FixedVector2(contact.normal.x * extents.x, start.y);
+			}
+			else
+			{
+				contact.normal = FixedVector2(fixedZero, start.y < fixedZero ? -fixedOne : fixedOne);
+				contact.penetration = insideY + radius;
+				contact.point = box.center + FixedVector2(start.x, contact.normal.y * extents.y);
+			}
+		}
+
+		return contact;
+	}
+
+	// trace against the grown box, one axis (slab) at a time
+	FixedVector2 grown = extents + FixedVector2(radius, radius);
+	Fixed tEnter = fixedZero;
+	Fixed tExit = fixedOne;
+	int enterAxis = -1;
+
+	for (int axis = 0; axis < 2; axis++)
+	{
+		Fixed p = axis == 0 ? start.x : start.y;
+		Fixed d = axis == 0 ? displacement.x : displacement.y;
+		Fixed g = axis == 0 ? grown.x : grown.y;
+
+		if (d == fixedZero)
+		{
+			// not moving on this axis, we have to already be in the slab
+			if (p < -g || p > g)
+				return contact;
+			continue;
+		}
+
+		Fixed t1 = (-g - p) / d;
+		Fixed t2 = (g - p) / d;
+		if (t1 > t2)
+		{
+			Fixed temp = t1;
+			t1 = t2;
+			t2 = temp;
+		}
+
+		if (t1 > tEnter)
+		{
+			tEnter = t1;
+			enterAxis = axis;
+		}
+		if (t2 < tExit)
+			tExit = t2;
+
+		if (tEnter > tExit)
+			return contact;
+	}
+
+	// where we entered the grown box
+	FixedVector2 enter = start + displacement * tEnter;
+	bool outsideX = enter.x < -extents.x || enter.x > extents.x;
+	bool outsideY = enter.y < -extents.y || enter.y > extents.y;
+
+	if (outsideX && outsideY)
+	{
+		// in a corner region, the rounded box is a circle around the corner here
+		FixedVector2 corner(enter.x < fixedZero ? -extents.x : extents.x, enter.y < fixedZero ? -extents.y : extents.y);
+		FixedVector2 m = start - corner;
+
+		// the float version solves the quadratic directly, but b * b - a * c overflows in fixed point.
+		//	walking along the unit direction instead keeps the numbers in pixels
+		Fixed length = displacement.Length();
+		if (length == fixedZero)
+			return contact;
+
+		FixedVector2 direction = displacement / length;
+		int64_t b = m.DotWide(direction);
+		int64_t c = m.LengthSquaredWide() - Fixed::WideMul(radius.raw, radius.raw);
+
+		// moving away from the corner, or missing it
+		int64_t discriminant = Fixed::WideMul(b, b) - c;
+		if (b >= 0 || discriminant < 0)
+			return contact;
+
+		int64_t distance = -b - Fixed::SqrtWide(discriminant).raw;
+		Fixed t = Fixed::FromWide(Fixed::WideDiv(distance, length.raw));
+		if (t < fixedZero || t > fixedOne)
+			return contact;
+
+		contact.hit = true;
+		contact.toi = t;
+		contact.normal = (m + displacement * t) / radius;
+		contact.point = box.center + corner;
+		return contact;
+	}
+
+	// starting inside the grown box always lands in a corner, so we entered through a face
+	if (enterAxis < 0)
+		return contact;
+
+	contact.hit = true;
+	contact.toi = tEnter;
+	if (enterAxis == 0)
+		contact.normal = FixedVector2(displacement.x > fixedZero ? -fixedOne : fixedOne, fixedZero);
+	else
+		contact.normal = FixedVector2(fixedZero, displacement.y > fixedZero ? -fixedOne : fixedOne);
+
+	// the contact is one radius from the center, back along the normal
+	contact.point = circle.center + displacement * tEnter - contact.normal * radius;
+
+	return contact;
+}
+
+// -----------------------------------------------------
+// Moves a circle through a set of boxes, bouncing off the first thing it hits
+//	and carrying on with the time left over until the time is used up
+FixedVector2 FixedCollision2D::MoveCircle(FixedCircle circle, FixedVector2& velocity, Fixed deltaTime, const FixedBox2D* boxes, int count,
+	FixedSweepHit2D* hits, int maxHits, int& numHits)
+{
+	// stop bouncing back and forth forever in a tight spot
+	const int maxBounces = 8;
+
+	numHits = 0;
+	Fixed timeLeft = fixedOne; // fraction of deltaTime we still have to move
+
+	for (int bounce = 0; bounce < maxBounces && timeLeft > fixedZero; bounce++)
+	{
+		FixedVector2 displacement = velocity * (deltaTime * timeLeft);
+
+		// find the first box we hit
+		int hitIndex = -1;
+		FixedContact2D hit;
+
+		for (int i = 0; i < count; i++)
+		{
+			FixedContact2D contact = CircleBoxContact(circle, boxes[i], displacement);
+
+			// already overlapping and moving away isn't a hit
+			if (!contact.hit || (contact.toi == fixedZero && displacement.DotWide(contact.normal) >= 0))
+				continue;
+
+			// take the earliest, and the deepest if we are overlapping more than one
+			if (hitIndex < 0 || contact.toi < hit.toi || (contact.toi == hit.toi && contact.penetration > hit.penetration))
+			{
+				hitIndex = i;
+				hit = contact;
+			}
+		}
+
+		// nothing in the way, move the rest of the way
+		if (hitIndex < 0)
+		{
+			circle.center += displacement;
+			break;
+		}
+
+		// move up to the contact, out of the box if we started inside it, and bounce
+		circle.center += displacement * hit.toi + hit.normal * hit.penetration;
+		velocity = FixedVector2::Reflect(velocity, hit.normal);
+
+		// record the time as a fraction of the whole step
+		Fixed timeUsed = (fixedOne - timeLeft) + hit.toi * timeLeft;
+		timeLeft = timeLeft * (fixedOne - hit.toi);
+
+		if (numHits < maxHits)
+		{
+			hits[numHits].index = hitIndex;
+			hits[numHits].time = timeUsed;
+			hits[numHits].position = circle.center;
+			hits[numHits].contact = hit;
+			numHits++;
+		}
+	}
+
+	return circle.center;
+}
@@ -0,0 +1,109 @@
+//
+// FixedCollision
+//		Fixed point versions of the Collision2D shapes and tests
+//
+//	Same tests as Collision2D, but all the math is Q16.16 fixed point so the results are
+//	bit identical on every build. Used when DETERMINISTIC_SIM is defined, so replays and
+//	lockstep sessions don't drift apart.
+//
+
+#ifndef _FIXED_COLLISION_H
+#define _FIXED_COLLISION_H
+
+#include "Fixed.h"
+#include "Collision2D.h"
+
+// conversions from and to the float types
+inline FixedVector2 ToFixed(Vector2 v) { return FixedVector2::FromFloat(v.x, v.y); }
+inline Vector2 ToVector2(const FixedVector2& v) { return Vector2(v.x.ToFloat(), v.y.ToFloat()); }
+
+//
+//	An axis aligned bounding box
+//
+struct FixedBox2D
+{
+	FixedVector2 center;
+	FixedVector2 extents;
+
+	FixedBox2D() {}
+	FixedBox2D(FixedVector2 _center, FixedVector2 _extents) : center(_center), extents(_extents) {}
+	explicit FixedBox2D(const Box2D& box) : center(ToFixed(box.center)), extents(ToFixed(box.extents)) {}
+};
+
+//
+//	A circle
+//
+struct FixedCircle
+{
+	FixedVector2	center;
+	Fixed			radius;
+
+	FixedCircle() {}
+	FixedCircle(FixedVector2 _center, Fixed _radius) : center(_center), radius(_radius) {}
+	explicit FixedCircle(const Circle& circle) : center(ToFixed(circle.center)), radius(Fixed::FromFloat(circle.radius)) {}
+};
+
+//
+//	A line segment
+//
+struct FixedLine2D
+{
+	FixedVector2 start;
+	FixedVector2 end;
+
+	FixedLine2D() {}
+	FixedLine2D(FixedVector2 _start, FixedVector2 _end) : start(_start), end(_end) {}
+	explicit FixedLine2D(const Line2D& line) : start(ToFixed(line.start)), end(ToFixed(line.end)) {}
+};
+
+//
+// Contact between two shapes, see Contact2D
+//
+struct FixedContact2D
+{
+	bool			hit;
+	Fixed			toi;
+	Fixed			penetration;
+	FixedVector2	normal;
+	FixedVector2	point;
+
+	FixedContact2D() : hit(false) {}
+};
+
+//
+// One bounce found while moving a circle through a set of boxes, see SweepHit2D
+//
+struct FixedSweepHit2D
+{
+	int				index;
+	Fixed			time;
+	FixedVector2	position;
+	FixedContact2D	contact;
+
+	FixedSweepHit2D() : index(-1) {}
+};
+
+//
+// Fixed point versions of the Collision2D functions
+//
+class FixedCollision2D
+{
+public:
+	static bool BoxBoxCheck(const FixedBox2D& boxA, const FixedBox2D& boxB);
+	static bool BoxCircleCheck(const FixedBox2D& box, const FixedCircle& circle);
+	static bool CircleCircleCheck(const FixedCircle& circleA, const FixedCircle& circleB);
+
+	// Line / Line test
+	//	returns false if the lines are exactly parallel, there is no epsilon
+	static bool LineLineCheck(const FixedLine2D& a, const FixedLine2D& b, Fixed& t_a, Fixed& t_b, FixedVector2& intersection);
+
+	// contact between a circle moving by displacement and a box
+	static FixedContact2D CircleBoxContact(const FixedCircle& circle, const FixedBox2D& box, FixedVector2 displacement = FixedVector2());
+
+	// moves a circle through a set of boxes, bouncing off anything it hits
+	//	see Collision2D::MoveCircle
+	static FixedVector2 MoveCircle(FixedCircle circle, FixedVector2& velocity, Fixed deltaTime, const FixedBox2D* boxes, int count,
+		FixedSweepHit2D* hits, int maxHits, int& numHits);
+};
+
+#endif // _FIXED_COLLISION_H
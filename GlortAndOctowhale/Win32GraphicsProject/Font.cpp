@@ -18,10 +18,24 @@ void FontType::PrintMessage(int posX, int posY, const wchar_t* message, DirectX:
 //----------------------------------------------------------------------------------------------------------------
 void FontType::InitializeFont(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, wstring fileName)
 {
+	// don't leak the last one if this is called again
+	delete pBatch;
+	delete pFont;
+
 	pBatch = new DirectX::SpriteBatch( pContext );
 	pFont = new DirectX::SpriteFont( pDevice, fileName.c_str() );
 }
 
+void FontType::InitializeFont(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, const uint8_t* data, size_t size)
+{
+	delete pBatch;
+	delete pFont;
+
+	// SpriteFont reads the glyphs and texture out of data, it doesn't keep it
+	pBatch = new DirectX::SpriteBatch( pContext );
+	pFont = new DirectX::SpriteFont( pDevice, data, size );
+}
+
 //----------------------------------------------------------------------------------------------------------------
 // Returns the size of the string
 Vector2 FontType::MeasureString(const wchar_t* message)
@@ -34,9 +48,18 @@ Vector2 FontType::MeasureString(const wchar_t* message)
 //----------------------------------------------------------------------------------------------------------------
 FontType::FontType(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, wstring fileName)
 {
+	pBatch = NULL;
+	pFont = NULL;
 	InitializeFont(pDevice, pContext, fileName);
 }
 
+FontType::FontType(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, const uint8_t* data, size_t size)
+{
+	pBatch = NULL;
+	pFont = NULL;
+	InitializeFont(pDevice, pContext, data, size);
+}
+
 //----------------------------------------------------------------------------------------------------------------
 FontType::FontType(void)
 {
@@ -27,9 +27,12 @@ class FontType
 	void PrintMessage(int posX, int posY, wstring message, DirectX::FXMVECTOR color) { PrintMessage(posX, posY, message.c_str(), color); }
 	void PrintMessage(int posX, int posY, const wchar_t* message, DirectX::FXMVECTOR color);
     void InitializeFont(ID3D11Device* pDevice, ID3D11DeviceContext* pDC, wstring fileName);
+    // from a .spritefont file already in memory, like a mapped AssetPack
+    void InitializeFont(ID3D11Device* pDevice, ID3D11DeviceContext* pDC, const uint8_t* data, size_t size);
 
     FontType(void);
     FontType(ID3D11Device* pDevice, ID3D11DeviceContext* pDC, wstring fileName);
+    FontType(ID3D11Device* pDevice, ID3D11DeviceContext* pDC, const uint8_t* data, size_t size);
     ~FontType();
 
 	Vector2 MeasureString(const wchar_t* message);
@@ -0,0 +1,174 @@
+//
+// FrameTable
+//		The frames of an animation sheet, worked out once and shared
+//
+
+#include "FrameTable.h"
+#include "SpriteSheet.h"
+#include "AssetPack.h"
+#include "TextureType.h"
+
+// every table made so far. there are only ever a few sheets, so a list is fine
+static std::vector<FrameTable*> tables;
+
+// -----------------------------------------------------
+// Cut the sheet up
+//
+FrameTable::FrameTable(const TextureType* pTex, int width, int height)
+{
+	pTexture = pTex;
+	textureWidth = pTex->GetWidth();
+	textureHeight = pTex->GetHeight();
+	frameWidth = width;
+	frameHeight = height;
+	framesPerSecond = 0.0f;
+
+	int cols = textureWidth / frameWidth;
+	int rows = textureHeight / frameHeight;
+	frames.resize(cols * rows);
+
+	for (int i = 0; i < (int)frames.size(); i++)
+	{
+		int c = i % cols;
+		int r = i / cols;
+
+		Frame& frame = frames[i];
+		frame.region.left = c * frameWidth;
+		frame.region.right = (c + 1) * frameWidth;
+		frame.region.top = r * frameHeight;
+		frame.region.bottom = (r + 1) * frameHeight;
+
+		// same as Sprite::SetPivot would work out for this region
+		const RECT& rc = frame.region;
+		frame.origin[Sprite::UpperLeft] = Vector2(float(rc.left), float(rc.top));
+		frame.origin[Sprite::UpperRight] = Vector2(float(rc.right), float(rc.top));
+		frame.origin[Sprite::Center] = Vector2(float(rc.right - rc.left) / 2.0f, float(rc.bottom - rc.top) / 2.0f);
+		frame.origin[Sprite::LowerLeft] = Vector2(float(rc.left), float(rc.bottom));
+		frame.origin[Sprite::LowerRight] = Vector2(float(rc.right), float(rc.bottom));
+		frame.duration = 0.0f;
+	}
+}
+
+// -----------------------------------------------------
+// Take the frames from a descriptor
+//
+FrameTable::FrameTable(const TextureType* pTex, const SpriteSheet& sheet, const char* fileName)
+{
+	pTexture = pTex;
+	textureWidth = pTex->GetWidth();
+	textureHeight = pTex->GetHeight();
+	frameWidth = sheet.GetFrame(0).sourceWidth;
+	frameHeight = sheet.GetFrame(0).sourceHeight;
+	sheetFileName = fileName;
+	framesPerSecond = sheet.GetFramesPerSecond();
+
+	frames.resize(sheet.GetFrameCount());
+
+	for (int i = 0; i < (int)frames.size(); i++)
+	{
+		const SheetFrame& f = sheet.GetFrame(i);
+
+		Frame& frame = frames[i];
+		frame.region.left = f.x;
+		frame.region.top = f.y;
+		frame.region.right = f.x + f.width;
+		frame.region.bottom = f.y + f.height;
+
+		// the origins are relative to the trimmed rect, so the corners and pivot of the
+		//	full frame stay put whatever was trimmed off
+		float left = -float(f.trimX);
+		float top = -float(f.trimY);
+		float right = left + f.sourceWidth;
+		float bottom = top + f.sourceHeight;
+		frame.origin[Sprite::UpperLeft] = Vector2(left, top);
+		frame.origin[Sprite::UpperRight] = Vector2(right, top);
+		frame.origin[Sprite::Center] = Vector2(left + f.pivotX, top + f.pivotY);
+		frame.origin[Sprite::LowerLeft] = Vector2(left, bottom);
+		frame.origin[Sprite::LowerRight] = Vector2(right, bottom);
+		frame.duration = f.duration;
+	}
+}
+
+// -----------------------------------------------------
+// Find or make the table for a sheet
+//
+const FrameTable* FrameTable::Get(const TextureType* pTexture, int frameWidth, int frameHeight)
+{
+	if (pTexture == nullptr || frameWidth <= 0 || frameHeight <= 0)
+		return nullptr;
+
+	for (size_t i = 0; i < tables.size(); i++)
+	{
+		const FrameTable* t = tables[i];
+
+		// the size is checked too, in case the texture was reloaded with another image
+		if (t->pTexture == pTexture && t->sheetFileName.empty() && t->frameWidth == frameWidth && t->frameHeight == frameHeight &&
+			t->textureWidth == pTexture->GetWidth() && t->textureHeight == pTexture->GetHeight())
+		{
+			return t;
+		}
+	}
+
+	tables.push_back(new FrameTable(pTexture, frameWidth, frameHeight));
+	return tables.back();
+}
+
+// -----------------------------------------------------
+// Find or load the table for a descriptor
+//
+const FrameTable* FrameTable::Load(const char* sheetFileName, const TextureType* pTexture)
+{
+	if (pTexture == nullptr || sheetFileName == nullptr)
+		return nullptr;
+
+	for (size_t i = 0; i < tables.size(); i++)
+	{
+		const FrameTable* t = tables[i];
+
+		if (t->pTexture == pTexture && t->sheetFileName == sheetFileName &&
+			t->textureWidth == pTexture->GetWidth() && t->textureHeight == pTexture->GetHeight())
+		{
+			return t;
+		}
+	}
+
+	// from the mounted pack if there is one
+	SpriteSheet sheet;
+	AssetData file;
+	if (!AssetPack::ReadFile(sheetFileName, file))
+	{
+		OutputDebugStringA((std::string("can't open ") + sheetFileName + "\n").c_str());
+		return nullptr;
+	}
+	if (!sheet.Parse(file.data, file.size))
+	{
+		OutputDebugStringA((std::string(sheetFileName) + ": " + sheet.GetError() + "\n").c_str());
+		return nullptr;
+	}
+
+	// every frame has to be inside the texture
+	for (int i = 0; i < sheet.GetFrameCount(); i++)
+	{
+		const SheetFrame& f = sheet.GetFrame(i);
+		if (f.x + f.width > pTexture->GetWidth() || f.y + f.height > pTexture->GetHeight())
+		{
+			OutputDebugStringA((std::string(sheetFileName) + ": frame " + std::to_string(i) + " is off the texture\n").c_str());
+			return nullptr;
+		}
+	}
+
+	tables.push_back(new FrameTable(pTexture, sheet, sheetFileName));
+	return tables.back();
+}
+
+// -----------------------------------------------------
+// Delete every table
+//
+void FrameTable::ReleaseAll()
+{
+	for (size_t i = 0; i < tables.size(); i++)
+	{
+		delete tables[i];
+	}
+	tables.clear();
+}
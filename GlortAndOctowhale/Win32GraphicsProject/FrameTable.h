@@ -0,0 +1,71 @@
+//
+// FrameTable
+//		The frames of an animation sheet, worked out once and shared
+//
+//	A sheet is either cut into frameWidth x frameHeight cells, left to right then top
+//	to bottom, or read from a SpriteSheet descriptor, where every frame has its own
+//	rect, trim, pivot and duration. Every sprite animating the same sheet points at the
+//	same table, so moving to another frame is just picking another entry.
+//
+
+#ifndef _FRAME_TABLE_H
+#define _FRAME_TABLE_H
+
+#include <string>
+#include <vector>
+#include "Sprite.h"
+
+class SpriteSheet;
+
+class FrameTable
+{
+public:
+	// one frame of the sheet
+	struct Frame
+	{
+		RECT	region;						// where it is in the texture
+		Vector2	origin[Sprite::LowerRight + 1];	// origin for each Sprite::Pivot
+		float	duration;					// seconds on this frame, 0 to use the playback rate
+	};
+
+	// get the table for a texture cut into frames of this size, making it the first time
+	//	returns null if the frame size is no good. tables live until ReleaseAll
+	static const FrameTable* Get(const TextureType* pTexture, int frameWidth, int frameHeight);
+
+	// get the table for a sheet descriptor (text or cooked), loading it the first time
+	//	returns null if the file can't be read or doesn't fit the texture
+	static const FrameTable* Load(const char* sheetFileName, const TextureType* pTexture);
+
+	// throw away every table. sprites using them must not animate afterwards
+	static void ReleaseAll();
+
+	// number of frames in the sheet
+	int GetFrameCount() const { return (int)frames.size(); }
+
+	// get a frame, frame must be < GetFrameCount()
+	const Frame& GetFrame(int frame) const { return frames[frame]; }
+
+	// size of the cells, or of the first untrimmed frame for a descriptor
+	int GetFrameWidth() const { return frameWidth; }
+	int GetFrameHeight() const { return frameHeight; }
+
+	// playback rate the descriptor asks for, 0 for a cut up sheet
+	float GetFramesPerSecond() const { return framesPerSecond; }
+
+private:
+	FrameTable(const TextureType* pTexture, int frameWidth, int frameHeight);
+	FrameTable(const TextureType* pTexture, const SpriteSheet& sheet, const char* sheetFileName);
+
+	// what the table was made from
+	const TextureType*	pTexture;
+	int					textureWidth;
+	int					textureHeight;
+	int					frameWidth;
+	int					frameHeight;
+	std::string			sheetFileName;		// empty for a cut up sheet
+	float				framesPerSecond;
+
+	std::vector<Frame>	frames;
+};
+
+#endif // _FRAME_TABLE_H
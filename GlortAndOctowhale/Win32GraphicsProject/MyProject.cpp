@@ -17,6 +17,8 @@
 #include <DirectXColors.h>
 #include <sstream>
 #include "Collision2D.h"
+#include "FrameTable.h"
+#include "SoftwareFramebuffer.h"
 
 using namespace DirectX;
 using namespace DirectX::SimpleMath;
@@ -26,11 +28,39 @@ using namespace DirectX::SimpleMath;
 // returns a random float between 0 & 1
 float RandFloat() { return float(rand())/float(RAND_MAX); } 
 
+// Particle bursts
+//	count, speed min/max, angle/spread, life min/max, size min/max, colour (0xAABBGGRR)
+static const ParticleEmitter hitBurst = { 12, 40.0f, 140.0f, 0.0f, 3.141592f, 0.2f, 0.5f, 1.0f, 2.0f, 0xffc8e6ff };
+static const ParticleEmitter debrisBurst = { 40, 60.0f, 220.0f, 0.0f, 3.141592f, 0.4f, 0.9f, 1.0f, 3.0f, 0xff9ed2f0 };
+static const ParticleEmitter speedyBurst = { 80, 120.0f, 320.0f, 0.0f, 3.141592f, 0.5f, 1.2f, 1.0f, 2.0f, 0xff30d0ff };
+static const ParticleEmitter slowBurst = { 80, 40.0f, 160.0f, 0.0f, 3.141592f, 0.8f, 1.6f, 1.5f, 3.5f, 0xffffa040 };
+static const ParticleEmitter lifeBurst = { 80, 80.0f, 240.0f, -1.570796f, 1.2f, 0.6f, 1.4f, 1.0f, 2.5f, 0xff60ff60 };
+
+// a captured frame is always this long, so a capture doesn't depend on how fast it ran
+static const float CAPTURE_STEP = 1.0f / 60.0f;
+
 //----------------------------------------------------------------------------------------------
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pCmdLine, int nShowCmd)
 {
 	MyProject application(hInstance);    // Create the class variable
 
+	// -capture <directory> [-frames <count>] saves every frame drawn on the cpu as well
+	std::istringstream args(pCmdLine ? pCmdLine : "");
+	std::string arg;
+	std::string captureDirectory;
+	int captureFrames = 600;
+	while (args >> arg)
+	{
+		if (arg == "-capture")
+			args >> captureDirectory;
+		else if (arg == "-frames")
+			args >> captureFrames;
+	}
+	if (!captureDirectory.empty() && !application.SetCapture(captureDirectory.c_str(), captureFrames))
+	{
+		return 0;
+	}
+
 	if( application.InitWindowsApp(L"BREAKOUT!", nShowCmd) == false )    // Initialize the window, if all is well show and update it so it displays
 	{
 		return 0;                   // Error creating the window, terminate application
@@ -40,6 +70,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PSTR pCmdLine,
 	{
 		application.SetDepthStencil(true);      // Tell DirectX class to create and maintain a depth stencil buffer
 		application.InitializeTextures();
+		application.InitializeLevel();
 		application.MessageLoop();				// Window has been successfully created, start the application message loop
 	}
 
@@ -76,6 +107,38 @@ MyProject::MyProject(HINSTANCE hInstance)
 	difficultyScaler = 2;
 	livesColor = Color(1, 1, 1);
 	spriteBatch = NULL;
+	commonStates = NULL;
+	pixel30 = nullptr;
+	startTex = rulesTex = loseTex = winTex = nullptr;
+	buttonPlayTex = buttonRulesTex = buttonExitTex = buttonMenuTex = nullptr;
+	backgroundTex = ballTex = paddleTex = particleTex = nullptr;
+	blockTex = blockDamageTex = blockSpeedyTex = blockSlowTex = blockLifeTex = nullptr;
+	blockDamagedClip = nullptr;
+	captureFrame = false;
+	pCapture = NULL;
+	pCaptureLog = NULL;
+	captureFrames = 0;
+	capturedCount = 0;
+	firstFrameTime = -1.0;
+	loadReported = false;
+
+	// menu trees, the buttons are set up with their textures in InitializeTextures
+	startButtons[0].SetId(BUTTON_PLAY);
+	startButtons[1].SetId(BUTTON_EXIT);
+	startButtons[2].SetId(BUTTON_RULES);
+	rulesButtons[0].SetId(BUTTON_PLAY);
+	rulesButtons[1].SetId(BUTTON_EXIT);
+	menuButton.SetId(BUTTON_MENU);
+
+	for (int i = 0; i < 3; i++)
+		startScreen.AddChild(&startButtons[i]);
+	for (int i = 0; i < 2; i++)
+		rulesScreen.AddChild(&rulesButtons[i]);
+	overScreen.AddChild(&menuButton);
+
+	startScreen.SetListener(this);
+	rulesScreen.SetListener(this);
+	overScreen.SetListener(this);
 
 	ClearColor = Color(DirectX::Colors::DarkGray.v);
 }
@@ -86,19 +149,204 @@ MyProject::MyProject(HINSTANCE hInstance)
 MyProject::~MyProject()
 {
 	delete spriteBatch;
+	delete commonStates;
+	delete pCapture;
+	if (pCaptureLog)
+		fclose(pCaptureLog);
+
+	// hand back everything InitializeTextures got
+	for (TextureType* pTexture : GetTextures())
+	{
+		resources.ReleaseTexture(pTexture);
+	}
+	resources.ReleaseFont(pixel30);
+
+	// the sprites are done animating
+	FrameTable::ReleaseAll();
+}
+
+std::vector<TextureType*> MyProject::GetTextures() const
+{
+	TextureType* textures[] = { startTex, rulesTex, loseTex, winTex, buttonPlayTex, buttonRulesTex, buttonExitTex, buttonMenuTex,
+		backgroundTex, ballTex, paddleTex, blockTex, blockDamageTex, blockSpeedyTex, blockSlowTex, blockLifeTex, particleTex };
+	return std::vector<TextureType*>(textures, textures + sizeof(textures) / sizeof(textures[0]));
+}
+
+//----------------------------------------------------------------------------------------------
+// Draw every frame into a SoftwareFramebuffer as well, and save them
+//----------------------------------------------------------------------------------------------
+bool MyProject::SetCapture(const char* directory, int frames)
+{
+	CreateDirectoryA(directory, NULL); // fails if it's already there, which is fine
+
+	captureDirectory = directory;
+	pCaptureLog = fopen((captureDirectory + "\\checksums.txt").c_str(), "w");
+	if (pCaptureLog == NULL)
+	{
+		OutputDebugStringA(("MyProject: can't write a capture to " + captureDirectory + "\n").c_str());
+		return false;
+	}
+
+	captureFrames = frames;
+	capturedCount = 0;
+	pCapture = new SoftwareFramebuffer;
+
+	// the framebuffer draws from the decoded PNGs, so they have to be kept
+	TextureType::SetKeepPixels(true);
+
+	// straight into play, the menus would wait for a click
+	currentState = gameStates::PLAYING;
+	return true;
+}
+
+void MyProject::BeginCaptureFrame()
+{
+	// on the first frame, once every texture has been asked for
+	if (pCapture->GetWidth() == 0)
+	{
+		pCapture->Resize(clientWidth, clientHeight);
+
+		// a region's view and pixels are its page's, so the page goes in more than once
+		for (TextureType* pTexture : GetTextures())
+		{
+			if (pTexture && pTexture->GetPixels())
+				pCapture->SetTexture(pTexture->GetResourceView(), pTexture->GetPixels());
+		}
+	}
+
+	pCapture->Clear(DrawCommand::PackColor(ClearColor.x, ClearColor.y, ClearColor.z, ClearColor.w));
+}
+
+void MyProject::EndCaptureFrame()
+{
+	char fileName[32];
+	snprintf(fileName, sizeof(fileName), "frame_%05d.png", capturedCount);
+
+	fprintf(pCaptureLog, "%s %016llx\n", fileName, (unsigned long long)pCapture->GetChecksum());
+	if (!pCapture->SaveCapture((captureDirectory + "\\" + fileName).c_str()))
+	{
+		OutputDebugStringA(("MyProject: can't save " + captureDirectory + "\\" + fileName + "\n").c_str());
+	}
+
+	if (++capturedCount == captureFrames)
+	{
+		fclose(pCaptureLog);
+		pCaptureLog = NULL;
+		PostQuitMessage(0);
+	}
 }
 
 //----------------------------------------------------------------------------------------------
-// Initialize any fonts we need to use here
+// Load everything we need, only called once
 //----------------------------------------------------------------------------------------------
 void MyProject::InitializeTextures()
 {
+	// with a pack (Tools\AssetPacker) everything is mapped from that one file instead of
+	//	opening each. it's looked for in the directory above the exe, where Font and Textures
+	//	are, so it doesn't matter where the game was started from. without one the loose
+	//	files are loaded as before
+	std::wstring packPath = L"assets.pack";
+	wchar_t exePath[MAX_PATH];
+	DWORD length = GetModuleFileNameW(NULL, exePath, MAX_PATH);
+	if (length > 0 && length < MAX_PATH)
+	{
+		packPath = std::wstring(exePath, length);
+		packPath = packPath.substr(0, packPath.find_last_of(L"\\/") + 1) + L"..\\assets.pack";
+	}
+	if (pack.Open(packPath.c_str()))
+		AssetPack::Mount(&pack);
+	else
+		OutputDebugStringW((L"MyProject: no asset pack at " + packPath + L", loading loose files\n").c_str());
+
+	// PNGs decoded on an earlier run are read back as pixels, from the temp directory so
+	//	it's always writable. a PNG that's been edited misses and is decoded again
+	wchar_t tempPath[MAX_PATH];
+	length = GetTempPathW(MAX_PATH, tempPath);
+	if (length == 0 || length >= MAX_PATH || !DecodeCache::SetDirectory((std::wstring(tempPath, length) + L"GlortAndOctowhale").c_str()))
+		OutputDebugStringW(L"MyProject: no decode cache, every PNG will be decoded\n");
+
+	// the PNGs are read and decoded on the loader's threads while the rest of this runs,
+	//	and each becomes a texture when it's first drawn. they come out premultiplied, so the
+	//	sprites draw with the cheaper premultiplied blend
+	loader.SetPremultiply(true);
+	resources.Initialize(D3DDevice, DeviceContext, &loader);
+
 	// initialize the sprite batch
 	spriteBatch = new DirectX::SpriteBatch( DeviceContext );
 
 	commonStates = new CommonStates(D3DDevice);
+	spriteBackend.Initialize(spriteBatch, commonStates);
+
+	// the buttons and everything drawn in play are packed into one page (Tools\AtlasPacker), so
+	//	a gameplay frame is one texture and one SpriteBatch draw. the full screen pictures
+	//	aren't in it, they're copied straight to the back buffer
+	resources.LoadAtlas(L"..\\Textures\\gameplay.atlas");
 
-	srand((int)time(0));
+	// Loading textures
+	// Menus/Buttons
+	startTex = resources.AcquireTexture(L"..\\Textures\\start.png");
+	rulesTex = resources.AcquireTexture(L"..\\Textures\\rules.png");
+	loseTex = resources.AcquireTexture(L"..\\Textures\\lose.png");
+	winTex = resources.AcquireTexture(L"..\\Textures\\win.png");
+	buttonPlayTex = resources.AcquireTexture(L"..\\Textures\\buttonPlay.png");
+	buttonRulesTex = resources.AcquireTexture(L"..\\Textures\\buttonRules.png");
+	buttonExitTex = resources.AcquireTexture(L"..\\Textures\\buttonExit.png");
+	buttonMenuTex = resources.AcquireTexture(L"..\\Textures\\buttonMenu.png");
+
+	// Gameplay Textures
+	backgroundTex = resources.AcquireTexture(L"..\\Textures\\background.png");
+	ballTex = resources.AcquireTexture(L"..\\Textures\\glortSpritesheet.png");
+	paddleTex = resources.AcquireTexture(L"..\\Textures\\octowhaleSpritesheet.png");
+	// Various block textures (default, damaged, powers)
+	blockTex = resources.AcquireTexture(L"..\\Textures\\morloxSpritesheet.png");
+	blockDamageTex = resources.AcquireTexture(L"..\\Textures\\morloxDamagedSpritesheet.png");
+	blockSpeedyTex = resources.AcquireTexture(L"..\\Textures\\morloxPowerSpritesheet01.png");
+	blockSlowTex = resources.AcquireTexture(L"..\\Textures\\morloxPowerSpritesheet02.png");
+	blockLifeTex = resources.AcquireTexture(L"..\\Textures\\morloxPowerSpritesheet03.png");
+
+	// particles are tinted, so they use a plain white texture
+	particleTex = resources.AcquireTexture(L"..\\Textures\\particle.png");
+	particles.Initialize(MAX_PARTICLES);
+	particles.SetTexture(particleTex->GetResourceView(), particleTex->GetWidth(), particleTex->GetHeight(),
+		particleTex->GetOffsetX(), particleTex->GetOffsetY());
+	particles.SetGravity(Vector2(0, 300));
+	particles.SetDrag(1.0f);
+
+	// Block animations. a block plays one of these, and switches to the damaged one when hit
+	//	the frames and clips come from the sheets, cooked from Textures\*.sheet with Tools\SheetCook
+	clips.AddSheet("..\\Textures\\morloxSpritesheet.sheetb", blockTex);
+	clips.AddSheet("..\\Textures\\morloxPowerSpritesheet01.sheetb", blockSpeedyTex);
+	clips.AddSheet("..\\Textures\\morloxPowerSpritesheet02.sheetb", blockSlowTex);
+	clips.AddSheet("..\\Textures\\morloxPowerSpritesheet03.sheetb", blockLifeTex);
+	clips.AddSheet("..\\Textures\\morloxDamagedSpritesheet.sheetb", blockDamageTex);
+	blockDamagedClip = clips.Find("morloxDamaged");
+
+	// Menu buttons, they light up when the mouse is over them
+	Vector2 playPos = Vector2(buttonPlayTex->GetWidth() * 0.5f, clientHeight * 0.8f);
+	Vector2 rulesPos = Vector2(buttonRulesTex->GetWidth() * 0.5f, clientHeight * 0.933f);
+	startButtons[0].Initialize(buttonPlayTex, playPos, Colors::White.v, Colors::Green.v);
+	startButtons[1].Initialize(buttonExitTex, Vector2(clientWidth - buttonExitTex->GetWidth() * 0.5f, 50), Colors::White.v, Colors::Green.v);
+	startButtons[2].Initialize(buttonRulesTex, rulesPos, Colors::White.v, Colors::Green.v);
+
+	// on the rules screen exit takes the place of the rules button
+	rulesButtons[0].Initialize(buttonPlayTex, playPos, Colors::White.v, Colors::Green.v);
+	rulesButtons[1].Initialize(buttonExitTex, rulesPos, Colors::White.v, Colors::Green.v);
+
+	menuButton.Initialize(buttonMenuTex, Vector2(buttonMenuTex->GetWidth() * 0.5f, clientHeight * 0.933f), Colors::DarkBlue.v, Colors::White.v);
+
+	// initialize font
+	pixel30 = resources.AcquireFont(L"..\\Font\\pixel30.spritefont");
+
+	// the stats go out with the loader's report, once everything's in (see Render)
+}
+
+//----------------------------------------------------------------------------------------------
+// Set up a new round, everything it uses is already loaded
+//----------------------------------------------------------------------------------------------
+void MyProject::InitializeLevel()
+{
+	// a capture has to lay out the same level every run
+	srand(pCapture ? 1 : (int)time(0));
 
 	// Extremely ugly while loop to assign a powerup to 7 random blocks. They cannot be the same.
 	while (powerSpot1 == powerSpot2 || powerSpot1 == powerSpot3 || powerSpot1 == powerSpot4 || powerSpot1 == powerSpot5 || powerSpot1 == powerSpot6 || powerSpot1 == powerSpot7 ||
@@ -117,99 +365,78 @@ void MyProject::InitializeTextures()
 		powerSpot7 = rand() % NUM_BLOCKS;
 	}
 
-	// Loading textures
-	// Menus/Buttons
-	startTex.Load(D3DDevice, L"..\\Textures\\start.png");
-	rulesTex.Load(D3DDevice, L"..\\Textures\\rules.png");
-	loseTex.Load(D3DDevice, L"..\\Textures\\lose.png");
-	winTex.Load(D3DDevice, L"..\\Textures\\win.png");
-	buttonPlayTex.Load(D3DDevice, L"..\\Textures\\buttonPlay.png");
-	buttonRulesTex.Load(D3DDevice, L"..\\Textures\\buttonRules.png");
-	buttonExitTex.Load(D3DDevice, L"..\\Textures\\buttonExit.png");
-	buttonMenuTex.Load(D3DDevice, L"..\\Textures\\buttonMenu.png");
-
-	// Gameplay Textures
-	backgroundTex.Load(D3DDevice, L"..\\Textures\\background.png");
-	ballTex.Load(D3DDevice, L"..\\Textures\\glortSpritesheet.png");
-	paddleTex.Load(D3DDevice, L"..\\Textures\\octowhaleSpritesheet.png");
-	// Various block textures (default, damaged, powers)
-	blockTex.Load(D3DDevice, L"..\\Textures\\morloxSpritesheet.png");
-	blockDamageTex.Load(D3DDevice, L"..\\Textures\\morloxDamagedSpritesheet.png");
-	blockSpeedyTex.Load(D3DDevice, L"..\\Textures\\morloxPowerSpritesheet01.png");
-	blockSlowTex.Load(D3DDevice, L"..\\Textures\\morloxPowerSpritesheet02.png");
-	blockLifeTex.Load(D3DDevice, L"..\\Textures\\morloxPowerSpritesheet03.png");
+	// nothing left flying from the last round
+	particles.Clear();
 
 	// Initializing sprites
-	ballSprite.Initialize(&ballTex, Vector2(clientWidth * 0.5, clientHeight * 0.65), 0, 1.3f, Color(1, 1, 1), 0);
+	ballSprite.Initialize(ballTex, Vector2(clientWidth * 0.5, clientHeight * 0.65), 0, 1.3f, Color(1, 1, 1), 0);
 	ballSprite.SetVelocity(Vector2(ballSpeed, -ballSpeed), ballSpeed);
-	ballSprite.SetTextureAnimation(36, 35, 8);
+	ballSprite.LoadSheet("..\\Textures\\glortSpritesheet.sheetb");
 
-	paddleSprite.Initialize(&paddleTex, Vector2(clientWidth * 0.5, clientHeight * 0.85), 0, 1.0f, Color(1, 1, 1), 0);
+	paddleSprite.Initialize(paddleTex, Vector2(clientWidth * 0.5, clientHeight * 0.85), 0, 1.0f, Color(1, 1, 1), 0);
 	paddleSprite.SetVelocity(Vector2(0, 0), 0);
-	paddleSprite.SetTextureAnimation(379, 63, 8);
-
-	// For loop to initialize button sprites
-	for (int i = 0; i < 4; i++)
-	{
-		switch(i)
-		{
-			case 0:
-				menuButtons[i].Initialize(&buttonPlayTex, Vector2(buttonPlayTex.GetWidth() * 0.5, clientHeight * 0.8), 0, 1.0f, Color(1, 1, 1), 0);
-				break;
-			case 1:
-				menuButtons[i].Initialize(&buttonExitTex, Vector2(clientWidth - buttonExitTex.GetWidth() * 0.5, 50), 0, 1.0f, Color(1, 1, 1), 0);
-				break;
-			case 2:
-				menuButtons[i].Initialize(&buttonRulesTex, Vector2(buttonRulesTex.GetWidth() * 0.5, clientHeight * 0.933), 0, 1.0f, Color(1, 1, 1), 0);
-				break;
-			case 3:
-				menuButtons[i].Initialize(&buttonMenuTex, Vector2(buttonMenuTex.GetWidth() * 0.5, clientHeight * 0.933), 0, 1.0f, Colors::DarkBlue.v, 0);
-		}
-	}
+	paddleSprite.LoadSheet("..\\Textures\\octowhaleSpritesheet.sheetb");
 
 	// For loop to initialize block sprites
+	//	they leave the sprite system while they are set up, and go back in once laid out
+	blockSystem.Clear();
+	blocks.Clear();
 	Vector2 pos = Vector2(180, 50); // starting position
-	for (int i = 0; i < NUM_BLOCKS; i++)
+	for (int n = 0; n < NUM_BLOCKS; n++)
 	{
-		blockDamageSprites[i].Initialize(&blockDamageTex, Vector2(-100, 0), 0, 1.0f, Color(1, 1, 1), 0); // another array of damaged block sprites
+		EntityId id = blocks.Create();
+		int i = blocks.SlotOf(id); // the power spots are slots
+		Block& block = *blocks.Get(id);
 
 		// if statements check if the block is powered
 		if (i == powerSpot1 || i == powerSpot4 || i == powerSpot6) // speed power blocks
 		{
-			blockSprites[i].Initialize(&blockSpeedyTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
-			blockDamage[i] = 3;
+			block.sprite.Initialize(blockSpeedyTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
+			block.sprite.PlayClip(clips.Find("morloxSpeedy"));
+			block.damage = 3;
 		}
 		else if (i == powerSpot2 || i == powerSpot5 || i == powerSpot7) // slow power blocks
 		{
-			blockSprites[i].Initialize(&blockSlowTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
-			blockDamage[i] = 3;
+			block.sprite.Initialize(blockSlowTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
+			block.sprite.PlayClip(clips.Find("morloxSlow"));
+			block.damage = 3;
 		}
 		else if (i == powerSpot3) // life power block
 		{
-			blockSprites[i].Initialize(&blockLifeTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
-			blockDamage[i] = 3;
+			block.sprite.Initialize(blockLifeTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
+			block.sprite.PlayClip(clips.Find("morloxLife"));
+			block.damage = 3;
 		}
 		else // otherwise blocktexture is set to default
 		{
-			blockSprites[i].Initialize(&blockTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
-			blockDamage[i] = 2;
+			block.sprite.Initialize(blockTex, pos, 0, 1.0f, Color(1, 1, 1), 0);
+			block.sprite.PlayClip(clips.Find("morlox"));
+			block.damage = 2;
 		}
-		blockSprites[i].SetTextureAnimation(85, 74, 8);
-		blockDamageSprites[i].SetTextureAnimation(85, 74, 8);
 
-		if (i == 7 || i == 15 || i == 23 || i == 31 || i == 39 || i == 47) // for blocks 8, 16, 24, 32, 40, and 48
+		if (n == 7 || n == 15 || n == 23 || n == 31 || n == 39 || n == 47) // for blocks 8, 16, 24, 32, 40, and 48
 		{
 			pos.x = 180; // place on starting x-point
-			pos.y += blockSprites[i].GetHeight(); // move down on y-axis
+			pos.y += block.sprite.GetHeight(); // move down on y-axis
 		}
 		else
 		{
-			pos.x += blockSprites[i].GetWidth() + 10; // spread them out along the x-axis
+			pos.x += block.sprite.GetWidth() + 10; // spread them out along the x-axis
 		}
 	}
+	for (int n = 0; n < blocks.GetCount(); n++)
+	{
+		blockSystem.Attach(&blocks[n].sprite);
+	}
 
-	// initialize font
-	pixel30.InitializeFont(D3DDevice, DeviceContext, L"..\\Font\\pixel30.spritefont");
+	// index the blocks for collision now that they are laid out. blocks don't move, so this only changes when one is destroyed
+	Box2D blockBoxes[NUM_BLOCKS];
+	for (int n = 0; n < blocks.GetCount(); n++)
+	{
+		const Sprite& sprite = blocks[n].sprite;
+		blockBoxes[blocks.SlotOf(blocks.GetId(n))] = Box2D(sprite.GetPosition(), sprite.GetExtents());
+	}
+	blockGrid.Build(blockBoxes, NUM_BLOCKS);
 }
 
 //----------------------------------------------------------------------------------------------
@@ -224,17 +451,22 @@ LRESULT MyProject::ProcessWindowMessages(UINT msg, WPARAM wParam, LPARAM lParam)
 	case WM_MOUSEMOVE:
 		mousePos.x = (float) GET_X_LPARAM(lParam);
 		mousePos.y = (float) GET_Y_LPARAM(lParam);
+		if (ActiveScreen())
+			ActiveScreen()->OnMouseMove(mousePos);
 		return 0;
 	case WM_LBUTTONUP:
 		buttonDown = false;
 		mousePos.x = (float) GET_X_LPARAM(lParam);
 		mousePos.y = (float) GET_Y_LPARAM(lParam);
+		if (ActiveScreen())
+			ActiveScreen()->OnMouseUp(mousePos);
 		break;
 	case WM_LBUTTONDOWN:
 		buttonDown = true;
 		mousePos.x = (float) GET_X_LPARAM(lParam);
 		mousePos.y = (float) GET_Y_LPARAM(lParam);
-		OnMouseDown();
+		if (ActiveScreen())
+			ActiveScreen()->OnMouseDown(mousePos);
 		break;
 	case WM_KEYUP:
 		keyDown = false;
@@ -243,6 +475,10 @@ LRESULT MyProject::ProcessWindowMessages(UINT msg, WPARAM wParam, LPARAM lParam)
 		{
 			PresentInterval = wParam - '0';
 		}
+		else if (wParam == VK_F12)
+		{
+			captureFrame = true; // dump the next frame's draws
+		}
 		break;
 	case WM_KEYDOWN:
 		keyDown = true;
@@ -270,64 +506,55 @@ LRESULT MyProject::ProcessWindowMessages(UINT msg, WPARAM wParam, LPARAM lParam)
 //----------------------------------------------------------------------------------------------
 void MyProject::Render(void)
 {
+	if (IsCapturing())
+	{
+		BeginCaptureFrame();
+	}
+
 	if (currentState == gameStates::START) // render the menu
 	{
-		startTex.Draw(DeviceContext, BackBuffer, 0, 0);
+		DrawBackground(startTex);
 
-		spriteBatch->Begin(SpriteSortMode_BackToFront, commonStates->NonPremultiplied());
+		startScreen.Draw(&renderQueue); // play, rules and exit buttons
 
-		for (int i = 0; i < 3; i++) // for loop to draw each button (play, rules, exit)
-		{
-			menuButtons[i].Draw(spriteBatch);
-		}
-
-		spriteBatch->End();
+		DrawQueue();
 	}
 	else if (currentState == gameStates::RULES) // render the rules screen
 	{
-		rulesTex.Draw(DeviceContext, BackBuffer, 0, 0);
-
-		menuButtons[1].SetPosition(menuButtons[2].GetPosition()); // set position of exit button to rules button position
-
-		spriteBatch->Begin(SpriteSortMode_BackToFront, commonStates->NonPremultiplied());
-
-		for (int i = 0; i < 2; i++)
-		{
-
-			menuButtons[i].Draw(spriteBatch); // draw play and exit buttons
+		DrawBackground(rulesTex);
 
-		}
+		rulesScreen.Draw(&renderQueue); // play and exit buttons
 
-		spriteBatch->End();
+		DrawQueue();
 	}
 	else if (currentState == gameStates::PLAYING) // render game
 	{
-		backgroundTex.Draw(DeviceContext, BackBuffer, 0, 0);
-
-		spriteBatch->Begin(SpriteSortMode_BackToFront, commonStates->NonPremultiplied());
+		DrawBackground(backgroundTex);
 
 		// draw sprites
-		ballSprite.Draw(spriteBatch);
-		paddleSprite.Draw(spriteBatch);
+		ballSprite.Draw(&renderQueue);
+		paddleSprite.Draw(&renderQueue);
 
-		// for loop to draw each block (+ damaged blocks)
-		for (int i = 0; i < NUM_BLOCKS; i++)
+		// for loop to draw each block still in play
+		for (int n = 0; n < blocks.GetCount(); n++)
 		{
-			blockSprites[i].Draw(spriteBatch);
-			blockDamageSprites[i].Draw(spriteBatch);
+			blocks[n].sprite.Draw(&renderQueue);
 		}
 
-		spriteBatch->End();
+		// particles go in after the sprites so their texture comes last
+		particles.Draw(&renderQueue, 0.0f, particleTex->IsPremultiplied() ? BlendAlpha : BlendNonPremultiplied);
+
+		DrawQueue();
 
 		// Display score
 		std::wostringstream scoreTxt;
 		scoreTxt << L"Score: " << score;
-		pixel30.PrintMessage(0, clientHeight - 45, scoreTxt.str(), Color(1, 1, 1));
+		pixel30->PrintMessage(0, clientHeight - 45, scoreTxt.str(), Color(1, 1, 1));
 
 		// Display lives
 		std::wostringstream livesTxt;
 		livesTxt << L"Lives: " << lives;
-		pixel30.PrintMessage(clientWidth - 250, clientHeight - 45, livesTxt.str(), livesColor);
+		pixel30->PrintMessage(clientWidth - 250, clientHeight - 45, livesTxt.str(), livesColor);
 
 		// render the base class
 		DirectXClass::Render();
@@ -336,23 +563,72 @@ void MyProject::Render(void)
 	{
 		if (lives == 0) // lose
 		{
-			loseTex.Draw(DeviceContext, BackBuffer, 0, 0);
+			DrawBackground(loseTex);
 		}
 		else if (blocksRemaining == 0) // win
 		{
-			winTex.Draw(DeviceContext, BackBuffer, 0, 0);
+			DrawBackground(winTex);
 		}
 
-		spriteBatch->Begin(SpriteSortMode_BackToFront, commonStates->NonPremultiplied());
-
-		menuButtons[3].Draw(spriteBatch); // draw menu button
+		overScreen.Draw(&renderQueue); // menu button
 
-		spriteBatch->End();
+		DrawQueue();
 
 		// Display score
 		std::wostringstream scoreTxt;
 		scoreTxt << L"Final Score: " << score;
-		pixel30.PrintMessage(0, clientHeight * 0.75, scoreTxt.str(), Color(1, 1, 1));
+		pixel30->PrintMessage(0, clientHeight * 0.75, scoreTxt.str(), Color(1, 1, 1));
+	}
+
+	if (IsCapturing())
+	{
+		EndCaptureFrame();
+	}
+
+	// once the first frame is out and the loader's finished, say how startup went
+	if (!loadReported)
+	{
+		if (firstFrameTime < 0)
+			firstFrameTime = loader.GetMilliseconds();
+
+		if (loader.IsIdle())
+		{
+			loader.LogReport(firstFrameTime);
+			resources.LogStats();
+			loadReported = true;
+		}
+	}
+}
+
+//----------------------------------------------------------------------------------------------
+// Sorts and draws the queued sprites
+//----------------------------------------------------------------------------------------------
+void MyProject::DrawQueue()
+{
+	renderQueue.Sort();
+
+	if (captureFrame)
+	{
+		renderQueue.WriteCapture("frame_capture.txt");
+		captureFrame = false;
+	}
+
+	spriteBackend.Execute(renderQueue);
+	if (IsCapturing())
+	{
+		pCapture->Execute(renderQueue);
+	}
+	renderQueue.Clear();
+}
+
+void MyProject::DrawBackground(TextureType* pTexture)
+{
+	pTexture->Draw(DeviceContext, BackBuffer, 0, 0);
+
+	const ImageRGBA* pPixels = IsCapturing() ? pTexture->GetPixels() : NULL;
+	if (pPixels)
+	{
+		pCapture->Blit(*pPixels, 0, 0, pTexture->GetOffsetX(), pTexture->GetOffsetY(), pTexture->GetWidth(), pTexture->GetHeight());
 	}
 }
 
@@ -362,46 +638,15 @@ void MyProject::Render(void)
 //----------------------------------------------------------------------------------------------
 void MyProject::Update(float deltaTime)
 {
-	// Menu
-	if (currentState == gameStates::START)
+	if (pCapture)
 	{
-		// for loop, checks to see if mouse is hovering over buttons
-		for (int i = 0; i < 3; i++)
-		{
-			if (menuButtons[i].ContainsPoint(mousePos))
-			{
-				Color setColor = Colors::Green; // if yes, highlight button
-				menuButtons[i].SetColor(setColor);
-			}
-			else
-			{
-				Color setColor = Colors::White; // otherwise don't highlight
-				menuButtons[i].SetColor(setColor);
-			}
-		}
+		deltaTime = CAPTURE_STEP;
 	}
 
-	// Rules screen
-	else if (currentState == gameStates::RULES)
-	{
-		// once again checks if button is being hovered over
-		for (int i = 0; i < 3; i++)
-		{
-			if (menuButtons[i].ContainsPoint(mousePos))
-			{
-				Color setColor = Colors::Green;
-				menuButtons[i].SetColor(setColor);
-			}
-			else
-			{
-				Color setColor = Colors::White;
-				menuButtons[i].SetColor(setColor);
-			}
-		}
-	}
+	// the menu screens only change on mouse messages, so there's nothing to do for them here
 
 	// Playing
-	else if (currentState == gameStates::PLAYING)
+	if (currentState == gameStates::PLAYING)
 	{
 		if (powerTime > 0) // if a power is active
 		{
@@ -427,6 +672,9 @@ void MyProject::Update(float deltaTime)
 			}
 		}
 
+		// remember where the ball started, collisions are traced from here
+		ballStartPos = ballSprite.GetPosition();
+
 		// Ball movement
 		MoveBall(deltaTime);
 
@@ -437,76 +685,65 @@ void MyProject::Update(float deltaTime)
 		}
 
 		// Update Animations
-		for (int i = 0; i < NUM_BLOCKS; i++)
-		{
-			blockSprites[i].UpdateAnimation(deltaTime);
-			blockDamageSprites[i].UpdateAnimation(deltaTime);
-		}
+		blockSystem.Update(deltaTime);
 		ballSprite.UpdateAnimation(deltaTime);
 		paddleSprite.UpdateAnimation(deltaTime);
+		particles.Update(deltaTime);
 
 		// Collisions
 		CollisionCheck(deltaTime);
 	}
+}
 
-	// Game Over
-	else if (currentState == gameStates::OVER)
+//----------------------------------------------------------------------------------------------
+// Called when a menu button is clicked
+//----------------------------------------------------------------------------------------------
+void MyProject::OnWidgetClicked(Widget* pWidget)
+{
+	switch (pWidget->GetId())
 	{
-		// Highlights button if hovered over
-		if (menuButtons[3].ContainsPoint(mousePos))
-		{
-			Color setColor = Colors::White;
-			menuButtons[3].SetColor(setColor);
-		}
-		else
-		{
-			Color setColor = Colors::DarkBlue;
-			menuButtons[3].SetColor(setColor);
-		}
+	case BUTTON_PLAY:
+		SetState(gameStates::PLAYING);
+		break;
+	case BUTTON_EXIT:
+		exit(0);
+		break;
+	case BUTTON_RULES:
+		SetState(gameStates::RULES);
+		break;
+	case BUTTON_MENU:
+		Reset();
+		break;
 	}
 }
 
 //----------------------------------------------------------------------------------------------
-// Called when the mouse is released
+// Changes the game state
 //----------------------------------------------------------------------------------------------
-void MyProject::OnMouseDown()
+void MyProject::SetState(gameStates state)
 {
-	// this is called when the left mouse button is clicked
-	// mouse position is stored in mousePos variable
-	
-	// Menu or Rules
-	if (currentState == gameStates::START || currentState == gameStates::RULES)
-	{
-		for (int i = 0; i < 3; i++) // for loop, checks if buttons are clicked
-		{
-			if (menuButtons[i].ContainsPoint(mousePos))
-			{
-				switch (i)
-				{
-				case 0:
-					currentState = gameStates::PLAYING; // if play selected
-					break;
-				case 1:
-					exit(0); // if exit selected
-					break;
-				case 2:
-					if (currentState == gameStates::START)
-					{
-						currentState = gameStates::RULES; // if rules selected
-					}
-					break;
-				}
-			}
-		}
-	}
+	currentState = state;
 
-	// Game Over
-	else if (currentState == gameStates::OVER)
+	// the mouse might already be over a button on the new screen
+	if (ActiveScreen())
+		ActiveScreen()->Refresh(mousePos);
+}
+
+//----------------------------------------------------------------------------------------------
+// The widget tree for the current state
+//----------------------------------------------------------------------------------------------
+WidgetRoot* MyProject::ActiveScreen()
+{
+	switch (currentState)
 	{
-		if (menuButtons[3].ContainsPoint(mousePos))
-		{
-			Reset(); // If menu selected
-		}
+	case gameStates::START:
+		return &startScreen;
+	case gameStates::RULES:
+		return &rulesScreen;
+	case gameStates::OVER:
+		return &overScreen;
+	default:
+		return nullptr;
 	}
 }
 
@@ -515,49 +752,42 @@ void MyProject::OnMouseDown()
 //----------------------------------------------------------------------------------------------
 void MyProject::MoveBall(float deltaTime)
 {
-	// Update ball position and rotation
+	// Update ball position and rotation based on its velocities
+	ballSprite.Integrate(deltaTime);
+
 	Vector2 pos = ballSprite.GetPosition();
 	Vector2 velocity = ballSprite.GetVelocity(); // if collision, then velocity will update too
-	float rotation = ballSprite.GetRotation();
 	float rotationVelocity = ballSprite.GetRotationalVelocity();
 
-	// add to position based on current velocity
-	pos += velocity * deltaTime;
-	ballSprite.SetPosition(pos);
-
-	// add to rotation based on rotational velocity of ball
-	rotation += rotationVelocity * deltaTime;
-	ballSprite.SetRotation(rotation);
-
 	// Bounce off left
-	if (pos.x < ballTex.GetWidth() * 0.5)
+	if (pos.x < ballTex->GetWidth() * 0.5)
 	{
-		pos.x = ballTex.GetWidth() * 0.5;
+		pos.x = ballTex->GetWidth() * 0.5;
 		ballSprite.SetPosition(pos);
 		velocity.x = -velocity.x;
 		rotationVelocity = -rotationVelocity;
 	}
 
 	// Bounce off right
-	else if (pos.x > clientWidth - ballTex.GetWidth() * 0.5)
+	else if (pos.x > clientWidth - ballTex->GetWidth() * 0.5)
 	{
-		pos.x = clientWidth - ballTex.GetWidth() * 0.5;
+		pos.x = clientWidth - ballTex->GetWidth() * 0.5;
 		ballSprite.SetPosition(pos);
 		velocity.x = -velocity.x;
 		rotationVelocity = -rotationVelocity;
 	}
 
 	// Bounce off top
-	else if (pos.y < ballTex.GetHeight() * 0.5)
+	else if (pos.y < ballTex->GetHeight() * 0.5)
 	{
-		pos.y = ballTex.GetHeight() * 0.5;
+		pos.y = ballTex->GetHeight() * 0.5;
 		ballSprite.SetPosition(pos);
 		velocity.y = -velocity.y;
 		rotationVelocity = -rotationVelocity;
 	}
 
 	// Bounce off bottom
-	else if (pos.y > clientHeight - ballTex.GetHeight() * 0.5)
+	else if (pos.y > clientHeight - ballTex->GetHeight() * 0.5)
 	{
 		lives--; // lose a life for hitting bottom of screen
 		scoreMultiplier = 1; // score multiplier reset
@@ -573,10 +803,10 @@ void MyProject::MoveBall(float deltaTime)
 		}
 		else if (lives == 0)
 		{
-			currentState = gameStates::OVER; // out of lives, game over!
+			SetState(gameStates::OVER); // out of lives, game over!
 		}
 
-		pos.y = clientHeight - ballTex.GetHeight() * 0.5;
+		pos.y = clientHeight - ballTex->GetHeight() * 0.5;
 		ballSprite.SetPosition(pos);
 		velocity.y = -velocity.y;
 		rotationVelocity = -rotationVelocity;
@@ -591,8 +821,8 @@ void MyProject::MoveBall(float deltaTime)
 //----------------------------------------------------------------------------------------------
 void MyProject::MovePaddle(float deltaTime)
 {
+	paddleSprite.Integrate(deltaTime); // update position based on velocity of paddle
 	Vector2 paddlePos = paddleSprite.GetPosition();
-	paddlePos += paddleSprite.GetVelocity() * deltaTime; // update position based on velocity of paddle
 
 	// Preventing paddle from going off screen on left or right side
 	if (paddlePos.x < paddleSprite.GetWidth() * 0.5) // left
@@ -609,185 +839,264 @@ void MyProject::MovePaddle(float deltaTime)
 }
 
 
+//----------------------------------------------------------------------------------------------
+// Reflects a velocity off a surface, if it is moving into it
+//----------------------------------------------------------------------------------------------
+static Vector2 BounceVelocity(Vector2 velocity, Vector2 normal)
+{
+#ifdef DETERMINISTIC_SIM
+	FixedVector2 v = ToFixed(velocity);
+	FixedVector2 n = ToFixed(normal);
+	if (v.DotWide(n) < 0)
+	{
+		v = FixedVector2::Reflect(v, n);
+	}
+	return ToVector2(v);
+#else
+	if (velocity.Dot(normal) < 0)
+	{
+		Vector2::Reflect(velocity, normal, velocity);
+	}
+	return velocity;
+#endif
+}
+
 //----------------------------------------------------------------------------------------------
 // Checks for collisions between ball and blocks/paddle
 //----------------------------------------------------------------------------------------------
 void MyProject::CollisionCheck(float deltaTime)
 {
-	Vector2 pos = ballSprite.GetPosition();
+	if (deltaTime <= 0.0f)
+	{
+		return;
+	}
+
 	Vector2 velocity = ballSprite.GetVelocity();
 	float rotationVelocity = ballSprite.GetRotationalVelocity();
 
-	// Block collisions
-	Circle ballCollision(pos, ballSprite.GetWidth() * 0.5f);
-	for (int i = 0; i < NUM_BLOCKS; i++)
+	// trace the ball along the path it moved this frame, from where it started
+	Circle ballCollision(ballStartPos, ballSprite.GetWidth() * 0.5f);
+	Vector2 displacement = ballSprite.GetPosition() - ballStartPos;
+
+	// only test the blocks in the grid cells the ball could have passed through this frame.
+	//	the path can bounce off in any direction, so it's everything within the distance moved
+	int candidates[NUM_BLOCKS];
+	Box2D queryBounds = CollisionGrid::BouncedBounds(ballCollision, displacement);
+#ifdef DETERMINISTIC_SIM
+	// pad the float bounds, so a rounding difference between builds can't change which blocks are found
+	queryBounds.extents += Vector2(1.0f, 1.0f);
+#endif
+	int numCandidates = blockGrid.Query(queryBounds, candidates, NUM_BLOCKS);
+
+	// the boxes the ball can hit, the paddle goes after the blocks
+	Box2D boxes[NUM_BLOCKS + 1];
+	for (int c = 0; c < numCandidates; c++)
 	{
-		Box2D blockCollision(blockSprites[i].GetPosition(), blockSprites[i].GetExtents());
+		boxes[c] = blockGrid.GetBox(candidates[c]);
+	}
+	boxes[numCandidates] = Box2D(paddleSprite.GetPosition(), paddleSprite.GetExtents());
+
+	// move the ball along the path, bouncing off anything it hits on the way
+	const int maxHits = 8;
+	SweepHit2D hits[maxHits];
+	int numHits = 0;
 
-		// if collision between a block and the ball
-		if (Collision2D::BoxCircleCheck(blockCollision, ballCollision))
+#ifdef DETERMINISTIC_SIM
+	// trace in fixed point, moving the whole displacement in one "second" so nothing is lost dividing by deltaTime
+	FixedBox2D fixedBoxes[NUM_BLOCKS + 1];
+	for (int c = 0; c <= numCandidates; c++)
+	{
+		fixedBoxes[c] = FixedBox2D(boxes[c]);
+	}
+
+	FixedSweepHit2D fixedHits[maxHits];
+	FixedVector2 pathDisplacement = ToFixed(ballSprite.GetPosition()) - ToFixed(ballStartPos);
+
+	FixedVector2 pos = FixedCollision2D::MoveCircle(FixedCircle(ballCollision), pathDisplacement, Fixed::FromInt(1),
+		fixedBoxes, numCandidates + 1, fixedHits, maxHits, numHits);
+	ballSprite.SetPosition(ToVector2(pos)); // update position of ball
+
+	for (int h = 0; h < numHits; h++)
+	{
+		hits[h].index = fixedHits[h].index;
+		hits[h].contact.normal = ToVector2(fixedHits[h].contact.normal);
+	}
+#else
+	Vector2 pathVelocity = displacement * (1.0f / deltaTime);
+
+	Vector2 pos = Collision2D::MoveCircle(ballCollision, pathVelocity, deltaTime, boxes, numCandidates + 1, hits, maxHits, numHits);
+	ballSprite.SetPosition(pos); // update position of ball
+#endif
+
+	for (int h = 0; h < numHits; h++)
+	{
+		// bounce the ball off the same surface the path bounced off
+		velocity = BounceVelocity(velocity, hits[h].contact.normal);
+		rotationVelocity = -rotationVelocity; // rotation velocity changes
+		ballSprite.SetVelocity(velocity, rotationVelocity); // update velocity of ball
+
+		// Paddle collision, nothing else to do
+		if (hits[h].index == numCandidates)
 		{
-			score += 10 * scoreMultiplier; // add to score
-			blockDamage[i]--; // Block takes damage
+			continue;
+		}
 
-			// if block still has health, and is not powered,
-			if (blockDamage[i] > 0 && i != powerSpot1 && i != powerSpot2 && i != powerSpot3 && i != powerSpot4 && i != powerSpot5 && i != powerSpot6 && i != powerSpot7)
-			{
-				blockDamageSprites[i].SetPosition(blockSprites[i].GetPosition()); // move damage sprite on screen
-				blockSprites[i].SetColor(Color(1, 1, 1, 0)); // make default invisible
-			}
-			else if (blockDamage[i] <= 0) // if block is out of health
-			{
-				blockDamageSprites[i].SetPosition(Vector2(-100, 0)); // move damage sprite off screen again
-				blockSprites[i].SetPosition(Vector2(-100, 0)); // move block off screen
-				blocksRemaining--; // blocks remaining decreases
-				scoreMultiplier++; // score multiplier increases
-			}
+		// Block collisions
+		int i = candidates[hits[h].index];
 
-			if (blocksRemaining <= 0)
-			{
-				currentState = gameStates::OVER; // No more blocks, game over!
-			}
+		// the path can bounce off a block that was destroyed earlier this frame, don't count it twice
+		EntityId id = blocks.GetIdAtSlot(i);
+		Block* pBlock = blocks.Get(id);
+		if (pBlock == nullptr)
+		{
+			continue;
+		}
+		Block& block = *pBlock;
 
-			ballCollision.center -= velocity * deltaTime;
+		score += 10 * scoreMultiplier; // add to score
+		block.damage--; // Block takes damage
+		Vector2 blockPos = block.sprite.GetPosition();
+		particles.Emit(block.damage > 0 ? hitBurst : debrisBurst, blockPos);
 
-			pos = Collision2D::ReflectCircleBox(ballCollision, velocity, deltaTime, blockCollision);
-			rotationVelocity = -rotationVelocity; // rotation velocity changes
+		// if block still has health, and is not powered,
+		if (block.damage > 0 && i != powerSpot1 && i != powerSpot2 && i != powerSpot3 && i != powerSpot4 && i != powerSpot5 && i != powerSpot6 && i != powerSpot7)
+		{
+			block.sprite.PlayClip(blockDamagedClip); // show the damaged animation
+		}
+		else if (block.damage <= 0) // if block is out of health
+		{
+			// stop updating, drawing and testing it. the block itself stays put until its slot is reused
+			blockSystem.Detach(&block.sprite);
+			blocks.Destroy(id);
+			blockGrid.Remove(i);
+			blocksRemaining--; // blocks remaining decreases
+			scoreMultiplier++; // score multiplier increases
+		}
 
-			ballSprite.SetPosition(pos); // update position of ball
-			ballSprite.SetVelocity(velocity, rotationVelocity); // update velocity of ball
+		if (blocksRemaining <= 0)
+		{
+			SetState(gameStates::OVER); // No more blocks, game over!
+		}
 
-			Vector2 newSpeed;
-			ballSpeed += difficultyScaler; // add difficulty scaler to ball and paddle speed. Game gets faster and faster as player progresses
-			paddleSpeed += difficultyScaler;
+		Vector2 newSpeed;
+		ballSpeed += difficultyScaler; // add difficulty scaler to ball and paddle speed. Game gets faster and faster as player progresses
+		paddleSpeed += difficultyScaler;
 
-			// Speedy Power (small and fast)
-			if (i == powerSpot1 || i == powerSpot4 || i == powerSpot6)
+		// Speedy Power (small and fast)
+		if (i == powerSpot1 || i == powerSpot4 || i == powerSpot6)
+		{
+			if (block.damage == 2)
 			{
-				if (blockDamage[i] == 2)
-				{
-					blockSprites[i].SetColor(Color(0.8, 0.8, 0.8)); // first hit
-				}
-				else if (blockDamage[i] == 1)
+				block.sprite.SetColor(Color(0.8, 0.8, 0.8)); // first hit
+			}
+			else if (block.damage == 1)
+			{
+				block.sprite.SetColor(Color(0.5, 0.5, 0.5)); // second hit
+			}
+			else if (block.damage <= 0) // third hit, destroyed
+			{
+				if (powerSlow) // ensure that other power is disabled
 				{
-					blockSprites[i].SetColor(Color(0.5, 0.5, 0.5)); // second hit
+					ballSpeed += speedyPower;
+					paddleSpeed += speedyPower;
 				}
-				else if (blockDamage[i] <= 0) // third hit, destroyed
+				else if (powerSpeed) // ensure that this power is disabled (before re-enabling)
 				{
-					if (powerSlow) // ensure that other power is disabled
-					{
-						ballSpeed += speedyPower;
-						paddleSpeed += speedyPower;
-					}
-					else if (powerSpeed) // ensure that this power is disabled (before re-enabling)
-					{
-						ballSpeed -= speedyPower;
-						paddleSpeed -= speedyPower * 2;
-					}
-
-					score += 10; // add 10 to score
-					ballSpeed += speedyPower; // add speed power to ball speed
-					paddleSpeed += speedyPower * 2; // add speed power x 2 to paddle speed
-
-					powerTime = 10.0f; // lasts 10 seconds
-					ballSprite.SetScale(1.0f); // ball and paddle shrink
-					paddleSprite.SetScale(0.5f);
-
-					powerSpeed = true;
-					powerSlow = false;
+					ballSpeed -= speedyPower;
+					paddleSpeed -= speedyPower * 2;
 				}
 
+				score += 10; // add 10 to score
+				ballSpeed += speedyPower; // add speed power to ball speed
+				paddleSpeed += speedyPower * 2; // add speed power x 2 to paddle speed
+
+				powerTime = 10.0f; // lasts 10 seconds
+				ballSprite.SetScale(1.0f); // ball and paddle shrink
+				paddleSprite.SetScale(0.5f);
+
+				powerSpeed = true;
+				powerSlow = false;
+				particles.Emit(speedyBurst, blockPos);
 			}
 
-			// Slow-mo power (big and slow)
-			else if (i == powerSpot2 || i == powerSpot5 || i == powerSpot7)
+		}
+
+		// Slow-mo power (big and slow)
+		else if (i == powerSpot2 || i == powerSpot5 || i == powerSpot7)
+		{
+			if (block.damage == 2)
 			{
-				if (blockDamage[i] == 2)
-				{
-					blockSprites[i].SetColor(Color(0.8, 0.8, 0.8)); // first hit
-				}
-				else if (blockDamage[i] == 1)
-				{
-					blockSprites[i].SetColor(Color(0.5, 0.5, 0.5)); // second hit
-				}
-				else if (blockDamage[i] <= 0) // third hit, destroyed
-				{
-					if (powerSpeed) // ensure other power is disabled
-					{
-						ballSpeed -= speedyPower;
-						paddleSpeed -= speedyPower * 2;
-					}
-					else if (powerSlow) // ensure this power is disabled (before re-enabling)
-					{
-						ballSpeed += speedyPower;
-						paddleSpeed += speedyPower;
-					}
-
-					score += 10; // add 10 to score
-					ballSpeed -= speedyPower; // ball and paddle speed are slowed
-					paddleSpeed -= speedyPower;
-
-					powerTime = 10.0f; // lasts 10 seconds
-					paddleSprite.SetScale(1.5f); // paddle and ball grow in size
-					ballSprite.SetScale(1.5f);
-
-					powerSpeed = false;
-					powerSlow = true;
-				}
+				block.sprite.SetColor(Color(0.8, 0.8, 0.8)); // first hit
 			}
-
-			else if (i == powerSpot3) // if third power brick type
+			else if (block.damage == 1)
 			{
-				if (blockDamage[i] == 2)
-				{
-					blockSprites[i].SetColor(Color(0.8, 0.8, 0.8)); // first hit
-				}
-				else if (blockDamage[i] == 1)
+				block.sprite.SetColor(Color(0.5, 0.5, 0.5)); // second hit
+			}
+			else if (block.damage <= 0) // third hit, destroyed
+			{
+				if (powerSpeed) // ensure other power is disabled
 				{
-					blockSprites[i].SetColor(Color(0.5, 0.5, 0.5)); // second hit
+					ballSpeed -= speedyPower;
+					paddleSpeed -= speedyPower * 2;
 				}
-				else if (blockDamage[i] <= 0) // destroyed
+				else if (powerSlow) // ensure this power is disabled (before re-enabling)
 				{
-					lives++; // extra life. yay!
+					ballSpeed += speedyPower;
+					paddleSpeed += speedyPower;
 				}
+
+				score += 10; // add 10 to score
+				ballSpeed -= speedyPower; // ball and paddle speed are slowed
+				paddleSpeed -= speedyPower;
+
+				powerTime = 10.0f; // lasts 10 seconds
+				paddleSprite.SetScale(1.5f); // paddle and ball grow in size
+				ballSprite.SetScale(1.5f);
+
+				powerSpeed = false;
+				powerSlow = true;
+				particles.Emit(slowBurst, blockPos);
 			}
+		}
 
-			// set newspeed of ball, ensuring it goes in the proper direction on x and y
-			if (velocity.x > 0)
+		else if (i == powerSpot3) // if third power brick type
+		{
+			if (block.damage == 2)
 			{
-				newSpeed.x = ballSpeed;
+				block.sprite.SetColor(Color(0.8, 0.8, 0.8)); // first hit
 			}
-			else if (velocity.x < 0)
+			else if (block.damage == 1)
 			{
-				newSpeed.x = -ballSpeed;
+				block.sprite.SetColor(Color(0.5, 0.5, 0.5)); // second hit
 			}
-
-			if (velocity.y > 0)
+			else if (block.damage <= 0) // destroyed
 			{
-				newSpeed.y = ballSpeed;
+				lives++; // extra life. yay!
+				particles.Emit(lifeBurst, blockPos);
 			}
-			else if (velocity.y < 0)
-			{
-				newSpeed.y = -ballSpeed;
-			}
-			// set new velocity (new speed)
-			ballSprite.SetVelocity(newSpeed, ballSpeed);
 		}
-	}
-
-	// Paddle collision
-	Box2D paddleCollision(paddleSprite.GetPosition(), paddleSprite.GetExtents());
-
-	// if collision between ball and paddle
-	if (Collision2D::BoxCircleCheck(paddleCollision, ballCollision))
-	{
-		ballCollision.center -= velocity * deltaTime;
 
-		pos = Collision2D::ReflectCircleBox(ballCollision, velocity, deltaTime, paddleCollision);
-		rotationVelocity = -rotationVelocity; // rotational velocity changes
+		// set newspeed of ball, ensuring it goes in the proper direction on x and y
+		if (velocity.x > 0)
+		{
+			newSpeed.x = ballSpeed;
+		}
+		else if (velocity.x < 0)
+		{
+			newSpeed.x = -ballSpeed;
+		}
 
-		// update position and velocity of ball
-		ballSprite.SetPosition(pos);
+		if (velocity.y > 0)
+		{
+			newSpeed.y = ballSpeed;
+		}
+		else if (velocity.y < 0)
+		{
+			newSpeed.y = -ballSpeed;
+		}
+		// set new velocity (new speed)
+		velocity = newSpeed;
+		rotationVelocity = ballSpeed;
 		ballSprite.SetVelocity(velocity, rotationVelocity);
 	}
 }
@@ -797,7 +1106,6 @@ void MyProject::CollisionCheck(float deltaTime)
 //----------------------------------------------------------------------------------------------
 void MyProject::Reset()
 {
-	currentState = gameStates::START;
 	buttonDown = false;
 	keyDown = false;
 	powerSpeed = false;
@@ -819,5 +1127,7 @@ void MyProject::Reset()
 	paddleSpeed = 150;
 	livesColor = Color(1, 1, 1);
 
-	InitializeTextures();
+	InitializeLevel();
+
+	SetState(gameStates::START);
 }
\ No newline at end of file
@@ -5,12 +5,25 @@
 #include "Font.h"
 #include "TextureType.h"
 #include "Sprite.h"
+#include "SpriteSystem.h"
+#include "AnimationClip.h"
+#include "EntityPool.h"
+#include "RenderQueue.h"
+#include "SpriteBatchBackend.h"
+#include "ParticleSystem.h"
+#include "Widget.h"
+#include "ResourceCache.h"
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "DecodeCache.h"
 #include "Collision2D.h"
+#include "CollisionGrid.h"
 
 //GAME 1201 Term Assignment 1
 
 // forward declare the sprite batch
 namespace DirectX { class SpriteBatch; };
+class SoftwareFramebuffer;
 
 struct Block
 {
@@ -22,18 +35,27 @@ struct Block
 //----------------------------------------------------------------------------------------------
 // Main project class
 //	Inherits the directx class to help us initalize directX
+//	and listens to the menu buttons
 //----------------------------------------------------------------------------------------------
 
-class MyProject : public DirectXClass
+class MyProject : public DirectXClass, public WidgetListener
 {
 public:
 	// constructor
 	MyProject(HINSTANCE hInstance);
 	~MyProject();
 
-	// Initialize any Textures we need to use
+	// draw every frame on the cpu too, and save it and its checksum to directory, for
+	//	frames frames then quit. the game starts in play, with a fixed step and seed so the
+	//	frames come out the same every run. has to be called before InitializeTextures
+	bool SetCapture(const char* directory, int frames);
+
+	// Load the textures and fonts and set up the drawing, once at startup
 	void InitializeTextures();
 
+	// Lay out a new round: ball, paddle, blocks and power ups. no loading
+	void InitializeLevel();
+
 	// window message handler
 	LRESULT ProcessWindowMessages(UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -51,40 +73,80 @@ public:
 
 	void Reset();
 
+	// a menu button was clicked
+	void OnWidgetClicked(Widget* pWidget);
+
 private:
 	static const int NUM_BLOCKS = 48;
 	static enum gameStates { START, RULES, PLAYING, OVER };		// Game State enumerated type
 
+	// every asset mapped from one file, if there is one. has to outlive the loader
+	AssetPack pack;
+
+	// reads and decodes the textures in the background, has to outlive the cache
+	AssetLoader loader;
+	double firstFrameTime; // ms from startup, < 0 until the first frame is drawn
+	bool loadReported;
+
+	// every texture and font below comes from here, and is loaded once
+	ResourceCache resources;
+
 	// font variables
-	FontType pixel30;
+	FontType* pixel30;
 
 	// Menu textures / Sprites
-	TextureType startTex;
-	TextureType rulesTex;
-	TextureType loseTex;
-	TextureType winTex;
-	TextureType buttonPlayTex;
-	TextureType buttonRulesTex;
-	TextureType buttonExitTex;
-	TextureType buttonMenuTex;
-
-	Sprite menuButtons[4];
+	TextureType* startTex;
+	TextureType* rulesTex;
+	TextureType* loseTex;
+	TextureType* winTex;
+	TextureType* buttonPlayTex;
+	TextureType* buttonRulesTex;
+	TextureType* buttonExitTex;
+	TextureType* buttonMenuTex;
+
+	// menu screens, one widget tree for each state with buttons
+	enum ButtonIds { BUTTON_PLAY, BUTTON_EXIT, BUTTON_RULES, BUTTON_MENU };
+	WidgetRoot startScreen;
+	WidgetRoot rulesScreen;
+	WidgetRoot overScreen;
+	ButtonWidget startButtons[3];	// play, exit, rules
+	ButtonWidget rulesButtons[2];	// play, exit
+	ButtonWidget menuButton;		// back to the start from game over
 
 	// Gameplay textures / Sprites
-	TextureType backgroundTex;
-	TextureType ballTex;
-	TextureType paddleTex;
-	TextureType blockTex;
-	TextureType blockDamageTex;
-	TextureType blockSpeedyTex;
-	TextureType blockSlowTex;
-	TextureType blockLifeTex;
+	TextureType* backgroundTex;
+	TextureType* ballTex;
+	TextureType* paddleTex;
+	TextureType* blockTex;
+	TextureType* blockDamageTex;
+	TextureType* blockSpeedyTex;
+	TextureType* blockSlowTex;
+	TextureType* blockLifeTex;
+
+	// the animations sprites can play, and the one a block switches to when damaged
+	ClipLibrary clips;
+	const AnimationClip* blockDamagedClip;
 
 	Sprite ballSprite;
+	Vector2 ballStartPos; // where the ball was at the start of the frame
 	Sprite paddleSprite;
-	Sprite blockSprites[NUM_BLOCKS];
-	Sprite blockDamageSprites[NUM_BLOCKS];
-	int blockDamage[NUM_BLOCKS];
+
+	// a block in the level. its slot in the pool is its index in blockGrid
+	struct Block
+	{
+		Sprite sprite;
+		int damage; // hits left
+	};
+	EntityPool<Block, NUM_BLOCKS> blocks; // only the blocks still in play are live
+	SpriteSystem blockSystem; // moves and animates all the live block sprites together
+
+	// hit and power up bursts
+	static const int MAX_PARTICLES = 4096;
+	TextureType* particleTex;
+	ParticleSystem particles;
+
+	// broadphase for the blocks, built when the blocks are laid out
+	CollisionGrid blockGrid;
 
 	// Score / Lives variables
 	int score;
@@ -113,11 +175,42 @@ private:
 
 	gameStates currentState;
 
+	// change state, and let the new screen's buttons catch up with the mouse
+	void SetState(gameStates state);
+
+	// the screen taking the mouse in the current state, null while playing
+	WidgetRoot* ActiveScreen();
+
 	// sprite batch 
 	DirectX::SpriteBatch* spriteBatch;
 
 	DirectX::CommonStates* commonStates;
 
+	// sprites record their draws here, then it's sorted and drawn with the sprite batch
+	RenderQueue renderQueue;
+	SpriteBatchBackend spriteBackend;
+	bool captureFrame; // F12 writes the next frame's draws to frame_capture.txt
+
+	// sort and draw whatever is in the render queue, then empty it
+	void DrawQueue();
+
+	// copy a full screen picture to the back buffer, and the capture
+	void DrawBackground(TextureType* pTexture);
+
+	// with -capture (see SetCapture), each frame is drawn here as well
+	SoftwareFramebuffer* pCapture;
+	std::string captureDirectory;
+	FILE* pCaptureLog;			// frame_NNNNN.png checksum, a line a frame
+	int captureFrames;			// to capture before quitting
+	int capturedCount;
+
+	bool IsCapturing() const { return pCapture != NULL && capturedCount < captureFrames; }
+	void BeginCaptureFrame();
+	void EndCaptureFrame();
+
+	// every texture InitializeTextures got
+	std::vector<TextureType*> GetTextures() const;
+
 	// mouse variables
 	Vector2 mousePos;
 	bool buttonDown;
@@ -125,9 +218,6 @@ private:
 	// keyboard variables
 	bool keyDown;
 
-	// call when the mouse is released
-	void OnMouseDown();
-
 };
 
 #endif
\ No newline at end of file
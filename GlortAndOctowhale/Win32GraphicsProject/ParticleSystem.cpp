@@ -0,0 +1,233 @@
+//
+// ParticleSystem
+//		Lots of short lived particles for bursts (debris, sparkles)
+//
+
+#include "ParticleSystem.h"
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define PARTICLE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// -----------------------------------------------------
+// Constructor
+//
+ParticleSystem::ParticleSystem()
+{
+	count = 0;
+	capacity = 0;
+	gravity = Vector2(0, 0);
+	drag = 0.0f;
+	randomState = 9201;
+	pTexture = nullptr;
+	textureLeft = 0;
+	textureTop = 0;
+	textureWidth = 0;
+	textureHeight = 0;
+}
+
+// -----------------------------------------------------
+// Allocate everything up front
+//
+void ParticleSystem::Initialize(int cap)
+{
+	capacity = cap > 0 ? cap : 0;
+	count = 0;
+
+	posX.assign(capacity, 0.0f);
+	posY.assign(capacity, 0.0f);
+	velX.assign(capacity, 0.0f);
+	velY.assign(capacity, 0.0f);
+	life.assign(capacity, 0.0f);
+	invLifetime.assign(capacity, 0.0f);
+	size.assign(capacity, 0.0f);
+	color.assign(capacity, 0);
+}
+
+void ParticleSystem::Clear()
+{
+	count = 0;
+}
+
+void ParticleSystem::SetTexture(ID3D11ShaderResourceView* pView, int width, int height, int left, int top)
+{
+	pTexture = pView;
+	textureLeft = left;
+	textureTop = top;
+	textureWidth = width;
+	textureHeight = height;
+}
+
+// -----------------------------------------------------
+// xorshift32
+//
+float ParticleSystem::Random()
+{
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+
+	// top 24 bits, exactly representable as a float
+	return (randomState >> 8) * (1.0f / 16777216.0f);
+}
+
+// -----------------------------------------------------
+// Start a burst
+//
+int ParticleSystem::Emit(const ParticleEmitter& emitter, Vector2 position)
+{
+	int spawn = emitter.count;
+	if (spawn > capacity - count)
+		spawn = capacity - count;
+
+	for (int n = 0; n < spawn; n++)
+	{
+		int i = count++;
+
+		float angle = emitter.angle + emitter.spread * (Random() * 2.0f - 1.0f);
+		float speed = emitter.speedMin + (emitter.speedMax - emitter.speedMin) * Random();
+		float lifetime = emitter.lifeMin + (emitter.lifeMax - emitter.lifeMin) * Random();
+		if (lifetime <= 0.0f)
+			lifetime = 0.001f;
+
+		posX[i] = position.x;
+		posY[i] = position.y;
+		velX[i] = cosf(angle) * speed;
+		velY[i] = sinf(angle) * speed;
+		life[i] = lifetime;
+		invLifetime[i] = 1.0f / lifetime;
+		size[i] = emitter.sizeMin + (emitter.sizeMax - emitter.sizeMin) * Random();
+		color[i] = emitter.color;
+	}
+
+	return spawn;
+}
+
+// -----------------------------------------------------
+// Swap remove
+//
+void ParticleSystem::Kill(int i)
+{
+	int last = --count;
+
+	posX[i] = posX[last];
+	posY[i] = posY[last];
+	velX[i] = velX[last];
+	velY[i] = velY[last];
+	life[i] = life[last];
+	invLifetime[i] = invLifetime[last];
+	size[i] = size[last];
+	color[i] = color[last];
+}
+
+// -----------------------------------------------------
+// Move, age, and cull
+//
+void ParticleSystem::Update(float deltaTime)
+{
+	// drag as a scale on the velocity, can't go backwards
+	float keep = 1.0f - drag * deltaTime;
+	if (keep < 0.0f)
+		keep = 0.0f;
+
+	float gx = gravity.x * deltaTime;
+	float gy = gravity.y * deltaTime;
+
+	int i = 0;
+
+#ifdef PARTICLE_SSE2
+	const __m128 dt = _mm_set1_ps(deltaTime);
+	const __m128 keep4 = _mm_set1_ps(keep);
+	const __m128 gx4 = _mm_set1_ps(gx);
+	const __m128 gy4 = _mm_set1_ps(gy);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128 vx = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&velX[i]), keep4), gx4);
+		__m128 vy = _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(&velY[i]), keep4), gy4);
+		_mm_storeu_ps(&velX[i], vx);
+		_mm_storeu_ps(&velY[i], vy);
+
+		_mm_storeu_ps(&posX[i], _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(vx, dt)));
+		_mm_storeu_ps(&posY[i], _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(vy, dt)));
+
+		_mm_storeu_ps(&life[i], _mm_sub_ps(_mm_loadu_ps(&life[i]), dt));
+	}
+#endif
+
+	// whatever is left over
+	for (; i < count; i++)
+	{
+		velX[i] = velX[i] * keep + gx;
+		velY[i] = velY[i] * keep + gy;
+		posX[i] += velX[i] * deltaTime;
+		posY[i] += velY[i] * deltaTime;
+		life[i] -= deltaTime;
+	}
+
+	// remove the dead ones, the one swapped in has to be checked too
+	i = 0;
+	while (i < count)
+	{
+#ifdef PARTICLE_SSE2
+		// skip 4 at a time while they're all alive
+		if (i + 4 <= count && _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(&life[i]), _mm_setzero_ps())) == 0)
+		{
+			i += 4;
+			continue;
+		}
+#endif
+		if (life[i] <= 0.0f)
+			Kill(i);
+		else
+			i++;
+	}
+}
+
+// -----------------------------------------------------
+// Queue up the draws, fading the alpha out over the life
+//
+void ParticleSystem::Draw(RenderQueue* pQueue, float layer, BlendMode blend) const
+{
+	if (count == 0 || pTexture == nullptr)
+		return;
+
+	DrawCommand* commands = pQueue->Allocate(count, pTexture, layer, blend);
+	bool premultiplied = blend == BlendAlpha;
+
+	float originX = textureWidth * 0.5f;
+	float originY = textureHeight * 0.5f;
+
+	for (int i = 0; i < count; i++)
+	{
+		DrawCommand& c = commands[i];
+		c.srcLeft = textureLeft;
+		c.srcTop = textureTop;
+		c.srcRight = textureLeft + textureWidth;
+		c.srcBottom = textureTop + textureHeight;
+		c.x = posX[i];
+		c.y = posY[i];
+		c.originX = originX;
+		c.originY = originY;
+		c.rotation = 0.0f;
+		c.scale = size[i];
+
+		// life / lifetime is 1 when it starts and 0 when it dies
+		uint32_t alpha = (uint32_t)((color[i] >> 24) * (life[i] * invLifetime[i]));
+		if (premultiplied)
+		{
+			// fading takes the colour down with the alpha
+			uint32_t rgb = color[i];
+			uint32_t r = ((rgb & 0xff) * alpha + 127) / 255;
+			uint32_t g = (((rgb >> 8) & 0xff) * alpha + 127) / 255;
+			uint32_t b = (((rgb >> 16) & 0xff) * alpha + 127) / 255;
+			c.color = r | (g << 8) | (b << 16) | (alpha << 24);
+		}
+		else
+		{
+			c.color = (color[i] & 0x00ffffff) | (alpha << 24);
+		}
+	}
+}
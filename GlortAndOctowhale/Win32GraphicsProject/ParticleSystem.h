@@ -0,0 +1,103 @@
+//
+// ParticleSystem
+//		Lots of short lived particles for bursts (debris, sparkles)
+//
+//	Particles are kept in fixed size arrays, one per attribute, allocated once in
+//	Initialize. Update moves them 4 at a time with SSE2 and swaps dead ones out of the
+//	end, so only live particles are ever touched. Every particle uses the same texture,
+//	so they all draw in one run of the render queue.
+//
+
+#ifndef _PARTICLE_SYSTEM_H
+#define _PARTICLE_SYSTEM_H
+
+#ifdef _WIN32
+#include <d3d11.h>
+#include <SimpleMath.h>
+#else
+#include "PortableMath.h"	// lets the benchmarks build without the Windows SDK
+#endif
+#include <stdint.h>
+#include <vector>
+#include "RenderQueue.h"
+
+using DirectX::SimpleMath::Vector2;
+
+// what a burst looks like
+struct ParticleEmitter
+{
+	int			count;				// particles per burst
+	float		speedMin, speedMax;	// pixels / sec
+	float		angle, spread;		// direction in radians (0 is +x, y is down), and +- spread around it
+	float		lifeMin, lifeMax;	// seconds
+	float		sizeMin, sizeMax;	// scale of the texture
+	uint32_t	color;				// packed like DrawCommand::color, the alpha fades out over the life
+};
+
+class ParticleSystem
+{
+public:
+	ParticleSystem();
+
+	// make room for capacity particles. this is the only allocation, bursts that don't
+	//	fit are cut short
+	void Initialize(int capacity);
+
+	// remove every particle
+	void Clear();
+
+	// pull on every particle, pixels / sec^2
+	void SetGravity(Vector2 g) { gravity = g; }
+
+	// fraction of velocity lost per second
+	void SetDrag(float d) { drag = d; }
+
+	// texture to draw with, centred on the particle. left / top is where the image starts
+	//	in the view, for a region of an atlas page
+	void SetTexture(ID3D11ShaderResourceView* pView, int width, int height, int left = 0, int top = 0);
+
+	// start a burst at position, returns how many particles it got
+	int Emit(const ParticleEmitter& emitter, Vector2 position);
+
+	// move, age and remove dead particles
+	void Update(float deltaTime);
+
+	// add every particle to the queue. with BlendAlpha the colours are premultiplied, for
+	//	a premultiplied texture
+	void Draw(RenderQueue* pQueue, float layer = 0.0f, BlendMode blend = BlendNonPremultiplied) const;
+
+	int GetCount() const { return count; }
+	int GetCapacity() const { return capacity; }
+
+private:
+	// random number in [0, 1), xorshift so there's no locking or global state
+	float Random();
+
+	// copy the last particle over i
+	void Kill(int i);
+
+	// one entry per particle
+	std::vector<float>		posX;
+	std::vector<float>		posY;
+	std::vector<float>		velX;
+	std::vector<float>		velY;
+	std::vector<float>		life;			// seconds left
+	std::vector<float>		invLifetime;	// 1 / starting life, for the fade
+	std::vector<float>		size;
+	std::vector<uint32_t>	color;
+
+	int						count;
+	int						capacity;
+
+	Vector2					gravity;
+	float					drag;
+	uint32_t				randomState;
+
+	ID3D11ShaderResourceView* pTexture;
+	int						textureLeft;
+	int						textureTop;
+	int						textureWidth;
+	int						textureHeight;
+};
+
+#endif // _PARTICLE_SYSTEM_H
@@ -0,0 +1,801 @@
+//
+// PngCodec
+//		Reads and writes PNG files without WIC or libpng, so tools can use it anywhere
+//
+
+#include "PngCodec.h"
+#include "Zlib.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define PNG_X86 1
+#include <emmintrin.h>	// SSE2
+#include <immintrin.h>	// AVX2
+#ifdef _MSC_VER
+#include <intrin.h>		// __cpuid
+#endif
+#endif
+
+// the AVX2 kernels are compiled for AVX2 even if the rest of the file isn't
+#if defined(PNG_X86) && (defined(__GNUC__) || defined(__clang__))
+#define PNG_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PNG_TARGET_AVX2
+#endif
+
+static const uint8_t signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+// Adam7 passes: first column / row and step
+static const int adam7X[7] = { 0, 4, 0, 2, 0, 1, 0 };
+static const int adam7Y[7] = { 0, 0, 4, 0, 2, 0, 1 };
+static const int adam7DX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+static const int adam7DY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+static uint32_t ReadU32(const uint8_t* p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static void PutU32(std::vector<uint8_t>& out, uint32_t v)
+{
+	out.push_back((uint8_t)(v >> 24));
+	out.push_back((uint8_t)(v >> 16));
+	out.push_back((uint8_t)(v >> 8));
+	out.push_back((uint8_t)v);
+}
+
+static bool Fail(std::string* error, const char* why)
+{
+	if (error)
+		*error = why;
+	return false;
+}
+
+// -----------------------------------------------------
+// Work out the best instruction set we can use
+//
+static PngCodec::SimdLevel DetectSimdLevel()
+{
+#if defined(PNG_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osSavesAvx)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2)
+		return PngCodec::SimdAVX2;
+	if (sse2)
+		return PngCodec::SimdSSE2;
+	return PngCodec::SimdScalar;
+#elif defined(PNG_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return PngCodec::SimdAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return PngCodec::SimdSSE2;
+	return PngCodec::SimdScalar;
+#else
+	return PngCodec::SimdScalar;
+#endif
+}
+
+PngCodec::SimdLevel PngCodec::GetSimdLevel()
+{
+	static SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+// -----------------------------------------------------
+// Undo one row's filter in place. prev is the row above, already unfiltered (zeros for the first)
+//
+static bool UnfilterRowScalar(int filter, uint8_t* row, const uint8_t* prev, size_t rowBytes, int bpp)
+{
+	switch (filter)
+	{
+	case 0:	// none
+		break;
+	case 1:	// sub
+		for (size_t i = bpp; i < rowBytes; i++)
+			row[i] += row[i - bpp];
+		break;
+	case 2:	// up
+		for (size_t i = 0; i < rowBytes; i++)
+			row[i] += prev[i];
+		break;
+	case 3:	// average
+		for (size_t i = 0; i < (size_t)bpp; i++)
+			row[i] += prev[i] >> 1;
+		for (size_t i = bpp; i < rowBytes; i++)
+			row[i] += (uint8_t)((row[i - bpp] + prev[i]) >> 1);
+		break;
+	case 4:	// paeth
+		for (size_t i = 0; i < rowBytes; i++)
+		{
+			int a = i >= (size_t)bpp ? row[i - bpp] : 0;
+			int b = prev[i];
+			int c = i >= (size_t)bpp ? prev[i - bpp] : 0;
+			int p = a + b - c;
+			int pa = p > a ? p - a : a - p;
+			int pb = p > b ? p - b : b - p;
+			int pc = p > c ? p - c : c - p;
+			row[i] += (uint8_t)((pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c));
+		}
+		break;
+	default:
+		return false;
+	}
+	return true;
+}
+
+#ifdef PNG_X86
+
+// -----------------------------------------------------
+// SSE2 unfiltering. Sub, Average and Paeth depend on the pixel to the left, so they go
+//	a pixel at a time with the pixel's bytes side by side in a register, which is still
+//	3 or 4 bytes a step where the scalar code does one. Up goes 16 bytes at a time
+//
+template <int bpp>
+static inline __m128i LoadPixel(const uint8_t* p)
+{
+	int32_t v = 0;
+	memcpy(&v, p, bpp);
+	return _mm_cvtsi32_si128(v);
+}
+
+template <int bpp>
+static inline void StorePixel(uint8_t* p, __m128i v)
+{
+	int32_t x = _mm_cvtsi128_si32(v);
+	memcpy(p, &x, bpp);
+}
+
+// 3 byte pixels are put together in a register, a 3 byte memcpy goes through the stack
+//	and stalls every pixel waiting for the stores to reach the load
+template <>
+inline __m128i LoadPixel<3>(const uint8_t* p)
+{
+	uint16_t low;
+	memcpy(&low, p, 2);
+	return _mm_cvtsi32_si128((int32_t)(low | ((uint32_t)p[2] << 16)));
+}
+
+template <>
+inline void StorePixel<3>(uint8_t* p, __m128i v)
+{
+	uint32_t x = (uint32_t)_mm_cvtsi128_si32(v);
+	uint16_t low = (uint16_t)x;
+	memcpy(p, &low, 2);
+	p[2] = (uint8_t)(x >> 16);
+}
+
+static inline __m128i Abs16(__m128i x)
+{
+	return _mm_max_epi16(x, _mm_sub_epi16(_mm_setzero_si128(), x));
+}
+
+static inline __m128i Select(__m128i mask, __m128i a, __m128i b)
+{
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+static void UnfilterUpSSE2(uint8_t* row, const uint8_t* prev, size_t rowBytes)
+{
+	size_t i = 0;
+	for (; i + 16 <= rowBytes; i += 16)
+	{
+		__m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+		_mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(x, b));
+	}
+	for (; i < rowBytes; i++)
+		row[i] += prev[i];
+}
+
+// bpp is a template argument so the pixel loads and stores are single moves, not memcpy calls
+template <int bpp>
+static void UnfilterPixelsSSE2(int filter, uint8_t* row, const uint8_t* prev, size_t rowBytes)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+
+	switch (filter)
+	{
+	case 1:	// sub
+	{
+		__m128i a = zero;
+		for (size_t i = 0; i < rowBytes; i += bpp)
+		{
+			a = _mm_add_epi8(a, LoadPixel<bpp>(row + i));
+			StorePixel<bpp>(row + i, a);
+		}
+		break;
+	}
+	case 3:	// average, avg_epu8 rounds up so take the odd bit back off
+	{
+		__m128i a = zero;
+		for (size_t i = 0; i < rowBytes; i += bpp)
+		{
+			__m128i b = LoadPixel<bpp>(prev + i);
+			__m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one));
+			a = _mm_add_epi8(LoadPixel<bpp>(row + i), average);
+			StorePixel<bpp>(row + i, a);
+		}
+		break;
+	}
+	case 4:	// paeth, in 16 bits. pa = |b - c|, pb = |a - c|, pc = |a + b - 2c|
+	{
+		__m128i a = zero;
+		__m128i c = zero;
+		for (size_t i = 0; i < rowBytes; i += bpp)
+		{
+			__m128i b = _mm_unpacklo_epi8(LoadPixel<bpp>(prev + i), zero);
+			__m128i x = LoadPixel<bpp>(row + i);
+
+			__m128i pa = _mm_sub_epi16(b, c);
+			__m128i pb = _mm_sub_epi16(a, c);
+			__m128i pc = Abs16(_mm_add_epi16(pa, pb));
+			pa = Abs16(pa);
+			pb = Abs16(pb);
+
+			// ties go a, then b, then c
+			__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+			__m128i nearest = Select(_mm_cmpeq_epi16(smallest, pa), a, Select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+			x = _mm_add_epi8(x, _mm_packus_epi16(nearest, nearest));
+			StorePixel<bpp>(row + i, x);
+
+			a = _mm_unpacklo_epi8(x, zero);
+			c = b;
+		}
+		break;
+	}
+	}
+}
+
+static bool UnfilterRowSSE2(int filter, uint8_t* row, const uint8_t* prev, size_t rowBytes, int bpp)
+{
+	// 3 and 4 byte pixels are the ones worth doing, anything else is rare
+	if (filter == 2)
+		UnfilterUpSSE2(row, prev, rowBytes);
+	else if (filter == 0 || filter > 4 || (bpp != 3 && bpp != 4))
+		return UnfilterRowScalar(filter, row, prev, rowBytes, bpp);
+	else if (bpp == 4)
+		UnfilterPixelsSSE2<4>(filter, row, prev, rowBytes);
+	else
+		UnfilterPixelsSSE2<3>(filter, row, prev, rowBytes);
+	return true;
+}
+
+// -----------------------------------------------------
+// AVX2 only helps Up, the others are a pixel at a time whatever the width
+//
+PNG_TARGET_AVX2 static void UnfilterUpAVX2(uint8_t* row, const uint8_t* prev, size_t rowBytes)
+{
+	size_t i = 0;
+	for (; i + 32 <= rowBytes; i += 32)
+	{
+		__m256i x = _mm256_loadu_si256((const __m256i*)(row + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(prev + i));
+		_mm256_storeu_si256((__m256i*)(row + i), _mm256_add_epi8(x, b));
+	}
+	for (; i < rowBytes; i++)
+		row[i] += prev[i];
+}
+
+// RGB to RGBA, 4 pixels a shuffle. reads 16 bytes for every 12 it uses, so stops 2 pixels short
+PNG_TARGET_AVX2 static int ExpandRGBAVX2(const uint8_t* row, int width, uint32_t* out)
+{
+	const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+	const __m128i opaque = _mm_set1_epi32((int)0xff000000);
+
+	int x = 0;
+	for (; x + 6 <= width; x += 4)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*)(row + x * 3));
+		_mm_storeu_si128((__m128i*)(out + x), _mm_or_si128(_mm_shuffle_epi8(rgb, shuffle), opaque));
+	}
+	return x;
+}
+
+#endif // PNG_X86
+
+static bool UnfilterRow(int filter, uint8_t* row, const uint8_t* prev, size_t rowBytes, int bpp, PngCodec::SimdLevel level)
+{
+#ifdef PNG_X86
+	if (level == PngCodec::SimdAVX2 && filter == 2)
+	{
+		UnfilterUpAVX2(row, prev, rowBytes);
+		return true;
+	}
+	if (level >= PngCodec::SimdSSE2)
+		return UnfilterRowSSE2(filter, row, prev, rowBytes, bpp);
+#endif
+	return UnfilterRowScalar(filter, row, prev, rowBytes, bpp);
+}
+
+// -----------------------------------------------------
+// Premultiply, c * a / 255 rounded: t = c * a + 128, (t + (t >> 8)) >> 8. exact for every c and a
+//
+static void PremultiplyRow(uint32_t* pixels, size_t count, PngCodec::SimdLevel level)
+{
+	size_t i = 0;
+
+#ifdef PNG_X86
+	if (level >= PngCodec::SimdSSE2)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i half = _mm_set1_epi16(128);
+		const __m128i alphaMask = _mm_set1_epi32((int)0xff000000);
+
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128i v = _mm_loadu_si128((const __m128i*)(pixels + i));
+
+			// two pixels per half, alpha copied across each pixel's lanes
+			__m128i lo = _mm_unpacklo_epi8(v, zero);
+			__m128i hi = _mm_unpackhi_epi8(v, zero);
+			__m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			__m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+			lo = _mm_add_epi16(_mm_mullo_epi16(lo, alphaLo), half);
+			hi = _mm_add_epi16(_mm_mullo_epi16(hi, alphaHi), half);
+			lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+			hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+			// alpha stays as it was
+			__m128i result = _mm_packus_epi16(lo, hi);
+			result = Select(alphaMask, v, result);
+			_mm_storeu_si128((__m128i*)(pixels + i), result);
+		}
+	}
+#else
+	(void)level;
+#endif
+
+	for (; i < count; i++)
+	{
+		uint32_t p = pixels[i];
+		uint32_t a = p >> 24;
+		uint32_t r = (p & 0xff) * a + 128;
+		uint32_t g = ((p >> 8) & 0xff) * a + 128;
+		uint32_t b = ((p >> 16) & 0xff) * a + 128;
+		r = (r + (r >> 8)) >> 8;
+		g = (g + (g >> 8)) >> 8;
+		b = (b + (b >> 8)) >> 8;
+		pixels[i] = r | (g << 8) | (b << 16) | (a << 24);
+	}
+}
+
+void PngCodec::Premultiply(ImageRGBA& image)
+{
+	PremultiplyRow(image.pixels.data(), image.pixels.size(), GetSimdLevel());
+}
+
+// what the pixels in the file look like
+struct PngFormat
+{
+	int			colorType;
+	int			bitDepth;
+	int			channels;
+	uint32_t	palette[256];		// RGBA, alpha from tRNS
+	bool		hasKey;				// tRNS colour key for grey / RGB
+	uint16_t	key[3];
+};
+
+// sample n of a row, at the file's bit depth
+static uint32_t Sample(const uint8_t* row, size_t n, int bitDepth)
+{
+	switch (bitDepth)
+	{
+	case 8:
+		return row[n];
+	case 16:
+		return (row[n * 2] << 8) | row[n * 2 + 1];
+	default:
+	{
+		size_t bit = n * bitDepth;
+		int shift = 8 - bitDepth - (int)(bit & 7);
+		return (row[bit >> 3] >> shift) & ((1 << bitDepth) - 1);
+	}
+	}
+}
+
+// -----------------------------------------------------
+// Turn one unfiltered row into RGBA pixels, every step pixels apart
+//
+static void ConvertRow(const uint8_t* row, int width, const PngFormat& f, uint32_t* out, int step, PngCodec::SimdLevel level)
+{
+	// the common cases, 8 bit RGBA and RGB rows going straight into the image
+	if (f.bitDepth == 8 && step == 1)
+	{
+#ifdef PNG_X86
+		// little endian, so RGBA bytes are already red in the low byte
+		if (f.colorType == 6)
+		{
+			memcpy(out, row, (size_t)width * 4);
+			return;
+		}
+#endif
+		if (f.colorType == 2 && !f.hasKey)
+		{
+			int x = 0;
+#ifdef PNG_X86
+			if (level == PngCodec::SimdAVX2)
+				x = ExpandRGBAVX2(row, width, out);
+#else
+			(void)level;
+#endif
+			for (; x < width; x++)
+				out[x] = row[x * 3] | (row[x * 3 + 1] << 8) | (row[x * 3 + 2] << 16) | 0xff000000;
+			return;
+		}
+	}
+
+	// scale a sample to 8 bits
+	int maxValue = (1 << f.bitDepth) - 1;
+
+	for (int x = 0; x < width; x++, out += step)
+	{
+		uint32_t r, g, b, a = 255;
+
+		switch (f.colorType)
+		{
+		case 0:	// grey
+		{
+			uint32_t v = Sample(row, x, f.bitDepth);
+			if (f.hasKey && v == f.key[0])
+				a = 0;
+			r = g = b = f.bitDepth == 16 ? v >> 8 : v * 255 / maxValue;
+			break;
+		}
+		case 2:	// RGB
+		{
+			uint32_t sr = Sample(row, x * 3, f.bitDepth);
+			uint32_t sg = Sample(row, x * 3 + 1, f.bitDepth);
+			uint32_t sb = Sample(row, x * 3 + 2, f.bitDepth);
+			if (f.hasKey && sr == f.key[0] && sg == f.key[1] && sb == f.key[2])
+				a = 0;
+			int shift = f.bitDepth == 16 ? 8 : 0;
+			r = sr >> shift;
+			g = sg >> shift;
+			b = sb >> shift;
+			break;
+		}
+		case 3:	// palette
+			*out = f.palette[Sample(row, x, f.bitDepth)];
+			continue;
+		case 4:	// grey + alpha
+		{
+			int shift = f.bitDepth == 16 ? 8 : 0;
+			r = g = b = Sample(row, x * 2, f.bitDepth) >> shift;
+			a = Sample(row, x * 2 + 1, f.bitDepth) >> shift;
+			break;
+		}
+		default:	// RGBA
+		{
+			int shift = f.bitDepth == 16 ? 8 : 0;
+			r = Sample(row, x * 4, f.bitDepth) >> shift;
+			g = Sample(row, x * 4 + 1, f.bitDepth) >> shift;
+			b = Sample(row, x * 4 + 2, f.bitDepth) >> shift;
+			a = Sample(row, x * 4 + 3, f.bitDepth) >> shift;
+			break;
+		}
+		}
+
+		*out = r | (g << 8) | (b << 16) | (a << 24);
+	}
+}
+
+// -----------------------------------------------------
+// Decode
+//
+bool PngCodec::Decode(const uint8_t* data, size_t size, ImageRGBA& image, std::string* error, bool premultiply)
+{
+	return Decode(data, size, image, error, premultiply, GetSimdLevel());
+}
+
+bool PngCodec::Decode(const uint8_t* data, size_t size, ImageRGBA& image, std::string* error, bool premultiply, SimdLevel level)
+{
+	if (level > GetSimdLevel())
+		level = GetSimdLevel();
+
+	if (size < 8 || memcmp(data, signature, 8) != 0)
+		return Fail(error, "not a PNG");
+
+	PngFormat f;
+	memset(&f, 0, sizeof(f));
+	for (int i = 0; i < 256; i++)
+		f.palette[i] = 0xff000000;
+
+	int width = 0, height = 0, interlace = 0;
+	bool haveHeader = false, haveEnd = false;
+	std::vector<uint8_t> compressed;
+
+	size_t pos = 8;
+	while (pos + 12 <= size && !haveEnd)
+	{
+		uint32_t length = ReadU32(data + pos);
+		const uint8_t* type = data + pos + 4;
+		const uint8_t* body = data + pos + 8;
+		if (length > size - pos - 12)
+			return Fail(error, "chunk runs off the end");
+		if (Zlib::Crc32(type, length + 4) != ReadU32(body + length))
+			return Fail(error, "chunk CRC doesn't match");
+
+		if (memcmp(type, "IHDR", 4) == 0)
+		{
+			if (length != 13)
+				return Fail(error, "bad IHDR");
+			width = (int)ReadU32(body);
+			height = (int)ReadU32(body + 4);
+			f.bitDepth = body[8];
+			f.colorType = body[9];
+			interlace = body[12];
+
+			static const int channels[7] = { 1, 0, 3, 1, 2, 0, 4 };
+			bool ok = f.colorType <= 6 && channels[f.colorType] != 0 && body[10] == 0 && body[11] == 0 && interlace <= 1 &&
+				width > 0 && height > 0 && width <= 0x4000 && height <= 0x4000;
+
+			// depths each colour type can have
+			switch (f.colorType)
+			{
+			case 0: ok = ok && (f.bitDepth == 1 || f.bitDepth == 2 || f.bitDepth == 4 || f.bitDepth == 8 || f.bitDepth == 16); break;
+			case 3: ok = ok && (f.bitDepth == 1 || f.bitDepth == 2 || f.bitDepth == 4 || f.bitDepth == 8); break;
+			default: ok = ok && (f.bitDepth == 8 || f.bitDepth == 16); break;
+			}
+			if (!ok)
+				return Fail(error, "unsupported IHDR");
+
+			f.channels = channels[f.colorType];
+			haveHeader = true;
+		}
+		else if (memcmp(type, "PLTE", 4) == 0)
+		{
+			for (uint32_t i = 0; i < length / 3 && i < 256; i++)
+				f.palette[i] = body[i * 3] | (body[i * 3 + 1] << 8) | (body[i * 3 + 2] << 16) | 0xff000000;
+		}
+		else if (memcmp(type, "tRNS", 4) == 0)
+		{
+			if (f.colorType == 3)
+			{
+				for (uint32_t i = 0; i < length && i < 256; i++)
+					f.palette[i] = (f.palette[i] & 0x00ffffff) | ((uint32_t)body[i] << 24);
+			}
+			else if ((f.colorType == 0 && length >= 2) || (f.colorType == 2 && length >= 6))
+			{
+				f.hasKey = true;
+				for (int i = 0; i < (f.colorType == 0 ? 1 : 3); i++)
+					f.key[i] = (uint16_t)((body[i * 2] << 8) | body[i * 2 + 1]);
+			}
+		}
+		else if (memcmp(type, "IDAT", 4) == 0)
+		{
+			compressed.insert(compressed.end(), body, body + length);
+		}
+		else if (memcmp(type, "IEND", 4) == 0)
+		{
+			haveEnd = true;
+		}
+		else if (!(type[0] & 0x20))
+		{
+			// upper case first letter means we'd need to understand it
+			return Fail(error, "unknown critical chunk");
+		}
+
+		pos += length + 12;
+	}
+
+	if (!haveHeader || compressed.empty())
+		return Fail(error, "missing IHDR or IDAT");
+
+	int bitsPerPixel = f.channels * f.bitDepth;
+	int bpp = bitsPerPixel >= 8 ? bitsPerPixel / 8 : 1;
+
+	// work out the size of every pass, to check the data and reserve for it
+	int passes = interlace ? 7 : 1;
+	int passWidth[7], passHeight[7];
+	size_t rawSize = 0;
+	for (int p = 0; p < passes; p++)
+	{
+		if (interlace)
+		{
+			passWidth[p] = width > adam7X[p] ? (width - adam7X[p] + adam7DX[p] - 1) / adam7DX[p] : 0;
+			passHeight[p] = height > adam7Y[p] ? (height - adam7Y[p] + adam7DY[p] - 1) / adam7DY[p] : 0;
+		}
+		else
+		{
+			passWidth[p] = width;
+			passHeight[p] = height;
+		}
+		if (passWidth[p] && passHeight[p])
+			rawSize += passHeight[p] * (1 + ((size_t)passWidth[p] * bitsPerPixel + 7) / 8);
+	}
+
+	std::vector<uint8_t> raw;
+	if (!Zlib::Inflate(compressed.data(), compressed.size(), raw, rawSize))
+		return Fail(error, "image data is broken");
+	if (raw.size() < rawSize)
+		return Fail(error, "image data is short");
+
+	image.Resize(width, height);
+
+	uint8_t* p = raw.data();
+	std::vector<uint8_t> zeros;
+	for (int pass = 0; pass < passes; pass++)
+	{
+		int w = passWidth[pass];
+		int h = passHeight[pass];
+		if (w == 0 || h == 0)
+			continue;
+
+		size_t rowBytes = ((size_t)w * bitsPerPixel + 7) / 8;
+		zeros.assign(rowBytes, 0);
+		const uint8_t* prev = zeros.data();
+
+		int x0 = interlace ? adam7X[pass] : 0;
+		int y0 = interlace ? adam7Y[pass] : 0;
+		int dx = interlace ? adam7DX[pass] : 1;
+		int dy = interlace ? adam7DY[pass] : 1;
+
+		for (int y = 0; y < h; y++)
+		{
+			uint8_t* row = p + 1;
+			if (!UnfilterRow(p[0], row, prev, rowBytes, bpp, level))
+				return Fail(error, "bad filter type");
+
+			uint32_t* out = image.Row(y0 + y * dy) + x0;
+			ConvertRow(row, w, f, out, dx, level);
+
+			// while the row's still in cache. interlaced rows are spread out, they're done at the end
+			if (premultiply && !interlace)
+				PremultiplyRow(out, w, level);
+
+			prev = row;
+			p += rowBytes + 1;
+		}
+	}
+
+	if (premultiply && interlace)
+		PremultiplyRow(image.pixels.data(), image.pixels.size(), level);
+
+	return true;
+}
+
+// -----------------------------------------------------
+// Read a file and decode it
+//
+bool PngCodec::Load(const char* fileName, ImageRGBA& image, std::string* error, bool premultiply)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (file == nullptr)
+		return Fail(error, "can't open the file");
+
+	std::vector<uint8_t> data;
+	uint8_t buffer[65536];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + n);
+	}
+	fclose(file);
+
+	return Decode(data.data(), data.size(), image, error, premultiply);
+}
+
+// -----------------------------------------------------
+// Encode, RGBA 8 bit, filter picked per row
+//
+static void PutChunk(std::vector<uint8_t>& out, const char* type, const uint8_t* body, size_t length)
+{
+	PutU32(out, (uint32_t)length);
+	size_t start = out.size();
+	out.insert(out.end(), type, type + 4);
+	out.insert(out.end(), body, body + length);
+	PutU32(out, Zlib::Crc32(out.data() + start, length + 4));
+}
+
+void PngCodec::Encode(const ImageRGBA& image, std::vector<uint8_t>& out)
+{
+	out.insert(out.end(), signature, signature + 8);
+
+	uint8_t header[13];
+	std::vector<uint8_t> h;
+	PutU32(h, image.width);
+	PutU32(h, image.height);
+	memcpy(header, h.data(), 8);
+	header[8] = 8;		// bit depth
+	header[9] = 6;		// RGBA
+	header[10] = 0;
+	header[11] = 0;
+	header[12] = 0;		// not interlaced
+	PutChunk(out, "IHDR", header, 13);
+
+	// filter each row whichever way gives the smallest bytes, a rough guess at what compresses best
+	size_t rowBytes = (size_t)image.width * 4;
+	std::vector<uint8_t> raw;
+	raw.reserve((rowBytes + 1) * image.height);
+	std::vector<uint8_t> zeros(rowBytes, 0);
+	std::vector<uint8_t> candidate(rowBytes), best(rowBytes);
+
+	for (int y = 0; y < image.height; y++)
+	{
+		const uint8_t* row = (const uint8_t*)image.Row(y);
+		const uint8_t* prev = y > 0 ? (const uint8_t*)image.Row(y - 1) : zeros.data();
+
+		int bestFilter = 0;
+		uint64_t bestScore = ~0ull;
+		for (int filter = 0; filter < 5; filter++)
+		{
+			for (size_t i = 0; i < rowBytes; i++)
+			{
+				int a = i >= 4 ? row[i - 4] : 0;
+				int b = prev[i];
+				int c = i >= 4 ? prev[i - 4] : 0;
+				int predict = 0;
+				switch (filter)
+				{
+				case 1: predict = a; break;
+				case 2: predict = b; break;
+				case 3: predict = (a + b) >> 1; break;
+				case 4:
+				{
+					int p = a + b - c;
+					int pa = p > a ? p - a : a - p;
+					int pb = p > b ? p - b : b - p;
+					int pc = p > c ? p - c : c - p;
+					predict = (pa <= pb && pa <= pc) ? a : (pb <= pc ? b : c);
+					break;
+				}
+				}
+				candidate[i] = (uint8_t)(row[i] - predict);
+			}
+
+			uint64_t score = 0;
+			for (size_t i = 0; i < rowBytes; i++)
+				score += candidate[i] < 128 ? candidate[i] : 256 - candidate[i];
+
+			if (score < bestScore)
+			{
+				bestScore = score;
+				bestFilter = filter;
+				best.swap(candidate);
+			}
+		}
+
+		raw.push_back((uint8_t)bestFilter);
+		raw.insert(raw.end(), best.begin(), best.end());
+	}
+
+	std::vector<uint8_t> compressed;
+	Zlib::Deflate(raw.data(), raw.size(), compressed);
+	PutChunk(out, "IDAT", compressed.data(), compressed.size());
+	PutChunk(out, "IEND", nullptr, 0);
+}
+
+// -----------------------------------------------------
+// Encode and write
+//
+bool PngCodec::Save(const char* fileName, const ImageRGBA& image)
+{
+	std::vector<uint8_t> data;
+	Encode(image, data);
+
+	FILE* file = fopen(fileName, "wb");
+	if (file == nullptr)
+		return false;
+
+	bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+	fclose(file);
+	return written;
+}
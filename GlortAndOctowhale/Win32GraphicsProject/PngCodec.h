@@ -0,0 +1,70 @@
+//
+// PngCodec
+//		Reads and writes PNG files without WIC or libpng, so tools can use it anywhere
+//
+//	Decoding handles every PNG colour type and bit depth, interlaced or not, and
+//	always gives 8 bit RGBA, optionally with the colour premultiplied by alpha. Encoding
+//	always writes 8 bit RGBA.
+//
+//	Rows of 3 and 4 byte pixels are unfiltered with SSE2, AVX2 for the Up filter and the
+//	RGB to RGBA expand, picked at runtime. Every level gives exactly the same pixels.
+//
+
+#ifndef _PNG_CODEC_H
+#define _PNG_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+// an image in memory, rows top to bottom
+struct ImageRGBA
+{
+	int						width;
+	int						height;
+	std::vector<uint32_t>	pixels;		// red in the low byte, like TextureType::Create wants
+
+	ImageRGBA() : width(0), height(0) {}
+
+	// a blank (transparent black) image
+	void Resize(int w, int h) { width = w; height = h; pixels.assign((size_t)w * h, 0); }
+
+	uint32_t* Row(int y) { return pixels.data() + (size_t)y * width; }
+	const uint32_t* Row(int y) const { return pixels.data() + (size_t)y * width; }
+};
+
+class PngCodec
+{
+public:
+	// instruction sets the decoder can use
+	enum SimdLevel
+	{
+		SimdScalar,
+		SimdSSE2,
+		SimdAVX2
+	};
+
+	// the best level this cpu supports
+	static SimdLevel GetSimdLevel();
+
+	// decode a PNG in memory. if it fails and error isn't null, it says why
+	static bool Decode(const uint8_t* data, size_t size, ImageRGBA& image, std::string* error = nullptr, bool premultiply = false);
+
+	// same, at a given level (clamped to what the cpu supports), for testing and benchmarks
+	static bool Decode(const uint8_t* data, size_t size, ImageRGBA& image, std::string* error, bool premultiply, SimdLevel level);
+
+	// read and decode a file
+	static bool Load(const char* fileName, ImageRGBA& image, std::string* error = nullptr, bool premultiply = false);
+
+	// multiply the colour by alpha, rounded, for drawing with premultiplied blending
+	static void Premultiply(ImageRGBA& image);
+
+	// encode as an RGBA PNG, appending to out
+	static void Encode(const ImageRGBA& image, std::vector<uint8_t>& out);
+
+	// encode and write a file
+	static bool Save(const char* fileName, const ImageRGBA& image);
+};
+
+#endif // _PNG_CODEC_H
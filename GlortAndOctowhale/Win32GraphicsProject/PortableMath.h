@@ -0,0 +1,79 @@
+//
+// PortableMath
+//		Stand-in for the parts of DirectXTK's SimpleMath we use, for builds without the
+//		Windows SDK (the Linux benchmarks and tools). Windows builds use the real SimpleMath.
+//
+
+#ifndef _PORTABLE_MATH_H
+#define _PORTABLE_MATH_H
+
+#include <math.h>
+
+namespace DirectX
+{
+	namespace SimpleMath
+	{
+		struct Vector2
+		{
+			float x;
+			float y;
+
+			Vector2() : x(0.0f), y(0.0f) {}
+			Vector2(float _x, float _y) : x(_x), y(_y) {}
+			explicit Vector2(float v) : x(v), y(v) {}
+
+			Vector2 operator+(const Vector2& v) const { return Vector2(x + v.x, y + v.y); }
+			Vector2 operator-(const Vector2& v) const { return Vector2(x - v.x, y - v.y); }
+			Vector2 operator*(const Vector2& v) const { return Vector2(x * v.x, y * v.y); }
+			Vector2 operator*(float s) const { return Vector2(x * s, y * s); }
+			Vector2 operator/(float s) const { return Vector2(x / s, y / s); }
+			Vector2 operator-() const { return Vector2(-x, -y); }
+
+			Vector2& operator+=(const Vector2& v) { x += v.x; y += v.y; return *this; }
+			Vector2& operator-=(const Vector2& v) { x -= v.x; y -= v.y; return *this; }
+			Vector2& operator*=(float s) { x *= s; y *= s; return *this; }
+			Vector2& operator/=(float s) { x /= s; y /= s; return *this; }
+
+			bool operator==(const Vector2& v) const { return x == v.x && y == v.y; }
+			bool operator!=(const Vector2& v) const { return x != v.x || y != v.y; }
+
+			float Length() const { return sqrtf(x * x + y * y); }
+			float LengthSquared() const { return x * x + y * y; }
+			float Dot(const Vector2& v) const { return x * v.x + y * v.y; }
+
+			void Normalize()
+			{
+				float len = Length();
+				if (len > 0.0f)
+				{
+					x /= len;
+					y /= len;
+				}
+			}
+
+			static float Distance(const Vector2& a, const Vector2& b) { return (a - b).Length(); }
+			static float DistanceSquared(const Vector2& a, const Vector2& b) { return (a - b).LengthSquared(); }
+
+			static Vector2 Min(const Vector2& a, const Vector2& b) { return Vector2(fminf(a.x, b.x), fminf(a.y, b.y)); }
+			static Vector2 Max(const Vector2& a, const Vector2& b) { return Vector2(fmaxf(a.x, b.x), fmaxf(a.y, b.y)); }
+
+			// reflect v about the normal n
+			static void Reflect(const Vector2& v, const Vector2& n, Vector2& result) { result = v - n * (2.0f * v.Dot(n)); }
+			static Vector2 Reflect(const Vector2& v, const Vector2& n) { return v - n * (2.0f * v.Dot(n)); }
+
+			static const Vector2 Zero;
+			static const Vector2 One;
+			static const Vector2 UnitX;
+			static const Vector2 UnitY;
+		};
+
+		inline Vector2 operator*(float s, const Vector2& v) { return Vector2(v.x * s, v.y * s); }
+
+		inline const Vector2 Vector2::Zero(0.0f, 0.0f);
+		inline const Vector2 Vector2::One(1.0f, 1.0f);
+		inline const Vector2 Vector2::UnitX(1.0f, 0.0f);
+		inline const Vector2 Vector2::UnitY(0.0f, 1.0f);
+	}
+}
+
+#endif // _PORTABLE_MATH_H
@@ -0,0 +1,267 @@
+//
+// RenderQueue
+//		Records the frame's sprite draws, sorts them, and hands them to a backend
+//
+
+#include "RenderQueue.h"
+#include <stdio.h>
+#include <string.h>
+
+// -----------------------------------------------------
+// Colour packing
+//
+static uint32_t PackChannel(float v)
+{
+	if (v <= 0.0f) return 0;
+	if (v >= 1.0f) return 255;
+	return (uint32_t)(v * 255.0f + 0.5f);
+}
+
+uint32_t DrawCommand::PackColor(float r, float g, float b, float a)
+{
+	return PackChannel(r) | (PackChannel(g) << 8) | (PackChannel(b) << 16) | (PackChannel(a) << 24);
+}
+
+void DrawCommand::UnpackColor(uint32_t color, float& r, float& g, float& b, float& a)
+{
+	const float toFloat = 1.0f / 255.0f;
+	r = (color & 0xff) * toFloat;
+	g = ((color >> 8) & 0xff) * toFloat;
+	b = ((color >> 16) & 0xff) * toFloat;
+	a = (color >> 24) * toFloat;
+}
+
+// -----------------------------------------------------
+// Constructor
+//
+RenderQueue::RenderQueue()
+{
+}
+
+// -----------------------------------------------------
+// Start a new frame
+//
+void RenderQueue::Clear()
+{
+	commands.clear();
+	order.clear();
+	textures.clear();
+	runs.clear();
+}
+
+// -----------------------------------------------------
+// Texture ids, there are only ever a handful of textures in a frame
+//
+uint32_t RenderQueue::TextureId(ID3D11ShaderResourceView* texture)
+{
+	// most draws use the same texture as the one before
+	if (!textures.empty() && textures.back() == texture)
+		return (uint32_t)textures.size() - 1;
+
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		if (textures[i] == texture)
+			return (uint32_t)i;
+	}
+
+	textures.push_back(texture);
+	return (uint32_t)textures.size() - 1;
+}
+
+// -----------------------------------------------------
+// Sort key, high to low: layer (back first), blend, texture, then 16 bits of nothing
+//
+uint64_t RenderQueue::MakeKey(ID3D11ShaderResourceView* texture, float layer, BlendMode blend)
+{
+	if (layer < 0.0f) layer = 0.0f;
+	if (layer > 1.0f) layer = 1.0f;
+	uint64_t depth = (uint64_t)((1.0f - layer) * 65535.0f + 0.5f);
+
+	uint64_t id = TextureId(texture) & 0xffffff;
+
+	return (depth << DrawCommand::LayerShift) |
+		((uint64_t)(blend & 0xff) << DrawCommand::BlendShift) |
+		(id << DrawCommand::TextureShift);
+}
+
+// -----------------------------------------------------
+// Keep track of runs of the same key
+//
+void RenderQueue::AddToRun(uint64_t key, uint32_t first, uint32_t count)
+{
+	if (count == 0)
+		return;
+
+	if (!runs.empty() && runs.back().key == key)
+	{
+		runs.back().count += count;
+		return;
+	}
+
+	Run run = { key, first, count };
+	runs.push_back(run);
+}
+
+// -----------------------------------------------------
+// Add a draw
+//
+void RenderQueue::Submit(const DrawCommand& command, BlendMode blend)
+{
+	uint64_t key = MakeKey(command.texture, command.layer, blend);
+
+	commands.push_back(command);
+	commands.back().key = key;
+
+	// until it's sorted, the order is the order they came in
+	AddToRun(key, (uint32_t)order.size(), 1);
+	order.push_back((uint32_t)order.size());
+}
+
+// -----------------------------------------------------
+// Add a run of draws with the same state
+//
+DrawCommand* RenderQueue::Allocate(int count, ID3D11ShaderResourceView* texture, float layer, BlendMode blend)
+{
+	uint64_t key = MakeKey(texture, layer, blend);
+
+	// filling them in as they're made saves going over them all a second time
+	DrawCommand command = {};
+	command.key = key;
+	command.texture = texture;
+	command.layer = layer;
+
+	size_t first = commands.size();
+	commands.resize(first + count, command);
+	order.resize(first + count);
+
+	for (int i = 0; i < count; i++)
+	{
+		order[first + i] = (uint32_t)(first + i);
+	}
+	AddToRun(key, (uint32_t)first, (uint32_t)count);
+
+	return count > 0 ? &commands[first] : nullptr;
+}
+
+// -----------------------------------------------------
+// LSD radix sort on the runs' keys, a byte at a time
+//	it's stable, and any byte that's the same in every key is skipped, which is most
+//	of them (the bottom 2 are always 0, and there are only a few layers and textures).
+//	the sorted runs are then written out into the order a command at a time
+//
+void RenderQueue::Sort()
+{
+	int count = (int)runs.size();
+
+	// stable, so runs already in order would come out where they are. the order is
+	//	either how they came in or what the last sort made of the same runs, so it's right
+	bool inOrder = true;
+	for (int i = 1; i < count && inOrder; i++)
+	{
+		inOrder = runs[i - 1].key <= runs[i].key;
+	}
+	if (inOrder)
+		return;
+
+	sortKeys.resize(count);
+	sortKeysTemp.resize(count);
+	sortOrder.resize(count);
+	sortTemp.resize(count);
+
+	// count every byte of every key in one pass
+	static const int Passes = 8;
+	uint32_t histogram[Passes][256];
+	memset(histogram, 0, sizeof(histogram));
+
+	for (int i = 0; i < count; i++)
+	{
+		uint64_t key = runs[i].key;
+		sortKeys[i] = key;
+		sortOrder[i] = (uint32_t)i;
+
+		for (int p = 0; p < Passes; p++)
+		{
+			histogram[p][(key >> (p * 8)) & 0xff]++;
+		}
+	}
+
+	for (int p = 0; p < Passes; p++)
+	{
+		int shift = p * 8;
+
+		// everything has the same byte here, nothing would move
+		if (histogram[p][(sortKeys[0] >> shift) & 0xff] == (uint32_t)count)
+			continue;
+
+		// where each byte value starts
+		uint32_t offset = 0;
+		for (int b = 0; b < 256; b++)
+		{
+			uint32_t n = histogram[p][b];
+			histogram[p][b] = offset;
+			offset += n;
+		}
+
+		for (int i = 0; i < count; i++)
+		{
+			uint32_t dest = histogram[p][(sortKeys[i] >> shift) & 0xff]++;
+			sortKeysTemp[dest] = sortKeys[i];
+			sortTemp[dest] = sortOrder[i];
+		}
+
+		sortKeys.swap(sortKeysTemp);
+		sortOrder.swap(sortTemp);
+	}
+
+	// each run's commands, in the order they were added
+	uint32_t* out = order.data();
+	for (int i = 0; i < count; i++)
+	{
+		const Run& run = runs[sortOrder[i]];
+		for (uint32_t c = 0; c < run.count; c++)
+		{
+			*out++ = run.first + c;
+		}
+	}
+}
+
+// -----------------------------------------------------
+// How many times the state changes when drawing in order
+//
+int RenderQueue::CountStateChanges() const
+{
+	const uint64_t stateMask = ((uint64_t)0xff << DrawCommand::BlendShift) | ((uint64_t)0xffffff << DrawCommand::TextureShift);
+
+	int changes = 0;
+	for (int i = 0; i < GetCount(); i++)
+	{
+		if (i == 0 || (GetCommand(i).key & stateMask) != (GetCommand(i - 1).key & stateMask))
+			changes++;
+	}
+	return changes;
+}
+
+// -----------------------------------------------------
+// Write the commands out as text
+//
+bool RenderQueue::WriteCapture(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (file == nullptr)
+		return false;
+
+	fprintf(file, "# commands %d, state changes %d, textures %d\n", GetCount(), CountStateChanges(), (int)textures.size());
+	fprintf(file, "# index key texture blend left top right bottom x y originX originY rotation scale color layer\n");
+
+	for (int i = 0; i < GetCount(); i++)
+	{
+		const DrawCommand& c = GetCommand(i);
+		fprintf(file, "%d %016llx %u %d %d %d %d %d %.3f %.3f %.3f %.3f %.5f %.3f %08x %.5f\n",
+			i, (unsigned long long)c.key, (unsigned)((c.key >> DrawCommand::TextureShift) & 0xffffff), (int)c.GetBlend(),
+			c.srcLeft, c.srcTop, c.srcRight, c.srcBottom,
+			c.x, c.y, c.originX, c.originY, c.rotation, c.scale, c.color, c.layer);
+	}
+
+	fclose(file);
+	return true;
+}
@@ -0,0 +1,136 @@
+//
+// RenderQueue
+//		Records the frame's sprite draws, sorts them, and hands them to a backend
+//
+//	Sprites don't draw straight away, they add a small DrawCommand to the queue. Each
+//	command gets a 64 bit key (layer, then blend state, then texture) and the queue radix
+//	sorts on it, so draws come out back to front with everything that shares a blend state
+//	and texture together. Draws with the same key stay in the order they were added.
+//
+//	Draws added one after another with the same key (an Allocate, or a row of sprites from
+//	one texture) are kept as a run and sorted as one, so a frame of 100k particles sorts
+//	as a handful of runs. If the runs are already in key order, Sort does nothing.
+//
+//	The queue itself doesn't need D3D, so frames can be recorded, sorted and written out
+//	without a device (see WriteCapture), or drawn on the cpu with SoftwareFramebuffer.
+//
+
+#ifndef _RENDER_QUEUE_H
+#define _RENDER_QUEUE_H
+
+#include <stdint.h>
+#include <vector>
+
+// forward declares
+struct ID3D11ShaderResourceView;
+
+// how a draw is blended with what's already there
+enum BlendMode
+{
+	BlendNonPremultiplied,	// straight alpha, what WIC and DDS textures have
+	BlendAlpha,				// premultiplied alpha, cheaper. see TextureType::IsPremultiplied
+	BlendAdditive,
+	BlendOpaque,
+	BlendModeCount
+};
+
+// one sprite draw, 64 bytes
+struct DrawCommand
+{
+	uint64_t					key;		// filled in by the queue
+	ID3D11ShaderResourceView*	texture;
+
+	// source region in the texture
+	int32_t		srcLeft;
+	int32_t		srcTop;
+	int32_t		srcRight;
+	int32_t		srcBottom;
+
+	float		x, y;				// position
+	float		originX, originY;	// pivot, in texels
+	float		rotation;			// radians
+	float		scale;
+	uint32_t	color;				// RGBA, 8 bits each, red in the low byte
+	float		layer;				// 0 front to 1 back, like SpriteBatch's layerDepth
+
+	BlendMode GetBlend() const { return (BlendMode)((key >> BlendShift) & 0xff); }
+
+	// pack / unpack colour channels in 0..1
+	static uint32_t PackColor(float r, float g, float b, float a);
+	static void UnpackColor(uint32_t color, float& r, float& g, float& b, float& a);
+
+	// where each part of the key goes
+	static const int LayerShift = 48;
+	static const int BlendShift = 40;
+	static const int TextureShift = 16;
+};
+
+class RenderQueue
+{
+public:
+	RenderQueue();
+
+	// start a new frame, throws the old commands away (the memory is kept)
+	void Clear();
+
+	// add a draw. everything but the key should be filled in
+	void Submit(const DrawCommand& command, BlendMode blend = BlendNonPremultiplied);
+
+	// add count draws that share a texture, layer and blend state, for the caller to fill in
+	//	everything but the key, texture and layer. the pointer is good until the next Submit / Allocate
+	DrawCommand* Allocate(int count, ID3D11ShaderResourceView* texture, float layer, BlendMode blend = BlendNonPremultiplied);
+
+	// sort the commands by key
+	void Sort();
+
+	// commands in sorted order (or the order they were added if Sort hasn't been called)
+	int GetCount() const { return (int)commands.size(); }
+	const DrawCommand& GetCommand(int i) const { return commands[order[i]]; }
+
+	// number of times the texture or blend state changes going through the commands in order
+	int CountStateChanges() const;
+
+	// write the commands out as text, one per line. returns false if the file can't be written
+	bool WriteCapture(const char* fileName) const;
+
+private:
+	// small number for a texture, in the order they were first seen this frame
+	uint32_t TextureId(ID3D11ShaderResourceView* texture);
+
+	// the sort key for a draw
+	uint64_t MakeKey(ID3D11ShaderResourceView* texture, float layer, BlendMode blend);
+
+	std::vector<DrawCommand>				commands;
+	std::vector<uint32_t>					order;		// sorted index into commands
+	std::vector<ID3D11ShaderResourceView*>	textures;	// index is the texture id
+
+	// commands added one after another with the same key, in the order they were added
+	struct Run
+	{
+		uint64_t	key;
+		uint32_t	first;
+		uint32_t	count;
+	};
+	std::vector<Run>						runs;
+
+	// start a new run for key, or add count to the last one if it has the same key
+	void AddToRun(uint64_t key, uint32_t first, uint32_t count);
+
+	// scratch space for the sort, indexed by run
+	std::vector<uint64_t>					sortKeys;
+	std::vector<uint64_t>					sortKeysTemp;
+	std::vector<uint32_t>					sortOrder;
+	std::vector<uint32_t>					sortTemp;
+};
+
+// something that can draw a sorted queue
+class RenderBackend
+{
+public:
+	virtual ~RenderBackend() {}
+
+	// draw the queue's commands in order
+	virtual void Execute(const RenderQueue& queue) = 0;
+};
+
+#endif // _RENDER_QUEUE_H
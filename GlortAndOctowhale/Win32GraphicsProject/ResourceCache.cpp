@@ -0,0 +1,317 @@
+//
+// ResourceCache
+//		Loads each texture and font once, and hands the same one to everyone who asks
+//
+
+#include "ResourceCache.h"
+#include "TextureType.h"
+#include "Font.h"
+#include "TextureAtlas.h"
+#include "AssetPack.h"
+#include <sstream>
+#include <wctype.h>
+
+// -----------------------------------------------------
+// Constructor
+//
+ResourceCache::ResourceCache()
+{
+	pDevice = nullptr;
+	pContext = nullptr;
+	pLoader = nullptr;
+
+	stats.hits = 0;
+	stats.misses = 0;
+	stats.failures = 0;
+	stats.textures = 0;
+	stats.fonts = 0;
+	stats.textureBytes = 0;
+}
+
+ResourceCache::~ResourceCache()
+{
+	// everything's going, so the regions don't need to let go of their pages
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		entries[i].pPage = nullptr;
+	}
+
+	while (!entries.empty())
+	{
+		Remove(entries.size() - 1);
+	}
+}
+
+void ResourceCache::Initialize(ID3D11Device* pD, ID3D11DeviceContext* pC, AssetLoader* pL)
+{
+	pDevice = pD;
+	pContext = pC;
+	pLoader = pL;
+}
+
+// -----------------------------------------------------
+// Same file, same key
+//
+std::wstring ResourceCache::MakeKey(const wchar_t* fileName)
+{
+	std::wstring key = fileName;
+	for (size_t i = 0; i < key.size(); i++)
+	{
+		key[i] = key[i] == L'/' ? L'\\' : (wchar_t)towlower(key[i]);
+	}
+	return key;
+}
+
+std::wstring ResourceCache::FindCooked(const wchar_t* fileName)
+{
+	std::wstring path = fileName;
+	size_t dot = path.find_last_of(L'.');
+	if (dot == std::wstring::npos || MakeKey(path.substr(dot).c_str()) != L".png" || TextureType::GetKeepPixels())
+		return path;
+
+	std::wstring cooked = path.substr(0, dot) + L".dds";
+	const AssetPack* pPack = AssetPack::GetMounted();
+	if (pPack && pPack->Find(cooked.c_str()))
+		return cooked;
+	return GetFileAttributesW(cooked.c_str()) != INVALID_FILE_ATTRIBUTES ? cooked : path;
+}
+
+const ResourceCache::AtlasEntry* ResourceCache::FindRegion(const std::wstring& key) const
+{
+	for (size_t i = 0; i < atlasRegions.size(); i++)
+	{
+		if (atlasRegions[i].key == key)
+			return &atlasRegions[i];
+	}
+	return nullptr;
+}
+
+ResourceCache::Entry* ResourceCache::Find(const std::wstring& key, bool font)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].key == key && (entries[i].pFont != nullptr) == font)
+			return &entries[i];
+	}
+	return nullptr;
+}
+
+void ResourceCache::Remove(size_t i)
+{
+	Entry& entry = entries[i];
+	TextureType* pPage = entry.pPage;
+
+	if (entry.pTexture)
+	{
+		stats.textures--;
+		delete entry.pTexture;
+	}
+	if (entry.pFont)
+	{
+		stats.fonts--;
+		delete entry.pFont;
+	}
+
+	entries[i] = entries.back();
+	entries.pop_back();
+
+	// last, it can remove another entry
+	if (pPage)
+		ReleaseTexture(pPage);
+}
+
+// -----------------------------------------------------
+// Atlas
+//
+bool ResourceCache::LoadAtlas(const wchar_t* manifestFileName)
+{
+	// the paths are all plain ASCII
+	std::wstring manifest = manifestFileName;
+	std::string narrow(manifest.begin(), manifest.end());
+
+	TextureAtlas atlas;
+	AssetData file;
+	if (!AssetPack::ReadFile(narrow.c_str(), file))
+	{
+		OutputDebugStringA(("ResourceCache: can't open " + narrow + "\n").c_str());
+		return false;
+	}
+	if (!atlas.Parse((const char*)file.data, file.size))
+	{
+		OutputDebugStringA(("ResourceCache: " + atlas.GetError() + "\n").c_str());
+		return false;
+	}
+
+	// the pages and packed files are next to the manifest
+	std::wstring directory = manifest.substr(0, manifest.find_last_of(L"\\/") + 1);
+
+	for (int i = 0; i < atlas.GetRegionCount(); i++)
+	{
+		const AtlasRegion& r = atlas.GetRegion(i);
+		const std::string& page = atlas.GetPage(r.page).fileName;
+
+		AtlasEntry entry;
+		entry.key = MakeKey((directory + std::wstring(r.name.begin(), r.name.end())).c_str());
+		entry.pageFile = directory + std::wstring(page.begin(), page.end());
+		entry.left = r.x;
+		entry.top = r.y;
+		entry.width = r.width;
+		entry.height = r.height;
+		atlasRegions.push_back(entry);
+	}
+
+	return true;
+}
+
+// -----------------------------------------------------
+// Textures
+//
+TextureType* ResourceCache::AcquireTexture(const wchar_t* fileName)
+{
+	std::wstring key = MakeKey(fileName);
+
+	Entry* pEntry = Find(key, false);
+	if (pEntry)
+	{
+		stats.hits++;
+		pEntry->references++;
+		return pEntry->pTexture;
+	}
+
+	stats.misses++;
+
+	Entry entry;
+	entry.key = key;
+	entry.pTexture = new TextureType;
+	entry.pFont = nullptr;
+	entry.pPage = nullptr;
+	entry.references = 1;
+
+	// packed into the atlas, share its page
+	const AtlasEntry* pRegion = FindRegion(key);
+	if (pRegion)
+	{
+		entry.pPage = AcquireTexture(pRegion->pageFile.c_str());
+		if (!entry.pTexture->CreateRegion(*entry.pPage, pRegion->left, pRegion->top, pRegion->width, pRegion->height))
+		{
+			// no page, so try the file on its own
+			ReleaseTexture(entry.pPage);
+			entry.pPage = nullptr;
+		}
+	}
+
+	// a failed load still goes in, so it's only tried once and everyone gets the same empty texture
+	//	async loads can't fail here, the texture reports it when it's first used. LoadAsync
+	//	loads a cooked .dds straight away, there's nothing to decode
+	if (entry.pPage == nullptr && !LoadTexture(*entry.pTexture, FindCooked(fileName)))
+	{
+		stats.failures++;
+		OutputDebugStringW((std::wstring(L"ResourceCache: can't load ") + fileName + L"\n").c_str());
+	}
+
+	stats.textures++;
+
+	entries.push_back(entry);
+	return entry.pTexture;
+}
+
+bool ResourceCache::LoadTexture(TextureType& texture, const std::wstring& fileName)
+{
+	// the mounted pack if it has it, the loose file if not
+	const AssetPack* pPack = AssetPack::GetMounted();
+	if (pPack && pPack->Find(fileName.c_str()))
+	{
+		return pLoader ? texture.LoadAsync(pDevice, *pLoader, *pPack, fileName.c_str()) : texture.Load(pDevice, *pPack, fileName.c_str());
+	}
+
+	return pLoader ? texture.LoadAsync(pDevice, *pLoader, fileName.c_str()) : texture.Load(pDevice, fileName.c_str());
+}
+
+void ResourceCache::ReleaseTexture(TextureType* pTexture)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].pTexture == pTexture && pTexture != nullptr)
+		{
+			if (--entries[i].references <= 0)
+				Remove(i);
+			return;
+		}
+	}
+}
+
+// -----------------------------------------------------
+// Fonts
+//
+FontType* ResourceCache::AcquireFont(const wchar_t* fileName)
+{
+	std::wstring key = MakeKey(fileName);
+
+	Entry* pEntry = Find(key, true);
+	if (pEntry)
+	{
+		stats.hits++;
+		pEntry->references++;
+		return pEntry->pFont;
+	}
+
+	stats.misses++;
+
+	Entry entry;
+	entry.key = key;
+	entry.pTexture = nullptr;
+	entry.pPage = nullptr;
+
+	// straight out of the pack's mapping, unless it was compressed
+	const AssetPack* pPack = AssetPack::GetMounted();
+	const PackEntry* pPacked = pPack ? pPack->Find(fileName) : nullptr;
+	AssetData data;
+	if (pPacked && pPack->Read(*pPacked, data))
+		entry.pFont = new FontType(pDevice, pContext, data.data, data.size);
+	else
+		entry.pFont = new FontType(pDevice, pContext, fileName);
+	entry.references = 1;
+	stats.fonts++;
+
+	entries.push_back(entry);
+	return entry.pFont;
+}
+
+void ResourceCache::ReleaseFont(FontType* pFont)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].pFont == pFont && pFont != nullptr)
+		{
+			if (--entries[i].references <= 0)
+				Remove(i);
+			return;
+		}
+	}
+}
+
+// -----------------------------------------------------
+// Report
+//
+ResourceCache::Stats ResourceCache::GetStats() const
+{
+	// textures loading in the background don't know their size until they're used
+	Stats current = stats;
+	current.textureBytes = 0;
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		if (entries[i].pTexture)
+			current.textureBytes += entries[i].pTexture->GetByteSize();
+	}
+	return current;
+}
+
+void ResourceCache::LogStats() const
+{
+	Stats current = GetStats();
+
+	std::wostringstream text;
+	text << L"ResourceCache: " << current.hits << L" hits, " << current.misses << L" misses (" << current.failures << L" failed), "
+		<< current.textures << L" textures (" << current.textureBytes / 1024 << L" KB), " << current.fonts << L" fonts\n";
+	OutputDebugStringW(text.str().c_str());
+}
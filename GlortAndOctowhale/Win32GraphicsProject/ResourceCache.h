@@ -0,0 +1,127 @@
+//
+// ResourceCache
+//		Loads each texture and font once, and hands the same one to everyone who asks
+//
+//	Resources are keyed by their path (case and slash direction don't matter) and
+//	reference counted. Asking for something already resident is a hit and does no disk
+//	I/O; the resource is unloaded when the last reference is released.
+//
+//	With an atlas loaded (see Tools\AtlasPacker), asking for a file that was packed into
+//	it gets a region of the atlas page instead, so everything on the page shares one
+//	D3D texture and SpriteBatch can draw it all in one go.
+//
+//	A PNG that's been cooked (see Tools\TextureCook) is loaded from the .dds next to it
+//	instead, block compressed and with nothing to decode. The .dds isn't checked against
+//	the PNG, so anything re-packed or edited has to be cooked again.
+//
+//	With an AssetPack mounted, textures, fonts and the atlas manifest are read from it
+//	when it has them, and from loose files when it doesn't.
+//
+
+#ifndef _RESOURCE_CACHE_H
+#define _RESOURCE_CACHE_H
+
+#include <string>
+#include <vector>
+#include <d3d11.h>
+
+// forward declares
+class TextureType;
+class FontType;
+class AssetLoader;
+
+class ResourceCache
+{
+public:
+	// what the cache has done so far
+	struct Stats
+	{
+		int		hits;			// acquires that found it resident
+		int		misses;			// acquires that had to load it
+		int		failures;		// misses that couldn't be loaded
+		int		textures;		// resident now
+		int		fonts;
+		size_t	textureBytes;	// video memory the resident textures take, roughly. not
+								//	counting ones still loading
+	};
+
+	ResourceCache();
+
+	// unloads everything, whether it was released or not
+	~ResourceCache();
+
+	// the device and context to load with, before anything is acquired. with a loader,
+	//	PNGs are read and decoded on its threads and made into textures when first used
+	void Initialize(ID3D11Device* pDevice, ID3D11DeviceContext* pContext, AssetLoader* pLoader = nullptr);
+
+	// use an atlas manifest for the textures acquired after this. the regions are found by
+	//	file name next to the manifest. false if the manifest can't be read
+	bool LoadAtlas(const wchar_t* manifestFileName);
+
+	// get the texture for a file, loading it if it isn't resident. never null: if the file
+	//	can't be loaded you get an empty texture, like a failed TextureType::Load
+	//	every Acquire needs a Release
+	TextureType* AcquireTexture(const wchar_t* fileName);
+	void ReleaseTexture(TextureType* pTexture);
+
+	// same for fonts
+	FontType* AcquireFont(const wchar_t* fileName);
+	void ReleaseFont(FontType* pFont);
+
+	Stats GetStats() const;
+
+	// write the stats to the debugger output
+	void LogStats() const;
+
+private:
+	struct Entry
+	{
+		std::wstring	key;
+		TextureType*	pTexture;	// one of these is set
+		FontType*		pFont;
+		TextureType*	pPage;		// the atlas page a region holds a reference to
+		int				references;
+	};
+
+	// a file that's been packed into an atlas
+	struct AtlasEntry
+	{
+		std::wstring	key;		// what the file's key would be
+		std::wstring	pageFile;
+		int				left, top, width, height;
+	};
+
+	// the cooked .dds for a PNG if there is one, otherwise the file itself. always the PNG
+	//	while textures keep their pixels, a .dds doesn't give any (see TextureType::SetKeepPixels)
+	static std::wstring FindCooked(const wchar_t* fileName);
+
+	// load a texture from the mounted pack or the disk, on the loader if there is one
+	bool LoadTexture(TextureType& texture, const std::wstring& fileName);
+
+	// lower case with backslashes, so the same file is always the same key
+	static std::wstring MakeKey(const wchar_t* fileName);
+
+	// the entry for a key, null if it isn't resident
+	Entry* Find(const std::wstring& key, bool font);
+
+	// the atlas region for a key, null if it wasn't packed
+	const AtlasEntry* FindRegion(const std::wstring& key) const;
+
+	// unload and forget entry i
+	void Remove(size_t i);
+
+	ID3D11Device*			pDevice;
+	ID3D11DeviceContext*	pContext;
+	AssetLoader*			pLoader;
+
+	// there are only a few dozen resources, so a list is fine
+	std::vector<Entry>		entries;
+	std::vector<AtlasEntry>	atlasRegions;
+	Stats					stats;
+
+	// no copying, the entries own what they point at
+	ResourceCache(const ResourceCache&);
+	ResourceCache& operator=(const ResourceCache&);
+};
+
+#endif // _RESOURCE_CACHE_H
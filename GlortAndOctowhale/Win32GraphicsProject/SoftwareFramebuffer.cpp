@@ -0,0 +1,780 @@
+//
+// SoftwareFramebuffer
+//		Draws a RenderQueue into pixels in memory, no GPU or device needed
+//
+
+#include "SoftwareFramebuffer.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define RASTER_X86 1
+#include <emmintrin.h>	// SSE2
+#include <immintrin.h>	// AVX2
+#ifdef _MSC_VER
+#include <intrin.h>		// __cpuid
+#endif
+#endif
+
+// the AVX2 kernels are compiled for AVX2 even if the rest of the file isn't
+#if defined(RASTER_X86) && (defined(__GNUC__) || defined(__clang__))
+#define RASTER_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define RASTER_TARGET_AVX2
+#endif
+
+// -----------------------------------------------------
+// Work out the best instruction set we can use
+//
+static SoftwareFramebuffer::SimdLevel DetectSimdLevel()
+{
+#if defined(RASTER_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	int maxLeaf = info[0];
+
+	__cpuid(info, 1);
+	bool sse2 = (info[3] & (1 << 26)) != 0;
+	bool osSavesAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6) == 6;
+
+	bool avx2 = false;
+	if (maxLeaf >= 7 && osSavesAvx)
+	{
+		__cpuidex(info, 7, 0);
+		avx2 = (info[1] & (1 << 5)) != 0;
+	}
+
+	if (avx2)
+		return SoftwareFramebuffer::SimdAVX2;
+	if (sse2)
+		return SoftwareFramebuffer::SimdSSE2;
+	return SoftwareFramebuffer::SimdScalar;
+#elif defined(RASTER_X86)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return SoftwareFramebuffer::SimdAVX2;
+	if (__builtin_cpu_supports("sse2"))
+		return SoftwareFramebuffer::SimdSSE2;
+	return SoftwareFramebuffer::SimdScalar;
+#else
+	return SoftwareFramebuffer::SimdScalar;
+#endif
+}
+
+SoftwareFramebuffer::SimdLevel SoftwareFramebuffer::GetSimdLevel()
+{
+	static SimdLevel level = DetectSimdLevel();
+	return level;
+}
+
+// -----------------------------------------------------
+// Blending a span of pixels
+//	every channel is tinted, then out = src * srcFactor + dst * dstFactor, with the
+//	factors CommonStates gives each blend state:
+//		NonPremultiplied	alpha, 1 - alpha
+//		Alpha				1, 1 - alpha
+//		Additive			alpha, 1
+//		Opaque				1, 0
+//	alpha is the tinted source's. x * y / 255 is rounded the same way PngCodec
+//	premultiplies, t = x * y + 128, (t + (t >> 8)) >> 8, which is exact, so a white tint
+//	leaves texels as they are. sums over 255 saturate
+//
+static inline uint32_t Mul255(uint32_t x, uint32_t y)
+{
+	uint32_t t = x * y + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+template <int Blend>
+static inline uint32_t BlendPixel(uint32_t src, uint32_t dst, uint32_t color)
+{
+	uint32_t s[4];
+	for (int c = 0; c < 4; c++)
+	{
+		s[c] = Mul255((src >> (c * 8)) & 0xff, (color >> (c * 8)) & 0xff);
+	}
+	uint32_t a = s[3];
+
+	uint32_t out = 0;
+	for (int c = 0; c < 4; c++)
+	{
+		uint32_t d = (dst >> (c * 8)) & 0xff;
+		uint32_t v;
+		switch (Blend)
+		{
+		case BlendNonPremultiplied:	v = Mul255(s[c], a) + Mul255(d, 255 - a); break;
+		case BlendAlpha:			v = s[c] + Mul255(d, 255 - a); break;
+		case BlendAdditive:			v = Mul255(s[c], a) + d; break;
+		default:					v = s[c]; break;
+		}
+		out |= (v < 255 ? v : 255) << (c * 8);
+	}
+	return out;
+}
+
+// texels that can't change what's under them: no alpha for the alpha weighted blends,
+//	nothing at all for premultiplied
+template <int Blend>
+static inline bool LeavesDst(uint32_t src)
+{
+	switch (Blend)
+	{
+	case BlendNonPremultiplied:
+	case BlendAdditive:
+		return (src >> 24) == 0;
+	case BlendAlpha:
+		return src == 0;
+	default:
+		return false;
+	}
+}
+
+template <int Blend>
+static void BlendSpanScalar(uint32_t* dst, const uint32_t* src, int count, uint32_t color)
+{
+	for (int i = 0; i < count; i++)
+	{
+		if (!LeavesDst<Blend>(src[i]))
+			dst[i] = BlendPixel<Blend>(src[i], dst[i], color);
+	}
+}
+
+#ifdef RASTER_X86
+// x * y / 255 on 16 bit lanes, both under 256
+static inline __m128i Mul255(__m128i x, __m128i y)
+{
+	__m128i t = _mm_add_epi16(_mm_mullo_epi16(x, y), _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+// two pixels of 16 bit channels in, the same out blended
+template <int Blend>
+static inline __m128i BlendHalf(__m128i s, __m128i d, __m128i tint)
+{
+	const __m128i full = _mm_set1_epi16(255);
+
+	s = Mul255(s, tint);
+	__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+	switch (Blend)
+	{
+	case BlendNonPremultiplied:	return _mm_add_epi16(Mul255(s, a), Mul255(d, _mm_sub_epi16(full, a)));
+	case BlendAlpha:			return _mm_add_epi16(s, Mul255(d, _mm_sub_epi16(full, a)));
+	case BlendAdditive:			return _mm_add_epi16(Mul255(s, a), d);
+	default:					return s;
+	}
+}
+
+// a mask of 4 pixels that can't change what's under them, all 16 bits set if none can
+template <int Blend>
+static inline int LeavesDst(__m128i v)
+{
+	const __m128i zero = _mm_setzero_si128();
+	switch (Blend)
+	{
+	case BlendNonPremultiplied:
+	case BlendAdditive:
+		return _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(v, _mm_set1_epi32((int)0xff000000)), zero));
+	case BlendAlpha:
+		return _mm_movemask_epi8(_mm_cmpeq_epi32(v, zero));
+	default:
+		return 0;
+	}
+}
+
+// 4 pixels, 2 in each half of the register. tint is the colour's channels in 16 bits
+template <int Blend>
+static inline void BlendFour(uint32_t* dst, const uint32_t* src, __m128i tint)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	__m128i s = _mm_loadu_si128((const __m128i*)src);
+	if (LeavesDst<Blend>(s) == 0xffff)
+		return;
+	__m128i d = _mm_loadu_si128((const __m128i*)dst);
+
+	__m128i lo = BlendHalf<Blend>(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero), tint);
+	__m128i hi = BlendHalf<Blend>(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero), tint);
+
+	// sums are at most 510, the pack saturates them to 255
+	_mm_storeu_si128((__m128i*)dst, _mm_packus_epi16(lo, hi));
+}
+
+template <int Blend>
+static void BlendSpanSSE2(uint32_t* dst, const uint32_t* src, int count, uint32_t color)
+{
+	const __m128i tint = _mm_unpacklo_epi8(_mm_set1_epi32((int)color), _mm_setzero_si128());
+
+	int i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		BlendFour<Blend>(dst + i, src + i, tint);
+	}
+
+	BlendSpanScalar<Blend>(dst + i, src + i, count - i, color);
+}
+
+RASTER_TARGET_AVX2 static inline __m256i Mul255(__m256i x, __m256i y)
+{
+	__m256i t = _mm256_add_epi16(_mm256_mullo_epi16(x, y), _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+template <int Blend>
+RASTER_TARGET_AVX2 static inline __m256i BlendHalf(__m256i s, __m256i d, __m256i tint)
+{
+	const __m256i full = _mm256_set1_epi16(255);
+
+	s = Mul255(s, tint);
+	__m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+	switch (Blend)
+	{
+	case BlendNonPremultiplied:	return _mm256_add_epi16(Mul255(s, a), Mul255(d, _mm256_sub_epi16(full, a)));
+	case BlendAlpha:			return _mm256_add_epi16(s, Mul255(d, _mm256_sub_epi16(full, a)));
+	case BlendAdditive:			return _mm256_add_epi16(Mul255(s, a), d);
+	default:					return s;
+	}
+}
+
+template <int Blend>
+RASTER_TARGET_AVX2 static inline int LeavesDst(__m256i v)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	switch (Blend)
+	{
+	case BlendNonPremultiplied:
+	case BlendAdditive:
+		return _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(v, _mm256_set1_epi32((int)0xff000000)), zero));
+	case BlendAlpha:
+		return _mm256_movemask_epi8(_mm256_cmpeq_epi32(v, zero));
+	default:
+		return 0;
+	}
+}
+
+// 8 pixels at a time. the unpacks and pack work within each 128 bit lane, so the
+//	pixels come back out where they went in
+template <int Blend>
+RASTER_TARGET_AVX2 static void BlendSpanAVX2(uint32_t* dst, const uint32_t* src, int count, uint32_t color)
+{
+	const __m256i zero = _mm256_setzero_si256();
+	const __m256i tint = _mm256_unpacklo_epi8(_mm256_set1_epi32((int)color), zero);
+
+	int i = 0;
+	for (; i + 8 <= count; i += 8)
+	{
+		__m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+		if (LeavesDst<Blend>(s) == -1)
+			continue;
+		__m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+
+		__m256i lo = BlendHalf<Blend>(_mm256_unpacklo_epi8(s, zero), _mm256_unpacklo_epi8(d, zero), tint);
+		__m256i hi = BlendHalf<Blend>(_mm256_unpackhi_epi8(s, zero), _mm256_unpackhi_epi8(d, zero), tint);
+
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(lo, hi));
+	}
+
+	// the rest here too, compiled for AVX2. jumping to the SSE2 code with the top halves
+	//	of the registers dirty costs more than blending them
+	if (i + 4 <= count)
+	{
+		BlendFour<Blend>(dst + i, src + i, _mm256_castsi256_si128(tint));
+		i += 4;
+	}
+	BlendSpanScalar<Blend>(dst + i, src + i, count - i, color);
+	_mm256_zeroupper();
+}
+#endif
+
+template <int Blend>
+static void BlendSpan(uint32_t* dst, const uint32_t* src, int count, uint32_t color, SoftwareFramebuffer::SimdLevel level)
+{
+#ifdef RASTER_X86
+	if (level == SoftwareFramebuffer::SimdAVX2)
+		return BlendSpanAVX2<Blend>(dst, src, count, color);
+	if (level == SoftwareFramebuffer::SimdSSE2)
+		return BlendSpanSSE2<Blend>(dst, src, count, color);
+#else
+	(void)level;
+#endif
+	BlendSpanScalar<Blend>(dst, src, count, color);
+}
+
+static void BlendSpan(BlendMode blend, uint32_t* dst, const uint32_t* src, int count, uint32_t color, SoftwareFramebuffer::SimdLevel level)
+{
+	switch (blend)
+	{
+	case BlendAlpha:
+		BlendSpan<BlendAlpha>(dst, src, count, color, level);
+		break;
+	case BlendAdditive:
+		BlendSpan<BlendAdditive>(dst, src, count, color, level);
+		break;
+	case BlendOpaque:
+		// an untinted opaque span is a copy
+		if (color == 0xffffffff)
+			memcpy(dst, src, count * sizeof(uint32_t));
+		else
+			BlendSpan<BlendOpaque>(dst, src, count, color, level);
+		break;
+	default:
+		BlendSpan<BlendNonPremultiplied>(dst, src, count, color, level);
+		break;
+	}
+}
+
+// -----------------------------------------------------
+// Narrow [lo, hi) to the x where 0 <= base + step * x < limit
+//	false if there aren't any. invStep is 1 / step
+//
+static bool ClipInterval(float base, float step, float invStep, float limit, float& lo, float& hi)
+{
+	if (step == 0.0f)
+		return base >= 0.0f && base < limit;
+
+	float a = -base * invStep;
+	float b = (limit - base) * invStep;
+	if (step < 0.0f)
+		std::swap(a, b);
+
+	lo = std::max(lo, a);
+	hi = std::min(hi, b);
+	return lo < hi;
+}
+
+// -----------------------------------------------------
+// Constructor / destructor
+//
+SoftwareFramebuffer::SoftwareFramebuffer(int threads)
+{
+	tilesX = 0;
+	tilesY = 0;
+	simdLevel = GetSimdLevel();
+	nextTile = 0;
+	pixelCount = 0;
+	generation = 0;
+	busy = 0;
+	quit = false;
+	lastDrawCount = 0;
+	lastSkipCount = 0;
+	lastPixelCount = 0;
+
+	if (threads <= 0)
+	{
+		threads = (int)std::thread::hardware_concurrency();
+		if (threads < 1)
+			threads = 1;
+		if (threads > 16)
+			threads = 16;	// an 800x600 frame is 130 tiles, more won't help
+	}
+
+	// the thread calling Execute draws tiles too
+	for (int i = 1; i < threads; i++)
+	{
+		workers.push_back(std::thread(&SoftwareFramebuffer::WorkerLoop, this));
+	}
+}
+
+SoftwareFramebuffer::~SoftwareFramebuffer()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+
+	for (size_t i = 0; i < workers.size(); i++)
+	{
+		workers[i].join();
+	}
+}
+
+// -----------------------------------------------------
+// Setup
+//
+void SoftwareFramebuffer::Resize(int width, int height)
+{
+	if (width < 0) width = 0;
+	if (height < 0) height = 0;
+
+	image.Resize(width, height);
+	tilesX = (width + TileSize - 1) / TileSize;
+	tilesY = (height + TileSize - 1) / TileSize;
+	bins.resize((size_t)tilesX * tilesY);
+}
+
+void SoftwareFramebuffer::Clear(uint32_t color)
+{
+	std::fill(image.pixels.begin(), image.pixels.end(), color);
+}
+
+void SoftwareFramebuffer::SetSimdLevel(SimdLevel level)
+{
+	simdLevel = level > GetSimdLevel() ? GetSimdLevel() : level;
+}
+
+void SoftwareFramebuffer::SetTexture(ID3D11ShaderResourceView* view, const ImageRGBA* pixels)
+{
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		if (textures[i].view == view)
+		{
+			if (pixels)
+				textures[i].image = pixels;
+			else
+				textures.erase(textures.begin() + i);
+			return;
+		}
+	}
+
+	if (pixels)
+	{
+		Texture texture = { view, pixels };
+		textures.push_back(texture);
+	}
+}
+
+// there are only ever a handful, and most commands use the same one as the one before
+const ImageRGBA* SoftwareFramebuffer::FindTexture(ID3D11ShaderResourceView* view)
+{
+	for (size_t i = 0; i < textures.size(); i++)
+	{
+		if (textures[i].view == view)
+		{
+			if (i > 0)
+				std::swap(textures[i], textures[0]);
+			return textures[0].image;
+		}
+	}
+	return nullptr;
+}
+
+// -----------------------------------------------------
+// Copy part of an image in, clipped the same way as TextureType::Draw
+//
+void SoftwareFramebuffer::Blit(const ImageRGBA& source, int destX, int destY, int srcLeft, int srcTop, int width, int height)
+{
+	if (width < 0) width = source.width - srcLeft;
+	if (height < 0) height = source.height - srcTop;
+
+	// keep the source region inside the image
+	if (srcLeft < 0) { width += srcLeft; destX -= srcLeft; srcLeft = 0; }
+	if (srcTop < 0) { height += srcTop; destY -= srcTop; srcTop = 0; }
+	width = std::min(width, source.width - srcLeft);
+	height = std::min(height, source.height - srcTop);
+
+	// then the destination inside the framebuffer
+	if (destX < 0) { width += destX; srcLeft -= destX; destX = 0; }
+	if (destY < 0) { height += destY; srcTop -= destY; destY = 0; }
+	width = std::min(width, image.width - destX);
+	height = std::min(height, image.height - destY);
+
+	if (width <= 0 || height <= 0)
+		return;
+
+	for (int y = 0; y < height; y++)
+	{
+		memcpy(image.Row(destY + y) + destX, source.Row(srcTop + y) + srcLeft, width * sizeof(uint32_t));
+	}
+}
+
+// -----------------------------------------------------
+// Work each command out, bin it, and draw the tiles
+//
+void SoftwareFramebuffer::Execute(const RenderQueue& queue)
+{
+	lastDrawCount = 0;
+	lastSkipCount = 0;
+	lastPixelCount = 0;
+	if (image.width == 0 || image.height == 0)
+		return;
+
+	sprites.clear();
+	for (size_t i = 0; i < bins.size(); i++)
+	{
+		bins[i].clear();
+	}
+
+	for (int i = 0; i < queue.GetCount(); i++)
+	{
+		const DrawCommand& c = queue.GetCommand(i);
+		const ImageRGBA* texture = FindTexture(c.texture);
+
+		// the source region, kept inside the texture
+		int srcLeft = 0, srcTop = 0, srcRight = 0, srcBottom = 0;
+		if (texture)
+		{
+			srcLeft = std::max(c.srcLeft, 0);
+			srcTop = std::max(c.srcTop, 0);
+			srcRight = std::min(c.srcRight, texture->width);
+			srcBottom = std::min(c.srcBottom, texture->height);
+		}
+		if (texture == nullptr || srcRight <= srcLeft || srcBottom <= srcTop || c.scale == 0.0f)
+		{
+			lastSkipCount++;
+			continue;
+		}
+
+		Sprite s;
+		s.texels = texture->Row(srcTop) + srcLeft;
+		s.stride = texture->width;
+		s.width = srcRight - srcLeft;
+		s.height = srcBottom - srcTop;
+		s.color = c.color;
+		s.blend = c.GetBlend();
+		s.unscaled = c.rotation == 0.0f && c.scale == 1.0f;
+
+		// pixel centres back into the region: texel = origin + unrotate(centre - position) / scale
+		float cosR = cosf(c.rotation) / c.scale;
+		float sinR = sinf(c.rotation) / c.scale;
+		s.ux = cosR;
+		s.uy = sinR;
+		s.vx = -sinR;
+		s.vy = cosR;
+		s.u0 = c.originX + cosR * (0.5f - c.x) + sinR * (0.5f - c.y);
+		s.v0 = c.originY - sinR * (0.5f - c.x) + cosR * (0.5f - c.y);
+		s.invUx = s.ux != 0.0f ? 1.0f / s.ux : 0.0f;
+		s.invVx = s.vx != 0.0f ? 1.0f / s.vx : 0.0f;
+		s.stepU = (int64_t)(s.ux * 65536.0f);
+		s.stepV = (int64_t)(s.vx * 65536.0f);
+
+		if (s.unscaled)
+		{
+			// the texel's x is floor(px + u0), which is px + floor(u0) with nothing to round
+			s.offsetX = (int)floorf(s.u0);
+			s.offsetY = (int)floorf(s.v0);
+			s.left = -s.offsetX;
+			s.top = -s.offsetY;
+			s.right = s.width - s.offsetX;
+			s.bottom = s.height - s.offsetY;
+		}
+		else
+		{
+			// around the four corners
+			s.offsetX = 0;
+			s.offsetY = 0;
+			float cosS = cosf(c.rotation) * c.scale;
+			float sinS = sinf(c.rotation) * c.scale;
+			float minX = 1e30f, minY = 1e30f, maxX = -1e30f, maxY = -1e30f;
+			for (int corner = 0; corner < 4; corner++)
+			{
+				float lx = ((corner & 1) ? s.width : 0) - c.originX;
+				float ly = ((corner & 2) ? s.height : 0) - c.originY;
+				float px = c.x + cosS * lx - sinS * ly;
+				float py = c.y + sinS * lx + cosS * ly;
+				minX = std::min(minX, px);
+				minY = std::min(minY, py);
+				maxX = std::max(maxX, px);
+				maxY = std::max(maxY, py);
+			}
+
+			// well outside the framebuffer is just off it, and fits in an int
+			const float limit = 1e6f;
+			s.left = (int)floorf(std::max(minX, -limit));
+			s.top = (int)floorf(std::max(minY, -limit));
+			s.right = (int)ceilf(std::min(maxX, limit));
+			s.bottom = (int)ceilf(std::min(maxY, limit));
+		}
+
+		s.left = std::max(s.left, 0);
+		s.top = std::max(s.top, 0);
+		s.right = std::min(s.right, image.width);
+		s.bottom = std::min(s.bottom, image.height);
+		if (s.right <= s.left || s.bottom <= s.top)
+		{
+			lastSkipCount++;
+			continue;
+		}
+
+		uint32_t index = (uint32_t)sprites.size();
+		sprites.push_back(s);
+		lastDrawCount++;
+
+		for (int ty = s.top / TileSize; ty <= (s.bottom - 1) / TileSize; ty++)
+		{
+			for (int tx = s.left / TileSize; tx <= (s.right - 1) / TileSize; tx++)
+			{
+				bins[ty * tilesX + tx].push_back(index);
+			}
+		}
+	}
+
+	if (sprites.empty())
+		return;
+
+	nextTile = 0;
+	pixelCount = 0;
+
+	if (workers.empty())
+	{
+		DrawTiles();
+	}
+	else
+	{
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			generation++;
+			busy = (int)workers.size();
+		}
+		wake.notify_all();
+
+		DrawTiles();
+
+		std::unique_lock<std::mutex> guard(lock);
+		finished.wait(guard, [this]() { return busy == 0; });
+	}
+
+	lastPixelCount = pixelCount;
+}
+
+// -----------------------------------------------------
+// Tiles
+//
+void SoftwareFramebuffer::DrawTiles()
+{
+	size_t pixels = 0;
+	int tileCount = tilesX * tilesY;
+
+	for (int tile = nextTile++; tile < tileCount; tile = nextTile++)
+	{
+		if (!bins[tile].empty())
+			DrawTile(tile, pixels);
+	}
+
+	pixelCount += pixels;
+}
+
+void SoftwareFramebuffer::DrawTile(int tile, size_t& pixels)
+{
+	int tileLeft = (tile % tilesX) * TileSize;
+	int tileTop = (tile / tilesX) * TileSize;
+	int tileRight = std::min(tileLeft + TileSize, image.width);
+	int tileBottom = std::min(tileTop + TileSize, image.height);
+
+	// texels for one row of a rotated or scaled sprite
+	uint32_t gathered[TileSize];
+
+	const std::vector<uint32_t>& bin = bins[tile];
+	for (size_t i = 0; i < bin.size(); i++)
+	{
+		const Sprite& s = sprites[bin[i]];
+		int left = std::max(s.left, tileLeft);
+		int top = std::max(s.top, tileTop);
+		int right = std::min(s.right, tileRight);
+		int bottom = std::min(s.bottom, tileBottom);
+
+		for (int y = top; y < bottom; y++)
+		{
+			uint32_t* row = image.Row(y);
+
+			if (s.unscaled)
+			{
+				const uint32_t* src = s.texels + (size_t)(y + s.offsetY) * s.stride + s.offsetX;
+				BlendSpan(s.blend, row + left, src + left, right - left, s.color, simdLevel);
+				pixels += right - left;
+				continue;
+			}
+
+			// the pixels on this row whose centres land inside the region
+			float u = s.u0 + s.uy * y;
+			float v = s.v0 + s.vy * y;
+			float lo = (float)left;
+			float hi = (float)right;
+			if (!ClipInterval(u, s.ux, s.invUx, (float)s.width, lo, hi) || !ClipInterval(v, s.vx, s.invVx, (float)s.height, lo, hi))
+				continue;
+
+			int start = std::max(left, (int)ceilf(lo));
+			int end = std::min(right, (int)ceilf(hi));
+			if (end <= start)
+				continue;
+
+			// nearest texels, stepping in 16.16 fixed point from the row's x = 0 so every
+			//	tile the row crosses agrees. clamped in case rounding put one just over the edge
+			int64_t fu = (int64_t)(u * 65536.0f) + s.stepU * start;
+			int64_t fv = (int64_t)(v * 65536.0f) + s.stepV * start;
+			int maxU = s.width - 1;
+			int maxV = s.height - 1;
+
+			if (s.stepV == 0)
+			{
+				// not rotated, every texel comes from one row
+				const uint32_t* src = s.texels + (size_t)std::min(std::max((int)(fv >> 16), 0), maxV) * s.stride;
+				for (int x = start; x < end; x++, fu += s.stepU)
+				{
+					gathered[x - start] = src[std::min(std::max((int)(fu >> 16), 0), maxU)];
+				}
+			}
+			else
+			{
+				for (int x = start; x < end; x++, fu += s.stepU, fv += s.stepV)
+				{
+					int tu = std::min(std::max((int)(fu >> 16), 0), maxU);
+					int tv = std::min(std::max((int)(fv >> 16), 0), maxV);
+					gathered[x - start] = s.texels[(size_t)tv * s.stride + tu];
+				}
+			}
+
+			BlendSpan(s.blend, row + start, gathered, end - start, s.color, simdLevel);
+			pixels += end - start;
+		}
+	}
+}
+
+// -----------------------------------------------------
+// Worker threads
+//
+void SoftwareFramebuffer::WorkerLoop()
+{
+	unsigned seen = 0;
+
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [&]() { return quit || generation != seen; });
+			if (quit)
+				return;
+			seen = generation;
+		}
+
+		DrawTiles();
+
+		bool last;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			last = --busy == 0;
+		}
+		if (last)
+			finished.notify_one();
+	}
+}
+
+// -----------------------------------------------------
+// Capture
+//
+uint64_t SoftwareFramebuffer::GetChecksum() const
+{
+	uint64_t hash = 14695981039346656037ull;
+	uint32_t size[2] = { (uint32_t)image.width, (uint32_t)image.height };
+
+	const uint8_t* bytes = (const uint8_t*)size;
+	for (size_t i = 0; i < sizeof(size); i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+
+	bytes = (const uint8_t*)image.pixels.data();
+	size_t count = image.pixels.size() * sizeof(uint32_t);
+	for (size_t i = 0; i < count; i++)
+	{
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool SoftwareFramebuffer::SaveCapture(const char* fileName) const
+{
+	return PngCodec::Save(fileName, image);
+}
@@ -0,0 +1,182 @@
+//
+// SoftwareFramebuffer
+//		Draws a RenderQueue into pixels in memory, no GPU or device needed
+//
+//	It's a RenderBackend like SpriteBatchBackend, so the same sorted queue can be drawn
+//	either way. Textures are looked up by the view the commands carry, so each one the
+//	frame uses has to be given to SetTexture with its pixels. On a machine without D3D
+//	the views are never dereferenced, any pointer that's the same for the texture works.
+//
+//	Sprites are drawn the way SpriteBatch would draw them: the source region is scaled
+//	and rotated about its origin, tinted by the colour and blended with the command's
+//	BlendMode, using the same blend factors as CommonStates. Texels are sampled nearest,
+//	not bilinear, and all the maths is 8 bit fixed point, so a frame comes out exactly the
+//	same on every machine, instruction set and thread count. That's what makes it good for
+//	comparing frames against ones captured earlier (see GetChecksum and SaveCapture).
+//
+//	The framebuffer is cut into TileSize square tiles, Execute bins each command into the
+//	tiles it touches, then worker threads take tiles until there are none left, drawing
+//	every command in a tile in queue order. Only one thread ever writes a tile, so there's
+//	no locking while drawing. Spans of pixels are blended 4 at a time with SSE2 or 8 with
+//	AVX2, picked at runtime.
+//
+//	The game draws into one as well with -capture (see MyProject::SetCapture), saving every
+//	frame and its checksum. Things it doesn't do yet:
+//	- text is drawn by SpriteFont straight to the GPU, not through the queue, so it's missing
+//	- the game still needs a D3D device to run, only RasterBenchmark draws with none
+//	- how Execute scales with threads hasn't been measured, it's only been run on one core
+//
+
+#ifndef _SOFTWARE_FRAMEBUFFER_H
+#define _SOFTWARE_FRAMEBUFFER_H
+
+#include "PngCodec.h"
+#include "RenderQueue.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class SoftwareFramebuffer : public RenderBackend
+{
+public:
+	// instruction sets the blending can use
+	enum SimdLevel
+	{
+		SimdScalar,
+		SimdSSE2,
+		SimdAVX2
+	};
+
+	// the best level this cpu supports
+	static SimdLevel GetSimdLevel();
+
+	// pixels on a side of a tile
+	static const int TileSize = 64;
+
+	// threads 0 uses one per core, the calling thread included. 1 draws everything on
+	//	the calling thread and starts no workers
+	explicit SoftwareFramebuffer(int threads = 0);
+
+	// stops the workers
+	~SoftwareFramebuffer();
+
+	// make the framebuffer width * height, transparent black
+	void Resize(int width, int height);
+
+	// fill every pixel with color, packed like DrawCommand::color
+	void Clear(uint32_t color);
+
+	// the pixels to draw a texture's commands with. the image isn't copied, so it has to
+	//	stay around until it's removed. null removes it. commands whose texture hasn't been
+	//	given are skipped
+	void SetTexture(ID3D11ShaderResourceView* view, const ImageRGBA* image);
+	void RemoveAllTextures() { textures.clear(); }
+
+	// copy a region of an image in with no blending, clipped to the framebuffer, like
+	//	TextureType::Draw does to the back buffer. width or height < 0 is the rest of the image
+	void Blit(const ImageRGBA& image, int destX, int destY, int srcLeft = 0, int srcTop = 0, int width = -1, int height = -1);
+
+	// draw the queue's commands in order, on top of what's there
+	virtual void Execute(const RenderQueue& queue);
+
+	// blend with a given level (clamped to what the cpu supports), for testing and benchmarks
+	void SetSimdLevel(SimdLevel level);
+	SimdLevel GetUsedSimdLevel() const { return simdLevel; }
+
+	int GetWidth() const { return image.width; }
+	int GetHeight() const { return image.height; }
+	int GetThreadCount() const { return (int)workers.size() + 1; }
+
+	// the pixels, red in the low byte
+	const ImageRGBA& GetImage() const { return image; }
+
+	// 64 bit FNV-1a of the size and every pixel, for checking a frame hasn't changed
+	uint64_t GetChecksum() const;
+
+	// write the pixels as a PNG. false if the file can't be written
+	bool SaveCapture(const char* fileName) const;
+
+	// what the last Execute did
+	int GetLastDrawCount() const { return lastDrawCount; }		// commands that touched the framebuffer
+	int GetLastSkipCount() const { return lastSkipCount; }		// no texture given, or nothing on screen
+	size_t GetLastPixelCount() const { return lastPixelCount; }	// pixels blended, every tile's added up
+
+private:
+	// a command worked out ready to draw
+	struct Sprite
+	{
+		const uint32_t*	texels;		// the source region's top left texel
+		int				stride;		// texels in a row of the texture
+		int				width;		// of the source region
+		int				height;
+
+		// framebuffer pixels it can touch, right and bottom not included
+		int				left, top, right, bottom;
+
+		// the source texel under a pixel's centre is (u0 + ux * x + uy * y, v0 + vx * x + vy * y)
+		float			u0, ux, uy;
+		float			v0, vx, vy;
+		float			invUx, invVx;	// 1 / ux and 1 / vx, 0 if they're 0
+
+		// ux and vx in 16.16 fixed point, for stepping along a row
+		int64_t			stepU, stepV;
+
+		// no rotation or scaling, so the texel is just the pixel moved by this much
+		bool			unscaled;
+		int				offsetX;
+		int				offsetY;
+
+		uint32_t		color;
+		BlendMode		blend;
+	};
+
+	struct Texture
+	{
+		ID3D11ShaderResourceView*	view;
+		const ImageRGBA*			image;
+	};
+
+	const ImageRGBA* FindTexture(ID3D11ShaderResourceView* view);
+
+	// take tiles until there are none left
+	void DrawTiles();
+	void DrawTile(int tile, size_t& pixels);
+
+	void WorkerLoop();
+
+	ImageRGBA				image;
+	int						tilesX;
+	int						tilesY;
+	SimdLevel				simdLevel;
+
+	std::vector<Texture>	textures;
+
+	// this frame's commands, and which of them touch each tile, in queue order
+	std::vector<Sprite>					sprites;
+	std::vector<std::vector<uint32_t> >	bins;
+
+	// the tiles being drawn
+	std::atomic<int>		nextTile;
+	std::atomic<size_t>		pixelCount;
+
+	// workers sleep until generation changes, then draw tiles and count themselves out
+	std::vector<std::thread>	workers;
+	std::mutex					lock;
+	std::condition_variable		wake;
+	std::condition_variable		finished;
+	unsigned					generation;
+	int							busy;
+	bool						quit;
+
+	int						lastDrawCount;
+	int						lastSkipCount;
+	size_t					lastPixelCount;
+
+	// no copying
+	SoftwareFramebuffer(const SoftwareFramebuffer&);
+	SoftwareFramebuffer& operator=(const SoftwareFramebuffer&);
+};
+
+#endif // _SOFTWARE_FRAMEBUFFER_H
@@ -8,11 +8,18 @@
 #include <SpriteBatch.h>
 #include <DirectXColors.h>
 #include "TextureType.h"
+#include "SpriteSystem.h"
+#include "FrameTable.h"
+#include "AnimationClip.h"
+#include "RenderQueue.h"
 #include <math.h>
 using namespace DirectX::SimpleMath;
 
 // constant
 const float twoPi = 3.141592f * 2.0f;
+#ifdef DETERMINISTIC_SIM
+static const Fixed fixedTwoPi = Fixed::FromFloat(twoPi);
+#endif
 
 // convert degrees to radians
 inline float DegToRad( float deg ) { return 3.141592f * deg / 180.0f; } 
@@ -32,6 +39,8 @@ Sprite::Sprite()
 	position = Vector2(0,0);
 	rotation = 0;
 	scale = 1;
+	cosRotation = 1;
+	sinRotation = 0;
 
 	color = Color(DirectX::Colors::White.v);
 	pTexture = NULL;
@@ -46,12 +55,97 @@ Sprite::Sprite()
 	textureRegion.bottom = 0;
 	textureRegion.right = 0;
 
-	frameWidth = 0;
-	frameHeight = 0;
-	totalFrames = 0;
+	pFrames = nullptr;
+	pClip = nullptr;
+	pClipListener = nullptr;
 	currentFrame = 0;
 	elapsedTime = 0;
 	frameTime = 0;
+	baseFrameTime = 0;
+
+	velocity = Vector2(0,0);
+	rotationalVelocity = 0;
+
+	pSystem = nullptr;
+	slot = -1;
+}
+
+// -----------------------------------------------------------------------------
+// destructor
+Sprite::~Sprite()
+{
+	if ( pSystem )
+	{
+		pSystem->Detach( this );
+	}
+}
+
+// -----------------------------------------------------------------------------
+// where the moving / animating state lives
+//
+bool Sprite::IsView() const
+{
+#ifdef DETERMINISTIC_SIM
+	// the system only keeps a list of sprites, they update their own fixed point state
+	return false;
+#else
+	return pSystem != nullptr;
+#endif
+}
+
+float Sprite::Rotation() const		{ return IsView() ? pSystem->rotation[slot] : rotation; }
+float Sprite::CosRotation() const	{ return IsView() ? pSystem->cosRotation[slot] : cosRotation; }
+float Sprite::SinRotation() const	{ return IsView() ? pSystem->sinRotation[slot] : sinRotation; }
+int Sprite::CurrentFrame() const	{ return IsView() ? pSystem->currentFrame[slot] : currentFrame; }
+
+Vector2 Sprite::GetPosition() const
+{
+	return IsView() ? Vector2(pSystem->posX[slot], pSystem->posY[slot]) : position;
+}
+
+Vector2 Sprite::GetVelocity() const
+{
+	return IsView() ? Vector2(pSystem->velX[slot], pSystem->velY[slot]) : velocity;
+}
+
+float Sprite::GetRotationalVelocity() const
+{
+	float radians = IsView() ? pSystem->rotationalVelocity[slot] : rotationalVelocity;
+	return radians * 180.0f / 3.141592f;
+}
+
+int Sprite::FrameCount() const
+{
+	if ( pClip )
+		return pClip->CycleLength();
+	return pFrames ? pFrames->GetFrameCount() : 0;
+}
+
+bool Sprite::IsAnimating() const
+{
+	float seconds = IsView() ? pSystem->frameTime[slot] : frameTime;
+	return FrameCount() > 0 && seconds > 0.0f;
+}
+
+bool Sprite::isLastFrame() const
+{
+	return CurrentFrame() == FrameCount() - 1;
+}
+
+void Sprite::RestartAnimation()
+{
+	if ( IsView() )
+	{
+		// the system only changes the region when the frame advances
+		pSystem->currentFrame[slot] = 0;
+		if ( FrameCount() > 0 )
+		{
+			SetTextureAnimationRegion();
+			ApplyFrameDuration();
+		}
+	}
+	else
+		currentFrame = 0;
 }
 
 // -----------------------------------------------------------------------------
@@ -59,8 +153,8 @@ Sprite::Sprite()
 void Sprite::Initialize( TextureType* pTex, Vector2 pos, float rotInDegrees, float scl, Color clr, float lyr ) 
 {
 	pTexture = pTex;
-	position = pos;
-	rotation = DegToRad( rotInDegrees );
+	SetPosition( pos );
+	SetRotation( rotInDegrees );
 	scale = scl;
 	color = clr;
 	layer = lyr;
@@ -112,10 +206,65 @@ void Sprite::Draw( SpriteBatch* pBatch )
 {
 	if ( pTexture )
 	{
-		pBatch->Draw( pTexture->GetResourceView(), position, &textureRegion ,color, rotation, origin, scale, DirectX::SpriteEffects_None, layer );
+		// the texture might be a region of an atlas page
+		RECT source = textureRegion;
+		source.left += pTexture->GetOffsetX();
+		source.right += pTexture->GetOffsetX();
+		source.top += pTexture->GetOffsetY();
+		source.bottom += pTexture->GetOffsetY();
+
+		pBatch->Draw( pTexture->GetResourceView(), GetPosition(), &source ,color, Rotation(), origin, scale, DirectX::SpriteEffects_None, layer );
+	}
+}
+
+// -----------------------------------------------------------------------------
+// draw - records the draw in the queue
+void Sprite::Draw( RenderQueue* pQueue ) const
+{
+	DrawCommand command;
+	if ( MakeDrawCommand( command ) )
+	{
+		pQueue->Submit( command, GetBlend() );
 	}
 }
 
+// -----------------------------------------------------------------------------
+// fill in the draw command for where the sprite is now
+bool Sprite::MakeDrawCommand( DrawCommand& command ) const
+{
+	if ( pTexture )
+	{
+		Vector2 pos = GetPosition();
+
+		command.texture = pTexture->GetResourceView();
+		command.srcLeft = textureRegion.left + pTexture->GetOffsetX();
+		command.srcTop = textureRegion.top + pTexture->GetOffsetY();
+		command.srcRight = textureRegion.right + pTexture->GetOffsetX();
+		command.srcBottom = textureRegion.bottom + pTexture->GetOffsetY();
+		command.x = pos.x;
+		command.y = pos.y;
+		command.originX = origin.x;
+		command.originY = origin.y;
+		command.rotation = Rotation();
+		command.scale = scale;
+
+		// premultiplied textures need a premultiplied tint too
+		if ( pTexture->IsPremultiplied() )
+			command.color = DrawCommand::PackColor( color.x * color.w, color.y * color.w, color.z * color.w, color.w );
+		else
+			command.color = DrawCommand::PackColor( color.x, color.y, color.z, color.w );
+
+		command.layer = layer;
+		return true;
+	}
+	return false;
+}
+
+BlendMode Sprite::GetBlend() const
+{
+	return ( pTexture && pTexture->IsPremultiplied() ) ? BlendAlpha : BlendNonPremultiplied;
+}
+
 // -----------------------------------------------------------------------------
 // Sets the texture to show only a portion of the texture
 //
@@ -150,12 +299,15 @@ bool Sprite::ContainsPoint(Vector2 point) const
 	// get the pivot point of the sprite
 	Vector2 center = GetCenterNoRotation();
 
-	if (rotation != 0.0f)
+	if (Rotation() != 0.0f)
 	{
 		// rotate the point in the opposite direction
-		Matrix rotMatrix = Matrix::CreateRotationZ(-rotation);
-		Vector3 dir(point.x - position.x, point.y - position.y, 0.0f);
-		dir = Vector3::TransformNormal(dir, rotMatrix);
+		Vector2 offset = point - GetPosition();
+		float c = CosRotation();
+		float s = SinRotation();
+		Vector2 dir(
+			offset.x * c + offset.y * s,
+			offset.y * c - offset.x * s);
 
 		// update the point to a new position in the space of the unrotated box
 		point = center - dir;
@@ -175,21 +327,24 @@ Vector2	Sprite::GetCenterNoRotation() const
 {
 	float halfwidth = 0.5f * (float)GetWidth();
 	float halfheight = 0.5f * (float)GetHeight();
+	Vector2 pos = GetPosition();
 
 	switch (pivot)
 	{
 	case Sprite::UpperLeft:
-		return position + Vector2(-halfwidth, -halfheight);
+		return pos + Vector2(-halfwidth, -halfheight);
 	case Sprite::UpperRight:
-		return position + Vector2(-halfwidth, -halfheight);
+		return pos + Vector2(-halfwidth, -halfheight);
 	case Sprite::Center:
-		return position;
+		// the pivot is usually the middle, but a sheet can put it anywhere
+		return pos + Vector2((0.5f * (textureRegion.right - textureRegion.left) - origin.x) * scale,
+			(0.5f * (textureRegion.bottom - textureRegion.top) - origin.y) * scale);
 	case Sprite::LowerRight:
-		return position + Vector2(-halfwidth, -halfheight);
+		return pos + Vector2(-halfwidth, -halfheight);
 	case Sprite::LowerLeft:
-		return position + Vector2(-halfwidth, -halfheight);
+		return pos + Vector2(-halfwidth, -halfheight);
 	}
-	return position;
+	return pos;
 }
 
 // --------------------------------------------------------------------
@@ -200,72 +355,276 @@ void Sprite::SetTextureAnimation(int frameSizeX, int frameSizeY, int framesPerSe
 	if (pTexture == nullptr)
 		return;
 
-	frameWidth = frameSizeX;
-	frameHeight = frameSizeY;
-	int cols = pTexture->GetWidth() / frameWidth;
-	int rows = pTexture->GetHeight() / frameHeight;
-	totalFrames = rows * cols;
+	pClip = nullptr;
+	pFrames = FrameTable::Get(pTexture, frameSizeX, frameSizeY);
+
+	StartAnimation((float)framesPerSecond);
+}
+
+// --------------------------------------------------------------------
+// Set up the animation from a sheet descriptor
+//	plays every frame in the sheet, looping
+bool Sprite::LoadSheet(const char* sheetFileName)
+{
+	if (pTexture == nullptr)
+		return false;
+
+	const FrameTable* pTable = FrameTable::Load(sheetFileName, pTexture);
+	if (pTable == nullptr)
+		return false;
+
+	pClip = nullptr;
+	pFrames = pTable;
+
+	StartAnimation(pFrames->GetFramesPerSecond());
+	return true;
+}
+
+// --------------------------------------------------------------------
+// Play a clip from the start
+//
+void Sprite::PlayClip(const AnimationClip* pNewClip)
+{
+	if (pNewClip == nullptr || pNewClip->frameCount <= 0)
+		return;
+
+	pClip = pNewClip;
+	pFrames = pClip->pFrames;
+	pTexture = pClip->pTexture;
+
+	StartAnimation(pClip->framesPerSecond);
+}
+
+// --------------------------------------------------------------------
+// Back to the first frame of the animation
+//
+void Sprite::StartAnimation(float framesPerSecond)
+{
+	int totalFrames = FrameCount();
 	currentFrame = 0;
 
 	elapsedTime = 0;
-	frameTime = 1.0f / framesPerSecond;
+	frameTime = (totalFrames > 0 && framesPerSecond > 0) ? 1.0f / framesPerSecond : 0.0f;
+	baseFrameTime = frameTime;
+
+	if (IsView())
+	{
+		pSystem->totalFrames[slot] = totalFrames;
+		pSystem->currentFrame[slot] = 0;
+		pSystem->elapsedTime[slot] = 0;
+		pSystem->frameTime[slot] = frameTime;
+	}
+
+#ifdef DETERMINISTIC_SIM
+	simElapsedTime = Fixed();
+	simFrameTime = frameTime > 0 ? Fixed::FromInt(1) / Fixed::FromFloat(framesPerSecond) : Fixed();
+	simBaseFrameTime = simFrameTime;
+#endif
+
+	if (totalFrames > 0)
+	{
+		SetTextureAnimationRegion();
+		ApplyFrameDuration();
+	}
+}
+
+// --------------------------------------------------------------------
+// Stay on the current frame for as long as it asks
+//	frames without a duration go at the playback rate
+//
+void Sprite::ApplyFrameDuration()
+{
+	// stopped, or nothing to time
+	if (baseFrameTime <= 0.0f)
+		return;
+
+	float duration = pFrames->GetFrame(FrameIndex()).duration;
+
+	frameTime = duration > 0.0f ? duration : baseFrameTime;
+	if (IsView())
+	{
+		pSystem->frameTime[slot] = frameTime;
+	}
+
+#ifdef DETERMINISTIC_SIM
+	// too short to show up in fixed point counts as no duration
+	Fixed simDuration = Fixed::FromFloat(duration);
+	simFrameTime = simDuration.raw > 0 ? simDuration : simBaseFrameTime;
+#endif
+}
+
+// --------------------------------------------------------------------
+// Move the animation on
+//
+void Sprite::StepFrames(int& frame, int advanceFrames)
+{
+	int totalFrames = FrameCount();
+	int next = frame + advanceFrames;
+	bool finished = next >= totalFrames;
+
+	if (finished)
+	{
+		if (pClip && pClip->mode == AnimationClip::Once)
+		{
+			// hold the last frame and stop
+			next = totalFrames - 1;
+			frameTime = 0;
+			baseFrameTime = 0;
+			elapsedTime = 0;
+			if (IsView())
+			{
+				pSystem->frameTime[slot] = 0;
+				pSystem->elapsedTime[slot] = 0;
+			}
+#ifdef DETERMINISTIC_SIM
+			simFrameTime = Fixed();
+			simElapsedTime = Fixed();
+#endif
+		}
+		else
+		{
+			//  % operator causes it to wrap to 0
+			next %= totalFrames;
+		}
+	}
 
+	frame = next;
 	SetTextureAnimationRegion();
+	ApplyFrameDuration();
+
+	// last, the listener might start another clip
+	if (finished && pClipListener && pClip)
+	{
+		pClipListener->OnClipFinished(this, pClip);
+	}
 }
 
 // --------------------------------------------------------------------
 // Updates the animation
 void Sprite::UpdateAnimation(float deltaTime)
 {
-	if (totalFrames > 0)
+	if (IsView())
 	{
+		pSystem->UpdateRange(slot, slot + 1, deltaTime);
+		return;
+	}
+
+	if (IsAnimating())
+	{
+#ifdef DETERMINISTIC_SIM
+		// whole frames and the time left over, with integer division instead of fmodf
+		simElapsedTime += Fixed::FromFloat(deltaTime);
+
+		int advanceFrames = simElapsedTime.raw / simFrameTime.raw;
+		simElapsedTime.raw %= simFrameTime.raw;
+		elapsedTime = simElapsedTime.ToFloat();
+#else
 		elapsedTime += deltaTime;
 
 		// how many frames to move forward
 		int advanceFrames = int(elapsedTime / frameTime); 
 		// fmodf is the % operator for floats
 		elapsedTime = fmodf(elapsedTime, frameTime);
+#endif
+
+		// advance the animation, and recalculate the region
+		if (advanceFrames > 0)
+		{
+			StepFrames(currentFrame, advanceFrames);
+		}
+	}
 
-		// advance the animation
-		//  % operator causes it to wrap to 0
-		currentFrame = (currentFrame + advanceFrames) % totalFrames;
+	Integrate(deltaTime);
+}
 
-		// recalculate the region
-		SetTextureAnimationRegion();
+// ------------------------------------------------------------
+// Move and turn by the velocities
+//
+void Sprite::Integrate(float deltaTime)
+{
+	if (IsView())
+	{
+		pSystem->posX[slot] += pSystem->velX[slot] * deltaTime;
+		pSystem->posY[slot] += pSystem->velY[slot] * deltaTime;
+
+		if (pSystem->rotationalVelocity[slot] != 0)
+		{
+			float& r = pSystem->rotation[slot];
+			r += pSystem->rotationalVelocity[slot] * deltaTime;
+
+			// keep it honest
+			while (r > twoPi) r -= twoPi;
+			while (r < -twoPi) r += twoPi;
+
+			pSystem->UpdateRotationTrig(slot);
+		}
+		return;
 	}
 
+#ifdef DETERMINISTIC_SIM
+	Fixed dt = Fixed::FromFloat(deltaTime);
+
+	simPosition += simVelocity * dt;
+	position = ToVector2(simPosition);
+
+	if (simRotationalVelocity != Fixed())
+	{
+		simRotation += simRotationalVelocity * dt;
+
+		// keep it honest
+		while (simRotation > fixedTwoPi) simRotation -= fixedTwoPi;
+		while (simRotation < -fixedTwoPi) simRotation += fixedTwoPi;
+
+		// the trig is only used for drawing and picking, so float is fine there
+		rotation = simRotation.ToFloat();
+		UpdateRotationTrig();
+	}
+#else
 	position += velocity * deltaTime;
-	rotation += rotationalVelocity * deltaTime;
 
-	// keep it honest
-	while (rotation > twoPi) rotation -= twoPi;
-	while (rotation < -twoPi) rotation += twoPi;
+	if (rotationalVelocity != 0)
+	{
+		rotation += rotationalVelocity * deltaTime;
+
+		// keep it honest
+		while (rotation > twoPi) rotation -= twoPi;
+		while (rotation < -twoPi) rotation += twoPi;
+
+		UpdateRotationTrig();
+	}
+#endif
 }
 
 
 // ------------------------------------------------------------
 // Sets the texture region based on the current animation frame
+//	the region and origin were worked out when the frame table was made
 //
 void Sprite::SetTextureAnimationRegion()
 {
-	// get the number of columns
-	int cols = pTexture->GetWidth() / frameWidth;
+	const FrameTable::Frame& frame = pFrames->GetFrame(FrameIndex());
 
-	// get the column and the row
-	int c = currentFrame % cols;
-	int r = currentFrame / cols;
+	textureRegion = frame.region;
+	origin = frame.origin[pivot];
+}
 
-	// set the texture region
-	textureRegion.left = c * frameWidth;
-	textureRegion.right = (c + 1) * frameWidth;
-	textureRegion.top = r * frameHeight;
-	textureRegion.bottom = ( r + 1 )  * frameHeight;
 
-	// we've change the texturegion, update the origin
-	SetPivot(pivot);
+// ------------------------------------------------------------
+// Where the current frame is in pFrames
+//
+int Sprite::FrameIndex() const
+{
+	int index = CurrentFrame();
+	if (pClip)
+	{
+		// the way back of a ping-pong
+		if (index >= pClip->frameCount)
+			index = pClip->CycleLength() - index;
+		index += pClip->firstFrame;
+	}
+	return index;
 }
 
-
 // -----------------------------------------------------------------------
 // Get the extents of the bounding box of the sprite 
 //	Extents are 1/2 width and height of the transformed sprite
@@ -277,29 +636,102 @@ Vector2 Sprite::GetExtents() const
 		(textureRegion.bottom - textureRegion.top) * scale * 0.5f
 		);
 
-	// need to adjust it for rotation
-	if (rotation != 0)
+	// need to adjust it for rotation, the box has to fit all 4 rotated corners
+	if (Rotation() != 0)
 	{
-		float cosTheta = cosf(rotation);
-		float sinTheta = sinf(rotation);
-
-		Vector2 rotated = Vector2(
-				extents.x * cosTheta  - extents.y * sinTheta,
-				extents.x * sinTheta  + extents.y * cosTheta
-			);
-			
-		extents.x = fabsf(rotated.x);
-		extents.y = fabsf(rotated.y);
+		extents = Collision2D::RotatedExtents(extents, CosRotation(), SinRotation());
 	}
 
 	return extents;
 }
 
+// -----------------------------------------------------------------------
+// Get the oriented box around the sprite
+//
+OBB2D Sprite::GetOBB() const
+{
+	Vector2 extents(
+		(textureRegion.right - textureRegion.left) * scale * 0.5f,
+		(textureRegion.bottom - textureRegion.top) * scale * 0.5f
+		);
+
+	// the center turns around the pivot with the sprite
+	Vector2 pos = GetPosition();
+	float c = CosRotation();
+	float s = SinRotation();
+	Vector2 offset = GetCenterNoRotation() - pos;
+	Vector2 center = pos + Vector2(
+		offset.x * c - offset.y * s,
+		offset.x * s + offset.y * c);
+
+	return OBB2D(center, extents, c, s);
+}
+
+// -----------------------------------------------------------------------
+// Recalculate the cos and sin of the rotation
+//
+void Sprite::UpdateRotationTrig()
+{
+	cosRotation = cosf(rotation);
+	sinRotation = sinf(rotation);
+}
+
 // -----------------------------------------------------------------------
 // Sets the velocity
 //
 void Sprite::SetVelocity(Vector2 velocityPixPerSec, float rotationalVelocityDegPerSec)
 {
+	if (IsView())
+	{
+		pSystem->velX[slot] = velocityPixPerSec.x;
+		pSystem->velY[slot] = velocityPixPerSec.y;
+		pSystem->rotationalVelocity[slot] = DegToRad(rotationalVelocityDegPerSec);
+		return;
+	}
+
 	velocity = velocityPixPerSec;
 	rotationalVelocity = DegToRad(rotationalVelocityDegPerSec);
+
+#ifdef DETERMINISTIC_SIM
+	simVelocity = ToFixed(velocity);
+	simRotationalVelocity = Fixed::FromFloat(rotationalVelocity);
+#endif
+}
+
+// -----------------------------------------------------------------------
+void Sprite::SetPosition(Vector2 p)
+{
+	if (IsView())
+	{
+		pSystem->posX[slot] = p.x;
+		pSystem->posY[slot] = p.y;
+		return;
+	}
+
+	position = p;
+
+#ifdef DETERMINISTIC_SIM
+	simPosition = ToFixed(p);
+	position = ToVector2(simPosition);
+#endif
+}
+
+// -----------------------------------------------------------------------
+void Sprite::SetRotation(float d)
+{
+	if (IsView())
+	{
+		pSystem->rotation[slot] = DegToRad(d);
+		pSystem->UpdateRotationTrig(slot);
+		return;
+	}
+
+	rotation = DegToRad(d);
+
+#ifdef DETERMINISTIC_SIM
+	simRotation = Fixed::FromFloat(rotation);
+	rotation = simRotation.ToFloat();
+#endif
+
+	UpdateRotationTrig();
 }
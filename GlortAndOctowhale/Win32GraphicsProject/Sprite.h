@@ -12,10 +12,19 @@
 #include <d3d11.h>
 #include <SimpleMath.h> // for vectors and colours
 #include <math.h>
+#include "Collision2D.h"
+#include "RenderQueue.h"	// for BlendMode
+#ifdef DETERMINISTIC_SIM
+#include "FixedCollision2D.h"
+#endif
 
 
 // forward declares
 class TextureType;
+class SpriteSystem;
+class FrameTable;
+struct AnimationClip;
+class ClipListener;
 namespace DirectX { class SpriteBatch; }
 
 // namespace resolution
@@ -43,6 +52,9 @@ public:
 	// constructor
 	Sprite();
 
+	// leaves its SpriteSystem, if it is in one
+	~Sprite();
+
 	// initialize the sprite
 	void Initialize(TextureType* pTexture, Vector2 position, float rotinDegrees, float scale, Color color, float layer);
 
@@ -56,16 +68,29 @@ public:
 	// draw 
 	void Draw(SpriteBatch* pBatch);
 
+	// add a draw command to the queue, it gets drawn when the queue is
+	void Draw(RenderQueue* pQueue) const;
+
+	// the command Draw would queue, for things that keep it and queue it themselves
+	//	returns false if there's nothing to draw
+	bool MakeDrawCommand(DrawCommand& command) const;
+
+	// the blend state the sprite's texture wants, premultiplied or not
+	BlendMode GetBlend() const;
+
 	// Get the sprite width and height, independent of rotation, scaled and rounded up
 	int GetWidth() const	{ return (int)ceilf((textureRegion.right - textureRegion.left) * scale); }
 	int GetHeight() const	{ return (int)ceilf((textureRegion.bottom - textureRegion.top) * scale); }
 
-	// get the extents
+	// get the extents of the axis aligned box around the (rotated) sprite
 	Vector2 GetExtents() const;
 
+	// get the oriented box around the sprite
+	OBB2D GetOBB() const;
+
 	void SetVelocity(Vector2 velocityPixPerSec, float rotationalVelocityDegPerSec); 
-	Vector2 GetVelocity() const { return velocity; }
-	float GetRotationalVelocity() { return rotationalVelocity * 180.0f / 3.141592f; }
+	Vector2 GetVelocity() const;
+	float GetRotationalVelocity() const;
 
 
 	// check if this sprite contains this point 
@@ -76,35 +101,75 @@ public:
 	void SetColor(Color c) { color = c; }
 	
 	// get and set the position
-	Vector2 GetPosition() const { return position; }
-	void SetPosition(Vector2 p) { position = p;  }
+	Vector2 GetPosition() const;
+	void SetPosition(Vector2 p);
 
 	// get and set the rotation in degrees
-	float GetRotation() { return rotation * 180.0f / 3.141592f; }
-	void SetRotation(float d) { rotation = d * 3.141592f / 180.0f;  }
+	float GetRotation() const { return Rotation() * 180.0f / 3.141592f; }
+	void SetRotation(float d);
 
 	// get/set the scale
 	float GetScale() const { return scale;  }
 	void SetScale(float f) { scale = f;  }
 
-	// Set up a texture animation
+	// Set up a texture animation, the whole sheet as one looping clip
 	void SetTextureAnimation(int frameSizeX, int frameSizeY, int framesPerSecond);
 
-	// advance the animation
+	// Set up the animation from a sheet descriptor (see SpriteSheet) for the sprite's texture,
+	//	the whole sheet as one looping clip. returns false if it can't be loaded
+	bool LoadSheet(const char* sheetFileName);
+
+	// play a clip from a ClipLibrary from its first frame, switching to its texture
+	void PlayClip(const AnimationClip* pClip);
+
+	// the clip being played, null if there isn't one
+	const AnimationClip* GetClip() const { return pClip; }
+
+	// get told when the clip ends or comes back round. the listener isn't owned by the sprite
+	void SetClipListener(ClipListener* pListener) { pClipListener = pListener; }
+
+	// false when there's no animation, or a Once clip has finished
+	bool IsAnimating() const;
+
+	// advance the animation, and move by the velocities
 	void UpdateAnimation(float deltaTime);
 
+	// move and turn by the velocities for deltaTime seconds
+	void Integrate(float deltaTime);
+
 	// check if we are on the last frame of animation
-	bool isLastFrame() const { return currentFrame == totalFrames - 1; }
+	bool isLastFrame() const;
 
 	// restart the animation
-	void RestartAnimation() { currentFrame = 0;  }
+	void RestartAnimation();
 
 
 private:
+	friend class SpriteSystem;
+
+	// the system this sprite is a view into, and its slot there. null when it's by itself
+	SpriteSystem*	pSystem;
+	int				slot;
+
+	// true if the position, velocity, rotation and animation timing are in pSystem
+	//	rather than the members below
+	bool			IsView() const;
+
+	// read the rotation state from wherever it lives
+	float			Rotation() const;
+	float			CosRotation() const;
+	float			SinRotation() const;
+	int				CurrentFrame() const;
+
 	// transformation information
 	Vector2			position;
 	float			rotation;
 	float			scale;
+
+	// cos and sin of the rotation, only recalculated when the rotation changes
+	float			cosRotation;
+	float			sinRotation;
+	void			UpdateRotationTrig();
 	float			layer;
 
 	// colour & texture
@@ -121,14 +186,31 @@ private:
 	// get the center position of the sprite (internal helper)
 	Vector2			GetCenterNoRotation() const;
 
-	// texture animation
-	int				frameWidth;
-	int				frameHeight;
-	int				totalFrames;
-	int				currentFrame;
+	// texture animation, the frames are shared with every sprite using the same sheet
+	const FrameTable* pFrames;
+	const AnimationClip* pClip;
+	ClipListener*	pClipListener;
+	int				currentFrame;		// how far through the clip's cycle
+
+	// frames in one time through the animation
+	int				FrameCount() const;
+
+	// start from the beginning of pFrames / pClip
+	void			StartAnimation(float framesPerSecond);
+
+	// move on some frames, wrapping or stopping as the clip says, and tell the listener
+	//	frame is wherever the current frame lives
+	void			StepFrames(int& frame, int advanceFrames);
+
+	// the current frame's entry in pFrames
+	int				FrameIndex() const;
+
+	// time the current frame from its duration in the sheet, if it has one
+	void			ApplyFrameDuration();
 
 	float			elapsedTime;
 	float			frameTime; // seconds per frames 
+	float			baseFrameTime; // seconds per frame for frames without their own duration
 
 	// Set the texture animation region
 	void SetTextureAnimationRegion();
@@ -136,6 +218,22 @@ private:
 	Vector2			velocity;		 // pixels /sec
 	float			rotationalVelocity; // rad / sec
 
+#ifdef DETERMINISTIC_SIM
+	// fixed point copies of the simulated state. these are what actually get updated,
+	//	the floats above are only set from them so every build moves and animates the same
+	FixedVector2	simPosition;
+	FixedVector2	simVelocity;
+	Fixed			simRotation;
+	Fixed			simRotationalVelocity;
+	Fixed			simElapsedTime;
+	Fixed			simFrameTime;
+	Fixed			simBaseFrameTime;
+#endif
+
+	// no copying, a copy would share the original's slot in its SpriteSystem and take it
+	//	away when it was destroyed
+	Sprite(const Sprite&);
+	Sprite& operator=(const Sprite&);
 };
 
 
@@ -0,0 +1,84 @@
+//
+// SpriteBatchBackend
+//		Draws a RenderQueue with DirectXTK's SpriteBatch
+//
+
+#include "SpriteBatchBackend.h"
+#include <SpriteBatch.h>
+#include <CommonStates.h>
+#include <SimpleMath.h>
+
+using namespace DirectX;
+using DirectX::SimpleMath::Color;
+using DirectX::SimpleMath::Vector2;
+
+// -----------------------------------------------------
+// Constructor
+//
+SpriteBatchBackend::SpriteBatchBackend()
+{
+	pBatch = nullptr;
+	pStates = nullptr;
+	lastBatchCount = 0;
+}
+
+void SpriteBatchBackend::Initialize(SpriteBatch* batch, CommonStates* states)
+{
+	pBatch = batch;
+	pStates = states;
+}
+
+// -----------------------------------------------------
+// Draw the queue in order, a new batch each time the blend state changes
+//
+void SpriteBatchBackend::Execute(const RenderQueue& queue)
+{
+	lastBatchCount = 0;
+	if (pBatch == nullptr || pStates == nullptr || queue.GetCount() == 0)
+		return;
+
+	int blend = -1;
+	for (int i = 0; i < queue.GetCount(); i++)
+	{
+		const DrawCommand& c = queue.GetCommand(i);
+
+		if (c.GetBlend() != blend)
+		{
+			if (blend >= 0)
+				pBatch->End();
+
+			blend = c.GetBlend();
+
+			ID3D11BlendState* pBlendState = pStates->NonPremultiplied();
+			switch (blend)
+			{
+			case BlendAlpha:
+				pBlendState = pStates->AlphaBlend();
+				break;
+			case BlendAdditive:
+				pBlendState = pStates->Additive();
+				break;
+			case BlendOpaque:
+				pBlendState = pStates->Opaque();
+				break;
+			}
+
+			pBatch->Begin(SpriteSortMode_Deferred, pBlendState);
+			lastBatchCount++;
+		}
+
+		RECT source;
+		source.left = c.srcLeft;
+		source.top = c.srcTop;
+		source.right = c.srcRight;
+		source.bottom = c.srcBottom;
+
+		float r, g, b, a;
+		DrawCommand::UnpackColor(c.color, r, g, b, a);
+
+		pBatch->Draw(c.texture, Vector2(c.x, c.y), &source, Color(r, g, b, a), c.rotation,
+			Vector2(c.originX, c.originY), c.scale, SpriteEffects_None, c.layer);
+	}
+
+	pBatch->End();
+}
@@ -0,0 +1,37 @@
+//
+// SpriteBatchBackend
+//		Draws a RenderQueue with DirectXTK's SpriteBatch
+//
+//	The queue is already sorted, so the batch runs in Deferred mode and only gets
+//	restarted when the blend state changes.
+//
+
+#ifndef _SPRITE_BATCH_BACKEND_H
+#define _SPRITE_BATCH_BACKEND_H
+
+#include "RenderQueue.h"
+
+// forward declares
+namespace DirectX { class SpriteBatch; class CommonStates; }
+
+class SpriteBatchBackend : public RenderBackend
+{
+public:
+	SpriteBatchBackend();
+
+	// the batch and states to draw with, not owned
+	void Initialize(DirectX::SpriteBatch* pBatch, DirectX::CommonStates* pStates);
+
+	// draw the queue
+	virtual void Execute(const RenderQueue& queue);
+
+	// Begin / End pairs used by the last Execute
+	int GetLastBatchCount() const { return lastBatchCount; }
+
+private:
+	DirectX::SpriteBatch*	pBatch;
+	DirectX::CommonStates*	pStates;
+	int						lastBatchCount;
+};
+
+#endif // _SPRITE_BATCH_BACKEND_H
@@ -0,0 +1,348 @@
+//
+// SpriteSheet
+//		Describes the frames and clips in a sprite sheet texture
+//
+//	Binary layout, all little endian:
+//		uint32 magic, uint32 frame count, uint32 clip count, float fps
+//		uint16 texture name length, then the name
+//		per frame: int16 x, y, width, height, trimX, trimY, sourceWidth, sourceHeight
+//			float pivotX, pivotY, duration
+//		per clip: uint8 name length, the name, uint16 first frame, uint16 frame count, float fps, uint8 mode
+//
+
+#include "SpriteSheet.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+
+// -----------------------------------------------------
+// Little endian reading and writing
+//
+class ByteReader
+{
+public:
+	ByteReader(const void* data, size_t size) : p((const uint8_t*)data), end((const uint8_t*)data + size), ok(true) {}
+
+	uint32_t U8() { return Need(1) ? *p++ : 0; }
+	uint32_t U16() { uint32_t v = U8(); return v | (U8() << 8); }
+	uint32_t U32() { uint32_t v = U16(); return v | (U16() << 16); }
+	int32_t I16() { return (int16_t)U16(); }
+	float F32() { uint32_t v = U32(); float f; memcpy(&f, &v, 4); return f; }
+
+	std::string String(size_t length)
+	{
+		if (!Need(length))
+			return std::string();
+		std::string s((const char*)p, length);
+		p += length;
+		return s;
+	}
+
+	bool Ok() const { return ok; }
+
+private:
+	bool Need(size_t n)
+	{
+		if (!ok || (size_t)(end - p) < n)
+			ok = false;
+		return ok;
+	}
+
+	const uint8_t*	p;
+	const uint8_t*	end;
+	bool			ok;
+};
+
+static void PutU8(std::vector<uint8_t>& out, uint32_t v)	{ out.push_back((uint8_t)v); }
+static void PutU16(std::vector<uint8_t>& out, uint32_t v)	{ PutU8(out, v & 0xff); PutU8(out, (v >> 8) & 0xff); }
+static void PutU32(std::vector<uint8_t>& out, uint32_t v)	{ PutU16(out, v & 0xffff); PutU16(out, v >> 16); }
+static void PutF32(std::vector<uint8_t>& out, float f)		{ uint32_t v; memcpy(&v, &f, 4); PutU32(out, v); }
+
+// -----------------------------------------------------
+// Constructor
+//
+SpriteSheet::SpriteSheet()
+{
+	Reset();
+}
+
+void SpriteSheet::Reset()
+{
+	textureName.clear();
+	framesPerSecond = 8.0f;
+	frames.clear();
+	clips.clear();
+	error.clear();
+}
+
+// -----------------------------------------------------
+// Load from disk, text or binary
+//
+bool SpriteSheet::Load(const char* fileName)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (file == nullptr)
+	{
+		Reset();
+		error = std::string("can't open ") + fileName;
+		return false;
+	}
+
+	std::vector<char> data;
+	char buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + n);
+	}
+	fclose(file);
+
+	return Parse(data.data(), data.size());
+}
+
+bool SpriteSheet::Parse(const void* data, size_t size)
+{
+	if (size >= 4)
+	{
+		ByteReader reader(data, size);
+		if (reader.U32() == Magic)
+			return ParseBinary(data, size);
+	}
+
+	return ParseText((const char*)data, size);
+}
+
+// -----------------------------------------------------
+// Parse the text format
+//
+bool SpriteSheet::ParseText(const char* text, size_t length)
+{
+	Reset();
+
+	std::istringstream input(std::string(text, length));
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(input, line))
+	{
+		lineNumber++;
+
+		// comments and blank lines
+		size_t hash = line.find('#');
+		if (hash != std::string::npos)
+			line.erase(hash);
+
+		std::istringstream words(line);
+		std::string keyword;
+		if (!(words >> keyword))
+			continue;
+
+		bool ok = true;
+		if (keyword == "texture")
+		{
+			ok = (bool)(words >> textureName);
+		}
+		else if (keyword == "fps")
+		{
+			ok = (bool)(words >> framesPerSecond) && framesPerSecond > 0.0f;
+		}
+		else if (keyword == "frame")
+		{
+			SheetFrame f;
+			float durationMs;
+			ok = (bool)(words >> f.x >> f.y >> f.width >> f.height >> f.trimX >> f.trimY >> f.sourceWidth >> f.sourceHeight
+				>> f.pivotX >> f.pivotY >> durationMs);
+			f.duration = durationMs / 1000.0f;
+			frames.push_back(f);
+		}
+		else if (keyword == "clip")
+		{
+			SheetClip c;
+			std::string mode;
+			ok = (bool)(words >> c.name >> c.firstFrame >> c.frameCount >> c.framesPerSecond >> mode);
+
+			if (mode == "loop")
+				c.mode = SheetClip::Loop;
+			else if (mode == "once")
+				c.mode = SheetClip::Once;
+			else if (mode == "pingpong")
+				c.mode = SheetClip::PingPong;
+			else
+				ok = false;
+
+			clips.push_back(c);
+		}
+		else
+		{
+			ok = false;
+		}
+
+		if (!ok)
+		{
+			error = "line " + std::to_string(lineNumber) + ": can't read '" + line + "'";
+			return false;
+		}
+	}
+
+	return Validate();
+}
+
+// -----------------------------------------------------
+// Parse the cooked format
+//
+bool SpriteSheet::ParseBinary(const void* data, size_t size)
+{
+	Reset();
+
+	ByteReader reader(data, size);
+	if (reader.U32() != Magic)
+	{
+		error = "not a binary sheet";
+		return false;
+	}
+
+	uint32_t frameCount = reader.U32();
+	uint32_t clipCount = reader.U32();
+	framesPerSecond = reader.F32();
+	textureName = reader.String(reader.U16());
+
+	// don't trust the counts further than the data goes
+	if (!reader.Ok() || frameCount > size / 28 || clipCount > size / 10)
+	{
+		error = "header is broken";
+		return false;
+	}
+
+	frames.resize(frameCount);
+	for (uint32_t i = 0; i < frameCount; i++)
+	{
+		SheetFrame& f = frames[i];
+		f.x = reader.I16();
+		f.y = reader.I16();
+		f.width = reader.I16();
+		f.height = reader.I16();
+		f.trimX = reader.I16();
+		f.trimY = reader.I16();
+		f.sourceWidth = reader.I16();
+		f.sourceHeight = reader.I16();
+		f.pivotX = reader.F32();
+		f.pivotY = reader.F32();
+		f.duration = reader.F32();
+	}
+
+	clips.resize(clipCount);
+	for (uint32_t i = 0; i < clipCount; i++)
+	{
+		SheetClip& c = clips[i];
+		c.name = reader.String(reader.U8());
+		c.firstFrame = reader.U16();
+		c.frameCount = reader.U16();
+		c.framesPerSecond = reader.F32();
+		c.mode = (SheetClip::Mode)reader.U8();
+	}
+
+	if (!reader.Ok())
+	{
+		error = "file is cut short";
+		return false;
+	}
+
+	return Validate();
+}
+
+// -----------------------------------------------------
+// Write the cooked format
+//
+bool SpriteSheet::SaveBinary(const char* fileName) const
+{
+	std::vector<uint8_t> out;
+	PutU32(out, Magic);
+	PutU32(out, (uint32_t)frames.size());
+	PutU32(out, (uint32_t)clips.size());
+	PutF32(out, framesPerSecond);
+	PutU16(out, (uint32_t)textureName.size());
+	out.insert(out.end(), textureName.begin(), textureName.end());
+
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		const SheetFrame& f = frames[i];
+		PutU16(out, (uint16_t)f.x);
+		PutU16(out, (uint16_t)f.y);
+		PutU16(out, (uint16_t)f.width);
+		PutU16(out, (uint16_t)f.height);
+		PutU16(out, (uint16_t)f.trimX);
+		PutU16(out, (uint16_t)f.trimY);
+		PutU16(out, (uint16_t)f.sourceWidth);
+		PutU16(out, (uint16_t)f.sourceHeight);
+		PutF32(out, f.pivotX);
+		PutF32(out, f.pivotY);
+		PutF32(out, f.duration);
+	}
+
+	for (size_t i = 0; i < clips.size(); i++)
+	{
+		const SheetClip& c = clips[i];
+		PutU8(out, (uint32_t)c.name.size());
+		out.insert(out.end(), c.name.begin(), c.name.end());
+		PutU16(out, (uint32_t)c.firstFrame);
+		PutU16(out, (uint32_t)c.frameCount);
+		PutF32(out, c.framesPerSecond);
+		PutU8(out, (uint32_t)c.mode);
+	}
+
+	FILE* file = fopen(fileName, "wb");
+	if (file == nullptr)
+		return false;
+
+	bool written = fwrite(out.data(), 1, out.size(), file) == out.size();
+	fclose(file);
+	return written;
+}
+
+// -----------------------------------------------------
+// Check it all makes sense
+//
+bool SpriteSheet::Validate()
+{
+	for (size_t i = 0; i < frames.size(); i++)
+	{
+		const SheetFrame& f = frames[i];
+
+		// the rect has to fit in the frame it was trimmed from, and everything fits in 16 bits
+		bool ok = f.x >= 0 && f.y >= 0 && f.width > 0 && f.height > 0 &&
+			f.trimX >= 0 && f.trimY >= 0 &&
+			f.trimX + f.width <= f.sourceWidth && f.trimY + f.height <= f.sourceHeight &&
+			f.x + f.width <= 0x7fff && f.y + f.height <= 0x7fff && f.sourceWidth <= 0x7fff && f.sourceHeight <= 0x7fff &&
+			f.duration >= 0.0f;
+
+		if (!ok)
+		{
+			error = "frame " + std::to_string(i) + " is out of range";
+			return false;
+		}
+	}
+
+	for (size_t i = 0; i < clips.size(); i++)
+	{
+		const SheetClip& c = clips[i];
+
+		bool ok = !c.name.empty() && c.name.size() < 256 && c.firstFrame >= 0 && c.frameCount > 0 &&
+			c.firstFrame + c.frameCount <= (int)frames.size() && c.framesPerSecond > 0.0f &&
+			c.mode >= SheetClip::Loop && c.mode <= SheetClip::PingPong;
+
+		if (!ok)
+		{
+			error = "clip " + std::to_string(i) + " is out of range";
+			return false;
+		}
+	}
+
+	if (frames.empty())
+	{
+		error = "no frames";
+		return false;
+	}
+
+	return true;
+}
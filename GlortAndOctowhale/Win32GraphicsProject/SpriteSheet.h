@@ -0,0 +1,92 @@
+//
+// SpriteSheet
+//		Describes the frames and clips in a sprite sheet texture
+//
+//	Sheets are written as text, and cooked to binary for the game to load.
+//	Frames can be any size and anywhere in the texture, and can be trimmed: only the
+//	rect with something in it is stored, along with where it sat in the full frame.
+//
+//	Text format, one thing per line, # starts a comment:
+//		texture glortSpritesheet.png
+//		fps 8
+//		frame x y width height trimX trimY sourceWidth sourceHeight pivotX pivotY durationMs
+//		clip name firstFrame frameCount fps loop|once|pingpong
+//
+//	pivotX / pivotY are in the untrimmed frame. durationMs 0 means use the clip (or sheet) rate.
+//
+
+#ifndef _SPRITE_SHEET_H
+#define _SPRITE_SHEET_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+struct SheetFrame
+{
+	int		x, y, width, height;		// the (trimmed) rect in the texture
+	int		trimX, trimY;				// where that rect sits in the full frame
+	int		sourceWidth, sourceHeight;	// the full frame, before trimming
+	float	pivotX, pivotY;				// in the full frame
+	float	duration;					// seconds, 0 to use the playback rate
+};
+
+struct SheetClip
+{
+	enum Mode { Loop, Once, PingPong };	// same order as AnimationClip::Mode
+
+	std::string	name;
+	int			firstFrame;
+	int			frameCount;
+	float		framesPerSecond;
+	Mode		mode;
+};
+
+class SpriteSheet
+{
+public:
+	SpriteSheet();
+
+	// load a text or binary sheet, works out which from the first bytes
+	bool Load(const char* fileName);
+
+	// read a sheet that's already in memory. Parse works out which it is like Load
+	bool Parse(const void* data, size_t size);
+	bool ParseText(const char* text, size_t length);
+	bool ParseBinary(const void* data, size_t size);
+
+	// write the cooked version
+	bool SaveBinary(const char* fileName) const;
+
+	// what went wrong with the last Load / Parse
+	const std::string& GetError() const { return error; }
+
+	// texture the sheet was made for, as written in it
+	const std::string& GetTextureName() const { return textureName; }
+
+	// playback rate for frames without a duration, when there's no clip
+	float GetFramesPerSecond() const { return framesPerSecond; }
+
+	int GetFrameCount() const { return (int)frames.size(); }
+	const SheetFrame& GetFrame(int i) const { return frames[i]; }
+
+	int GetClipCount() const { return (int)clips.size(); }
+	const SheetClip& GetClip(int i) const { return clips[i]; }
+
+	// binary files start with this
+	static const uint32_t Magic = 0x31544853;	// "SHT1"
+
+private:
+	void Reset();
+
+	// checks the frames and clips make sense, sets error if not
+	bool Validate();
+
+	std::string				textureName;
+	float					framesPerSecond;
+	std::vector<SheetFrame>	frames;
+	std::vector<SheetClip>	clips;
+	std::string				error;
+};
+
+#endif // _SPRITE_SHEET_H
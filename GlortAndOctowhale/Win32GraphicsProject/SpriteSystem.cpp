@@ -0,0 +1,248 @@
+//
+// SpriteSystem
+//		Keeps the moving and animating state of lots of sprites in contiguous arrays
+//
+
+#include "SpriteSystem.h"
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define SPRITE_SYSTEM_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static const float twoPi = 3.141592f * 2.0f;
+
+// -----------------------------------------------------
+// Constructor
+//
+SpriteSystem::SpriteSystem()
+{
+}
+
+SpriteSystem::~SpriteSystem()
+{
+	Clear();
+}
+
+// -----------------------------------------------------
+// Move a sprite's state into the system
+//
+void SpriteSystem::Attach(Sprite* pSprite)
+{
+	if (pSprite == nullptr || pSprite->pSystem != nullptr)
+		return;
+
+	posX.push_back(pSprite->position.x);
+	posY.push_back(pSprite->position.y);
+	velX.push_back(pSprite->velocity.x);
+	velY.push_back(pSprite->velocity.y);
+	rotation.push_back(pSprite->rotation);
+	rotationalVelocity.push_back(pSprite->rotationalVelocity);
+	cosRotation.push_back(pSprite->cosRotation);
+	sinRotation.push_back(pSprite->sinRotation);
+	elapsedTime.push_back(pSprite->elapsedTime);
+	frameTime.push_back(pSprite->FrameCount() > 0 ? pSprite->frameTime : 0.0f);
+	currentFrame.push_back(pSprite->currentFrame);
+	totalFrames.push_back(pSprite->FrameCount());
+	owners.push_back(pSprite);
+
+	pSprite->pSystem = this;
+	pSprite->slot = (int)owners.size() - 1;
+}
+
+// -----------------------------------------------------
+// Copy a sprite's state back into it
+//	the last slot moves into the gap, so the arrays stay packed
+//
+void SpriteSystem::Detach(Sprite* pSprite)
+{
+	if (pSprite == nullptr || pSprite->pSystem != this)
+		return;
+
+	int s = pSprite->slot;
+
+	// in DETERMINISTIC_SIM builds the sprite kept its own state all along
+	if (pSprite->IsView())
+	{
+		pSprite->position = Vector2(posX[s], posY[s]);
+		pSprite->velocity = Vector2(velX[s], velY[s]);
+		pSprite->rotation = rotation[s];
+		pSprite->rotationalVelocity = rotationalVelocity[s];
+		pSprite->cosRotation = cosRotation[s];
+		pSprite->sinRotation = sinRotation[s];
+		pSprite->elapsedTime = elapsedTime[s];
+		pSprite->currentFrame = currentFrame[s];
+	}
+
+	pSprite->pSystem = nullptr;
+	pSprite->slot = -1;
+
+	int last = (int)owners.size() - 1;
+	if (s != last)
+	{
+		posX[s] = posX[last];
+		posY[s] = posY[last];
+		velX[s] = velX[last];
+		velY[s] = velY[last];
+		rotation[s] = rotation[last];
+		rotationalVelocity[s] = rotationalVelocity[last];
+		cosRotation[s] = cosRotation[last];
+		sinRotation[s] = sinRotation[last];
+		elapsedTime[s] = elapsedTime[last];
+		frameTime[s] = frameTime[last];
+		currentFrame[s] = currentFrame[last];
+		totalFrames[s] = totalFrames[last];
+		owners[s] = owners[last];
+		owners[s]->slot = s;
+	}
+
+	posX.pop_back();
+	posY.pop_back();
+	velX.pop_back();
+	velY.pop_back();
+	rotation.pop_back();
+	rotationalVelocity.pop_back();
+	cosRotation.pop_back();
+	sinRotation.pop_back();
+	elapsedTime.pop_back();
+	frameTime.pop_back();
+	currentFrame.pop_back();
+	totalFrames.pop_back();
+	owners.pop_back();
+}
+
+// -----------------------------------------------------
+// Detach everything
+//
+void SpriteSystem::Clear()
+{
+	while (!owners.empty())
+		Detach(owners.back());
+}
+
+// -----------------------------------------------------
+// A slot moved on to another frame, only now does the sprite's region need changing
+//	the sprite knows how its clip wraps or ends
+//
+void SpriteSystem::AdvanceFrame(int slot, int advanceFrames)
+{
+	owners[slot]->StepFrames(currentFrame[slot], advanceFrames);
+}
+
+// -----------------------------------------------------
+// Keep the rotation in range and recalculate its cos and sin
+//
+void SpriteSystem::UpdateRotationTrig(int slot)
+{
+	float& r = rotation[slot];
+	while (r > twoPi) r -= twoPi;
+	while (r < -twoPi) r += twoPi;
+
+	cosRotation[slot] = cosf(r);
+	sinRotation[slot] = sinf(r);
+}
+
+// -----------------------------------------------------
+// Scalar update of some slots
+//
+void SpriteSystem::UpdateRange(int begin, int end, float deltaTime)
+{
+	for (int i = begin; i < end; i++)
+	{
+		if (frameTime[i] > 0.0f)
+		{
+			elapsedTime[i] += deltaTime;
+
+			// how many frames to move forward, and the time left over
+			int advanceFrames = (int)(elapsedTime[i] / frameTime[i]);
+			if (advanceFrames > 0)
+			{
+				elapsedTime[i] -= advanceFrames * frameTime[i];
+				if (elapsedTime[i] < 0.0f)
+					elapsedTime[i] = 0.0f;
+
+				AdvanceFrame(i, advanceFrames);
+			}
+		}
+
+		posX[i] += velX[i] * deltaTime;
+		posY[i] += velY[i] * deltaTime;
+
+		if (rotationalVelocity[i] != 0.0f)
+		{
+			rotation[i] += rotationalVelocity[i] * deltaTime;
+			UpdateRotationTrig(i);
+		}
+	}
+}
+
+// -----------------------------------------------------
+// Move and animate everything
+//	the arithmetic is done 4 slots at a time, then only the slots that changed
+//	frame or are rotating get any more work
+//
+void SpriteSystem::Update(float deltaTime)
+{
+#ifdef DETERMINISTIC_SIM
+	for (size_t i = 0; i < owners.size(); i++)
+		owners[i]->UpdateAnimation(deltaTime);
+#else
+	int count = (int)owners.size();
+	int i = 0;
+
+#ifdef SPRITE_SYSTEM_SSE2
+	const __m128 dt = _mm_set1_ps(deltaTime);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		// position
+		__m128 x = _mm_add_ps(_mm_loadu_ps(&posX[i]), _mm_mul_ps(_mm_loadu_ps(&velX[i]), dt));
+		__m128 y = _mm_add_ps(_mm_loadu_ps(&posY[i]), _mm_mul_ps(_mm_loadu_ps(&velY[i]), dt));
+		_mm_storeu_ps(&posX[i], x);
+		_mm_storeu_ps(&posY[i], y);
+
+		// rotation, the slots that don't rotate add 0
+		__m128 rv = _mm_loadu_ps(&rotationalVelocity[i]);
+		_mm_storeu_ps(&rotation[i], _mm_add_ps(_mm_loadu_ps(&rotation[i]), _mm_mul_ps(rv, dt)));
+		int rotating = _mm_movemask_ps(_mm_cmpneq_ps(rv, zero));
+
+		// animation time, slots that aren't animated stay at 0
+		__m128 ft = _mm_loadu_ps(&frameTime[i]);
+		__m128 animated = _mm_cmpgt_ps(ft, zero);
+		__m128 elapsed = _mm_and_ps(_mm_add_ps(_mm_loadu_ps(&elapsedTime[i]), dt), animated);
+
+		// whole frames passed (divide by 1 where not animated), and the time left over
+		__m128 divisor = _mm_or_ps(_mm_and_ps(animated, ft), _mm_andnot_ps(animated, one));
+		__m128i advance = _mm_cvttps_epi32(_mm_div_ps(elapsed, divisor));
+		elapsed = _mm_sub_ps(elapsed, _mm_mul_ps(_mm_cvtepi32_ps(advance), ft));
+		_mm_storeu_ps(&elapsedTime[i], _mm_max_ps(elapsed, zero));
+
+		int advanced = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(advance, _mm_setzero_si128())));
+
+		// the few slots that need more work
+		if (advanced)
+		{
+			int frames[4];
+			_mm_storeu_si128((__m128i*)frames, advance);
+			for (int lane = 0; lane < 4; lane++)
+			{
+				if (advanced & (1 << lane))
+					AdvanceFrame(i + lane, frames[lane]);
+			}
+		}
+
+		for (int lane = 0; rotating && lane < 4; lane++)
+		{
+			if (rotating & (1 << lane))
+				UpdateRotationTrig(i + lane);
+		}
+	}
+#endif
+
+	// whatever is left over
+	UpdateRange(i, count, deltaTime);
+#endif
+}
@@ -0,0 +1,74 @@
+//
+// SpriteSystem
+//		Keeps the moving and animating state of lots of sprites in contiguous arrays
+//
+//	A Sprite attached to a system becomes a view, its position, velocity, rotation and
+//	animation timing live here instead, and Update moves and animates every sprite in one
+//	pass, 4 at a time with SSE2. Everything else about the sprite (texture, region, colour)
+//	stays in the Sprite, and only gets touched when the animation frame actually changes.
+//
+//	In DETERMINISTIC_SIM builds the sprites keep their own fixed point state, and Update
+//	just calls UpdateAnimation on each of them.
+//
+
+#ifndef _SPRITE_SYSTEM_H
+#define _SPRITE_SYSTEM_H
+
+#include <vector>
+#include "Sprite.h"
+
+class SpriteSystem
+{
+public:
+	SpriteSystem();
+
+	// detaches everything still attached
+	~SpriteSystem();
+
+	// move a sprite's state into the system, the sprite then reads and writes it here
+	//	a sprite can only be in one system. sprites can't be copied
+	void Attach(Sprite* pSprite);
+
+	// copy a sprite's state back into it, it carries on by itself
+	void Detach(Sprite* pSprite);
+
+	// detach everything
+	void Clear();
+
+	// move and animate every attached sprite
+	void Update(float deltaTime);
+
+	// number of attached sprites
+	int GetCount() const { return (int)owners.size(); }
+
+private:
+	friend class Sprite;
+
+	// scalar update of a range of slots, for the leftovers and single sprites
+	void UpdateRange(int begin, int end, float deltaTime);
+
+	// a slot moved on to another frame
+	void AdvanceFrame(int slot, int advanceFrames);
+
+	// a slot's rotation changed
+	void UpdateRotationTrig(int slot);
+
+	// hot state, one entry per slot
+	std::vector<float>		posX;
+	std::vector<float>		posY;
+	std::vector<float>		velX;
+	std::vector<float>		velY;
+	std::vector<float>		rotation;			// radians
+	std::vector<float>		rotationalVelocity;	// radians / sec
+	std::vector<float>		cosRotation;
+	std::vector<float>		sinRotation;
+	std::vector<float>		elapsedTime;
+	std::vector<float>		frameTime;			// 0 when the sprite isn't animated
+	std::vector<int>		currentFrame;
+	std::vector<int>		totalFrames;
+
+	// the sprite each slot belongs to
+	std::vector<Sprite*>	owners;
+};
+
+#endif // _SPRITE_SYSTEM_H
@@ -0,0 +1,252 @@
+//
+// SweepAndPrune
+//		Sort and sweep broadphase for lots of moving shapes
+//
+
+#include "SweepAndPrune.h"
+#include <algorithm>
+
+// -----------------------------------------------------
+// Constructor
+//
+SweepAndPrune::SweepAndPrune()
+{
+	proxyCount = 0;
+	lastSwaps = 0;
+	inserted = 0;
+	removed = false;
+}
+
+// -----------------------------------------------------
+// Removes everything
+//
+void SweepAndPrune::Clear()
+{
+	proxies.clear();
+	freeProxies.clear();
+	endpoints.clear();
+	active.clear();
+	proxyCount = 0;
+	lastSwaps = 0;
+	inserted = 0;
+	removed = false;
+}
+
+// -----------------------------------------------------
+// Add a shape
+//	its endpoints go on the end of the list, the next sort moves them into place
+//
+int SweepAndPrune::Insert(const Box2D& box, int userData)
+{
+	int proxy;
+	if (!freeProxies.empty())
+	{
+		proxy = freeProxies.back();
+		freeProxies.pop_back();
+	}
+	else
+	{
+		proxy = (int)proxies.size();
+		proxies.push_back(Proxy());
+	}
+
+	Proxy& p = proxies[proxy];
+	p.lower = box.center - box.extents;
+	p.upper = box.center + box.extents;
+	p.userData = userData;
+	p.activeSlot = -1;
+	p.used = true;
+
+	Endpoint minEnd = { p.lower.x, proxy << 1 };
+	Endpoint maxEnd = { p.upper.x, (proxy << 1) | 1 };
+	endpoints.push_back(minEnd);
+	endpoints.push_back(maxEnd);
+	inserted += 2;
+
+	proxyCount++;
+	return proxy;
+}
+
+int SweepAndPrune::Insert(const Circle& circle, int userData)
+{
+	return Insert(Box2D(circle.center, Vector2(circle.radius, circle.radius)), userData);
+}
+
+// -----------------------------------------------------
+// Take a shape out
+//	its endpoints are dropped from the list in the next FindPairs
+//
+void SweepAndPrune::Remove(int proxy)
+{
+	if (proxy < 0 || proxy >= (int)proxies.size() || !proxies[proxy].used)
+		return;
+
+	proxies[proxy].used = false;
+	freeProxies.push_back(proxy);
+	proxyCount--;
+	removed = true;
+}
+
+// -----------------------------------------------------
+// A shape moved
+//
+void SweepAndPrune::Move(int proxy, const Box2D& box)
+{
+	proxies[proxy].lower = box.center - box.extents;
+	proxies[proxy].upper = box.center + box.extents;
+}
+
+void SweepAndPrune::Move(int proxy, const Circle& circle)
+{
+	Vector2 extents(circle.radius, circle.radius);
+	proxies[proxy].lower = circle.center - extents;
+	proxies[proxy].upper = circle.center + extents;
+}
+
+// -----------------------------------------------------
+// Get the box of a proxy
+//
+Box2D SweepAndPrune::GetBox(int proxy) const
+{
+	const Proxy& p = proxies[proxy];
+	return Box2D((p.lower + p.upper) * 0.5f, (p.upper - p.lower) * 0.5f);
+}
+
+// -----------------------------------------------------
+// Sort the endpoints
+//	mins go before maxes at the same value, so touching boxes still count as overlapping.
+//	the ones that were already sorted are insertion sorted, which is close to O(n) when
+//	they've only moved a little. a lot of new ones on the end would make that O(n^2),
+//	50k boxes inserted at once took seconds, so they're sorted by themselves and merged in
+//
+int SweepAndPrune::SortEndpoints(int sorted)
+{
+	// a handful of new ones are cheaper to insertion sort along with the rest
+	const int mergeThreshold = 64;
+
+	int swaps = 0;
+	int count = (int)endpoints.size();
+	if (count - sorted > mergeThreshold)
+		count = sorted;
+
+	for (int i = 1; i < count; i++)
+	{
+		Endpoint key = endpoints[i];
+		int j = i - 1;
+
+		while (j >= 0 && (endpoints[j].value > key.value ||
+			(endpoints[j].value == key.value && endpoints[j].IsMax() && !key.IsMax())))
+		{
+			endpoints[j + 1] = endpoints[j];
+			j--;
+		}
+
+		if (j + 1 != i)
+		{
+			swaps += i - (j + 1);
+			endpoints[j + 1] = key;
+		}
+	}
+
+	if (count < (int)endpoints.size())
+	{
+		auto less = [](const Endpoint& a, const Endpoint& b)
+		{
+			return a.value < b.value || (a.value == b.value && !a.IsMax() && b.IsMax());
+		};
+
+		std::sort(endpoints.begin() + sorted, endpoints.end(), less);
+		std::inplace_merge(endpoints.begin(), endpoints.begin() + sorted, endpoints.end(), less);
+	}
+
+	return swaps;
+}
+
+// -----------------------------------------------------
+// Re-sort and sweep the endpoints for overlapping pairs
+//
+int SweepAndPrune::FindPairs(std::vector<ProxyPair>& pairs)
+{
+	// drop the endpoints of removed proxies, and pick up where everything moved to
+	//	a removed proxy that was reused has new endpoints on the end, so only keep the first pair we see
+	int sorted = (int)endpoints.size() - inserted;
+	int write = 0;
+	if (removed)
+	{
+		int firstNew = sorted;
+		std::vector<char> seen(proxies.size() * 2, 0);
+		for (int i = 0; i < (int)endpoints.size(); i++)
+		{
+			if (i == firstNew)
+				sorted = write;
+
+			Endpoint e = endpoints[i];
+			const Proxy& p = proxies[e.Proxy()];
+			if (!p.used || seen[e.data])
+				continue;
+
+			seen[e.data] = 1;
+			e.value = e.IsMax() ? p.upper.x : p.lower.x;
+			endpoints[write++] = e;
+		}
+		endpoints.resize(write);
+		sorted = std::min(sorted, write);
+		removed = false;
+	}
+	else
+	{
+		for (int i = 0; i < (int)endpoints.size(); i++)
+		{
+			Endpoint& e = endpoints[i];
+			const Proxy& p = proxies[e.Proxy()];
+			e.value = e.IsMax() ? p.upper.x : p.lower.x;
+		}
+	}
+
+	lastSwaps = SortEndpoints(sorted);
+	inserted = 0;
+
+	// sweep along x. everything in the active list overlaps the current box on x,
+	//	so only y needs checking
+	int found = 0;
+	active.clear();
+
+	for (int i = 0; i < (int)endpoints.size(); i++)
+	{
+		const Endpoint& e = endpoints[i];
+		int proxy = e.Proxy();
+		Proxy& p = proxies[proxy];
+
+		if (e.IsMax())
+		{
+			// leaving this box, swap it out of the active list
+			int slot = p.activeSlot;
+			int last = active.back();
+			active[slot] = last;
+			proxies[last].activeSlot = slot;
+			active.pop_back();
+			p.activeSlot = -1;
+			continue;
+		}
+
+		for (int a = 0; a < (int)active.size(); a++)
+		{
+			int other = active[a];
+			const Proxy& o = proxies[other];
+
+			if (p.lower.y <= o.upper.y && o.lower.y <= p.upper.y)
+			{
+				ProxyPair pair;
+				pair.proxyA = proxy < other ? proxy : other;
+				pair.proxyB = proxy < other ? other : proxy;
+				pairs.push_back(pair);
+				found++;
+			}
+		}
+
+		p.activeSlot = (int)active.size();
+		active.push_back(proxy);
+	}
+
+	return found;
+}
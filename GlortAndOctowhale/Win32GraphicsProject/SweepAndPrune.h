@@ -0,0 +1,88 @@
+//
+// SweepAndPrune
+//		Sort and sweep broadphase for lots of moving shapes
+//
+//	The min and max x of every box are kept in one sorted list. Things don't move far
+//	between frames so the list is nearly sorted already, and an insertion sort puts it
+//	back in order in close to O(n). Shapes inserted since the last sort aren't anywhere
+//	near their place, so once there are more than a few of them they're sorted on their
+//	own and merged in instead. Sweeping the list then only has to compare boxes that
+//	overlap on x.
+//
+
+#ifndef _SWEEP_AND_PRUNE_H
+#define _SWEEP_AND_PRUNE_H
+
+#include <vector>
+#include "Collision2D.h"
+
+class SweepAndPrune
+{
+public:
+	SweepAndPrune();
+
+	// add a shape, returns the proxy id used to refer to it. userData is kept for the caller
+	int Insert(const Box2D& box, int userData);
+	int Insert(const Circle& circle, int userData);
+
+	// take a shape out
+	void Remove(int proxy);
+
+	// a shape moved. the sorted list is fixed up in the next FindPairs
+	void Move(int proxy, const Box2D& box);
+	void Move(int proxy, const Circle& circle);
+
+	// removes everything
+	void Clear();
+
+	// the box and user data of a proxy
+	Box2D GetBox(int proxy) const;
+	int GetUserData(int proxy) const { return proxies[proxy].userData; }
+
+	// re-sorts the list and gathers every pair of proxies whose boxes overlap
+	//	returns how many were added. the pairs still need a narrowphase test
+	int FindPairs(std::vector<ProxyPair>& pairs);
+
+	// number of endpoint swaps the last sort needed, low when things move coherently.
+	//	newly inserted endpoints that were merged in aren't counted
+	int GetLastSwapCount() const { return lastSwaps; }
+
+	int GetProxyCount() const { return proxyCount; }
+
+private:
+	// one end of a box on the x axis. the value is copied here so the sort stays in one array
+	struct Endpoint
+	{
+		float	value;
+		int		data;		// proxy << 1, low bit set for the max end
+
+		int Proxy() const { return data >> 1; }
+		bool IsMax() const { return (data & 1) != 0; }
+	};
+
+	struct Proxy
+	{
+		Vector2	lower;
+		Vector2	upper;
+		int		userData;
+		int		activeSlot;	// where it is in the active list during a sweep
+		bool	used;
+	};
+
+	// sort the endpoints, returns the number of insertion sort swaps. the ones from
+	//	sorted on are new and could be anywhere
+	int SortEndpoints(int sorted);
+
+	std::vector<Proxy>		proxies;
+	std::vector<int>		freeProxies;
+	std::vector<Endpoint>	endpoints;
+	int						proxyCount;
+	int						lastSwaps;
+	int						inserted;	// endpoints on the end of the list since the last sort
+	bool					removed;	// endpoints of removed proxies are still in the list
+
+	// proxies whose x range we are inside during the sweep
+	std::vector<int>		active;
+};
+
+#endif // _SWEEP_AND_PRUNE_H
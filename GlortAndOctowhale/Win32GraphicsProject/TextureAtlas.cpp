@@ -0,0 +1,163 @@
+//
+// TextureAtlas
+//		Where each packed image ended up in an atlas, written by Tools\AtlasPacker
+//
+
+#include "TextureAtlas.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <sstream>
+
+// -----------------------------------------------------
+// Load from disk
+//
+bool TextureAtlas::Load(const char* fileName)
+{
+	FILE* file = fopen(fileName, "rb");
+	if (file == nullptr)
+	{
+		pages.clear();
+		regions.clear();
+		error = std::string("can't open ") + fileName;
+		return false;
+	}
+
+	std::vector<char> data;
+	char buffer[4096];
+	size_t n;
+	while ((n = fread(buffer, 1, sizeof(buffer), file)) > 0)
+	{
+		data.insert(data.end(), buffer, buffer + n);
+	}
+	fclose(file);
+
+	return Parse(data.data(), data.size());
+}
+
+// -----------------------------------------------------
+// Parse the text
+//
+bool TextureAtlas::Parse(const char* text, size_t length)
+{
+	pages.clear();
+	regions.clear();
+	error.clear();
+
+	std::istringstream input(std::string(text, length));
+	std::string line;
+	int lineNumber = 0;
+
+	while (std::getline(input, line))
+	{
+		lineNumber++;
+
+		// comments and blank lines
+		size_t hash = line.find('#');
+		if (hash != std::string::npos)
+			line.erase(hash);
+
+		std::istringstream words(line);
+		std::string keyword;
+		if (!(words >> keyword))
+			continue;
+
+		bool ok = true;
+		if (keyword == "page")
+		{
+			AtlasPage p;
+			ok = (bool)(words >> p.fileName >> p.width >> p.height);
+			pages.push_back(p);
+		}
+		else if (keyword == "region")
+		{
+			AtlasRegion r;
+			ok = (bool)(words >> r.name >> r.page >> r.x >> r.y >> r.width >> r.height);
+			regions.push_back(r);
+		}
+		else
+		{
+			ok = false;
+		}
+
+		if (!ok)
+		{
+			error = "line " + std::to_string(lineNumber) + ": can't read '" + line + "'";
+			return false;
+		}
+	}
+
+	return Validate();
+}
+
+bool TextureAtlas::Validate()
+{
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		const AtlasRegion& r = regions[i];
+		if (r.page < 0 || r.page >= (int)pages.size())
+		{
+			error = "region " + r.name + " is on a page that isn't there";
+			return false;
+		}
+
+		const AtlasPage& p = pages[r.page];
+		if (r.x < 0 || r.y < 0 || r.width <= 0 || r.height <= 0 || r.x + r.width > p.width || r.y + r.height > p.height)
+		{
+			error = "region " + r.name + " is outside its page";
+			return false;
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------
+// Write it out
+//
+bool TextureAtlas::Save(const char* fileName) const
+{
+	FILE* file = fopen(fileName, "w");
+	if (file == nullptr)
+		return false;
+
+	fprintf(file, "# written by AtlasPacker\n");
+	for (size_t i = 0; i < pages.size(); i++)
+	{
+		fprintf(file, "page %s %d %d\n", pages[i].fileName.c_str(), pages[i].width, pages[i].height);
+	}
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		const AtlasRegion& r = regions[i];
+		fprintf(file, "region %s %d %d %d %d %d\n", r.name.c_str(), r.page, r.x, r.y, r.width, r.height);
+	}
+
+	return fclose(file) == 0;
+}
+
+int TextureAtlas::AddPage(const std::string& fileName, int width, int height)
+{
+	AtlasPage p;
+	p.fileName = fileName;
+	p.width = width;
+	p.height = height;
+	pages.push_back(p);
+	return (int)pages.size() - 1;
+}
+
+// -----------------------------------------------------
+// Look up a region, there are only ever a few dozen
+//
+const AtlasRegion* TextureAtlas::Find(const char* name) const
+{
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		const std::string& n = regions[i].name;
+
+		size_t c = 0;
+		while (c < n.size() && name[c] && tolower((unsigned char)n[c]) == tolower((unsigned char)name[c]))
+			c++;
+
+		if (c == n.size() && name[c] == 0)
+			return &regions[i];
+	}
+	return nullptr;
+}
@@ -0,0 +1,66 @@
+//
+// TextureAtlas
+//		Where each packed image ended up in an atlas, written by Tools\AtlasPacker
+//
+//	Text format, one thing per line, # starts a comment:
+//		page gameplay0.png 1024 512
+//		region buttonPlay.png page x y width height
+//
+//	Page files are relative to the manifest. Region names are the file names of the
+//	images that were packed, so a region can stand in for the file it came from.
+//
+
+#ifndef _TEXTURE_ATLAS_H
+#define _TEXTURE_ATLAS_H
+
+#include <string>
+#include <vector>
+
+struct AtlasPage
+{
+	std::string	fileName;
+	int			width, height;
+};
+
+struct AtlasRegion
+{
+	std::string	name;
+	int			page;
+	int			x, y, width, height;
+};
+
+class TextureAtlas
+{
+public:
+	// read a manifest
+	bool Load(const char* fileName);
+	bool Parse(const char* text, size_t length);
+
+	// write one
+	bool Save(const char* fileName) const;
+
+	// what went wrong with the last Load / Parse
+	const std::string& GetError() const { return error; }
+
+	int AddPage(const std::string& fileName, int width, int height);
+	void AddRegion(const AtlasRegion& region) { regions.push_back(region); }
+
+	int GetPageCount() const { return (int)pages.size(); }
+	const AtlasPage& GetPage(int i) const { return pages[i]; }
+
+	int GetRegionCount() const { return (int)regions.size(); }
+	const AtlasRegion& GetRegion(int i) const { return regions[i]; }
+
+	// the region for a name, case doesn't matter. null if there isn't one
+	const AtlasRegion* Find(const char* name) const;
+
+private:
+	// checks every region is inside its page, sets error if not
+	bool Validate();
+
+	std::vector<AtlasPage>		pages;
+	std::vector<AtlasRegion>	regions;
+	std::string					error;
+};
+
+#endif // _TEXTURE_ATLAS_H
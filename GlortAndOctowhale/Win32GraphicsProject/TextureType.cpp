@@ -5,9 +5,48 @@
 
 #include "TextureType.h"
 #include "DirectX.h"
+#include "AssetLoader.h"
+#include "AssetPack.h"
+#include "DecodeCache.h"
+#include "PngCodec.h"
+#include <wctype.h>
 #include <WICTextureLoader.h> // for loading bmp, jpgs
 #include <DDSTextureLoader.h> // for loading dds files
 
+// ----------------------------------------------------------
+// Whether the file name ends with extension, which is lower case
+//
+static bool HasExtension( const wchar_t* fileName, const wchar_t* extension )
+{
+	std::wstring end = fileName;
+	end.erase( 0, end.find_last_of( L'.' ) );
+	for ( size_t i = 0; i < end.size(); i++ )
+	{
+		end[i] = (wchar_t)towlower( end[i] );
+	}
+	return end == extension;
+}
+
+static bool ReadWholeFile( const wchar_t* fileName, std::vector<uint8_t>& data )
+{
+	FILE* file = _wfopen( fileName, L"rb" );
+	if ( file == NULL )
+	{
+		return false;
+	}
+
+	uint8_t buffer[65536];
+	size_t n;
+	while ( ( n = fread( buffer, 1, sizeof(buffer), file ) ) > 0 )
+	{
+		data.insert( data.end(), buffer, buffer + n );
+	}
+	fclose( file );
+	return true;
+}
+
+bool TextureType::keepPixels = false;
+
 // ----------------------------------------------------------
 // Constructor 
 //
@@ -15,6 +54,14 @@ TextureType::TextureType()
 {
 	pView = NULL;
 	pTexture = NULL;
+	ZeroMemory( &desc, sizeof(desc) );
+	offsetX = 0;
+	offsetY = 0;
+	isRegion = false;
+	premultiplied = false;
+	pDevice = NULL;
+	pLoader = NULL;
+	pRegionPage = NULL;
 }
 
 // ----------------------------------------------------------
@@ -23,11 +70,19 @@ TextureType::TextureType()
 bool TextureType::Load( ID3D11Device* device,  const wchar_t* fileName  )
 {
 	// If we're already loaded, unload the previous
-	if ( pTexture != NULL ) 
+	if ( pTexture != NULL || IsPending() ) 
 	{
 		Unload();
 	}
 
+	// PNGs go through the decode cache when there is one, it's quicker than WIC or PngCodec
+	//	every time. WIC doesn't give us the pixels, so they go that way to keep them too
+	if ( ( DecodeCache::IsEnabled() || keepPixels ) && HasExtension( fileName, L".png" ) )
+	{
+		std::vector<uint8_t> data;
+		return ReadWholeFile( fileName, data ) && LoadFromMemory( device, data.data(), data.size(), fileName );
+	}
+
 	// save the path to the file
 	filePath = fileName;
 
@@ -37,7 +92,10 @@ bool TextureType::Load( ID3D11Device* device,  const wchar_t* fileName  )
 	// check if it's a dds file or not
 	if ( filePath.find(L".dds") != std::wstring::npos )
 	{
-		result = DirectX::CreateDDSTextureFromFile( device, fileName, (ID3D11Resource**) &pTexture, &pView );
+		// cooked textures say whether they're premultiplied (see Tools\TextureCook)
+		DirectX::DDS_ALPHA_MODE alphaMode = DirectX::DDS_ALPHA_MODE_UNKNOWN;
+		result = DirectX::CreateDDSTextureFromFile( device, fileName, (ID3D11Resource**) &pTexture, &pView, 0, &alphaMode );
+		premultiplied = alphaMode == DirectX::DDS_ALPHA_MODE_PREMULTIPLIED;
 	}
 	else
 	{
@@ -56,16 +114,300 @@ bool TextureType::Load( ID3D11Device* device,  const wchar_t* fileName  )
 	return true;
 }
 
+// ----------------------------------------------------------
+// Load it from an asset pack
+//
+bool TextureType::Load( ID3D11Device* device, const AssetPack& pack, const wchar_t* fileName )
+{
+	if ( pTexture != NULL || IsPending() ) 
+	{
+		Unload();
+	}
+
+	const PackEntry* entry = pack.Find( fileName );
+	AssetData data;
+	if ( entry == NULL || !pack.Read( *entry, data ) )
+	{
+		return false;
+	}
+
+	return LoadFromMemory( device, data.data, data.size, fileName );
+}
+
+bool TextureType::LoadFromMemory( ID3D11Device* device, const uint8_t* data, size_t size, const wchar_t* fileName )
+{
+	if ( ( DecodeCache::IsEnabled() || keepPixels ) && HasExtension( fileName, L".png" ) )
+	{
+		ImageRGBA image;
+		if ( !DecodeCache::Decode( data, size, image ) || !Create( device, image.width, image.height, image.pixels.data() ) )
+		{
+			return false;
+		}
+		filePath = fileName;
+		if ( keepPixels )
+		{
+			pPixels = std::make_shared<ImageRGBA>( std::move( image ) );
+		}
+		return true;
+	}
+
+	filePath = fileName;
+
+	HRESULT result;
+	if ( HasExtension( fileName, L".dds" ) )
+	{
+		// the blocks are uploaded straight from data, a mapped pack's included
+		DirectX::DDS_ALPHA_MODE alphaMode = DirectX::DDS_ALPHA_MODE_UNKNOWN;
+		result = DirectX::CreateDDSTextureFromMemory( device, data, size, (ID3D11Resource**) &pTexture, &pView, 0, &alphaMode );
+		premultiplied = alphaMode == DirectX::DDS_ALPHA_MODE_PREMULTIPLIED;
+	}
+	else
+	{
+		result = DirectX::CreateWICTextureFromMemory( device, data, size, (ID3D11Resource**) &pTexture, &pView );
+	}
+
+	if ( result != S_OK )
+	{
+		return false;
+	}
+
+	pTexture->GetDesc( &desc );
+
+	return true;
+}
+
+// ----------------------------------------------------------
+// Start loading the texture on the loader's threads
+//
+bool TextureType::LoadAsync( ID3D11Device* device, AssetLoader& loader, const wchar_t* fileName )
+{
+	if ( pTexture != NULL || IsPending() ) 
+	{
+		Unload();
+	}
+
+	// the loader only decodes PNGs
+	if ( !HasExtension( fileName, L".png" ) )
+	{
+		return Load( device, fileName );
+	}
+
+	filePath = fileName;
+	pDevice = device;
+	pLoader = &loader;
+	pending = loader.Queue( fileName );
+	premultiplied = pending->premultiplied;
+
+	return true;
+}
+
+bool TextureType::LoadAsync( ID3D11Device* device, AssetLoader& loader, const AssetPack& pack, const wchar_t* fileName )
+{
+	if ( pTexture != NULL || IsPending() ) 
+	{
+		Unload();
+	}
+
+	const PackEntry* entry = pack.Find( fileName );
+	if ( entry == NULL )
+	{
+		return false;
+	}
+
+	if ( !HasExtension( fileName, L".png" ) )
+	{
+		return Load( device, pack, fileName );
+	}
+
+	filePath = fileName;
+	pDevice = device;
+	pLoader = &loader;
+	pending = loader.Queue( pack, *entry, fileName );
+	premultiplied = pending->premultiplied;
+
+	return true;
+}
+
+// ----------------------------------------------------------
+// Finish an async load
+//
+void TextureType::Resolve() const
+{
+	// finishing the load doesn't change what the texture is, so callers see this as const
+	TextureType* self = const_cast<TextureType*>( this );
+
+	if ( pRegionPage != NULL )
+	{
+		const TextureType* page = pRegionPage;
+		self->pRegionPage = NULL;
+
+		page->Resolve();
+		if ( page->pTexture == NULL || offsetX + (int)desc.Width > page->offsetX + page->GetWidth() ||
+			offsetY + (int)desc.Height > page->offsetY + page->GetHeight() )
+		{
+			OutputDebugStringW( ( L"TextureType: region of " + filePath + L" isn't on the page\n" ).c_str() );
+			return;
+		}
+
+		self->Share( *page );
+		return;
+	}
+
+	if ( pending == nullptr )
+	{
+		return;
+	}
+
+	// Create would throw these away
+	std::shared_ptr<PendingImage> image = pending;
+	AssetLoader* loader = pLoader;
+	ID3D11Device* device = pDevice;
+	std::wstring path = filePath;
+	self->pending.reset();
+
+	if ( !loader->Wait( *image ) )
+	{
+		OutputDebugStringW( ( L"TextureType: can't load " + path + L"\n" ).c_str() );
+		return;
+	}
+
+	double uploadStart = loader->GetMilliseconds();
+	self->Create( device, image->image.width, image->image.height, image->image.pixels.data() );
+	self->filePath = path;
+	self->premultiplied = image->premultiplied;
+	image->uploadTime = loader->GetMilliseconds() - uploadStart;
+
+	// the pixels are on the GPU now, only keep them if they're wanted on the cpu too
+	if ( keepPixels )
+	{
+		self->pPixels = std::make_shared<ImageRGBA>( std::move( image->image ) );
+	}
+	std::vector<uint32_t>().swap( image->image.pixels );
+}
+
+// ----------------------------------------------------------
+// Make the texture from pixels in memory
+//
+bool TextureType::Create( ID3D11Device* device, int width, int height, const unsigned int* pixels )
+{
+	if ( pTexture != NULL || IsPending() ) 
+	{
+		Unload();
+	}
+
+	filePath.clear();
+
+	D3D11_TEXTURE2D_DESC textureDesc;
+	ZeroMemory( &textureDesc, sizeof(textureDesc) );
+	textureDesc.Width = width;
+	textureDesc.Height = height;
+	textureDesc.MipLevels = 1;
+	textureDesc.ArraySize = 1;
+	textureDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	textureDesc.SampleDesc.Count = 1;
+	textureDesc.Usage = D3D11_USAGE_IMMUTABLE;
+	textureDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+
+	D3D11_SUBRESOURCE_DATA data;
+	data.pSysMem = pixels;
+	data.SysMemPitch = width * 4;
+	data.SysMemSlicePitch = 0;
+
+	if ( device->CreateTexture2D( &textureDesc, &data, &pTexture ) != S_OK )
+	{
+		return false;
+	}
+
+	if ( device->CreateShaderResourceView( pTexture, NULL, &pView ) != S_OK )
+	{
+		Unload();
+		return false;
+	}
+
+	pTexture->GetDesc( &desc );
+
+	return true;
+}
+
+// ----------------------------------------------------------
+// Share part of another texture
+//
+bool TextureType::CreateRegion( const TextureType& page, int left, int top, int width, int height )
+{
+	if ( pTexture != NULL || IsPending() ) 
+	{
+		Unload();
+	}
+
+	// has to be inside the page, if the page knows its size yet
+	if ( ( page.pTexture == NULL && !page.IsPending() ) || left < 0 || top < 0 || width <= 0 || height <= 0 ||
+		( page.desc.Width != 0 && ( left + width > (int)page.desc.Width || top + height > (int)page.desc.Height ) ) )
+	{
+		return false;
+	}
+
+	filePath = page.filePath;
+
+	// looks like a texture the size of the region
+	desc.Width = width;
+	desc.Height = height;
+
+	offsetX = page.offsetX + left;
+	offsetY = page.offsetY + top;
+	isRegion = true;
+	premultiplied = page.premultiplied;
+
+	// share the page's texture once it has one
+	if ( page.IsPending() )
+	{
+		pRegionPage = &page;
+		return true;
+	}
+
+	Share( page );
+
+	return true;
+}
+
+void TextureType::Share( const TextureType& page )
+{
+	pPixels = page.pPixels;
+	pTexture = page.pTexture;
+	pTexture->AddRef();
+	pView = page.pView;
+	pView->AddRef();
+
+	// the page's format and mips, our size
+	UINT width = desc.Width;
+	UINT height = desc.Height;
+	desc = page.desc;
+	desc.Width = width;
+	desc.Height = height;
+}
+
 // ----------------------------------------------------------
 // draws the texture to another 'resource'. Typically, drawTo will be the back buffer
 void TextureType::Draw( ID3D11DeviceContext* device, ID3D11Texture2D* drawTo, int destX, int destY )
 {
+	if ( IsPending() )
+	{
+		Resolve();
+	}
+
 	// if we aren't loaded
 	if ( pTexture == NULL )
 	{
 		return;
 	}
 
+	// copying can't turn compressed blocks into back buffer pixels, so a cooked texture
+	//	has to be drawn with SpriteBatch
+	if ( IsBlockCompressed() )
+	{
+		OutputDebugStringW( ( L"TextureType: can't copy compressed " + filePath + L" to the back buffer\n" ).c_str() );
+		return;
+	}
+
 	// get the width and height of what we are drawing to
 	D3D11_TEXTURE2D_DESC toDesc;
 	drawTo->GetDesc( &toDesc );
@@ -98,6 +440,10 @@ void TextureType::Draw( ID3D11DeviceContext* device, ID3D11Texture2D* drawTo, in
 		height = height + destY;
 	}
 
+	// the part that's cut off is skipped, and what's left starts at the edge
+	destX += left;
+	destY += top;
+
 	// check if we are off the edge of the right screen
 	if ( destX + width > (int) toDesc.Width )
 	{
@@ -109,14 +455,20 @@ void TextureType::Draw( ID3D11DeviceContext* device, ID3D11Texture2D* drawTo, in
 		height = (int)toDesc.Height - destY;
 	}
 
+	// a texture narrower than the screen can be all the way off it
+	if ( width <= 0 || height <= 0 )
+	{
+		return;
+	}
 
-	// describe the sub area we want to draw to
+	// describe the sub area we want to draw to. right and bottom are one past the
+	//	end, so they're measured from where the box starts
 	D3D11_BOX sourceRegion;					// box region
 
-	sourceRegion.left = left;
-	sourceRegion.right = width;
-	sourceRegion.top = top;
-	sourceRegion.bottom = height;
+	sourceRegion.left = offsetX + left;
+	sourceRegion.right = offsetX + left + width;
+	sourceRegion.top = offsetY + top;
+	sourceRegion.bottom = offsetY + top + height;
 	sourceRegion.front = 0;
 	sourceRegion.back = 1;
 
@@ -125,10 +477,69 @@ void TextureType::Draw( ID3D11DeviceContext* device, ID3D11Texture2D* drawTo, in
 
 }
 
+// ----------------------------------------------------------
+// Works out the memory from the description
+size_t TextureType::GetByteSize() const
+{
+	if ( pTexture == NULL || isRegion )
+	{
+		return 0;
+	}
+
+	// block compressed formats are 4x4 blocks of 8 or 16 bytes
+	int blockBytes = GetBlockBytes();
+
+	size_t bytes = 0;
+	int width = desc.Width;
+	int height = desc.Height;
+	for ( UINT mip = 0; mip < desc.MipLevels || mip == 0; mip++ )
+	{
+		if ( blockBytes )
+			bytes += (size_t)((width + 3) / 4) * ((height + 3) / 4) * blockBytes;
+		else
+			bytes += (size_t)width * height * 4;	// everything we load is 32 bit otherwise
+
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+
+	return bytes * ( desc.ArraySize ? desc.ArraySize : 1 );
+}
+
+// ----------------------------------------------------------
+// Bytes in a 4x4 block, 0 if it isn't block compressed
+int TextureType::GetBlockBytes() const
+{
+	switch ( desc.Format )
+	{
+	case DXGI_FORMAT_BC1_UNORM:
+	case DXGI_FORMAT_BC1_UNORM_SRGB:
+		return 8;
+	case DXGI_FORMAT_BC2_UNORM:
+	case DXGI_FORMAT_BC2_UNORM_SRGB:
+	case DXGI_FORMAT_BC3_UNORM:
+	case DXGI_FORMAT_BC3_UNORM_SRGB:
+	case DXGI_FORMAT_BC7_UNORM:
+	case DXGI_FORMAT_BC7_UNORM_SRGB:
+		return 16;
+	}
+	return 0;
+}
+
 // ----------------------------------------------------------
 // Unloads the texture
 void TextureType::Unload()
 {
 	SAFE_RELEASE( pTexture );
 	SAFE_RELEASE( pView );
+	ZeroMemory( &desc, sizeof(desc) );
+	offsetX = 0;
+	offsetY = 0;
+	isRegion = false;
+	premultiplied = false;
+	pending.reset();
+	pDevice = NULL;
+	pLoader = NULL;
+	pRegionPage = NULL;
+	pPixels.reset();
 }
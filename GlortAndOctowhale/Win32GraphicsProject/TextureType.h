@@ -9,8 +9,15 @@
 #define _TEXTURE_TYPE_H
 
 #include <string>
+#include <memory>
 #include <d3d11_1.h>
 
+// forward declares
+class AssetLoader;
+class AssetPack;
+struct PendingImage;
+struct ImageRGBA;
+
 class TextureType 
 {
 public:
@@ -20,17 +27,65 @@ public:
 
 	// loads the texture from disk
 	bool Load( ID3D11Device* device, const wchar_t* fileName  );
+
+	// starts loading a PNG on the loader's threads. the texture is made the first time it's
+	//	used, waiting for the decode if it isn't done. anything else loads straight away
+	bool LoadAsync( ID3D11Device* device, AssetLoader& loader, const wchar_t* fileName );
+
+	// the same, from a file in an asset pack. the file's bytes are read where they're mapped
+	//	unless they were compressed. false if the pack hasn't got it
+	bool Load( ID3D11Device* device, const AssetPack& pack, const wchar_t* fileName );
+	bool LoadAsync( ID3D11Device* device, AssetLoader& loader, const AssetPack& pack, const wchar_t* fileName );
+
+	// makes the texture from width * height RGBA pixels in memory, red in the low byte
+	bool Create( ID3D11Device* device, int width, int height, const unsigned int* pixels );
+
+	// makes this a view of part of another texture, like an atlas page. it shares the page's
+	//	D3D texture, so it stays good even if the page is unloaded first. if the page is
+	//	still loading, it has to stay around until the region is first used
+	bool CreateRegion( const TextureType& page, int left, int top, int width, int height );
 	void Unload();
 
 	// draws the texture to another 'resource'. Typically, drawTo will be the back buffer
+	//	only copies, so it doesn't work for block compressed textures
 	void Draw( ID3D11DeviceContext* device, ID3D11Texture2D* drawTo, int destX, int destY );
 
 	// get height & width of the texture
-	int GetHeight() const { return desc.Height; }
-	int GetWidth() const { return desc.Width; }
+	int GetHeight() const { if ( desc.Height == 0 && IsPending() ) Resolve(); return desc.Height; }
+	int GetWidth() const { if ( desc.Width == 0 && IsPending() ) Resolve(); return desc.Width; }
+
+	// where the texture starts in the resource view, not 0 for a region
+	int GetOffsetX() const { return offsetX; }
+	int GetOffsetY() const { return offsetY; }
 
 	// get the resource view
-	ID3D11ShaderResourceView* GetResourceView() const { return pView; }
+	ID3D11ShaderResourceView* GetResourceView() const { if ( IsPending() ) Resolve(); return pView; }
+
+	// video memory the texture takes, every mip level included. 0 for a region, the page has it,
+	//	and 0 while it's loading
+	size_t GetByteSize() const;
+
+	// a cooked BC3 / BC7 texture. these can only be drawn with SpriteBatch, not Draw
+	bool IsBlockCompressed() const { return GetBlockBytes() != 0; }
+
+	// the colours are already multiplied by alpha, so draw it with premultiplied blending
+	//	(see AssetLoader::SetPremultiply, and cooked DDS files)
+	bool IsPremultiplied() const { return premultiplied; }
+
+	// an async load that hasn't been made into a texture yet
+	bool IsPending() const { return pending != nullptr || pRegionPage != nullptr; }
+
+	// finish an async load now, on this thread. does nothing if there isn't one
+	void Resolve() const;
+
+	// keep the decoded pixels of PNGs loaded after this, so they can be drawn on the cpu
+	//	(see SoftwareFramebuffer). off by default, it's a second copy of every texture
+	static void SetKeepPixels( bool keep ) { keepPixels = keep; }
+	static bool GetKeepPixels() { return keepPixels; }
+
+	// the pixels, premultiplied if IsPremultiplied. a region gives its page's, which its
+	//	offset is in. null unless SetKeepPixels was on when a PNG was loaded
+	const ImageRGBA* GetPixels() const { if ( IsPending() ) Resolve(); return pPixels.get(); }
 
 private:
 
@@ -41,6 +96,29 @@ private:
 
 	D3D11_TEXTURE2D_DESC desc;					// description of our texture 
 
+	int offsetX;								// where a region is in its page
+	int offsetY;
+	bool isRegion;
+	bool premultiplied;
+
+	static bool keepPixels;
+	std::shared_ptr<const ImageRGBA> pPixels;	// with keepPixels, shared with regions
+
+	// an async load
+	ID3D11Device*					pDevice;	// to make the texture with
+	AssetLoader*					pLoader;
+	std::shared_ptr<PendingImage>	pending;
+	const TextureType*				pRegionPage;	// page that was still loading when the region was made
+
+	// make the texture from a whole DDS, PNG or other image file in memory
+	bool LoadFromMemory( ID3D11Device* device, const uint8_t* data, size_t size, const wchar_t* fileName );
+
+	// bytes in a 4x4 block of the format, 0 if it isn't block compressed
+	int GetBlockBytes() const;
+
+	// take a reference to page's texture and view
+	void Share( const TextureType& page );
+
 	
 };
 
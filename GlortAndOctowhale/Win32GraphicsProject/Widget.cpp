@@ -0,0 +1,224 @@
+//
+// Widget
+//		Retained menu UI: a tree of widgets that keep their own hover / press state
+//
+
+#include "Widget.h"
+
+// -----------------------------------------------------
+// Constructor
+//
+Widget::Widget()
+{
+	pParent = nullptr;
+	id = 0;
+	visible = true;
+	hovered = false;
+	pressed = false;
+	dirty = true;
+}
+
+Widget::~Widget()
+{
+}
+
+// -----------------------------------------------------
+// Tree
+//
+void Widget::AddChild(Widget* pChild)
+{
+	if (pChild == nullptr || pChild->pParent != nullptr)
+		return;
+
+	pChild->pParent = this;
+	children.push_back(pChild);
+}
+
+void Widget::SetVisible(bool v)
+{
+	if (visible != v)
+	{
+		visible = v;
+		MarkDirty();
+	}
+}
+
+// -----------------------------------------------------
+// State, only marked dirty when it actually changes
+//
+void Widget::SetHovered(bool hover)
+{
+	if (hovered != hover)
+	{
+		hovered = hover;
+		MarkDirty();
+	}
+}
+
+void Widget::SetPressed(bool press)
+{
+	if (pressed != press)
+	{
+		pressed = press;
+		MarkDirty();
+	}
+}
+
+// -----------------------------------------------------
+// Find what's under the mouse, last child first since it draws on top
+//
+Widget* Widget::HitTest(Vector2 point)
+{
+	if (!visible)
+		return nullptr;
+
+	for (size_t i = children.size(); i-- > 0; )
+	{
+		Widget* pHit = children[i]->HitTest(point);
+		if (pHit)
+			return pHit;
+	}
+
+	return Contains(point) ? this : nullptr;
+}
+
+// -----------------------------------------------------
+// Queue the tree
+//
+void Widget::Draw(RenderQueue* pQueue)
+{
+	if (!visible)
+		return;
+
+	if (dirty)
+	{
+		Rebuild();
+		dirty = false;
+	}
+
+	DrawSelf(pQueue);
+
+	for (size_t i = 0; i < children.size(); i++)
+	{
+		children[i]->Draw(pQueue);
+	}
+}
+
+// -----------------------------------------------------
+// Button
+//
+ButtonWidget::ButtonWidget()
+{
+	hasCommand = false;
+	left = top = right = bottom = 0.0f;
+}
+
+void ButtonWidget::Initialize(TextureType* pTexture, Vector2 position, Color normal, Color hover)
+{
+	normalColor = normal;
+	hoverColor = hover;
+	sprite.Initialize(pTexture, position, 0, 1.0f, normal, 0);
+
+	// the rect is needed for hit testing before the first draw
+	Rebuild();
+	MarkDirty();
+}
+
+void ButtonWidget::SetPosition(Vector2 position)
+{
+	sprite.SetPosition(position);
+	Rebuild();
+	MarkDirty();
+}
+
+bool ButtonWidget::Contains(Vector2 point) const
+{
+	return point.x >= left && point.x <= right && point.y >= top && point.y <= bottom;
+}
+
+void ButtonWidget::Rebuild()
+{
+	sprite.SetColor(IsHovered() ? hoverColor : normalColor);
+	hasCommand = sprite.MakeDrawCommand(command);
+
+	// buttons don't turn, so the box is the extents around the middle
+	Vector2 center = sprite.GetPosition();
+	Vector2 extents = sprite.GetExtents();
+	left = center.x - extents.x;
+	right = center.x + extents.x;
+	top = center.y - extents.y;
+	bottom = center.y + extents.y;
+}
+
+void ButtonWidget::DrawSelf(RenderQueue* pQueue) const
+{
+	if (hasCommand)
+		pQueue->Submit(command, sprite.GetBlend());
+}
+
+// -----------------------------------------------------
+// Root, the only place the mouse gets hit tested
+//
+WidgetRoot::WidgetRoot()
+{
+	pListener = nullptr;
+	pHovered = nullptr;
+	pPressed = nullptr;
+}
+
+void WidgetRoot::UpdateHover(Vector2 point)
+{
+	Widget* pHit = HitTest(point);
+	if (pHit == this)
+		pHit = nullptr;
+
+	if (pHit != pHovered)
+	{
+		if (pHovered)
+			pHovered->SetHovered(false);
+		if (pHit)
+			pHit->SetHovered(true);
+		pHovered = pHit;
+	}
+}
+
+void WidgetRoot::OnMouseMove(Vector2 point)
+{
+	UpdateHover(point);
+}
+
+void WidgetRoot::OnMouseDown(Vector2 point)
+{
+	UpdateHover(point);
+
+	pPressed = pHovered;
+	if (pPressed)
+		pPressed->SetPressed(true);
+}
+
+void WidgetRoot::OnMouseUp(Vector2 point)
+{
+	UpdateHover(point);
+
+	Widget* pClicked = (pPressed && pPressed == pHovered) ? pPressed : nullptr;
+	if (pPressed)
+	{
+		pPressed->SetPressed(false);
+		pPressed = nullptr;
+	}
+
+	// last, the listener might change screens
+	if (pClicked && pListener)
+		pListener->OnWidgetClicked(pClicked);
+}
+
+void WidgetRoot::Refresh(Vector2 point)
+{
+	if (pPressed)
+	{
+		pPressed->SetPressed(false);
+		pPressed = nullptr;
+	}
+
+	UpdateHover(point);
+}
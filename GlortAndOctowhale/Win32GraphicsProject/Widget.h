@@ -0,0 +1,140 @@
+//
+// Widget
+//		Retained menu UI: a tree of widgets that keep their own hover / press state
+//
+//	Nothing here runs per frame except Draw, which queues commands that were built the
+//	last time something changed. The mouse is only hit tested when a mouse message
+//	comes in, and a widget is only rebuilt when its state, position or visibility
+//	actually changes.
+//
+
+#ifndef _WIDGET_H
+#define _WIDGET_H
+
+#include <vector>
+#include "Sprite.h"
+#include "RenderQueue.h"
+
+class Widget;
+
+// gets told when a widget is clicked
+class WidgetListener
+{
+public:
+	virtual ~WidgetListener() {}
+
+	// the mouse was pressed and released over pWidget. it's fine to change screens from here
+	virtual void OnWidgetClicked(Widget* pWidget) = 0;
+};
+
+class Widget
+{
+public:
+	Widget();
+	virtual ~Widget();
+
+	// children draw over, and are hit tested before, their parent. they aren't owned
+	void AddChild(Widget* pChild);
+
+	// hidden widgets and their children don't draw or take the mouse
+	void SetVisible(bool visible);
+	bool IsVisible() const { return visible; }
+
+	// whatever the owner wants to tell widgets apart by
+	void SetId(int i) { id = i; }
+	int GetId() const { return id; }
+
+	// the topmost visible widget under point that takes the mouse, null if there isn't one
+	Widget* HitTest(Vector2 point);
+
+	// queue this widget and its children, rebuilding whatever changed since last time
+	void Draw(RenderQueue* pQueue);
+
+	// set by the root as the mouse moves and clicks
+	void SetHovered(bool hover);
+	void SetPressed(bool press);
+	bool IsHovered() const { return hovered; }
+	bool IsPressed() const { return pressed; }
+
+protected:
+	// does the widget itself take the mouse at point. plain containers don't
+	virtual bool Contains(Vector2 point) const { return false; }
+
+	// bring cached draw data up to date, only called when dirty
+	virtual void Rebuild() {}
+
+	// queue the widget itself, not its children
+	virtual void DrawSelf(RenderQueue* pQueue) const {}
+
+	// something changed, rebuild before the next draw
+	void MarkDirty() { dirty = true; }
+
+private:
+	std::vector<Widget*> children;
+	Widget*		pParent;
+	int			id;
+	bool		visible;
+	bool		hovered;
+	bool		pressed;
+	bool		dirty;
+
+	// no copying, parents point at their children
+	Widget(const Widget&);
+	Widget& operator=(const Widget&);
+};
+
+// a sprite that lights up under the mouse
+class ButtonWidget : public Widget
+{
+public:
+	ButtonWidget();
+
+	// the button is the whole texture, centred on position
+	void Initialize(TextureType* pTexture, Vector2 position, Color normalColor, Color hoverColor);
+
+	void SetPosition(Vector2 position);
+	Vector2 GetPosition() const { return sprite.GetPosition(); }
+
+protected:
+	virtual bool Contains(Vector2 point) const;
+	virtual void Rebuild();
+	virtual void DrawSelf(RenderQueue* pQueue) const;
+
+private:
+	Sprite		sprite;
+	Color		normalColor;
+	Color		hoverColor;
+
+	// worked out in Rebuild
+	DrawCommand	command;
+	bool		hasCommand;
+	float		left, top, right, bottom;
+};
+
+// the top of a screen's tree, turns mouse messages into hover, press and clicks
+class WidgetRoot : public Widget
+{
+public:
+	WidgetRoot();
+
+	// who hears about clicks, not owned
+	void SetListener(WidgetListener* pL) { pListener = pL; }
+
+	// feed these from the window messages
+	void OnMouseMove(Vector2 point);
+	void OnMouseDown(Vector2 point);
+	void OnMouseUp(Vector2 point);
+
+	// drop any press and hit test again, for when the screen has just come up
+	void Refresh(Vector2 point);
+
+private:
+	// move the hover to whatever is under point
+	void UpdateHover(Vector2 point);
+
+	WidgetListener*	pListener;
+	Widget*			pHovered;
+	Widget*			pPressed;
+};
+
+#endif // _WIDGET_H
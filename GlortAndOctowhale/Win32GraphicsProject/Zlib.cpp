@@ -0,0 +1,580 @@
+//
+// Zlib
+//		Just enough zlib (RFC 1950 / 1951) for PNG files, no library needed
+//
+
+#include "Zlib.h"
+#include <string.h>
+
+// length and distance codes, RFC 1951 3.2.5
+static const uint16_t lengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t lengthExtra[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t distanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+static const uint8_t distanceExtra[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// order the code length code lengths come in
+static const uint8_t codeLengthOrder[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+// reverse the low n bits, Huffman codes go in most significant bit first
+static uint32_t ReverseBits(uint32_t code, int n)
+{
+	uint32_t r = 0;
+	for (int i = 0; i < n; i++)
+	{
+		r = (r << 1) | (code & 1);
+		code >>= 1;
+	}
+	return r;
+}
+
+// -----------------------------------------------------
+// Reading bits, least significant first
+//
+class BitReader
+{
+public:
+	BitReader(const uint8_t* d, size_t s) : data(d), size(s), pos(0), bits(0), count(0) {}
+
+	// make sure there are at least 32 bits to look at. past the end reads zeros,
+	//	Overrun says if any of those were used
+	void Refill()
+	{
+		while (count <= 56)
+		{
+			uint64_t b = pos < size ? data[pos] : 0;
+			pos++;
+			bits |= b << count;
+			count += 8;
+		}
+	}
+
+	uint32_t Peek(int n)
+	{
+		if (count < n)
+			Refill();
+		return (uint32_t)(bits & ((1ull << n) - 1));
+	}
+
+	void Drop(int n)
+	{
+		bits >>= n;
+		count -= n;
+	}
+
+	uint32_t Bits(int n)
+	{
+		if (n == 0)
+			return 0;
+		uint32_t v = Peek(n);
+		Drop(n);
+		return v;
+	}
+
+	void AlignToByte() { Drop(count & 7); }
+
+	// bytes actually used
+	size_t Position() const { return pos - count / 8; }
+
+	bool Overrun() const { return Position() > size; }
+
+private:
+	const uint8_t*	data;
+	size_t			size;
+	size_t			pos;
+	uint64_t		bits;
+	int				count;
+};
+
+// -----------------------------------------------------
+// Canonical Huffman decoding, a table for the short codes and a slow walk for the rest
+//
+class Huffman
+{
+public:
+	static const int FastBits = 10;
+
+	bool Build(const uint8_t* lengths, int n)
+	{
+		memset(counts, 0, sizeof(counts));
+		memset(fast, 0, sizeof(fast));
+
+		for (int i = 0; i < n; i++)
+			counts[lengths[i]]++;
+		counts[0] = 0;
+
+		// over subscribed sets can't be decoded. incomplete ones are allowed (one distance code)
+		int left = 1;
+		for (int len = 1; len < 16; len++)
+		{
+			left <<= 1;
+			left -= counts[len];
+			if (left < 0)
+				return false;
+		}
+
+		int offsets[16];
+		offsets[1] = 0;
+		for (int len = 1; len < 15; len++)
+			offsets[len + 1] = offsets[len] + counts[len];
+
+		for (int sym = 0; sym < n; sym++)
+		{
+			if (lengths[sym])
+				symbols[offsets[lengths[sym]]++] = (uint16_t)sym;
+		}
+
+		// symbols are now in code order, so the codes just count up
+		int code = 0;
+		int index = 0;
+		for (int len = 1; len < 16; len++)
+		{
+			for (int i = 0; i < counts[len]; i++, index++, code++)
+			{
+				if (len <= FastBits)
+				{
+					uint32_t rev = ReverseBits(code, len);
+					for (uint32_t j = rev; j < (1u << FastBits); j += 1u << len)
+						fast[j] = (uint16_t)((len << 9) | symbols[index]);
+				}
+			}
+			code <<= 1;
+		}
+
+		return true;
+	}
+
+	// next symbol, -1 if the bits aren't a code
+	int Decode(BitReader& in) const
+	{
+		uint16_t e = fast[in.Peek(FastBits)];
+		if (e)
+		{
+			in.Drop(e >> 9);
+			return e & 511;
+		}
+
+		// longer than the table, one bit at a time
+		int code = 0, first = 0, index = 0;
+		for (int len = 1; len < 16; len++)
+		{
+			code |= in.Bits(1);
+			int count = counts[len];
+			if (code - count < first)
+				return symbols[index + (code - first)];
+			index += count;
+			first += count;
+			first <<= 1;
+			code <<= 1;
+		}
+		return -1;
+	}
+
+private:
+	uint16_t counts[16];
+	uint16_t symbols[288];
+	uint16_t fast[1 << FastBits];		// (length << 9) | symbol, 0 if the code is longer
+};
+
+// -----------------------------------------------------
+// One compressed block
+//
+static bool InflateBlock(BitReader& in, const Huffman& lit, const Huffman& dist, std::vector<uint8_t>& out, size_t start)
+{
+	for (;;)
+	{
+		int sym = lit.Decode(in);
+		if (sym < 0)
+			return false;
+
+		if (sym < 256)
+		{
+			out.push_back((uint8_t)sym);
+			continue;
+		}
+		if (sym == 256)
+			return true;
+
+		sym -= 257;
+		if (sym >= 29)
+			return false;
+		int length = lengthBase[sym] + in.Bits(lengthExtra[sym]);
+
+		int dsym = dist.Decode(in);
+		if (dsym < 0 || dsym >= 30)
+			return false;
+		size_t distance = distanceBase[dsym] + in.Bits(distanceExtra[dsym]);
+
+		size_t n = out.size();
+		if (distance > n - start)
+			return false;
+
+		// can overlap itself, so byte at a time
+		out.resize(n + length);
+		uint8_t* dst = out.data() + n;
+		const uint8_t* src = dst - distance;
+		for (int i = 0; i < length; i++)
+			dst[i] = src[i];
+	}
+}
+
+// -----------------------------------------------------
+// Decompress
+//
+bool Zlib::Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t expectedSize)
+{
+	// 2 byte header, no preset dictionary
+	if (size < 6 || (data[0] & 0x0f) != 8 || ((data[0] << 8) | data[1]) % 31 != 0 || (data[1] & 0x20))
+		return false;
+
+	size_t start = out.size();
+	out.reserve(start + expectedSize);
+
+	BitReader in(data + 2, size - 6);
+	Huffman lit, dist;
+
+	int final;
+	do
+	{
+		final = in.Bits(1);
+		int type = in.Bits(2);
+
+		if (type == 0)
+		{
+			// stored
+			in.AlignToByte();
+			uint32_t len = in.Bits(16);
+			uint32_t nlen = in.Bits(16);
+			if ((len ^ 0xffff) != nlen)
+				return false;
+			for (uint32_t i = 0; i < len; i++)
+				out.push_back((uint8_t)in.Bits(8));
+		}
+		else if (type == 1)
+		{
+			// fixed codes
+			uint8_t lengths[288];
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			lit.Build(lengths, 288);
+
+			memset(lengths, 5, 30);
+			dist.Build(lengths, 30);
+
+			if (!InflateBlock(in, lit, dist, out, start))
+				return false;
+		}
+		else if (type == 2)
+		{
+			// dynamic codes, the code lengths are Huffman coded too
+			int nlit = in.Bits(5) + 257;
+			int ndist = in.Bits(5) + 1;
+			int ncode = in.Bits(4) + 4;
+			if (nlit > 286 || ndist > 30)
+				return false;
+
+			uint8_t lengths[288 + 32];
+			memset(lengths, 0, 19);
+			for (int i = 0; i < ncode; i++)
+				lengths[codeLengthOrder[i]] = (uint8_t)in.Bits(3);
+
+			Huffman lengthCodes;
+			if (!lengthCodes.Build(lengths, 19))
+				return false;
+
+			int i = 0;
+			while (i < nlit + ndist)
+			{
+				int sym = lengthCodes.Decode(in);
+				if (sym < 0)
+					return false;
+
+				if (sym < 16)
+				{
+					lengths[i++] = (uint8_t)sym;
+					continue;
+				}
+
+				int repeat;
+				uint8_t value = 0;
+				if (sym == 16)
+				{
+					if (i == 0)
+						return false;
+					value = lengths[i - 1];
+					repeat = 3 + in.Bits(2);
+				}
+				else if (sym == 17)
+					repeat = 3 + in.Bits(3);
+				else
+					repeat = 11 + in.Bits(7);
+
+				if (i + repeat > nlit + ndist)
+					return false;
+				while (repeat--)
+					lengths[i++] = value;
+			}
+
+			// has to be able to end
+			if (lengths[256] == 0)
+				return false;
+
+			if (!lit.Build(lengths, nlit) || !dist.Build(lengths + nlit, ndist))
+				return false;
+
+			if (!InflateBlock(in, lit, dist, out, start))
+				return false;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (in.Overrun())
+			return false;
+	} while (!final);
+
+	// the checksum is after the deflate data, big endian
+	in.AlignToByte();
+	const uint8_t* tail = data + 2 + in.Position();
+	if (tail + 4 > data + size)
+		return false;
+
+	uint32_t adler = ((uint32_t)tail[0] << 24) | ((uint32_t)tail[1] << 16) | ((uint32_t)tail[2] << 8) | tail[3];
+	return adler == Adler32(out.data() + start, out.size() - start);
+}
+
+// -----------------------------------------------------
+// Writing bits, least significant first
+//
+class BitWriter
+{
+public:
+	BitWriter(std::vector<uint8_t>& o) : out(o), bits(0), count(0) {}
+
+	void Put(uint32_t value, int n)
+	{
+		bits |= (uint64_t)value << count;
+		count += n;
+		while (count >= 8)
+		{
+			out.push_back((uint8_t)bits);
+			bits >>= 8;
+			count -= 8;
+		}
+	}
+
+	// Huffman codes go most significant bit first
+	void PutCode(uint32_t code, int n) { Put(ReverseBits(code, n), n); }
+
+	void Flush()
+	{
+		if (count > 0)
+			out.push_back((uint8_t)bits);
+		bits = 0;
+		count = 0;
+	}
+
+private:
+	std::vector<uint8_t>&	out;
+	uint64_t				bits;
+	int						count;
+};
+
+// a literal / length symbol with the fixed codes
+static void PutFixedSymbol(BitWriter& w, int sym)
+{
+	if (sym < 144)
+		w.PutCode(0x30 + sym, 8);
+	else if (sym < 256)
+		w.PutCode(0x190 + sym - 144, 9);
+	else if (sym < 280)
+		w.PutCode(sym - 256, 7);
+	else
+		w.PutCode(0xc0 + sym - 280, 8);
+}
+
+// -----------------------------------------------------
+// Compress, one block with the fixed codes
+//
+void Zlib::Deflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out)
+{
+	size_t start = out.size();
+
+	// deflate, 32K window
+	out.push_back(0x78);
+	out.push_back(0x01);
+
+	BitWriter w(out);
+	w.Put(1, 1);	// final block
+	w.Put(1, 2);	// fixed codes
+
+	const int WindowSize = 32768;
+	const int HashBits = 15;
+	const int MaxChain = 48;
+	const int MinMatch = 3;
+	const int MaxMatch = 258;
+
+	// most recent position for each hash, and the one before it at that position
+	std::vector<int32_t> head(1 << HashBits, -1);
+	std::vector<int32_t> prev(WindowSize, -1);
+
+	// length to symbol, done once
+	uint8_t lengthSymbol[MaxMatch + 1];
+	for (int s = 0, len = MinMatch; len <= MaxMatch; len++)
+	{
+		while (s < 28 && len >= lengthBase[s + 1])
+			s++;
+		lengthSymbol[len] = (uint8_t)s;
+	}
+
+	size_t i = 0;
+	while (i < size)
+	{
+		int bestLength = 0;
+		size_t bestDistance = 0;
+
+		if (i + MinMatch <= size)
+		{
+			uint32_t h = ((data[i] << 16) | (data[i + 1] << 8) | data[i + 2]) * 2654435761u >> (32 - HashBits);
+			int32_t candidate = head[h];
+			int maxLength = (int)(size - i < (size_t)MaxMatch ? size - i : MaxMatch);
+
+			for (int chain = 0; candidate >= 0 && i - candidate <= (size_t)WindowSize && chain < MaxChain; chain++)
+			{
+				const uint8_t* a = data + candidate;
+				const uint8_t* b = data + i;
+				if (a[bestLength] == b[bestLength])
+				{
+					int len = 0;
+					while (len < maxLength && a[len] == b[len])
+						len++;
+					if (len > bestLength)
+					{
+						bestLength = len;
+						bestDistance = i - candidate;
+						if (len == maxLength)
+							break;
+					}
+				}
+				int32_t next = prev[candidate & (WindowSize - 1)];
+				if (next >= candidate)
+					break;
+				candidate = next;
+			}
+
+			prev[i & (WindowSize - 1)] = head[h];
+			head[h] = (int32_t)i;
+		}
+
+		if (bestLength >= MinMatch)
+		{
+			int s = lengthSymbol[bestLength];
+			PutFixedSymbol(w, 257 + s);
+			w.Put(bestLength - lengthBase[s], lengthExtra[s]);
+
+			int d = 0;
+			while (d < 29 && bestDistance >= distanceBase[d + 1])
+				d++;
+			w.PutCode(d, 5);
+			w.Put((uint32_t)(bestDistance - distanceBase[d]), distanceExtra[d]);
+
+			// put the skipped positions in the hash too, so later matches can find them
+			for (size_t j = i + 1; j < i + bestLength && j + MinMatch <= size; j++)
+			{
+				uint32_t h = ((data[j] << 16) | (data[j + 1] << 8) | data[j + 2]) * 2654435761u >> (32 - HashBits);
+				prev[j & (WindowSize - 1)] = head[h];
+				head[h] = (int32_t)j;
+			}
+			i += bestLength;
+		}
+		else
+		{
+			PutFixedSymbol(w, data[i]);
+			i++;
+		}
+	}
+
+	PutFixedSymbol(w, 256);
+	w.Flush();
+
+	// data that doesn't compress (noise, already compressed) is smaller stored as it is,
+	//	in blocks of up to 64K with a 5 byte header each
+	size_t storedSize = size + 5 * (size / 65535 + 1);
+	if (out.size() - start - 2 > storedSize)
+	{
+		out.resize(start + 2);
+		size_t pos = 0;
+		do
+		{
+			size_t n = size - pos < 65535 ? size - pos : 65535;
+			out.push_back(pos + n == size ? 1 : 0);
+			out.push_back((uint8_t)n);
+			out.push_back((uint8_t)(n >> 8));
+			out.push_back((uint8_t)~n);
+			out.push_back((uint8_t)(~n >> 8));
+			out.insert(out.end(), data + pos, data + pos + n);
+			pos += n;
+		} while (pos < size);
+	}
+
+	uint32_t adler = Adler32(data, size);
+	out.push_back((uint8_t)(adler >> 24));
+	out.push_back((uint8_t)(adler >> 16));
+	out.push_back((uint8_t)(adler >> 8));
+	out.push_back((uint8_t)adler);
+}
+
+// -----------------------------------------------------
+// Checksums
+//
+uint32_t Zlib::Crc32(const uint8_t* data, size_t size, uint32_t crc)
+{
+	// made the first time, thread safe since C++11
+	static const struct Table
+	{
+		uint32_t entries[256];
+		Table()
+		{
+			for (uint32_t n = 0; n < 256; n++)
+			{
+				uint32_t c = n;
+				for (int k = 0; k < 8; k++)
+					c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+				entries[n] = c;
+			}
+		}
+	} table;
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+		crc = table.entries[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+uint32_t Zlib::Adler32(const uint8_t* data, size_t size, uint32_t adler)
+{
+	uint32_t a = adler & 0xffff;
+	uint32_t b = adler >> 16;
+
+	while (size > 0)
+	{
+		// as many as can go before the sums could overflow
+		size_t n = size < 5552 ? size : 5552;
+		size -= n;
+		while (n--)
+		{
+			a += *data++;
+			b += a;
+		}
+		a %= 65521;
+		b %= 65521;
+	}
+
+	return (b << 16) | a;
+}
@@ -0,0 +1,32 @@
+//
+// Zlib
+//		Just enough zlib (RFC 1950 / 1951) for PNG files, no library needed
+//
+//	Inflate handles everything a zlib stream can hold. Deflate does LZ77 with hash
+//	chains and the fixed Huffman codes, which is a bit bigger than zlib's output but
+//	simple, and any inflater reads it.
+//
+
+#ifndef _ZLIB_H
+#define _ZLIB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class Zlib
+{
+public:
+	// decompress a zlib stream, appending to out. expectedSize is only a hint for reserving
+	//	returns false if the stream is broken or the checksum doesn't match
+	static bool Inflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out, size_t expectedSize = 0);
+
+	// compress into a zlib stream, appending to out
+	static void Deflate(const uint8_t* data, size_t size, std::vector<uint8_t>& out);
+
+	// the checksums, for PNG chunks and zlib streams. pass the last result to carry on
+	static uint32_t Crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+	static uint32_t Adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+};
+
+#endif // _ZLIB_H